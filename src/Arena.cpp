@@ -0,0 +1,154 @@
+/* Arena, allocation of the large model tables
+ *
+ * Copyright (c) 2019-2023 Marwijn Hessel
+ *
+ * Moruga is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Moruga is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file LICENSE.
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ * https://github.com/the-m-master/Moruga
+ */
+#include "Arena.h"
+#include <array>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+#if defined(__linux__)
+#  include <sys/mman.h>
+#endif
+
+namespace {
+  constexpr size_t HUGE_PAGE_SIZE{size_t(1) << 21};  // 2 MiB
+
+  enum class Pages : uint32_t {
+    Small,        // 4 KiB pages (calloc)
+    Transparent,  // Advised for transparent huge pages
+    Huge          // Explicit (reserved) huge pages
+  };
+
+  struct Mapping_t final {
+    size_t length;  // Mapped length, a multiple of HUGE_PAGE_SIZE
+    Pages pages;
+  };
+
+  std::mutex mutex_;                                  // Models are created on several threads in block mode
+  std::unordered_map<void*, Mapping_t> mappings_{};   // All tables not coming from calloc()
+  std::unordered_map<void*, size_t> small_tables_{};  // Tables coming from calloc(), for the report
+  std::array<uint64_t, 3> in_use_{};                  // Bytes in use per Pages
+
+  void Register(void* const table, const size_t length, const Pages pages) noexcept {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    if (Pages::Small == pages) {
+      small_tables_.emplace(table, length);
+    } else {
+      mappings_.emplace(table, Mapping_t{length, pages});
+    }
+    in_use_[static_cast<size_t>(pages)] += length;
+  }
+
+#if defined(__linux__)
+  [[nodiscard]] auto Map(const size_t length) noexcept -> void* {
+    if (void* const table{mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0)}; MAP_FAILED != table) {
+      Register(table, length, Pages::Huge);
+      return table;
+    }
+
+    // Transparent huge pages are only used for 2 MiB aligned parts of a mapping, so map more and trim
+    auto* const base{static_cast<uint8_t*>(mmap(nullptr, length + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0))};
+    if (MAP_FAILED == static_cast<void*>(base)) {
+      return nullptr;
+    }
+    const auto head{(HUGE_PAGE_SIZE - (reinterpret_cast<uintptr_t>(base) & (HUGE_PAGE_SIZE - 1))) & (HUGE_PAGE_SIZE - 1)};
+    auto* const table{base + head};
+    if (head > 0) {
+      munmap(base, head);
+    }
+    munmap(table + length, HUGE_PAGE_SIZE - head);
+    madvise(table, length, MADV_HUGEPAGE);
+    Register(table, length, Pages::Transparent);
+    return table;
+  }
+
+  /**
+   * Transparent huge pages of the process, the system decides when they are really used
+   * @return Size in KiB, or -1 when not known
+   */
+  [[nodiscard]] auto AnonHugePages() noexcept -> int64_t {
+    int64_t size{-1};
+    if (FILE* const smaps{fopen("/proc/self/smaps_rollup", "r")}; nullptr != smaps) {
+      std::array<char, 256> line{};
+      while (nullptr != fgets(line.data(), static_cast<int32_t>(line.size()), smaps)) {
+        if (1 == sscanf(line.data(), "AnonHugePages: %" SCNd64, &size)) {
+          break;
+        }
+      }
+      fclose(smaps);
+    }
+    return size;
+  }
+#endif
+};  // namespace
+
+auto Arena::Allocate(const size_t count, const size_t size) noexcept -> void* {
+  const auto length{count * size};
+#if defined(__linux__)
+  if (length >= HUGE_PAGE_SIZE) {
+    if (void* const table{Map((length + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1))}; nullptr != table) {
+      return table;
+    }
+  }
+#endif
+  void* const table{std::calloc(count, size)};
+  if (nullptr != table) {
+    Register(table, length, Pages::Small);
+  }
+  return table;
+}
+
+void Arena::Free(void* const table) noexcept {
+  if (nullptr == table) {
+    return;
+  }
+  const std::lock_guard<std::mutex> lock{mutex_};
+  if (const auto mapping{mappings_.find(table)}; mappings_.end() != mapping) {
+    in_use_[static_cast<size_t>(mapping->second.pages)] -= mapping->second.length;
+#if defined(__linux__)
+    munmap(table, mapping->second.length);
+#endif
+    mappings_.erase(mapping);
+    return;
+  }
+  if (const auto small{small_tables_.find(table)}; small_tables_.end() != small) {
+    in_use_[static_cast<size_t>(Pages::Small)] -= small->second;
+    small_tables_.erase(small);
+  }
+  std::free(table);
+}
+
+void Arena::Report() noexcept {
+  const std::lock_guard<std::mutex> lock{mutex_};
+  fprintf(stdout, "Tables: %" PRIu64 " MiB in 2 MiB pages, %" PRIu64 " MiB advised for transparent huge pages, %" PRIu64 " MiB in 4 KiB pages\n",
+          in_use_[static_cast<size_t>(Pages::Huge)] >> 20,         //
+          in_use_[static_cast<size_t>(Pages::Transparent)] >> 20,  //
+          in_use_[static_cast<size_t>(Pages::Small)] >> 20);
+#if defined(__linux__)
+  if (const auto size{AnonHugePages()}; size >= 0) {
+    fprintf(stdout, "Transparent huge pages obtained: %" PRId64 " MiB\n", size >> 10);
+  }
+#endif
+}
@@ -0,0 +1,54 @@
+/* Arena, allocation of the large model tables
+ *
+ * Copyright (c) 2019-2023 Marwijn Hessel
+ *
+ * Moruga is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Moruga is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file LICENSE.
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ * https://github.com/the-m-master/Moruga
+ */
+#pragma once
+
+#include <cstddef>
+
+/**
+ * @namespace Arena
+ * @brief Allocation of the large model tables
+ *
+ * Random probes into tables of several GiB thrash the TLB when 4 KiB pages are used.
+ * Tables of 2 MiB and larger are therefore mapped with explicit huge pages (MAP_HUGETLB) when
+ * the system has them reserved, otherwise as 2 MiB aligned mapping advised for transparent huge
+ * pages (MADV_HUGEPAGE). Smaller tables, and other platforms, use calloc().
+ * Like calloc() all memory is zero initialized.
+ */
+namespace Arena {
+  /**
+   * Allocate a zero initialized table
+   * @param count Number of elements
+   * @param size Size of one element
+   * @return The table, nullptr on failure
+   */
+  [[nodiscard]] auto Allocate(size_t count, size_t size) noexcept -> void*;
+
+  /**
+   * Release a table obtained from Allocate()
+   * @param table The table, nullptr is allowed
+   */
+  void Free(void* table) noexcept;
+
+  /**
+   * Print the page sizes obtained for the tables in use
+   */
+  void Report() noexcept;
+};  // namespace Arena
@@ -22,6 +22,7 @@
 
 #include <cassert>
 #include <cstring>
+#include "Arena.h"
 #include "File.h"
 
 #define ISPOWEROF2(x) (((x) > 1) && (!((x) & ((x)-1))))
@@ -36,9 +37,9 @@ class Buffer_t final {
 public:
   explicit Buffer_t() noexcept
       : _mask{1024 - 1},  // Initially claim one KiB, increase this with Resize later on
-        _buffer{static_cast<uint8_t*>(std::calloc(_mask + 1, sizeof(uint8_t)))} {}
+        _buffer{static_cast<uint8_t*>(Arena::Allocate(_mask + 1, sizeof(uint8_t)))} {}
   ~Buffer_t() noexcept {
-    std::free(_buffer);
+    Arena::Free(_buffer);
     _buffer = nullptr;
   }
   Buffer_t(const Buffer_t&) = delete;
@@ -47,7 +48,7 @@ public:
   auto operator=(Buffer_t&&) -> Buffer_t& = delete;
 
   // buf[i] returns a reference to the i'th byte with wrap
-  [[nodiscard]] ALWAYS_INLINE constexpr auto operator[](const uint32_t i) const noexcept -> uint8_t& {
+  [[nodiscard]] ALWAYS_INLINE constexpr auto operator[](const uint64_t i) const noexcept -> uint8_t& {
     return _buffer[i & _mask];
   }
 
@@ -60,7 +61,7 @@ public:
     _buffer[_pos++ & _mask] = ch;
   }
 
-  [[nodiscard]] ALWAYS_INLINE constexpr auto Pos() const noexcept -> uint32_t {
+  [[nodiscard]] ALWAYS_INLINE constexpr auto Pos() const noexcept -> uint64_t {
     return _pos;
   }
 
@@ -75,9 +76,9 @@ public:
       }
       max_size += max_size;
     }
-    uint8_t* const new_buf{static_cast<uint8_t*>(std::calloc(max_size, sizeof(uint8_t)))};
+    uint8_t* const new_buf{static_cast<uint8_t*>(Arena::Allocate(max_size, sizeof(uint8_t)))};
     memcpy(new_buf, _buffer, static_cast<size_t>(_mask) + UINT64_C(1));
-    std::free(_buffer);
+    Arena::Free(_buffer);
     _buffer = new_buf;
     _mask = static_cast<uint32_t>(max_size - UINT64_C(1));
   }
@@ -111,6 +112,7 @@ public:
 
 private:
   uint32_t _mask{0};
-  uint32_t _pos{0};  // Number of input bytes read (NOT wrapped)
+  int32_t : 32;      // Padding
+  uint64_t _pos{0};  // Number of input bytes read (NOT wrapped), inputs can be larger than 4 GiB
   uint8_t* __restrict _buffer{nullptr};
 };
@@ -29,6 +29,7 @@
 #include <string_view>
 #include <utility>
 #include "File.h"
+#include "Profile.h"
 #include "Progress.h"
 #include "Utilities.h"
 #include "ska/ska.h"
@@ -269,6 +270,7 @@ void CaseSpace_t::Encode(const int32_t ch) noexcept {
 }
 
 void CaseSpace_t::Encode() noexcept {
+  const Profile::Scope_t scope{Profile::Phase::CaseSpace};
   _lzw->Reserve();
 
   _original_length = _in.Size();
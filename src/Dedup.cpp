@@ -0,0 +1,228 @@
+/* Dedup, replaces repeated chunks of the input by references
+ *
+ * Copyright (c) 2019-2023 Marwijn Hessel
+ *
+ * Moruga is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Moruga is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file LICENSE.
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ * https://github.com/the-m-master/Moruga
+ */
+#include "Dedup.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "File.h"
+#include "Profile.h"
+#include "Utilities.h"
+#include "ska/ska.h"
+
+namespace {
+  constexpr size_t MIN_CHUNK{UINT32_C(1) << 11};  // 2 KiB
+  constexpr size_t AVG_CHUNK{UINT32_C(1) << 13};  // 8 KiB
+  constexpr size_t MAX_CHUNK{UINT32_C(1) << 16};  // 64 KiB
+
+  // Normalized chunking, a cut is harder to find below the average size and easier above it
+  constexpr auto MASK_SMALL{~UINT64_C(0) << (64 - 15)};
+  constexpr auto MASK_LARGE{~UINT64_C(0) << (64 - 11)};
+
+  // Random values of the gear hash (splitmix64)
+  constexpr std::array<uint64_t, 256> GEAR{[]() {
+    std::array<uint64_t, 256> gear{};
+    uint64_t state{0};
+    for (auto& value : gear) {
+      state += Utilities::PHI64;
+      auto z{state};
+      z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+      z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+      value = z ^ (z >> 31);
+    }
+    return gear;
+  }()};
+
+  /**
+   * @struct Ref_t
+   * @brief Unique bytes followed by a copy of earlier bytes
+   */
+  struct Ref_t final {
+    int64_t literal;   // Number of unique bytes
+    int64_t distance;  // Back from the start of the copy
+    int64_t length;    // Number of copied bytes, zero at the end of the data
+  };
+
+  /**
+   * Find the end of the chunk at the start of the data
+   * @param data The data
+   * @param size Number of bytes of the data, at least MAX_CHUNK unless it is the end of the input
+   * @return Length of the chunk
+   */
+  [[nodiscard]] auto Cut(const uint8_t* const data, const size_t size) noexcept -> size_t {
+    if (size <= MIN_CHUNK) {
+      return size;
+    }
+    const auto limit{(std::min)(size, MAX_CHUNK)};
+    const auto normal{(std::min)(limit, AVG_CHUNK)};
+    uint64_t hash{0};
+    size_t i{MIN_CHUNK};
+    for (; i < normal; ++i) {
+      hash = (hash << 1) + GEAR[data[i]];
+      if (!(hash & MASK_SMALL)) {
+        return i + 1;
+      }
+    }
+    for (; i < limit; ++i) {
+      hash = (hash << 1) + GEAR[data[i]];
+      if (!(hash & MASK_LARGE)) {
+        return i + 1;
+      }
+    }
+    return limit;
+  }
+
+  /**
+   * Digest of a chunk for the index, equal digests are verified on the data itself
+   */
+  [[nodiscard]] auto Digest(const uint8_t* data, size_t size) noexcept -> uint64_t {
+    auto digest{size * Utilities::PHI64};
+    for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t), data += sizeof(uint64_t)) {
+      uint64_t word;
+      memcpy(&word, data, sizeof(word));
+      digest = (digest ^ word) * UINT64_C(0xFF51AFD7ED558CCD);
+      digest ^= digest >> 32;
+    }
+    for (; size > 0; --size) {
+      digest = (digest ^ *data++) * Utilities::PHI64;
+    }
+    return digest ^ (digest >> 29);
+  }
+};  // namespace
+
+auto EncodeDedup(File_t& in, File_t& out) noexcept -> int64_t {
+  const Profile::Scope_t scope{Profile::Phase::Dedup};
+
+  map_digest2offset_t index{};
+  std::vector<Ref_t> refs{};
+  Ref_t ref{0, 0, 0};  // Being extended
+  int64_t start{0};    // Of the copy of ref
+
+  std::vector<uint8_t> data(4 * MAX_CHUNK);
+  std::vector<uint8_t> earlier(MAX_CHUNK);
+  size_t begin{0};
+  size_t end{0};
+  bool eof{false};
+  int64_t pos{0};  // Of data[begin] in the input
+  int64_t saved{0};
+
+  for (;;) {
+    if (!eof && ((end - begin) < MAX_CHUNK)) {  // Cut() looks up to MAX_CHUNK bytes ahead
+      std::memmove(data.data(), &data[begin], end - begin);
+      end -= begin;
+      begin = 0;
+      while (!eof && (end < data.size())) {
+        const auto n{in.Read(&data[end], data.size() - end)};
+        eof = 0 == n;
+        end += n;
+      }
+    }
+    if (begin == end) {
+      break;
+    }
+
+    const auto size{Cut(&data[begin], end - begin)};
+    const auto [entry, added]{index.emplace(Digest(&data[begin], size), pos)};
+    const auto offset{entry->second};
+    if (!added && (size == in.ReadAt(earlier.data(), size, offset)) && !memcmp(earlier.data(), &data[begin], size)) {
+      if ((ref.length > 0) && ((start - ref.distance + ref.length) == offset)) {  // The copy continues
+        ref.length += static_cast<int64_t>(size);
+      } else {
+        if (ref.length > 0) {
+          refs.push_back(ref);
+          ref.literal = 0;
+        }
+        ref.distance = pos - offset;
+        ref.length = static_cast<int64_t>(size);
+        start = pos;
+      }
+      saved += static_cast<int64_t>(size);
+    } else {
+      if (ref.length > 0) {
+        refs.push_back(ref);
+        ref = {0, 0, 0};
+      }
+      out.Write(&data[begin], size);
+      ref.literal += static_cast<int64_t>(size);
+    }
+    begin += size;
+    pos += static_cast<int64_t>(size);
+  }
+  refs.push_back(ref);
+
+  const auto table{out.Position()};
+  for (const auto& r : refs) {
+    out.putVLI(r.literal);
+    out.putVLI(r.distance);
+    out.putVLI(r.length);
+  }
+  out.put32(static_cast<uint32_t>(static_cast<uint64_t>(table) >> 32));
+  out.put32(static_cast<uint32_t>(table));
+  return saved;
+}
+
+auto DecodeDedup(File_t& in, File_t& out) noexcept -> int64_t {
+  const Profile::Scope_t scope{Profile::Phase::Dedup};
+
+  const auto size{in.Size() - 8};
+  if ((size < 0) || (0 != in.Seek(size))) {
+    return -1;
+  }
+  const auto high{static_cast<uint64_t>(in.get32())};
+  const auto table{static_cast<int64_t>((high << 32) | in.get32())};
+  if ((table < 0) || (table > size) || (0 != in.Seek(table))) {
+    return -1;
+  }
+
+  std::vector<uint8_t> chunk(MAX_CHUNK);
+  int64_t literal_pos{0};
+  int64_t pos{0};
+  while (in.Position() < size) {
+    auto literal{in.getVLI()};
+    const auto distance{in.getVLI()};
+    auto length{in.getVLI()};
+    if ((literal < 0) || (literal > (table - literal_pos)) || (length < 0) || ((length > 0) && ((distance <= 0) || (distance > (pos + literal))))) {
+      return -1;
+    }
+    while (literal > 0) {
+      const auto n{static_cast<size_t>((std::min)(literal, static_cast<int64_t>(chunk.size())))};
+      if (n != in.ReadAt(chunk.data(), n, literal_pos)) {
+        return -1;
+      }
+      out.Write(chunk.data(), n);
+      literal_pos += static_cast<int64_t>(n);
+      pos += static_cast<int64_t>(n);
+      literal -= static_cast<int64_t>(n);
+    }
+    while (length > 0) {  // The copy may overlap itself, never read beyond what is written
+      const auto n{static_cast<size_t>((std::min)({length, distance, static_cast<int64_t>(chunk.size())}))};
+      out.Flush();
+      if (n != out.ReadAt(chunk.data(), n, pos - distance)) {
+        return -1;
+      }
+      out.Write(chunk.data(), n);
+      pos += static_cast<int64_t>(n);
+      length -= static_cast<int64_t>(n);
+    }
+  }
+  return (literal_pos == table) ? pos : -1;
+}
@@ -0,0 +1,42 @@
+/* Dedup, replaces repeated chunks of the input by references
+ *
+ * Copyright (c) 2019-2023 Marwijn Hessel
+ *
+ * Moruga is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Moruga is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file LICENSE.
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ * https://github.com/the-m-master/Moruga
+ */
+#pragma once
+
+#include <cstdint>
+class File_t;
+
+/**
+ * Replace repeated chunks by references to their first occurrence, at any distance.
+ * The input is cut at content-defined positions (gear rolling hash), so an insertion only
+ * changes the chunks around it. Layout: unique chunks, reference table, table position.
+ * @param in Reference to input stream, must support ReadAt()
+ * @param out Reference to output stream
+ * @return Number of bytes replaced by references
+ */
+auto EncodeDedup(File_t& in, File_t& out) noexcept -> int64_t;
+
+/**
+ * Restore the repeated chunks
+ * @param in Reference to input stream, as written by EncodeDedup()
+ * @param out Reference to output stream, must be readable
+ * @return Original file length, -1 when the input is damaged
+ */
+auto DecodeDedup(File_t& in, File_t& out) noexcept -> int64_t;
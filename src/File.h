@@ -21,17 +21,27 @@
 #pragma once
 
 #include <sys/stat.h>
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <string>
+#include <vector>
 #include "Utilities.h"
 
 #if !defined(_MSC_VER)
 #  include <unistd.h>
 #endif
 
+#if defined(__linux__) || defined(__APPLE__) || defined(__CYGWIN__)
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  define FILE_MAPPING
+#endif
+
 #if defined(__APPLE__)
 #  define fflush_unlocked(stream) fflush(stream)
 #  define fread_unlocked(ptr, size, n, stream) fread(ptr, size, n, stream)
@@ -42,6 +52,9 @@
 #  include <windows.h>
 
 #  if !defined(__CYGWIN__)
+#    include <fcntl.h>
+#    include <io.h>
+
 #    define fflush_unlocked(stream) fflush(stream)
 #    define fileno_unlocked(stream) fileno(stream)
 #    define fread_unlocked(ptr, size, n, stream) fread(ptr, size, n, stream)
@@ -70,11 +83,149 @@ static std::string getTempFileLocation() noexcept {
 #  endif  // !defined(__CYGWIN__)
 #endif    // defined(_WIN32) || defined(_WIN64) || defined(__CYGWIN__)
 
+#if defined(__linux__)
+/**
+ * @class MemoryFile_t
+ * @brief Temporary file kept in memory
+ *
+ * Temporary file kept in memory, behind a stdio stream (fopencookie).
+ * When the file grows past the limit the content moves to a tmpfile() and all
+ * further access is forwarded to it, so big temporary files do not exhaust memory.
+ * Asking for the position is safe from another thread while the owner reads or writes.
+ */
+class MemoryFile_t final {
+public:
+  /**
+   * Open a temporary file in memory
+   * @param limit Maximum size kept in memory, in bytes
+   * @return The opened stream, or nullptr on failure
+   */
+  [[nodiscard]] static auto Open(const int64_t limit) noexcept -> FILE* {
+    auto* const file{new MemoryFile_t(limit)};
+    FILE* const stream{fopencookie(file, "wb+", {Read, Write, Seek, Close})};
+    if (nullptr == stream) {
+      delete file;
+      return nullptr;
+    }
+    setvbuf(stream, nullptr, _IOFBF, BUFFER_SIZE);
+    return stream;
+  }
+
+private:
+  explicit MemoryFile_t(const int64_t limit) noexcept : _limit{limit} {}
+
+  ~MemoryFile_t() noexcept {
+    if (nullptr != _spill) {
+      fclose(_spill);
+    }
+  }
+
+  MemoryFile_t(const MemoryFile_t& other) = delete;
+  MemoryFile_t(MemoryFile_t&& other) = delete;
+  MemoryFile_t& operator=(const MemoryFile_t& other) = delete;
+  MemoryFile_t& operator=(MemoryFile_t&& other) = delete;
+
+  static auto Read(void* const cookie, char* const data, const size_t size) noexcept -> ssize_t {
+    auto* const file{static_cast<MemoryFile_t*>(cookie)};
+    const auto pos{file->_pos.load(std::memory_order_relaxed)};
+    if (nullptr != file->_spill) {
+      const auto n{fread_unlocked(data, sizeof(char), size, file->_spill)};
+      file->_pos.store(pos + static_cast<int64_t>(n), std::memory_order_relaxed);
+      return static_cast<ssize_t>(n);
+    }
+    const auto length{static_cast<int64_t>(file->_data.size())};
+    const auto n{(pos < length) ? (std::min)(static_cast<int64_t>(size), length - pos) : INT64_C(0)};
+    memcpy(data, file->_data.data() + pos, static_cast<size_t>(n));
+    file->_pos.store(pos + n, std::memory_order_relaxed);
+    return static_cast<ssize_t>(n);
+  }
+
+  static auto Write(void* const cookie, const char* const data, const size_t size) noexcept -> ssize_t {
+    auto* const file{static_cast<MemoryFile_t*>(cookie)};
+    const auto pos{file->_pos.load(std::memory_order_relaxed)};
+    const auto end{pos + static_cast<int64_t>(size)};
+    if ((nullptr == file->_spill) && (end > file->_limit)) {
+      file->Spill();
+    }
+    if (nullptr != file->_spill) {
+      const auto n{fwrite_unlocked(data, sizeof(char), size, file->_spill)};
+      file->_pos.store(pos + static_cast<int64_t>(n), std::memory_order_relaxed);
+      return static_cast<ssize_t>(n);
+    }
+    if (end > static_cast<int64_t>(file->_data.size())) {
+      file->_data.resize(static_cast<size_t>(end));
+    }
+    memcpy(file->_data.data() + pos, data, size);
+    file->_pos.store(end, std::memory_order_relaxed);
+    return static_cast<ssize_t>(size);
+  }
+
+  static auto Seek(void* const cookie, off64_t* const offset, const int whence) noexcept -> int {
+    auto* const file{static_cast<MemoryFile_t*>(cookie)};
+    if ((SEEK_CUR == whence) && (0 == *offset)) {  // Tell, may come from the progress thread (ftello), touches nothing
+      *offset = file->_pos.load(std::memory_order_relaxed);
+      return 0;
+    }
+    if (nullptr != file->_spill) {
+      if (0 != fseeko64(file->_spill, *offset, whence)) {
+        return -1;
+      }
+      *offset = ftello64(file->_spill);
+      file->_pos.store(*offset, std::memory_order_relaxed);
+      return 0;
+    }
+    int64_t position{*offset};
+    if (SEEK_CUR == whence) {
+      position += file->_pos.load(std::memory_order_relaxed);
+    } else if (SEEK_END == whence) {
+      position += static_cast<int64_t>(file->_data.size());
+    }
+    if (position < 0) {
+      return -1;
+    }
+    file->_pos.store(position, std::memory_order_relaxed);
+    *offset = position;
+    return 0;
+  }
+
+  static auto Close(void* const cookie) noexcept -> int {
+    delete static_cast<MemoryFile_t*>(cookie);
+    return 0;
+  }
+
+  /**
+   * Move the content to a real temporary file, continue there
+   */
+  void Spill() noexcept {
+    _spill = std::tmpfile();
+    if (nullptr == _spill) {
+      fprintf(stderr, "Cannot open temporary file\n");
+      exit(EXIT_FAILURE);
+    }
+    fwrite_unlocked(_data.data(), sizeof(char), _data.size(), _spill);
+    fseeko64(_spill, _pos.load(std::memory_order_relaxed), SEEK_SET);
+    std::vector<char>().swap(_data);
+  }
+
+  static constexpr size_t BUFFER_SIZE{UINT32_C(1) << 16};
+
+  const int64_t _limit;
+  std::atomic<int64_t> _pos{0};  // Also kept while spilled, the progress thread asks for it
+  FILE* _spill{nullptr};
+  std::vector<char> _data{};
+};
+#endif  // defined(__linux__)
+
 /**
  * @class File_t
  * @brief General file handling for fast reading and writing
  *
- * General file handling for fast reading and writing
+ * General file handling for fast reading and writing.
+ * Files opened read only are memory mapped (when supported), reading and positioning is then
+ * done on the view. Any direct use of the stream (FILE*) detaches the view after synchronizing
+ * the stream position, the next Seek() attaches the view again.
+ * Files opened for writing get a large stream buffer.
+ * The path "-" selects stdin (read mode) or stdout (write mode).
  */
 class File_t final {
 public:
@@ -84,11 +235,30 @@ public:
   explicit File_t() noexcept : File_t(getTempFileLocation().c_str(), _mode) {}
 #endif
 
-  explicit File_t(const char* const path, const std::string& mode) noexcept : _stream{path ? fopen(path, mode.c_str()) : std::tmpfile()} {
+  explicit File_t(const char* const path, const std::string& mode) noexcept : _stream{path ? Open(path, mode) : OpenTemporary()} {
     if (nullptr == _stream) {
       fprintf(stderr, "Cannot open file '%s'\n", path ? path : "<nullptr>");
       exit(EXIT_FAILURE);
     }
+    if ((nullptr != path) && ("rb" == mode)) {
+      Map();
+    } else if ((std::string::npos != mode.find_first_of("wa")) && (fileno_unlocked(_stream) >= 0)) {
+      setvbuf(_stream, nullptr, _IOFBF, WRITE_BUFFER_SIZE);
+#if defined(__linux__)
+      posix_fadvise(fileno_unlocked(_stream), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    }
+  }
+
+  /**
+   * Take ownership of an already opened stream, e.g. from fmemopen() or fopencookie()
+   * @param stream The opened stream, closed on destruction
+   */
+  explicit File_t(FILE* const stream) noexcept : _stream{stream} {
+    if (nullptr == _stream) {
+      fprintf(stderr, "Cannot open stream\n");
+      exit(EXIT_FAILURE);
+    }
   }
 
   ~File_t() noexcept {
@@ -99,18 +269,35 @@ public:
   File_t(const File_t&& orig) = delete;
   auto operator=(const File_t&& orig) -> File_t& = delete;
 
-  constexpr operator FILE*() const noexcept {
+  /**
+   * Set the size up to which temporary files are kept in memory
+   * @param limit Size in bytes, zero keeps all temporary files on disk
+   */
+  static void TemporaryLimit(const int64_t limit) noexcept {
+    _tmp_limit = limit;
+  }
+
+  operator FILE*() const noexcept {
+    Detach();
     return _stream;
   }
 
   auto operator=(FILE* stream) noexcept -> File_t& {
     _stream = stream;
+    _map = nullptr;  // Ownership of a mapping is not transferred to an other stream
+    _view = nullptr;
+    _size = 0;
+    _pos = 0;
     return *this;
   }
 
   auto operator=(const File_t& source) noexcept -> File_t& {
     if (this != &source) {  // self-assignment check
       _stream = source._stream;
+      _map = source._map;
+      _view = source._view;
+      _size = source._size;
+      _pos = source._pos;
     }
     return *this;
   }
@@ -119,12 +306,31 @@ public:
     return nullptr != _stream;
   }
 
+  /**
+   * @return True when the file is mapped into memory (see Map()), false otherwise
+   */
+  [[nodiscard]] constexpr auto isMapped() const noexcept -> bool {
+    return nullptr != _map;
+  }
+
   /**
    * Get size of file
    * @return The size of file
    */
   [[nodiscard]] auto Size() const noexcept -> int64_t {
+    if (nullptr != _map) {
+      return _size;
+    }
     Flush();  // Mandatory to flush first!
+#if !defined(_MSC_VER)
+    if (fileno_unlocked(_stream) < 0) {  // Memory stream, there is no file descriptor
+      const auto position{Position()};
+      fseeko(_stream, 0, SEEK_END);
+      const auto size{Position()};
+      Seek(position);
+      return size;
+    }
+#endif
 #if defined(__CYGWIN__) || defined(__APPLE__)
     struct stat fileInfo;
     fstat(fileno_unlocked(_stream), &fileInfo);
@@ -143,6 +349,9 @@ public:
    * @return The current position in file
    */
   [[nodiscard]] auto Position() const noexcept -> int64_t {
+    if (nullptr != _view) {
+      return _pos;
+    }
 #if defined(__CYGWIN__)
     return ftell(_stream);
 #elif !defined(__linux__) && !defined(__APPLE__) && defined(_MSC_VER)
@@ -160,14 +369,15 @@ public:
   }
 
   auto Seek(const int64_t offset) const noexcept -> int32_t {
-#if defined(__APPLE__)
-    return fseeko(_stream, offset, SEEK_SET);
-#elif defined(__linux__)
-    return fseeko64(_stream, offset, SEEK_SET);
-#else
-    const fpos_t pos{offset};
-    return fsetpos(_stream, &pos);
-#endif
+    if (nullptr != _map) {
+      if ((offset < 0) || (offset > _size)) {
+        return -1;
+      }
+      _view = _map;  // Attach (again)
+      _pos = offset;
+      return 0;
+    }
+    return StreamSeek(offset);
   }
 
   auto Rewind() const noexcept -> int32_t {
@@ -185,13 +395,38 @@ public:
   }
 
   void Close() noexcept {
+#if defined(FILE_MAPPING)
+    if (nullptr != _map) {
+      munmap(_map, static_cast<size_t>(_size));
+    }
+#endif
+    _map = nullptr;
+    _view = nullptr;
     if (_stream) {
       fclose(_stream);
       _stream = nullptr;
     }
   }
 
+  /**
+   * Read the next byte without consuming it
+   * @return The next byte or EOF
+   */
+  [[nodiscard]] auto Peek() const noexcept -> int32_t {
+    if (nullptr != _view) {
+      return (_pos < _size) ? _view[_pos] : EOF;
+    }
+    const auto ch{getc()};
+    if (EOF != ch) {
+      ungetc(ch, _stream);
+    }
+    return ch;
+  }
+
   [[nodiscard]] ALWAYS_INLINE auto getc() const noexcept -> int32_t {
+    if (nullptr != _view) {
+      return (_pos < _size) ? _view[_pos++] : EOF;
+    }
 #if defined(__APPLE__)
     return ::getc(_stream);
 #else
@@ -208,10 +443,11 @@ public:
   }
 
   [[nodiscard]] auto get32() const noexcept -> uint32_t {
-    return static_cast<uint32_t>(getc() << 24) |  //
-           static_cast<uint32_t>(getc() << 16) |  //
-           static_cast<uint32_t>(getc() << 8) |   //
-           static_cast<uint32_t>(getc());
+    uint32_t value{0};
+    for (auto n{4}; n-- > 0;) {  // One read after the other, EOF reads as 0xFF (as the decoder does past the end)
+      value = (value << 8) | static_cast<uint32_t>(getc() & 0xFF);
+    }
+    return value;
   }
 
   void put32(const uint32_t value) const noexcept {
@@ -244,6 +480,12 @@ public:
   }
 
   auto Read(void* const data, const size_t size) const noexcept -> size_t {
+    if (nullptr != _view) {
+      const auto n{static_cast<size_t>((std::min)(static_cast<int64_t>(size), _size - _pos))};
+      memcpy(data, _view + _pos, n);
+      _pos += static_cast<int64_t>(n);
+      return n;
+    }
     return fread_unlocked(data, sizeof(char), size, _stream);
   }
 
@@ -251,8 +493,175 @@ public:
     return fwrite_unlocked(data, sizeof(char), size, _stream);
   }
 
+  /**
+   * Read at an absolute position, without using or moving the stream position.
+   * Can be used by several threads at the same time, Flush() pending writes first.
+   * @param data Destination of the read bytes
+   * @param size Number of bytes to read
+   * @param offset Absolute position in the file
+   * @return Number of bytes read
+   */
+  auto ReadAt(void* const data, const size_t size, const int64_t offset) const noexcept -> size_t {
+    if (nullptr != _map) {
+      const auto n{(offset < _size) ? static_cast<size_t>((std::min)(static_cast<int64_t>(size), _size - offset)) : size_t{0}};
+      memcpy(data, _map + offset, n);
+      return n;
+    }
+#if !defined(_WIN32) && !defined(_WIN64)
+    if (fileno_unlocked(_stream) < 0) {  // Memory stream, there is no file descriptor, serialize on the stream lock
+      flockfile(_stream);
+      const auto position{Position()};
+      const auto n{(0 == Seek(offset)) ? Read(data, size) : size_t{0}};
+      Seek(position);
+      funlockfile(_stream);
+      return n;
+    }
+#endif
+    auto* dst{static_cast<uint8_t*>(data)};
+    size_t done{0};
+    while (done < size) {
+#if defined(_WIN32) || defined(_WIN64)
+      OVERLAPPED overlapped{};
+      overlapped.Offset = static_cast<DWORD>(static_cast<uint64_t>(offset) + done);
+      overlapped.OffsetHigh = static_cast<DWORD>((static_cast<uint64_t>(offset) + done) >> 32);
+      DWORD n{0};
+      const auto handle{reinterpret_cast<HANDLE>(_get_osfhandle(fileno_unlocked(_stream)))};
+      if (!ReadFile(handle, dst + done, static_cast<DWORD>(size - done), &n, &overlapped) || (0 == n)) {
+        break;
+      }
+#elif defined(__linux__)
+      const auto n{pread64(fileno_unlocked(_stream), dst + done, size - done, offset + static_cast<int64_t>(done))};
+      if (n <= 0) {
+        break;
+      }
+#else
+      const auto n{pread(fileno_unlocked(_stream), dst + done, size - done, static_cast<off_t>(offset + static_cast<int64_t>(done)))};
+      if (n <= 0) {
+        break;
+      }
+#endif
+      done += static_cast<size_t>(n);
+    }
+    return done;
+  }
+
+  /**
+   * Write at an absolute position, without using or moving the stream position.
+   * Can be used by several threads at the same time (on different parts of the file).
+   * @param data Source of the bytes to write
+   * @param size Number of bytes to write
+   * @param offset Absolute position in the file
+   * @return Number of bytes written
+   */
+  auto WriteAt(const void* const data, const size_t size, const int64_t offset) const noexcept -> size_t {
+#if !defined(_WIN32) && !defined(_WIN64)
+    if (fileno_unlocked(_stream) < 0) {  // Memory stream, there is no file descriptor, serialize on the stream lock
+      flockfile(_stream);
+      const auto position{Position()};
+      const auto n{(0 == Seek(offset)) ? Write(data, size) : size_t{0}};
+      Seek(position);
+      funlockfile(_stream);
+      return n;
+    }
+#endif
+    const auto* src{static_cast<const uint8_t*>(data)};
+    size_t done{0};
+    while (done < size) {
+#if defined(_WIN32) || defined(_WIN64)
+      OVERLAPPED overlapped{};
+      overlapped.Offset = static_cast<DWORD>(static_cast<uint64_t>(offset) + done);
+      overlapped.OffsetHigh = static_cast<DWORD>((static_cast<uint64_t>(offset) + done) >> 32);
+      DWORD n{0};
+      const auto handle{reinterpret_cast<HANDLE>(_get_osfhandle(fileno_unlocked(_stream)))};
+      if (!WriteFile(handle, src + done, static_cast<DWORD>(size - done), &n, &overlapped) || (0 == n)) {
+        break;
+      }
+#elif defined(__linux__)
+      const auto n{pwrite64(fileno_unlocked(_stream), src + done, size - done, offset + static_cast<int64_t>(done))};
+      if (n <= 0) {
+        break;
+      }
+#else
+      const auto n{pwrite(fileno_unlocked(_stream), src + done, size - done, static_cast<off_t>(offset + static_cast<int64_t>(done)))};
+      if (n <= 0) {
+        break;
+      }
+#endif
+      done += static_cast<size_t>(n);
+    }
+    return done;
+  }
+
 private:
   static constexpr char _mode[6]{"wb+TD"};
+  static constexpr int WRITE_BUFFER_SIZE{1 << 20};
+  static inline int64_t _tmp_limit{INT64_C(64) << 20};  // Temporary files up to 64 MiB are kept in memory
+
+  [[nodiscard]] static auto Open(const char* const path, const std::string& mode) noexcept -> FILE* {
+    if (!strcmp(path, "-")) {
+      FILE* const stream{('r' == mode[0]) ? stdin : stdout};
+#if (defined(_WIN32) || defined(_WIN64)) && !defined(__CYGWIN__)
+      _setmode(_fileno(stream), _O_BINARY);
+#endif
+      return stream;
+    }
+    return fopen(path, mode.c_str());
+  }
+
+  [[nodiscard]] static auto OpenTemporary() noexcept -> FILE* {
+#if defined(__linux__)
+    if (_tmp_limit > 0) {
+      if (FILE* const stream{MemoryFile_t::Open(_tmp_limit)}; nullptr != stream) {
+        return stream;
+      }
+    }
+#endif
+    return std::tmpfile();
+  }
+
+  /**
+   * Map a read only file into memory, on failure the stream is used as is
+   */
+  void Map() noexcept {
+#if defined(FILE_MAPPING)
+    const auto size{Size()};
+    if (size > 0) {
+      const auto fd{fileno_unlocked(_stream)};
+      if (void* const map{mmap(nullptr, static_cast<size_t>(size), PROT_READ, MAP_PRIVATE, fd, 0)}; MAP_FAILED != map) {
+        madvise(map, static_cast<size_t>(size), MADV_SEQUENTIAL);
+        _map = static_cast<uint8_t*>(map);
+        _view = _map;
+        _size = size;
+        _pos = 0;
+      }
+    }
+#endif
+  }
+
+  /**
+   * Hand over positioning to the stream, it is used directly (e.g. by fseek or gzip)
+   */
+  void Detach() const noexcept {
+    if (nullptr != _view) {
+      _view = nullptr;
+      StreamSeek(_pos);
+    }
+  }
+
+  auto StreamSeek(const int64_t offset) const noexcept -> int32_t {
+#if defined(__APPLE__)
+    return fseeko(_stream, offset, SEEK_SET);
+#elif defined(__linux__)
+    return fseeko64(_stream, offset, SEEK_SET);
+#else
+    const fpos_t pos{offset};
+    return fsetpos(_stream, &pos);
+#endif
+  }
 
   FILE* _stream;
+  uint8_t* _map{nullptr};                 // Memory mapped file, or nullptr
+  mutable const uint8_t* _view{nullptr};  // Set to _map when reading from the mapping
+  int64_t _size{0};                       // Size of the mapped file
+  mutable int64_t _pos{0};                // Position in the mapped file
 };
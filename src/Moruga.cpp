@@ -27,8 +27,11 @@
  * https://github.com/the-m-master/Moruga
  */
 #include <getopt.h>
+#include <zlib.h>
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <bit>
 #include <cassert>
 #include <chrono>
 #include <cinttypes>
@@ -44,24 +47,26 @@
 #include <new>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <tuple>
 #include <utility>
+#include <vector>
+#include "Arena.h"
 #include "Buffer.h"
+#include "Dedup.h"
 #include "File.h"
 #include "IntegerXXL.h"
+#include "Moruga.h"
+#include "Profile.h"
 #include "Progress.h"
+#include "Simd.h"
 #include "TxtPrep5.h"
 #include "Utilities.h"
 #include "filters/filter.h"
+#include "filters/gzip.h"
 #include "iEncoder.h"
 #include "iMonitor.h"
 
-#if defined(__x86_64__)
-#  include <emmintrin.h>
-#  include <immintrin.h>
-#  include <mmintrin.h>
-#endif
-
 #if defined(_WIN32) || defined(_WIN64)
 #  include <processthreadsapi.h>
 #  include <psapi.h>
@@ -74,31 +79,44 @@
 namespace {
   using namespace std::literals;
 
-  int32_t level_{DEFAULT_OPTION};  // Compression level 0 to 12
+  enum class ModelSet : uint32_t {
+    Full,  // All models
+    Fast,  // --fast-model, without DMC, SMM and the APM chain after _a1
+    SIZE
+  };
 
-  auto MEM(const int32_t offset = 22) noexcept -> uint64_t {
-    return UINT64_C(1) << (offset + level_);
-  }
+  /**
+   * @struct Options_t
+   * @brief Settings of one compression or decompression
+   *
+   * Settings of one compression or decompression, passed down instead of kept global so the library can run several at the same time
+   */
+  struct Options_t final {
+    [[nodiscard]] auto MEM(const int32_t offset = 22) const noexcept -> uint64_t {
+      return UINT64_C(1) << (offset + level);
+    }
+
+    const char* in_file_name{nullptr};   // "-" is stdin
+    const char* out_file_name{nullptr};  // "-" is stdout
+    int64_t block_size{0};               // Block size in MiB in block mode, 0 when derived from the number of threads
+    int32_t level{DEFAULT_OPTION};       // Compression level 0 to 12
+    ModelSet model_set{ModelSet::Full};  // Topology of Predict_t, stored in the memory level byte
+    int32_t threads{0};                  // Number of worker threads in block mode, 0 when block mode is off
+    bool dedup{false};                   // Replace repeated chunks by references before compressing
+    bool bypass{true};                   // Code incompressible data and long runs without the models (Bypass_t, Run_t), off in files of the original format
+    int32_t : 16;                        // Padding
+  };
 
   // Global variables
   int32_t verbose_{0};  // Set during application parameter parsing (not change during activity)
-  uint32_t bcount_{7};  // Bit processed (7..0) bcount_=7-bpos
-  uint32_t c0_{1};      // Last 0-7 bits of the partial byte with a leading 1 bit (1-255)
-  uint32_t c1_{0};      // Last two higher 4-bit nibbles
-  uint32_t c2_{0};      // Last two higher 4-bit nibbles
-  uint64_t cx_{0};      // Last 8 whole bytes (buf(8)..buf(1)), packed
-  uint64_t word_{0};    // checksum of last 0..9, a..z and A..Z, reset to zero otherwise
-  uint32_t fails_{0};   //
-  uint32_t tt_{0};      //
-  uint32_t w5_{0};      //
-  uint32_t x5_{0};      //
-
-  const char* inFileName_{nullptr};
-  const char* outFileName_{nullptr};
+
+  // Files of the (de)compression running on this thread, only for messages
+  thread_local const char* inFileName_{"<input>"};
+  thread_local const char* outFileName_{"<output>"};
 
   // #define DEBUG_WRITE_ANALYSIS_ENCODER
+  // #define DISABLE_PREFETCH
   // #define DISABLE_TEXT_PREP
-  // #define ENABLE_INTRINSICS
   // #define GENERATE_SQUASH_STRETCH
   // #define TUNING
 
@@ -171,11 +189,6 @@ namespace {
     return tmp.data();
   }
 
-  int32_t dp_shift_{14};
-
-  std::array<std::array<int32_t, 256>, 12> smt_;
-  std::array<uint32_t, 5> hh_{{0, 0, 0, 0, 0}};
-
   constexpr std::array<const std::array<const uint8_t, 256>, 6> state_table_y0_              //
       {{{{1,   3,   4,   7,   8,   9,   11,  15,  16,  17,  18,  20,  21,  22,  26,  31,     // 00-0F . . . . . . . . . . . . . . . .
           32,  32,  32,  32,  34,  34,  34,  34,  34,  34,  36,  36,  36,  36,  38,  41,     // 10-1F . . . . . . . . . . . . . . . .
@@ -445,6 +458,87 @@ auto GetOutFileName() noexcept -> const char* {
   return outFileName_;
 }
 
+/**
+ * @struct Context_t
+ * @brief Model state of one compression
+ *
+ * Model state of one compression, shared by Predict_t and all its models.
+ * Each Predict_t owns its own Context_t, so independent compressions can run in parallel.
+ */
+struct Context_t final {
+  static constexpr uint32_t N_LAYERS{9};  // Number of neurons in the input layer of the mixer
+
+  explicit Context_t(const int32_t memory_level) noexcept : level{memory_level} {
+    std::fill(&smt[0][0], &smt[0][0] + sizeof(smt) / sizeof(smt[0][0]), 0x07FFFF);
+
+    for (uint32_t i{6}; i-- > 0;) {
+      int32_t* j{&smt[0xF & (0x578046 >> (i * 4))][0]};
+      uint8_t p1{state_table_y0_[i][0]};
+      uint8_t p2{state_table_y0_[i][0]};
+      uint8_t p3{state_table_y1_[i][0]};
+      uint8_t p4{state_table_y1_[i][0]};
+      p1 = state_table_y0_[i][p1];
+      j[p1] = (0xFFFFF * 1) / 4;
+      p2 = state_table_y1_[i][p2];
+      j[p2] = (0xFFFFF * 2) / 4;
+      p3 = state_table_y0_[i][p3];
+      j[p3] = (0xFFFFF * 2) / 4;
+      p4 = state_table_y1_[i][p4];
+      j[p4] = (0xFFFFF * 3) / 4;
+      uint8_t p5{p4};
+      uint8_t p6{p1};
+      for (auto z{5}; z < 70; ++z) {
+        uint8_t px;
+        // clang-format off
+        px = p1; p1 = state_table_y0_[i][p1];                           if (p1 != px) { j[p1] = (0xFFFFF * (    1)) / z; }
+        px = p2; p2 = state_table_y1_[i][p2];                           if (p2 != px) { j[p2] = (0xFFFFF * (z - 2)) / z; }
+        px = p3; p3 = state_table_y0_[i][p3];                           if (p3 != px) { j[p3] = (0xFFFFF * (    2)) / z; }
+        px = p4; p4 = state_table_y1_[i][p4];                           if (p4 != px) { j[p4] = (0xFFFFF * (z - 1)) / z; }
+        px = p5; p5 = state_table_y0_[i][p5]; if (p5 < px) { p5 = px; } if (p5 != px) { j[p5] = (0xFFFFF * (    3)) / z; }
+        px = p6; p6 = state_table_y1_[i][p6]; if (p6 < px) { p6 = px; } if (p6 != px) { j[p6] = (0xFFFFF * (z - 3)) / z; }
+        // clang-format on
+      }
+    }
+
+    memcpy(&smt[0x1], &smt[0x0], smt[0x0].size());
+    memcpy(&smt[0x2], &smt[0x0], smt[0x0].size());
+    memcpy(&smt[0x3], &smt[0x0], smt[0x0].size());
+    memcpy(&smt[0x9], &smt[0x8], smt[0x8].size());
+    memcpy(&smt[0xA], &smt[0x7], smt[0x7].size());
+    memcpy(&smt[0xB], &smt[0x7], smt[0x7].size());
+  }
+  ~Context_t() noexcept = default;
+
+  Context_t() = delete;
+  Context_t(const Context_t&) = delete;
+  Context_t(Context_t&&) = delete;
+  auto operator=(const Context_t&) -> Context_t& = delete;
+  auto operator=(Context_t&&) -> Context_t& = delete;
+
+  [[nodiscard]] auto MEM(const int32_t offset = 22) const noexcept -> uint64_t {
+    return UINT64_C(1) << (offset + level);
+  }
+
+  alignas(32) std::array<int32_t, N_LAYERS> tx{};  // Inputs of the mixer, range -2048..2047
+  const int32_t level;                             // Compression level 0 to 12
+  uint64_t cx{0};                                  // Last 8 whole bytes (buf(8)..buf(1)), packed
+  uint64_t word{0};                                // checksum of last 0..9, a..z and A..Z, reset to zero otherwise
+  uint32_t bcount{7};                              // Bit processed (7..0) bcount=7-bpos
+  uint32_t c0{1};                                  // Last 0-7 bits of the partial byte with a leading 1 bit (1-255)
+  uint32_t c1{0};                                  // Last two higher 4-bit nibbles
+  uint32_t c2{0};                                  // Last two higher 4-bit nibbles
+  uint32_t fails{0};                               //
+  uint32_t tt{0};                                  //
+  uint32_t w5{0};                                  //
+  uint32_t x5{0};                                  //
+  int32_t dp_shift{14};
+  std::array<uint32_t, 5> hh{};
+  std::array<uint8_t* __restrict, 5> cp{};
+  std::array<std::array<int32_t, 256>, 12> smt{};
+  int32_t : 32;  // Padding
+  int32_t : 32;  // Padding
+};
+
 /**
  * @class APM_t
  * @brief Adaptive probability maps (APM)
@@ -456,7 +550,7 @@ public:
   explicit APM_t(const uint64_t n, const uint32_t scale, const uint32_t start) noexcept
       : N{(n * 24) + 1},  //
         _mask{static_cast<uint32_t>(n - 1)},
-        _map{static_cast<Map_t*>(std::calloc(N, sizeof(Map_t)))} {
+        _map{static_cast<Map_t*>(Arena::Allocate(N, sizeof(Map_t)))} {
     assert(ISPOWEROF2(n));
     if (verbose_) {
       fprintf(stdout, "%s for APM_t\n", GetDimension(N * sizeof(Map_t)).c_str());
@@ -553,40 +647,22 @@ private:
   Map_t* const __restrict _map;      // ctx -> prediction
 };
 APM_t::~APM_t() noexcept {
-  std::free(_map);
+  Arena::Free(_map);
 }
 
-#if defined(ENABLE_INTRINSICS) && defined(__x86_64__)
-
-// https://gcc.gnu.org/onlinedocs/gcc/Vector-Extensions.html
-// https://www.intel.com/content/www/us/en/docs/intrinsics-guide/index.html#
-
-union Exchange_t final {
-  explicit Exchange_t(const int16_t* const __restrict p) noexcept : i16{p} {}
-  explicit Exchange_t(const int32_t* const __restrict p) noexcept : i32{p} {}
-  const int16_t* const __restrict i16;
-  const int32_t* const __restrict i32;
-  __m64* const __restrict m64;     // __MMX__
-  __m128i* const __restrict m128;  // __SSE2__
-  __v8si* const __restrict i32x8;  // __AVX__
-};
-
-#endif  // ENABLE_INTRINSICS
-
 /**
  * @class Mixer_t
  * @brief Combines models using a neural network
  *
- * Combines models using a neural network (using intrinsics functions if available)
+ * Combines models using a neural network (using the SIMD kernels of the CPU in use)
  */
 class Mixer_t final {
 public:
-  static constexpr uint32_t N_LAYERS{9};  // Number of neurons in the input layer
+  static constexpr uint32_t N_LAYERS{Context_t::N_LAYERS};  // Number of neurons in the input layer
+  static_assert(Simd::MIXER_INPUTS == N_LAYERS, "Inputs of the SIMD kernels");
 
-  static std::array<int32_t, N_LAYERS> tx_;
-
-  Mixer_t() noexcept {
-    tx_.fill(0);
+  explicit Mixer_t(Context_t& context) noexcept : _context{context} {
+    _context.tx.fill(0);
     wx_.fill(0xA00);
   }
 
@@ -599,12 +675,12 @@ public:
 
   void Update(const int32_t err) noexcept {
     assert((err + 4096) < 8192);
-    train(&tx_[0], &wx_[ctx_], err);
+    train(&_context.tx[0], &wx_[ctx_], err);
   }
 
   [[nodiscard]] auto Predict() noexcept -> int32_t {
-    const auto sum{dot_product(&tx_[0], &wx_[ctx_])};
-    const auto pr{sum / (1 << dp_shift_)};
+    const auto sum{dot_product(&_context.tx[0], &wx_[ctx_])};
+    const auto pr{sum / (1 << _context.dp_shift)};
     return clamp12(pr);
   }
 
@@ -620,84 +696,38 @@ public:
 
 private:
   void train(const int32_t* const __restrict t, int32_t* const __restrict w, const int32_t err) const noexcept {
-#if defined(ENABLE_INTRINSICS) && defined(__AVX__) && defined(__x86_64__)
-    if (7 & ctx_) {
-      const auto* __restrict tt{t};
-      auto* __restrict ww{w};
-      for (auto n{N_LAYERS}; n-- > 0;) {
-        *ww++ += (((*tt++ * err) >> 13) + 1) >> 1;
-      }
-    } else {
-      const Exchange_t tt{t};
-      Exchange_t ww{w};
-      *ww.i32x8 += (((*tt.i32x8 * err) >> 13) + 1) >> 1;  // ww[0..7] += (((tt[0..7] * err) >> 13) + 1) >> 1
-      w[8] += (((t[8] * err) >> 13) + 1) >> 1;
-    }
-#else
-    const auto* __restrict tt{t};
-    auto* __restrict ww{w};
-    for (auto n{N_LAYERS}; n-- > 0;) {
-      *ww++ += (((*tt++ * err) >> 13) + 1) >> 1;
-    }
-#endif
+    Simd::kernels_.mixer_train(t, w, err);
   }
 
   [[nodiscard]] auto dot_product(const int32_t* const __restrict t, const int32_t* const __restrict w) const noexcept -> int32_t {
-    int32_t sum{0};
-#if defined(ENABLE_INTRINSICS) && defined(__AVX__) && defined(__x86_64__)
-    if (7 & ctx_) {
-      const auto* __restrict tt{t};
-      const auto* __restrict ww{w};
-      for (auto n{N_LAYERS}; n-- > 0;) {
-        sum += *ww++ * *tt++;
-      }
-    } else {
-      const Exchange_t tt{t};
-      const Exchange_t ww{w};
-      const auto x{*ww.i32x8 * *tt.i32x8};
-      for (auto n{N_LAYERS - 1}; n-- > 0;) {
-        sum += x[n];
-      }
-      sum += w[8] * t[8];
-    }
-#else
-    const auto* __restrict tt{t};
-    const auto* __restrict ww{w};
-    for (auto n{N_LAYERS}; n-- > 0;) {
-      sum += *ww++ * *tt++;
-    }
-#endif
-    return sum;
+    return Simd::kernels_.mixer_dot(t, w);
   }
 
   alignas(32) std::array<int32_t, N_LAYERS * 1280> wx_{};
 
+  Context_t& _context;
   uint32_t ctx_{0};
   int32_t : 32;  // Padding
   int32_t : 32;  // Padding
   int32_t : 32;  // Padding
   int32_t : 32;  // Padding
   int32_t : 32;  // Padding
-  int32_t : 32;  // Padding
-  int32_t : 32;  // Padding
 };
 
-alignas(32) std::array<int32_t, Mixer_t::N_LAYERS> Mixer_t::tx_;  // Range -2048..2047
-
 /**
  * @class Blend_t
  * @brief Combines predictions using a neural network
  *
- * Combines predictions using a neural network (using intrinsics functions if available)
+ * Combines predictions using a neural network (using the SIMD kernels of the CPU in use)
  */
 template <const uint32_t N_LAYERS>
 class Blend_t final {
-  static_assert(ISPOWEROF2(N_LAYERS), "Number of layers must be a power of two");
+  static_assert((4 == N_LAYERS) || (8 == N_LAYERS), "Number of layers must be 4 or 8 (see Simd::Kernels_t)");
 
 public:
   explicit Blend_t(const uint32_t n, const int16_t weight) noexcept
       : _mask{n - 1},  //
-        _weights{static_cast<int16_t*>(std::calloc(n * N_LAYERS, sizeof(int16_t)))} {
+        _weights{static_cast<int16_t*>(Arena::Allocate(n * N_LAYERS, sizeof(int16_t)))} {
     assert(ISPOWEROF2(n));
     assert((2 * N_LAYERS) <= _pi.size());
     if (verbose_) {
@@ -709,7 +739,7 @@ public:
   }
 
   virtual ~Blend_t() noexcept {
-    std::free(_weights);
+    Arena::Free(_weights);
   }
 
   Blend_t() = delete;
@@ -735,64 +765,21 @@ public:
   }
 
 private:
-  void train(const int16_t* const __restrict t, int16_t* const __restrict w, const int32_t err_) const noexcept {
-    assert((err_ >= SHRT_MIN) && (err_ <= SHRT_MAX));
-#if defined(ENABLE_INTRINSICS) && defined(__SSE2__) && defined(__x86_64__)
-    const Exchange_t tt{t};
-    Exchange_t ww{w};
+  void train(const int16_t* const __restrict t, int16_t* const __restrict w, const int32_t err) const noexcept {
+    assert((err >= SHRT_MIN) && (err <= SHRT_MAX));
     if constexpr (4 == N_LAYERS) {
-      const auto one{_mm_set1_pi16(1)};                            //
-      const auto err{_mm_set1_pi16(static_cast<int16_t>(err_))};   //
-      auto var{_mm_mulhi_pi16(*tt.m64, err)};                      //              (t[0..3] * err) >> 16
-      var = _mm_adds_pi16(var, one);                               //             ((t[0..3] * err) >> 16) + 1
-      var = _mm_srai_pi16(var, 1);                                 //            (((t[0..3] * err) >> 16) + 1) >> 1
-      *ww.m64 = _mm_adds_pi16(*ww.m64, var);                       // w[0..3] + ((((t[0..3] * err) >> 16) + 1) >> 1)
-      _mm_empty();                                                 //
-    } else {                                                       //
-      const auto one{_mm_set1_epi16(1)};                           //
-      const auto err{_mm_set1_epi16(static_cast<int16_t>(err_))};  //
-      auto var{_mm_mulhi_epi16(*tt.m128, err)};                    //              (t[0..7] * err) >> 16
-      var = _mm_adds_epi16(var, one);                              //             ((t[0..7] * err) >> 16) + 1
-      var = _mm_srai_epi16(var, 1);                                //            (((t[0..7] * err) >> 16) + 1) >> 1
-      *ww.m128 = _mm_adds_epi16(*ww.m128, var);                    // w[0..7] + ((((t[0..7] * err) >> 16) + 1) >> 1)
-    }
-#else
-    const auto* __restrict tt{t};
-    auto* __restrict ww{w};
-    for (auto n{N_LAYERS}; n-- > 0;) {
-      const int32_t wt{*ww + ((((*tt++ * err_) >> 16) + 1) >> 1)};
-      *ww++ = static_cast<int16_t>(std::clamp(wt, SHRT_MIN, SHRT_MAX));
+      Simd::kernels_.blend4_train(t, w, err);
+    } else {
+      Simd::kernels_.blend8_train(t, w, err);
     }
-#endif
   }
 
   [[nodiscard]] auto dot_product(const int16_t* const __restrict t, const int16_t* const __restrict w) const noexcept -> int32_t {
-#if defined(ENABLE_INTRINSICS) && defined(__SSE2__) && defined(__x86_64__)
-    const Exchange_t tt{t};
-    const Exchange_t ww{w};
     if constexpr (4 == N_LAYERS) {
-      auto dp{_mm_madd_pi16(*tt.m64, *ww.m64)};       // (t[0] * w[0]) + ... + (t[3] * w[3])
-      dp = _mm_add_pi32(dp, _mm_srli_si64(dp, 32));   // Add sums together
-      const auto sum{_mm_cvtsi64_si32(dp)};           // Scale back to integer
-      _mm_empty();                                    //
-      return sum;                                     //
-    } else {                                          //
-      auto dp{_mm_madd_epi16(*tt.m128, *ww.m128)};    // (t[0] * w[0]) + ... + (t[7] * w[7])
-      dp = _mm_add_epi32(dp, _mm_srli_si128(dp, 8));  // Add sums together
-      dp = _mm_add_epi32(dp, _mm_srli_si128(dp, 4));  //
-      const auto sum{_mm_cvtsi128_si32(dp)};          // Scale back to integer
-      return sum;                                     //
-    }
-#else
-    int32_t sum{0};
-    const auto* __restrict tt{t};
-    const auto* __restrict ww{w};
-    for (auto n{N_LAYERS}; n-- > 0;) {
-      assert((*tt >= -2048) && (*tt < 2048));
-      sum += *ww++ * *tt++;
+      return Simd::kernels_.blend4_dot(t, w);
+    } else {
+      return Simd::kernels_.blend8_dot(t, w);
     }
-    return sum;
-#endif
   }
 
   const uint32_t _mask;                       // n-1
@@ -805,6 +792,105 @@ private:
   int16_t* __restrict _prv{&_pi[8]};          // Previous Inputs (alternating between _pi[8] and _pi[0])
 };
 
+/**
+ * @class Blend3x8_t
+ * @brief The Blend_t<8> of DynamicMarkovModel_t, LempelZivPredict_t and SparseMatchModel_t in one
+ *
+ * The three models blend 8 predictions each, using the same context. The weights of the three are
+ * kept side by side in one cache line per context, one call of the SIMD kernels trains or evaluates
+ * all three. The results are identical to three separate Blend_t<8>.
+ */
+class Blend3x8_t final {
+public:
+  enum class Lane : uint32_t {
+    DMC,  // DynamicMarkovModel_t
+    LZP,  // LempelZivPredict_t
+    SMM,  // SparseMatchModel_t
+    SIZE
+  };
+
+  static constexpr uint32_t N_LAYERS{8};                    // Inputs per blend
+  static constexpr uint32_t STRIDE{Simd::BLEND3X8_STRIDE};  // Inputs per context, including the padding
+  static constexpr auto N_LANES{static_cast<uint32_t>(Lane::SIZE)};
+  static_assert(((N_LANES + 1) * N_LAYERS) == STRIDE, "The kernels give a sum per 8 inputs, the last one is padding");
+
+  explicit Blend3x8_t(const uint32_t n, const std::array<int16_t, N_LANES>& weight) noexcept
+      : _weights{static_cast<int16_t*>(Arena::Allocate(n * STRIDE, sizeof(int16_t)))},  //
+        _mask{n - 1} {
+    assert(ISPOWEROF2(n));
+    if (verbose_) {
+      fprintf(stdout, "%s for Blend3x8_t\n", GetDimension(n * STRIDE * sizeof(int16_t)).c_str());
+    }
+    for (auto i{n * STRIDE}; i-- > 0;) {
+      const auto lane{(i % STRIDE) / N_LAYERS};
+      _weights[i] = (lane < N_LANES) ? weight[lane] : 0;  // Padding stays zero
+    }
+  }
+
+  ~Blend3x8_t() noexcept {
+    Arena::Free(_weights);
+  }
+
+  Blend3x8_t() = delete;
+  Blend3x8_t(const Blend3x8_t&) = delete;
+  Blend3x8_t(Blend3x8_t&&) = delete;
+  auto operator=(const Blend3x8_t&) -> Blend3x8_t& = delete;
+  auto operator=(Blend3x8_t&&) -> Blend3x8_t& = delete;
+
+  [[nodiscard]] auto Get(const Lane lane) noexcept -> std::array<int16_t, N_LAYERS>& {
+    return reinterpret_cast<std::array<int16_t, N_LAYERS>&>(_new[N_LAYERS * static_cast<uint32_t>(lane)]);
+  }
+
+  /**
+   * Set the error of the previous prediction of a blend, needed once per bit before Predict()
+   * @param lane The blend
+   * @param err The error
+   */
+  void Error(const Lane lane, const int32_t err) noexcept {
+    // Like Blend_t, only a mismatch trains; an error of zero leaves the weights unchanged
+    const auto mismatch{((std::abs)(err) > 32) ? std::clamp(err, SHRT_MIN, SHRT_MAX) : 0};
+    auto* const errors{&_err[N_LAYERS * static_cast<uint32_t>(lane)]};
+    for (uint32_t i{0}; i < N_LAYERS; ++i) {
+      errors[i] = static_cast<int16_t>(mismatch);
+    }
+    _train |= 0 != mismatch;
+  }
+
+  /**
+   * Train all blends with the errors, then predict all blends
+   * @param context The context shared by the blends
+   * @return Predictions per lane, range -2048..2047
+   */
+  [[nodiscard]] auto Predict(const uint32_t context) noexcept -> const std::array<int32_t, N_LANES + 1>& {
+    if (_train) {
+      _train = false;
+      Simd::kernels_.blend3x8_train(_prv, &_weights[_ctx], _err.data());
+    }
+    _ctx = (context & _mask) * STRIDE;
+    Simd::kernels_.blend3x8_dot(_new, &_weights[_ctx], _px.data());
+    std::swap(_new, _prv);
+    for (auto& px : _px) {
+      px = clamp12(px >> 14);
+    }
+    return _px;
+  }
+
+private:
+  alignas(64) std::array<int16_t, 2 * STRIDE> _pi{};   // Prediction inputs
+  alignas(64) std::array<int16_t, STRIDE> _err{};      // Error per input, the same for all inputs of a blend
+  alignas(16) std::array<int32_t, N_LANES + 1> _px{};  // Predictions (and the padding)
+  int16_t* __restrict _new{&_pi[0]};                   // New Inputs (alternating between _pi[0] and _pi[STRIDE])
+  int16_t* __restrict _prv{&_pi[STRIDE]};              // Previous Inputs (alternating between _pi[STRIDE] and _pi[0])
+  int16_t* const __restrict _weights;                  // Weights, STRIDE per context
+  const uint32_t _mask;                                // n-1
+  uint32_t _ctx{0};                                    // Context of last prediction
+  bool _train{false};                                  // At least one error to train
+  int32_t : 24;                                        // Padding
+  int32_t : 32;                                        // Padding
+  int32_t : 32;                                        // Padding
+  int32_t : 32;                                        // Padding
+};
+
 /**
  * @class HashTable_t
  * @brief Hash table handling
@@ -817,7 +903,7 @@ class HashTable_t final {
 public:
   explicit HashTable_t(const uint64_t max_size) noexcept
       : N{(max_size > MEM_LIMIT) ? MEM_LIMIT : max_size},  //
-        _hashtable{static_cast<Elements_t*>(calloc(N, sizeof(uint8_t)))},
+        _hashtable{static_cast<Elements_t*>(Arena::Allocate(N, sizeof(uint8_t)))},
         _mask{static_cast<uint32_t>((N / UINT64_C(4)) - 1)} {  // 4 is search limit
     assert(ISPOWEROF2(N));
     assert(_hashtable);
@@ -833,6 +919,18 @@ public:
   auto operator=(const HashTable_t&) -> HashTable_t& = delete;
   auto operator=(HashTable_t&&) -> HashTable_t& = delete;
 
+  /**
+   * Fetch the cache line of a slot ahead of its lookup, the lookup itself stays within the cache line
+   * @param i Index as given to get1x(), get3a() or get3b()
+   */
+  ALWAYS_INLINE void Prefetch(const uint32_t i) const noexcept {
+#if !defined(DISABLE_PREFETCH)
+    __builtin_prefetch(&_hashtable[i & _mask], 1);
+#else
+    (void)i;
+#endif
+  }
+
   // o --> 0,1,2,3,4,5,6,7
   [[nodiscard]] auto get1x(const uint32_t o, const uint32_t i) const noexcept -> uint8_t* {
     const auto chk{static_cast<uint8_t>(o | (i >> 27))};  // 3 + 5 bits
@@ -976,12 +1074,10 @@ private:
   int32_t : 32;  // Padding
 };
 HashTable_t::~HashTable_t() noexcept {
-  std::free(_hashtable);
+  Arena::Free(_hashtable);
 }
 
 namespace {
-  std::array<uint8_t* __restrict, 5> cp_{{nullptr, nullptr, nullptr, nullptr, nullptr}};
-
   // Some more arbitrary magic (prime) numbers
   constexpr auto MUL64_01{UINT64_C(0x993DDEFFB1462949)};
   constexpr auto MUL64_02{UINT64_C(0xE9C91DC159AB0D2D)};
@@ -1083,7 +1179,7 @@ class ContextMap_t final {
   static_assert(RATE2 >= 0, "Speed(s) of context map must be positive (0 is switch off)");
 
 public:
-  explicit ContextMap_t() noexcept = default;
+  explicit ContextMap_t(const Context_t& context) noexcept : _context{context} {}
   virtual ~ContextMap_t() noexcept = default;
 
   ContextMap_t(const ContextMap_t&) = delete;
@@ -1103,7 +1199,7 @@ public:
     st[1] = state_table[1][st[1]];
     st[2] = state_table[2][st[2]];
 
-    const auto ctx{(7 == bcount_) ? static_cast<uint32_t>(0xFF & cx_) : c0_};
+    const auto ctx{(7 == _context.bcount) ? static_cast<uint32_t>(0xFF & _context.cx) : _context.c0};
     _ctx_last_prediction = (_ctx_new | ctx) & _mask;
 
     if constexpr (0 == RATE2) {
@@ -1126,6 +1222,7 @@ private:
   StateMap_t<0x100> _sm1{};  // State to prediction
   StateMap_t<0x100> _sm2{};  // State to prediction
 
+  const Context_t& _context;
   const uint32_t _mask{(SIZE * 256) - 1};
   uint32_t _ctx_new{0};
   uint32_t _ctx_last_prediction{0};
@@ -1147,7 +1244,7 @@ private:
 class HashMap_t final {
 public:
   explicit HashMap_t(const uint32_t elements) noexcept
-      : _hashmap{static_cast<Elements_t*>(calloc(elements + M, sizeof(Elements_t)))},  //
+      : _hashmap{static_cast<Elements_t*>(Arena::Allocate(elements + M, sizeof(Elements_t)))},  //
         _mask{elements - 1} {
     assert(ISPOWEROF2(elements));
     assert(_hashmap);
@@ -1247,7 +1344,7 @@ private:
   int32_t : 32;  // Padding
 };
 HashMap_t::~HashMap_t() noexcept {
-  std::free(_hashmap);
+  Arena::Free(_hashmap);
 }
 
 /**
@@ -1258,8 +1355,9 @@ HashMap_t::~HashMap_t() noexcept {
  */
 class RunContextMap_t final {
 public:
-  explicit RunContextMap_t(const int32_t max_size, const int32_t scale) noexcept
-      : _hashmap{UINT32_C(1) << max_size},  //
+  explicit RunContextMap_t(const Context_t& context, const int32_t max_size, const int32_t scale) noexcept
+      : _context{context},  //
+        _hashmap{UINT32_C(1) << max_size},
         _cp{_hashmap[0]} {
     uint32_t x{14155776};
     for (uint32_t i{2}; i <= ilog.size(); ++i) {
@@ -1276,7 +1374,7 @@ public:
   auto operator=(RunContextMap_t&&) -> RunContextMap_t& = delete;
 
   void Set(const uint32_t context) noexcept {  // update count
-    const auto expected_byte{static_cast<uint8_t>(cx_)};
+    const auto expected_byte{static_cast<uint8_t>(_context.cx)};
     if ((0 == _cp->count) || (expected_byte != _cp->value)) {
       *_cp = HashMap_t::Node_t{.count = 1, .value = expected_byte};  // Reset count, set expected byte
     } else if (_cp->count < 255) {
@@ -1287,8 +1385,8 @@ public:
 
   [[nodiscard]] auto Predict() noexcept -> int16_t {  // predict next bit
     const uint8_t expected_byte{_cp->value};
-    if ((expected_byte | 0x100u) >> (1 + bcount_) == c0_) {
-      const int32_t expected_bit{1 & (expected_byte >> bcount_)};
+    if ((expected_byte | 0x100u) >> (1 + _context.bcount) == _context.c0) {
+      const int32_t expected_bit{1 & (expected_byte >> _context.bcount)};
       const auto prediction{((expected_bit * 2) - 1) * ilog[_cp->count]};
       return static_cast<int16_t>(prediction);
     }
@@ -1297,6 +1395,7 @@ public:
 
 private:
   std::array<int32_t, 0x100> ilog{};  // clamp12(round(log2(x)*16)*scale)
+  const Context_t& _context;
   HashMap_t _hashmap;
   HashMap_t::Node_t* __restrict _cp;
 };
@@ -1310,10 +1409,12 @@ RunContextMap_t::~RunContextMap_t() noexcept = default;
  */
 class DynamicMarkovModel_t final {
 public:
-  explicit DynamicMarkovModel_t(const uint64_t max_size) noexcept
-      : _max_size_bytes{(max_size > MEM_LIMIT) ? MEM_LIMIT : max_size},
+  explicit DynamicMarkovModel_t(Context_t& context, Blend3x8_t& blend, const uint64_t max_size) noexcept
+      : _context{context},
+        _blend{blend},
+        _max_size_bytes{(max_size > MEM_LIMIT) ? MEM_LIMIT : max_size},
         _max_nodes{static_cast<uint32_t>((_max_size_bytes / sizeof(Node)) - 1)},
-        _nodes{reinterpret_cast<Node*>(std::calloc(_max_size_bytes + sizeof(Node), sizeof(int8_t)))} {
+        _nodes{reinterpret_cast<Node*>(Arena::Allocate(_max_size_bytes + sizeof(Node), sizeof(int8_t)))} {
     assert(0 == (_max_nodes >> 28));  // the top 4 bits must be unused by nx0 and nx1 for storing the 4+4 bits of the bit history state byte
     assert(_max_nodes >= 65280);
     if (verbose_) {
@@ -1329,7 +1430,7 @@ public:
   auto operator=(DynamicMarkovModel_t&&) -> DynamicMarkovModel_t& = delete;
 
   void Update() noexcept {
-    _cm.Set(tt_);
+    _cm.Set(_context.tt);
   }
 
   void Predict(const bool bit) noexcept {
@@ -1424,25 +1525,23 @@ public:
 
     _curr = bit ? curr.nx1 : curr.nx0;
 
-    auto& pr{_blend.Get()};
+    auto& pr{_blend.Get(Blend3x8_t::Lane::DMC)};
     pr[0] = static_cast<int16_t>(Predict());                                 // DMC prediction -2048..2047
     pr[1] = static_cast<int16_t>(_sm2.Update(bit, _nodes[_curr].state, 5));  // Rate of 5 is based on enwik9
 
     // Little improvements of DMC predictions
-    pr[2] = static_cast<int16_t>(_sm3.Update(bit, (tt_ << 8) | c0_, 1));                    // Rate of 1 is based on enwik9
-    pr[3] = static_cast<int16_t>(_sm4.Update(bit, (Finalise64(word_, 32) << 8) | c0_, 1));  // Rate of 1 is based on enwik9
-    pr[4] = static_cast<int16_t>(_sm5.Update(bit, (x5_ << 8) | c0_, 2));                    // Rate of 2 is based on enwik9
+    pr[2] = static_cast<int16_t>(_sm3.Update(bit, (_context.tt << 8) | _context.c0, 1));                    // Rate of 1 is based on enwik9
+    pr[3] = static_cast<int16_t>(_sm4.Update(bit, (Finalise64(_context.word, 32) << 8) | _context.c0, 1));  // Rate of 1 is based on enwik9
+    pr[4] = static_cast<int16_t>(_sm5.Update(bit, (_context.x5 << 8) | _context.c0, 2));                    // Rate of 2 is based on enwik9
 
     const auto [p5, p6, p7]{_cm.Predict(bit)};
     pr[5] = p5;
     pr[6] = p6;
     pr[7] = p7;
 
-    const auto last_pr{Squash(Mixer_t::tx_[7])};  // Conversion from -2048..2047 (clamped) into 0..4095
-    const auto ctx{(w5_ << 3) | bcount_};
+    const auto last_pr{Squash(_context.tx[7])};  // Conversion from -2048..2047 (clamped) into 0..4095
     const int32_t err{((bit << 12) - static_cast<int32_t>(last_pr)) * 10};  // Scale of 10 is based on enwik9
-    const auto px{_blend.Predict(err, ctx)};
-    Mixer_t::tx_[7] = px;
+    _blend.Error(Blend3x8_t::Lane::DMC, err);  // Predict_t blends, into _context.tx[7]
   }
 
 private:
@@ -1524,6 +1623,8 @@ private:
 #endif
   }
 
+  Context_t& _context;
+  Blend3x8_t& _blend;  // w5, shared with LempelZivPredict_t and SparseMatchModel_t
   const uint64_t _max_size_bytes;
   const uint32_t _max_nodes;
   uint32_t _top{0};
@@ -1531,18 +1632,17 @@ private:
   uint32_t _curr{0};
   uint32_t _threshold{THRESHOLD};
   uint32_t _threshold_fine{THRESHOLD << THRESHOLD_SPEED};
-  int32_t : 32;                               // Padding
-  int32_t : 32;                               // Padding
-  int32_t : 32;                               // Padding
-  StateMap_t<0x100> _sm2{};                   // state
-  StateMap_t<0x4000> _sm3{};                  // tt_     | not part of model, just an improvement
-  StateMap_t<0x10000> _sm4{};                 // word_   | not part of model, just an improvement
-  StateMap_t<0x40000> _sm5{};                 // x5_     | not part of model, just an improvement
-  ContextMap_t<0x4000, 0xE, 0xD, 0x7> _cm{};  // tt_|c0_ | Rates of 14/13/ 7 are based on enwik9 | not part of model, just an improvement
-  Blend_t<8> _blend{UINT32_C(1) << 19, 512};  // w5_
+  int32_t : 32;                                       // Padding
+  int32_t : 32;                                       // Padding
+  int32_t : 32;                                       // Padding
+  StateMap_t<0x100> _sm2{};                           // state
+  StateMap_t<0x4000> _sm3{};                          // tt     | not part of model, just an improvement
+  StateMap_t<0x10000> _sm4{};                         // word   | not part of model, just an improvement
+  StateMap_t<0x40000> _sm5{};                         // x5     | not part of model, just an improvement
+  ContextMap_t<0x4000, 0xE, 0xD, 0x7> _cm{_context};  // tt|c0 | Rates of 14/13/ 7 are based on enwik9 | not part of model, just an improvement
 };
 DynamicMarkovModel_t::~DynamicMarkovModel_t() noexcept {
-  std::free(_nodes);
+  Arena::Free(_nodes);
 }
 
 /**
@@ -1553,10 +1653,12 @@ DynamicMarkovModel_t::~DynamicMarkovModel_t() noexcept {
  */
 class LempelZivPredict_t final {  // MatchModel
 public:
-  explicit LempelZivPredict_t(const Buffer_t& __restrict buf, const uint64_t max_size) noexcept
-      : _buf{buf},  //
+  explicit LempelZivPredict_t(Context_t& context, Blend3x8_t& blend, const Buffer_t& __restrict buf, const uint64_t max_size) noexcept
+      : _context{context},  //
+        _blend{blend},
+        _buf{buf},
         _hashbits{CountBits(((max_size > MEM_LIMIT) ? MEM_LIMIT : max_size) - UINT64_C(1))},
-        _ht{static_cast<uint32_t*>(std::calloc((UINT64_C(1) << _hashbits) + UINT64_C(1), sizeof(uint32_t)))} {
+        _ht{static_cast<uint32_t*>(Arena::Allocate((UINT64_C(1) << _hashbits) + UINT64_C(1), sizeof(uint32_t)))} {
     assert(ISPOWEROF2(max_size));
     if (verbose_) {
       fprintf(stdout, "%s for LempelZivPredict_t\n", GetDimension(((UINT64_C(1) << _hashbits) + UINT64_C(1)) * sizeof(uint32_t)).c_str());
@@ -1583,32 +1685,33 @@ public:
       ++_match;
     } else {
       _match_length = 0;
-      _match = _ht[idx];
-      if (_match) {
+      _match = 0;
+      if (const auto last{_ht[idx]}; last) {  // Low 32 bits of the position, the buffer (at most 1 GiB) is reached with a 32 bits distance
+        _match = _buf.Pos() - (static_cast<uint32_t>(_buf.Pos()) - last);
         while ((_match_length < MAXLEN) && (_buf(_match_length + 1) == _buf[_match - _match_length - 1])) {
           ++_match_length;
         }
       }
     }
-    _ht[idx] = _buf.Pos();
+    _ht[idx] = static_cast<uint32_t>(_buf.Pos());
 
     _expected_byte = _buf[_match];
 
-    _rc0.Set((_match_length << 8) | c1_);  // 6+8 bits
-    _rc1.Set(w5_);
-    _rc2.Set(x5_);
-    _rc3.Set(tt_);
-    _rc4.Set(Finalise64(word_, 32));
+    _rc0.Set((_match_length << 8) | _context.c1);  // 6+8 bits
+    _rc1.Set(_context.w5);
+    _rc2.Set(_context.x5);
+    _rc3.Set(_context.tt);
+    _rc4.Set(Finalise64(_context.word, 32));
   }
 
   [[nodiscard]] auto Predict(const bool bit) noexcept -> uint32_t {
-    auto& pr{_blend.Get()};
+    auto& pr{_blend.Get(Blend3x8_t::Lane::LZP)};
 
     uint32_t ctx0{0};
     uint32_t order;
 
-    if ((_match_length >= MINLEN) && (((_expected_byte | 0x100) >> (1 + bcount_)) == c0_)) {
-      const auto expected_bit{UINT32_C(1) & (_expected_byte >> bcount_)};
+    if ((_match_length >= MINLEN) && (((_expected_byte | 0x100) >> (1 + _context.bcount)) == _context.c0)) {
+      const auto expected_bit{UINT32_C(1) & (_expected_byte >> _context.bcount)};
 
       const auto sign{static_cast<int32_t>(2 * expected_bit) - 1};
       const auto length_to_prediction{sign * static_cast<int32_t>(_match_length) * 32};
@@ -1623,30 +1726,30 @@ public:
         }
       }
 
-      const auto ctx1{(length << 9) | (expected_bit << 8) | c1_};  // 6+1+8=15 bits
+      const auto ctx1{(length << 9) | (expected_bit << 8) | _context.c1};  // 6+1+8=15 bits
       pr[1] = static_cast<int16_t>(_ltp0.Update(bit, ctx1, 8));    // Rate of 8 is based on enwik9
 
       // Length to order, based on enwik9 (value must start with 9 and end with 4)
-      const auto l2o{(7 == bcount_) ? UINT64_C(0x9999988888776654) : UINT64_C(0x9999998888776654)};
+      const auto l2o{(7 == _context.bcount) ? UINT64_C(0x9999988888776654) : UINT64_C(0x9999998888776654)};
       order = static_cast<uint32_t>(0xF & (l2o >> (4 * (length / 4))));
     } else {
       _match_length = 0;  // Wrong prediction, reset!
       pr[0] = 0;
-      pr[1] = static_cast<int16_t>(_ltp0.Update(bit, c0_, 2) / 2);  // Rate of 2 is based on enwik9
+      pr[1] = static_cast<int16_t>(_ltp0.Update(bit, _context.c0, 2) / 2);  // Rate of 2 is based on enwik9
 
       order = 0;
-      if (*cp_[1]) {
+      if (*_context.cp[1]) {
         order = 1;
-        if (*cp_[2]) {
+        if (*_context.cp[2]) {
           order = 2;
-          if (*cp_[3]) {
+          if (*_context.cp[3]) {
             order = 3;
           }
         }
       }
     }
 
-    const auto py{static_cast<int16_t>(_ltp1.Update(bit, (ctx0 << 8) | c0_, 4))};  // 6+8=14 bits | Rate of 4 is based on enwik9
+    const auto py{static_cast<int16_t>(_ltp1.Update(bit, (ctx0 << 8) | _context.c0, 4))};  // 6+8=14 bits | Rate of 4 is based on enwik9
     pr[2] = ctx0 ? py : 0;
     pr[3] = _rc0.Predict();
     pr[4] = _rc1.Predict();
@@ -1654,11 +1757,9 @@ public:
     pr[6] = _rc3.Predict();
     pr[7] = _rc4.Predict();
 
-    const auto last_pr{Squash(Mixer_t::tx_[0])};  // Conversion from -2048..2047 (clamped) into 0..4095
-    const auto ctx{(w5_ << 3) | bcount_};
+    const auto last_pr{Squash(_context.tx[0])};  // Conversion from -2048..2047 (clamped) into 0..4095
     const int32_t err{((bit << 12) - static_cast<int32_t>(last_pr)) * 11};  // Scale of 11 is based on enwik9
-    const auto px{_blend.Predict(err, ctx)};
-    Mixer_t::tx_[0] = px;
+    _blend.Error(Blend3x8_t::Lane::LZP, err);  // Predict_t blends, into _context.tx[0]
 
     return order;
   }
@@ -1677,27 +1778,25 @@ private:
     return n;
   }
 
+  Context_t& _context;
+  Blend3x8_t& _blend;  // w5, shared with DynamicMarkovModel_t and SparseMatchModel_t
   const Buffer_t& __restrict _buf;
   const uint32_t _hashbits;
   int32_t : 32;  // Padding
   uint32_t* const __restrict _ht;
-  uint32_t _match{0};
+  uint64_t _match{0};
   uint32_t _match_length{0};
   uint32_t _expected_byte{0};
-  int32_t : 32;                           // Padding
-  StateMap_t<0x8000> _ltp0{};             // Length to prediction
-  StateMap_t<0x4000> _ltp1{};             // (curved) Length to prediction
-  RunContextMap_t _rc0{14, 23};           // match_length|c1_ | scale of 23 is based on enwik9
-  RunContextMap_t _rc1{16 + level_, 49};  //              w5_ | scale of 49 is based on enwik9 | not part of model, just an improvement
-  RunContextMap_t _rc2{16 + level_, 51};  //              x5_ | scale of 51 is based on enwik9 | not part of model, just an improvement
-  RunContextMap_t _rc3{16 + level_, 32};  //              tt_ | scale of 32 is based on enwik9 | not part of model, just an improvement
-  RunContextMap_t _rc4{16 + level_, 26};  //            word_ | scale of 26 is based on enwik9 | not part of model, just an improvement
-  int32_t : 32;                           // Padding
-  int32_t : 32;                           // Padding
-  Blend_t<8> _blend{1u << 19, 4096};      // w5_
+  StateMap_t<0x8000> _ltp0{};                               // Length to prediction
+  StateMap_t<0x4000> _ltp1{};                               // (curved) Length to prediction
+  RunContextMap_t _rc0{_context, 14, 23};                   // match_length|c1 | scale of 23 is based on enwik9
+  RunContextMap_t _rc1{_context, 16 + _context.level, 49};  //              w5 | scale of 49 is based on enwik9 | not part of model, just an improvement
+  RunContextMap_t _rc2{_context, 16 + _context.level, 51};  //              x5 | scale of 51 is based on enwik9 | not part of model, just an improvement
+  RunContextMap_t _rc3{_context, 16 + _context.level, 32};  //              tt | scale of 32 is based on enwik9 | not part of model, just an improvement
+  RunContextMap_t _rc4{_context, 16 + _context.level, 26};  //            word | scale of 26 is based on enwik9 | not part of model, just an improvement
 };
 LempelZivPredict_t::~LempelZivPredict_t() noexcept {
-  std::free(_ht);
+  Arena::Free(_ht);
 }
 
 /**
@@ -1708,9 +1807,11 @@ LempelZivPredict_t::~LempelZivPredict_t() noexcept {
  */
 class SparseMatchModel_t final {
 public:
-  explicit SparseMatchModel_t(const Buffer_t& __restrict buf) noexcept
-      : _buf{buf},  //
-        _ht{static_cast<uint32_t*>(std::calloc((UINT64_C(1) << NBITS) + UINT64_C(1), sizeof(uint32_t)))} {
+  explicit SparseMatchModel_t(Context_t& context, Blend3x8_t& blend, const Buffer_t& __restrict buf) noexcept
+      : _context{context},  //
+        _blend{blend},
+        _buf{buf},
+        _ht{static_cast<uint32_t*>(Arena::Allocate((UINT64_C(1) << NBITS) + UINT64_C(1), sizeof(uint32_t)))} {
     if (verbose_) {
       fprintf(stdout, "%s for SparseMatchModel_t\n", GetDimension(((UINT64_C(1) << NBITS) + UINT64_C(1)) * sizeof(uint32_t)).c_str());
     }
@@ -1724,47 +1825,48 @@ public:
   auto operator=(SparseMatchModel_t&&) -> SparseMatchModel_t& = delete;
 
   void Update() noexcept {
-    const auto idx{((UINT64_C(1) << NBITS) - 1) & cx_};
+    const auto idx{((UINT64_C(1) << NBITS) - 1) & _context.cx};
 
     if (_match_length >= MINLEN) {
       _match_length += _match_length < MAXLEN;
       ++_match;
     } else {
       _match_length = 0;
-      _match = _ht[idx];
-      if (_match) {
+      _match = 0;
+      if (const auto last{_ht[idx]}; last) {  // Low 32 bits of the position, the buffer (at most 1 GiB) is reached with a 32 bits distance
+        _match = _buf.Pos() - (static_cast<uint32_t>(_buf.Pos()) - last);
         while ((_match_length < MAXLEN) && (_buf(_match_length + 1) == _buf[_match - _match_length - 1])) {
           ++_match_length;
         }
       }
     }
-    _ht[idx] = _buf.Pos();
+    _ht[idx] = static_cast<uint32_t>(_buf.Pos());
 
     _expected_byte = _buf[_match];
 
     _cm0.Set(0);
-    _cm1.Set(x5_);
+    _cm1.Set(_context.x5);
   }
 
   void Predict(const bool bit) noexcept {
-    auto& pr{_blend.Get()};
+    auto& pr{_blend.Get(Blend3x8_t::Lane::SMM)};
 
-    if ((_match_length >= MINLEN) && (((_expected_byte | 0x100) >> (1 + bcount_)) == c0_)) {
-      const auto expected_bit{UINT32_C(1) & (_expected_byte >> bcount_)};
+    if ((_match_length >= MINLEN) && (((_expected_byte | 0x100) >> (1 + _context.bcount)) == _context.c0)) {
+      const auto expected_bit{UINT32_C(1) & (_expected_byte >> _context.bcount)};
 
       const auto sign{static_cast<int32_t>(2 * expected_bit) - 1};
       const auto length_to_prediction{sign * static_cast<int32_t>(_match_length) * 32};
       pr[0] = static_cast<int16_t>(clamp12(length_to_prediction));
 
-      const auto ctx0{(_match_length << 9) | (expected_bit << 8) | c1_};  // 6+1+8=15 bits
+      const auto ctx0{(_match_length << 9) | (expected_bit << 8) | _context.c1};  // 6+1+8=15 bits
       pr[1] = static_cast<int16_t>(_ltp.Update(bit, ctx0, 5));            // Rate of 5 is based on enwik9
 
-      const auto ctx1{(_expected_byte << 11) | (bcount_ << 8) | _buf(1)};  // 8+3+8=19 bits
+      const auto ctx1{(_expected_byte << 11) | (_context.bcount << 8) | _buf(1)};  // 8+3+8=19 bits
       pr[2] = static_cast<int16_t>(_sm1.Update(bit, ctx1, 8));             // Rate of 8 is based on enwik9
     } else {
       _match_length = 0;  // Wrong prediction, reset!
       pr[0] = 0;
-      pr[1] = static_cast<int16_t>(_ltp.Update(bit, c1_, 5) / 4);      // Rate of 5, division of 4 are based on enwik9
+      pr[1] = static_cast<int16_t>(_ltp.Update(bit, _context.c1, 5) / 4);      // Rate of 5, division of 4 are based on enwik9
       pr[2] = static_cast<int16_t>(_sm1.Update(bit, _buf(1), 4) / 8);  // Rate of 4, division of 8 are based on enwik9
     }
 
@@ -1780,11 +1882,9 @@ public:
     pr[8] = p8;
 #endif
 
-    const auto last_pr{Squash(Mixer_t::tx_[8])};  // Conversion from -2048..2047 (clamped) into 0..4095
-    const auto ctx{(w5_ << 3) | bcount_};
+    const auto last_pr{Squash(_context.tx[8])};  // Conversion from -2048..2047 (clamped) into 0..4095
     const int32_t err{((bit << 12) - static_cast<int32_t>(last_pr)) * 9};  // Scale of 9 is based on enwik9
-    const auto px{_blend.Predict(err, ctx)};
-    Mixer_t::tx_[8] = px;
+    _blend.Error(Blend3x8_t::Lane::SMM, err);  // Predict_t blends, into _context.tx[8]
   }
 
 private:
@@ -1792,22 +1892,22 @@ private:
   static constexpr auto MINLEN{UINT32_C(2)};            // Minimum required match length
   static constexpr auto MAXLEN{UINT32_C(MINLEN + 63)};  // Longest allowed match (max 6 bits, after subtraction of minimum length)
 
+  Context_t& _context;
+  Blend3x8_t& _blend;  // w5, shared with DynamicMarkovModel_t and LempelZivPredict_t
   const Buffer_t& __restrict _buf;
   uint32_t* const __restrict _ht;
-  uint32_t _match{0};
+  uint64_t _match{0};
   uint32_t _match_length{0};
   uint32_t _expected_byte{0};
-  int32_t : 32;                                // Padding
-  int32_t : 32;                                // Padding
-  int32_t : 32;                                // Padding
-  ContextMap_t<0x001, 0xC, 0xA, 0xD> _cm0{};   //     c0_ | Rates of 12/10/13 are based on enwik9 | not part of model, just an improvement
-  ContextMap_t<0x100, 0xC, 0x6> _cm1{};        // x5_|c0_ | Rates of 12/ 6    are based on enwik9 | not part of model, just an improvement
-  StateMap_t<0x8000> _ltp{};                   // length|expected_bit|c1
-  StateMap_t<0x80000> _sm1{};                  // expected_byte|bcount|buf(1)
-  Blend_t<8> _blend{UINT32_C(1) << 19, 4096};  // w5_
+  int32_t : 32;                                       // Padding
+  int32_t : 32;                                       // Padding
+  ContextMap_t<0x001, 0xC, 0xA, 0xD> _cm0{_context};  //     c0 | Rates of 12/10/13 are based on enwik9 | not part of model, just an improvement
+  ContextMap_t<0x100, 0xC, 0x6> _cm1{_context};       // x5|c0 | Rates of 12/ 6    are based on enwik9 | not part of model, just an improvement
+  StateMap_t<0x8000> _ltp{};                          // length|expected_bit|c1
+  StateMap_t<0x80000> _sm1{};                         // expected_byte|bcount|buf(1)
 };
 SparseMatchModel_t::~SparseMatchModel_t() noexcept {
-  std::free(_ht);
+  Arena::Free(_ht);
 }
 
 /**
@@ -1828,7 +1928,7 @@ SparseMatchModel_t::~SparseMatchModel_t() noexcept {
  */
 class Txt_t final {
 public:
-  explicit Txt_t() noexcept = default;
+  explicit Txt_t(const Context_t& context) noexcept : _context{context} {}
   ~Txt_t() noexcept = default;
 
   Txt_t(const Txt_t&) = delete;
@@ -1969,6 +2069,7 @@ public:
 private:
   uint128_t _prdct{0};
   uint128_t _value{0};
+  const Context_t& _context;
   uint32_t _skip_bytes{0};
   uint32_t _dic_start_offset{0};
   uint32_t _dic_end_offset{0};
@@ -1981,8 +2082,6 @@ private:
   int32_t : 8;   // Padding
   int32_t : 32;  // Padding
   int32_t : 32;  // Padding
-  int32_t : 32;  // Padding
-  int32_t : 32;  // Padding
 
   constexpr void Shift() noexcept {
     _prdct += _prdct;
@@ -1999,9 +2098,9 @@ private:
         return {true, _pr = prediction ? 0xFFF : 0x000};  // Prediction
       }
     } else {
-      if ((3 == bcount_) && (TP5_ESCAPE_CHAR != (0xFF & cx_))) {
+      if ((3 == _context.bcount) && (TP5_ESCAPE_CHAR != (0xFF & _context.cx))) {
         static_assert(0x40 == TP5_NEGATIVE_CHAR, "Modify this when changed");
-        if ((TP5_NEGATIVE_CHAR >> 4) == (0xF & c0_)) {
+        if ((TP5_NEGATIVE_CHAR >> 4) == (0xF & _context.c0)) {
           //         40      80 --> 5 bits prediction
           //       0b010000001xxxxxxx
           _prdct = 0b01000000100000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000_xxl;
@@ -2014,11 +2113,11 @@ private:
           Shift();
         } else {
           // Detect dictionary indexes
-          if (0xC == (0xC & c0_)) {
+          if (0xC == (0xC & _context.c0)) {
             uint32_t prdct{0};
             uint32_t value{0};
 
-            if (0xC == (0xE & c0_)) {
+            if (0xC == (0xE & _context.c0)) {
               // < MID
               //        C0      80 --> 2 bits prediction
               //      0b110xxxxx10xxxxxx
@@ -2026,7 +2125,7 @@ private:
               value = 0b11100000110000000000000000000000;
               //        ^^^     pp
               //
-            } else if (0xE == (0xF & c0_)) {
+            } else if (0xE == (0xF & _context.c0)) {
               // < HIGH
               //        E0      C0      80 --> 5 bits prediction
               //      0b1110xxxx110xxxxx10xxxxxx
@@ -2034,7 +2133,7 @@ private:
               value = 0b11110000111000001100000000000000;
               //        ^^^^    ppp     pp
               //
-            } else if (0xF == (0xF & c0_)) {
+            } else if (0xF == (0xF & _context.c0)) {
               // >= HIGH
               //        F0      E0      C0      80 --> 10 bits prediction
               //      0b11110xxx1110xxxx110xxxxx10xxxxxx
@@ -2070,13 +2169,13 @@ private:
         return {true, _pr = prediction ? 0xFFF : 0x000};  // Prediction
       }
     } else {
-      if (TP5_ESCAPE_CHAR != (0xFF & cx_)) {
+      if (TP5_ESCAPE_CHAR != (0xFF & _context.cx)) {
         // Detect dictionary indexes
-        if ((3 == bcount_) && (0xC == (0xC & c0_))) {
+        if ((3 == _context.bcount) && (0xC == (0xC & _context.c0))) {
           uint32_t prdct{0};
           uint32_t value{0};
 
-          if (0xC == (0xE & c0_)) {
+          if (0xC == (0xE & _context.c0)) {
             assert(_number_of_words >= 64);
             // < MID
             //        C0      80 --> 2 bits prediction
@@ -2086,7 +2185,7 @@ private:
             //        ^^^     pp
 
             value |= _extend_mask_low;
-          } else if (0xE == (0xF & c0_)) {
+          } else if (0xE == (0xF & _context.c0)) {
             assert(_number_of_words >= (64 + 2048));
             // < HIGH
             //        E0      C0      80 --> 5 bits prediction
@@ -2096,7 +2195,7 @@ private:
             //        ^^^^    ppp     pp
 
             value |= _extend_mask_mid;
-          } else if (0xF == (0xF & c0_)) {
+          } else if (0xF == (0xF & _context.c0)) {
             assert(_number_of_words >= (64 + 2048 + 32768));
             // >= HIGH
             //        F0      E0      C0      80 --> 10 bits prediction
@@ -2121,8 +2220,8 @@ private:
         }
 
         // Detect value transformation <escape><0xFx><0x8x>...<0x0x>
-        if ((5 == bcount_) && (0xF0 == (0xF0 & cx_)) && (0x06 == c0_)) {
-          const auto costs{0x0F & cx_};
+        if ((5 == _context.bcount) && (0xF0 == (0xF0 & _context.cx)) && (0x06 == _context.c0)) {
+          const auto costs{0x0F & _context.cx};
           switch (costs) {  // clang-format off
             case 0x4: // 80      80      80      00 --> 6 bits prediction
               //       0b10xxxxxx10xxxxxx10xxxxxx00xxxxxx
@@ -2280,16 +2379,50 @@ private:
   uint32_t _sse{0};
 };
 
+/**
+ * @struct ModelSet_t
+ * @brief Topology of Predict_t, every model set compiles into its own hot loop
+ * @tparam DMC Predict with DynamicMarkovModel_t
+ * @tparam SMM Predict with SparseMatchModel_t
+ * @tparam APM_CHAIN Refine the prediction of _a1 with _a2.._a6 and the blend of their predictions
+ *
+ * The order-N context slots, the mixer, LempelZivPredict_t, Txt_t and SSE_t are part of every model set.
+ */
+template <const bool DMC, const bool SMM, const bool APM_CHAIN>
+struct ModelSet_t final {
+  static constexpr bool HAS_DMC{DMC};
+  static constexpr bool HAS_SMM{SMM};
+  static constexpr bool HAS_APM_CHAIN{APM_CHAIN};
+};
+using FullModel_t = ModelSet_t<true, true, true>;     // ModelSet::Full
+using FastModel_t = ModelSet_t<false, false, false>;  // ModelSet::Fast
+
 /**
  * @class Predict_t
  * @brief Main model - predicts next bit probability from previous data
+ * @tparam Set The models in use, a ModelSet_t
  *
  * Main model - predicts next bit probability from previous data
  */
+template <typename Set>
 class Predict_t final {
 public:
-  explicit Predict_t(Buffer_t& __restrict buf) noexcept : _buf{buf} {
-    cp_[0] = cp_[1] = cp_[2] = cp_[3] = cp_[4] = _t0.data();
+  explicit Predict_t(Buffer_t& __restrict buf, const int32_t level) noexcept
+      : _context{level},  //
+        _buf{buf},
+        _dmc{Set::HAS_DMC ? std::make_unique<DynamicMarkovModel_t>(_context, _blend3x8, _context.MEM()) : nullptr},
+        _smm{Set::HAS_SMM ? std::make_unique<SparseMatchModel_t>(_context, _blend3x8, _buf) : nullptr},
+        _a2{Set::HAS_APM_CHAIN ? std::make_unique<APM_t>(_context.MEM(9), 9238, 8) : nullptr},
+        _a3{Set::HAS_APM_CHAIN ? std::make_unique<APM_t>(_context.MEM(12), 9238, 1) : nullptr},
+        _a4{Set::HAS_APM_CHAIN ? std::make_unique<APM_t>(_context.MEM(14), 9238, 8) : nullptr},
+        _a5{Set::HAS_APM_CHAIN ? std::make_unique<APM_t>(_context.MEM(12), 9238, 8) : nullptr},
+        _a6{Set::HAS_APM_CHAIN ? std::make_unique<APM_t>(_context.MEM(9), 9238, 8) : nullptr},
+        _blend{Set::HAS_APM_CHAIN ? std::make_unique<Blend_t<4>>(UINT32_C(1) << 19, 4096) : nullptr} {
+    _context.cp[0] = _context.cp[1] = _context.cp[2] = _context.cp[3] = _context.cp[4] = _t0.data();
+    if (verbose_) {
+      Arena::Report();
+      fprintf(stdout, "SIMD kernels: %s\n", Simd::Name(Simd::Selected()));
+    }
   }
 
   virtual ~Predict_t() noexcept;
@@ -2301,22 +2434,15 @@ public:
   auto operator=(Predict_t&&) -> Predict_t& = delete;
 
   [[nodiscard]] constexpr auto CalcCZ(const uint32_t fails, const uint32_t failcount) const noexcept -> uint32_t {
-    if (_is_binary) {
-      uint32_t cz{uint8_t(UINT64_C(0x1F11170917090F01) >> (8 * (7 & (fails >> 0))))};
-      cz += /* */ uint8_t(UINT64_C(0x1E14140A140A0A00) >> (8 * (7 & (fails >> 3))));
-      cz += ((1u << 6) & fails) ? 0x0A : 0;
-      cz = (std::min)(UINT32_C(0x9), (_failcount + cz) / 2);
-      return cz;
-    }
-
-    uint32_t cz{uint8_t(UINT64_C(0x26181A0C1B0D0F01) >> (8 * (7 & (fails >> 0))))};
-    cz += /* */ uint8_t(UINT64_C(0x170F0C04130B0800) >> (8 * (7 & (fails >> 3))));
-    cz += ((1u << 6) & fails) ? 0x7 : 0;
-    cz = (std::min)(UINT32_C(0xB), (failcount + cz) / 2);
+    uint32_t cz{uint8_t(_cz->low >> (8 * (7 & (fails >> 0))))};
+    cz += /* */ uint8_t(_cz->high >> (8 * (7 & (fails >> 3))));
+    cz += ((1u << 6) & fails) ? _cz->fail6 : 0;
+    cz = (std::min)(_cz->limit, (failcount + cz) / 2);
     return cz;
   }
 
   [[nodiscard]] auto Next(const bool bit) noexcept -> uint32_t {
+    _lap.Next();
     if (_fails & 0x80) {
       --_failcount;  // 0..8
     }
@@ -2334,46 +2460,27 @@ public:
     // Filter the context model with APMs
     const auto p0{Predict(bit)};
     const auto p0s{Stretch(p0)};
-    const auto p1{Balance(7u, _a1.Predict(bit, p0s, c0_), p0)};  // Weight of 7 is based on enwik9
-
-    const auto cz{CalcCZ(_fails, _failcount)};
-
-    // clang-format off
-    const auto p2{_a2.Predict(bit,         p0s, Finalise64(Hash(  8*c0_, 0x7FF & _failz                         ), 27))};           // hash bits of 27 is based on enwik9
-    const auto p3{_a3.Predict(bit,         p0s, Finalise64(Hash( 32*c0_, 0x80FFFF & x5_                         ), 25))};           // hash bits of 25 is based on enwik9
-    const auto p4{_a4.Predict(bit, Stretch(p1), Finalise64(Hash(_buf(1), 0xFF & (x5_ >> 8), 0x80FF & (x5_ >> 16)), 57) ^ (2*c0_))}; // hash bits of 57 is based on enwik9
-    const auto p4s{Stretch(p4)};
-    const auto p5{_a5.Predict(bit, Stretch(p2), Finalise64(Hash(    c0_, w5_                                    ), 24))};           // hash bits of 24 is based on enwik9
-    const auto p6{_a6.Predict(bit,         p4s, Finalise64(Hash(    cz, 0x0080FF & x5_                          ), 57) ^ (4*c0_))}; // hash bits of 57 is based on enwik9
-    // clang-format on
+    const auto p1{Balance(7u, _a1.Predict(bit, p0s, _context.c0), p0)};  // Weight of 7 is based on enwik9
 
-    auto& pr{_blend.Get()};
-    if (0x7FF != _pt) {
-      const auto no_model_pr{static_cast<int16_t>(_pt ? 0x7FF : ~0x7FF)};
-      pr[0] = no_model_pr;
-      pr[1] = no_model_pr;
-      pr[2] = no_model_pr;
-      pr[3] = no_model_pr;
+    int32_t pr12;
+    if constexpr (Set::HAS_APM_CHAIN) {
+      pr12 = Refine(bit, p0s, p1);
     } else {
-      pr[0] = static_cast<int16_t>(Stretch(p3));  // Conversions from 0..4095 into -2048..2047
-      pr[1] = static_cast<int16_t>(p4s);
-      pr[2] = static_cast<int16_t>(Stretch(p5));
-      pr[3] = static_cast<int16_t>(Stretch(p6));
+      pr12 = Stretch(p1);
+      _lap(Profile::Model::APM);
     }
 
-    const auto ctx{(w5_ << 1) | ((0xFF & _fails) ? 1 : 0)};
-    const int32_t err{((bit << 16) - static_cast<int32_t>(_pr16)) / 8};  // Division of 8 is based on enwik9
-    const auto pr12{_blend.Predict(err, ctx)};
-
     _pr16 = _sse.Predict16(pr12, bit);
     if (0x7FF != _pt) {
       _pr16 = _pt ? 0xFFFF : 0x0000;
     }
+    _lap(Profile::Model::SSE);
     return _pr16;
   }
 
   void SetBinary(const bool is_binary) noexcept {
     _is_binary = is_binary;
+    _cz = is_binary ? &BIN_CZ : &TXT_CZ;
   }
   void SetDataPos(const int64_t data_pos) noexcept {
     _txt.SetDataPos(data_pos);
@@ -2391,37 +2498,76 @@ public:
     _txt.SetDicWords(number_of_words);
   }
 
+  /**
+   * Add a byte that was coded without the models (see Bypass_t and Run_t), the models are not updated
+   * @param ch The byte
+   */
+  void Skip(const uint8_t ch) noexcept {
+    _buf.Add(ch);
+  }
+
+  /**
+   * Let the models learn skipped bytes that are already in the buffer, the buffer is not changed
+   * @param bytes Number of bytes, the last ones of the buffer
+   */
+  void CatchUp(const uint32_t bytes) noexcept {
+    _replay = true;
+    for (auto n{bytes}; n > 0; --n) {
+      const auto ch{_buf(n)};
+      for (auto i{8}; i-- > 0;) {
+        (void)Next((ch >> i) & 1);
+      }
+    }
+    _replay = false;
+  }
+
 private:
+  /**
+   * @struct CZ_t
+   * @brief Constants of CalcCZ(), chosen once by SetBinary() instead of on every bit
+   */
+  struct CZ_t final {
+    uint64_t low;    // Per pattern of the last 3 failures
+    uint64_t high;   // Per pattern of the 3 failures before
+    uint32_t fail6;  // When the 7th last bit failed
+    uint32_t limit;
+  };
+  static constexpr CZ_t TXT_CZ{UINT64_C(0x26181A0C1B0D0F01), UINT64_C(0x170F0C04130B0800), 0x7, 0xB};
+  static constexpr CZ_t BIN_CZ{UINT64_C(0x1F11170917090F01), UINT64_C(0x1E14140A140A0A00), 0xA, 0x9};
+
+  Context_t _context;
   Buffer_t& __restrict _buf;
   uint32_t _add2order{0};
   uint32_t _fails{0};
   uint32_t _failz{0};
   uint32_t _failcount{0};
-  Mixer_t _mixer{};
-  DynamicMarkovModel_t _dmc{MEM()};
-  LempelZivPredict_t _lzp{_buf, MEM(20)};
-  SparseMatchModel_t _smm{_buf};
-  Txt_t _txt{};
-  APM_t _ax1{0x10000, 9216, 9};  // Fixed 16 bit context | Offset 9 is based on enwik9
-  APM_t _ax2{0x4000, 3722, 37};  //                      | Offset 37 is based on enwik9
-  APM_t _a1{0x100, 9238, 12};    // Fixed 8 bit context  | Offset 12 is based on enwik9
-  APM_t _a2{MEM(9), 9238, 8};    // 5                    | Offset 8 is based on enwik9
-  APM_t _a3{MEM(12), 9238, 1};   // 3                    | Offset 1 is based on enwik9
-  APM_t _a4{MEM(14), 9238, 8};   // 1                    | Offset 8 is based on enwik9
-  APM_t _a5{MEM(12), 9238, 8};   // 2                    | Offset 8 is based on enwik9
-  APM_t _a6{MEM(9), 9238, 8};    // 4                    | Offset 8 is based on enwik9
+  Mixer_t _mixer{_context};
+  Blend3x8_t _blend3x8{UINT32_C(1) << 19, {{512, 4096, 4096}}};  // w5, of _dmc, _lzp and _smm
+  LempelZivPredict_t _lzp{_context, _blend3x8, _buf, _context.MEM(20)};
+  Txt_t _txt{_context};
+  APM_t _ax1{0x10000, 9216, 9};   // Fixed 16 bit context | Offset 9 is based on enwik9
+  APM_t _ax2{0x4000, 3722, 37};   //                      | Offset 37 is based on enwik9
+  APM_t _a1{0x100, 9238, 12};     // Fixed 8 bit context  | Offset 12 is based on enwik9
+  // The reduced model set (--fast-model) leaves out the models that are nullptr here
+  std::unique_ptr<DynamicMarkovModel_t> _dmc;
+  std::unique_ptr<SparseMatchModel_t> _smm;
+  std::unique_ptr<APM_t> _a2;     // 5                    | MEM(9), offset 8 is based on enwik9
+  std::unique_ptr<APM_t> _a3;     // 3                    | MEM(12), offset 1 is based on enwik9
+  std::unique_ptr<APM_t> _a4;     // 1                    | MEM(14), offset 8 is based on enwik9
+  std::unique_ptr<APM_t> _a5;     // 2                    | MEM(12), offset 8 is based on enwik9
+  std::unique_ptr<APM_t> _a6;     // 4                    | MEM(9), offset 8 is based on enwik9
   uint32_t _mxr_pr{0x7FF};
   uint32_t _pt{0x7FF};
   uint32_t _pr16{0x7FFF};  // Prediction 0..65535
   int32_t : 32;            // Padding
-  HashTable_t _t4a{MEM(23)};
-  HashTable_t _t4b{MEM(23)};
+  HashTable_t _t4a{_context.MEM(23)};
+  HashTable_t _t4b{_context.MEM(23)};
+  const CZ_t* _cz{&TXT_CZ};
   bool _is_binary{false};
-  int32_t : 24;                                // Padding
-  int32_t : 32;                                // Padding
-  int32_t : 32;                                // Padding
-  int32_t : 32;                                // Padding
-  Blend_t<4> _blend{UINT32_C(1) << 19, 4096};  // w5_
+  bool _replay{false};                 // CatchUp(), the bytes are already in the buffer
+  int32_t : 16;                        // Padding
+  int32_t : 32;                        // Padding
+  std::unique_ptr<Blend_t<4>> _blend;  // w5
   std::array<uint8_t, 0x10000> _t0{};
   uint8_t* __restrict _t0c1{_t0.data()};
   uint32_t _ctx1{0};
@@ -2430,48 +2576,88 @@ private:
   uint32_t _ctx4{0};
   uint32_t _ctx5{0};
   uint32_t _pw{0};
-  int32_t* _ctx6{&smt_[0][0]};
+  int32_t* _ctx6{&_context.smt[0][0]};
   uint32_t _bc4cp0{0};  // Range 0,1,2 or 3
   SSE_t _sse{};
-  int32_t : 32;  // Padding
-  int32_t : 32;  // Padding
-  int32_t : 32;  // Padding
-  int32_t : 32;  // Padding
+  Profile::Sampler_t _lap{};    // --profile, time per model component
+  Profile::Stalls_t _stalls{};  // --profile, stall time saved by PrefetchSlots()
+
+  /**
+   * The APM chain after _a1 and the blend of its predictions, only in the complete model set
+   * @param bit The last bit
+   * @param p0s The prediction of the mixer, stretched
+   * @param p1 The prediction of _a1
+   * @return The refined prediction, stretched
+   */
+  [[nodiscard]] auto Refine(const bool bit, const int32_t p0s, const uint32_t p1) noexcept -> int32_t {
+    const auto cz{CalcCZ(_fails, _failcount)};
+
+    // clang-format off
+    const auto p2{_a2->Predict(bit,         p0s, Finalise64(Hash(  8*_context.c0, 0x7FF & _failz                         ), 27))};           // hash bits of 27 is based on enwik9
+    const auto p3{_a3->Predict(bit,         p0s, Finalise64(Hash( 32*_context.c0, 0x80FFFF & _context.x5                         ), 25))};           // hash bits of 25 is based on enwik9
+    const auto p4{_a4->Predict(bit, Stretch(p1), Finalise64(Hash(_buf(1), 0xFF & (_context.x5 >> 8), 0x80FF & (_context.x5 >> 16)), 57) ^ (2*_context.c0))}; // hash bits of 57 is based on enwik9
+    const auto p4s{Stretch(p4)};
+    const auto p5{_a5->Predict(bit, Stretch(p2), Finalise64(Hash(    _context.c0, _context.w5                                    ), 24))};           // hash bits of 24 is based on enwik9
+    const auto p6{_a6->Predict(bit,         p4s, Finalise64(Hash(    cz, 0x0080FF & _context.x5                          ), 57) ^ (4*_context.c0))}; // hash bits of 57 is based on enwik9
+    // clang-format on
+    _lap(Profile::Model::APM);
+
+    auto& pr{_blend->Get()};
+    if (0x7FF != _pt) {
+      const auto no_model_pr{static_cast<int16_t>(_pt ? 0x7FF : ~0x7FF)};
+      pr[0] = no_model_pr;
+      pr[1] = no_model_pr;
+      pr[2] = no_model_pr;
+      pr[3] = no_model_pr;
+    } else {
+      pr[0] = static_cast<int16_t>(Stretch(p3));  // Conversions from 0..4095 into -2048..2047
+      pr[1] = static_cast<int16_t>(p4s);
+      pr[2] = static_cast<int16_t>(Stretch(p5));
+      pr[3] = static_cast<int16_t>(Stretch(p6));
+    }
+
+    const auto ctx{(_context.w5 << 1) | ((0xFF & _fails) ? 1 : 0)};
+    const int32_t err{((bit << 16) - static_cast<int32_t>(_pr16)) / 8};  // Division of 8 is based on enwik9
+    const auto pr12{_blend->Predict(err, ctx)};
+    _lap(Profile::Model::Blend);
+    return pr12;
+  }
 
   [[nodiscard]] auto Predict_not32(const bool bit) noexcept -> uint32_t {
     auto y2o{(bit << 20) - bit};
 
-    const auto len{_lzp.Predict(bit)};        // len --> 0..9
-    _mixer.Context(_add2order + (64 * len));  // len --> 0..576 --> 10800+576+(9*8)
     _ctx6[0] += (y2o - _ctx6[0]) >> 6;        // (6) 6 is based on enwik9 (little influence)
-    _ctx6 = &smt_[_bc4cp0][_t0c1[c0_]];       // smt[0,1,2 or 3][...]
+    _ctx6 = &_context.smt[_bc4cp0][_t0c1[_context.c0]];       // smt[0,1,2 or 3][...]
 
-    smt_[0x5][_ctx5] += (y2o - smt_[0x5][_ctx5]) * limits_15a(_ctx5) >> 9;  // P5
+    _context.smt[0x5][_ctx5] += (y2o - _context.smt[0x5][_ctx5]) * limits_15a(_ctx5) >> 9;  // P5
     y2o += 384;                                                             //
-    smt_[0x4][_ctx1] += (y2o - smt_[0x4][_ctx1]) >> 9;                      // P1
-    smt_[0x6][_ctx2] += (y2o - smt_[0x6][_ctx2]) >> 9;                      // P2
-    smt_[0x8][_ctx3] += (y2o - smt_[0x8][_ctx3]) >> 10;                     // P3
-    smt_[0xA][_ctx4] += (y2o - smt_[0xA][_ctx4]) >> 10;                     // P4
-
-    _ctx1 = *cp_[0x0];
-    _ctx2 = *cp_[0x1];
-    _ctx3 = *cp_[0x2];
-    _ctx4 = *cp_[0x3];
-    _ctx5 = *cp_[0x4];
-
-    Mixer_t::tx_[1] = Stretch256(smt_[0x4][_ctx1]);  // Conversion from 0..1048575 into -2048..2047
-    Mixer_t::tx_[2] = Stretch256(smt_[0x6][_ctx2]);  // Conversion from 0..1048575 into -2048..2047
-    Mixer_t::tx_[3] = Stretch256(smt_[0x8][_ctx3]);  // Conversion from 0..1048575 into -2048..2047
-    Mixer_t::tx_[4] = Stretch256(smt_[0xA][_ctx4]);  // Conversion from 0..1048575 into -2048..2047
-    Mixer_t::tx_[5] = Stretch256(smt_[0x5][_ctx5]);  // Conversion from 0..1048575 into -2048..2047
-    Mixer_t::tx_[6] = Stretch256(_ctx6[0]);          // Conversion from 0..1048575 into -2048..2047
-
+    _context.smt[0x4][_ctx1] += (y2o - _context.smt[0x4][_ctx1]) >> 9;                      // P1
+    _context.smt[0x6][_ctx2] += (y2o - _context.smt[0x6][_ctx2]) >> 9;                      // P2
+    _context.smt[0x8][_ctx3] += (y2o - _context.smt[0x8][_ctx3]) >> 10;                     // P3
+    _context.smt[0xA][_ctx4] += (y2o - _context.smt[0xA][_ctx4]) >> 10;                     // P4
+
+    _ctx1 = *_context.cp[0x0];
+    _ctx2 = *_context.cp[0x1];
+    _ctx3 = *_context.cp[0x2];
+    _ctx4 = *_context.cp[0x3];
+    _ctx5 = *_context.cp[0x4];
+
+    _context.tx[1] = Stretch256(_context.smt[0x4][_ctx1]);  // Conversion from 0..1048575 into -2048..2047
+    _context.tx[2] = Stretch256(_context.smt[0x6][_ctx2]);  // Conversion from 0..1048575 into -2048..2047
+    _context.tx[3] = Stretch256(_context.smt[0x8][_ctx3]);  // Conversion from 0..1048575 into -2048..2047
+    _context.tx[4] = Stretch256(_context.smt[0xA][_ctx4]);  // Conversion from 0..1048575 into -2048..2047
+    _context.tx[5] = Stretch256(_context.smt[0x5][_ctx5]);  // Conversion from 0..1048575 into -2048..2047
+    _context.tx[6] = Stretch256(_ctx6[0]);          // Conversion from 0..1048575 into -2048..2047
+
+    _lap(Profile::Model::Context);
     const auto pr{_mixer.Predict()};
-    _mxr_pr = _ax1.Predict(bit, pr, c2_ | c0_);
+    _lap(Profile::Model::Mixer);
+    _mxr_pr = _ax1.Predict(bit, pr, _context.c2 | _context.c0);
     const auto px{Balance(3u, Squash(pr), _mxr_pr)};  // Conversion from -2048..2047 (clamped) into 0..4095, Weight of 3 is based on enwik9
 
-    const auto py{_ax2.Predict(bit, Stretch(px), (fails_ * 8) + bcount_)};  // Conversion from 0..4095 into -2048..2047
+    const auto py{_ax2.Predict(bit, Stretch(px), (_context.fails * 8) + _context.bcount)};  // Conversion from 0..4095 into -2048..2047
     const auto pz{Balance(4u, _mxr_pr, py)};                                // Weight of 4 is based on enwik9
+    _lap(Profile::Model::APM);
     assert(pz < 0x1000);
     return pz;
   }
@@ -2479,45 +2665,46 @@ private:
   [[nodiscard]] auto Predict_not32s(const bool bit) noexcept -> uint32_t {
     auto y2o{(bit << 20) - bit};
 
-    const auto len{_lzp.Predict(bit)};        // len --> 0..9
-    _mixer.Context(_add2order + (64 * len));  // len --> 0..576 --> 10800+576+(9*8)
     _ctx6[0] += (y2o - _ctx6[0]) >> 6;        // (6) 6 is based on enwik9 (little influence)
-    _ctx6 = &smt_[_bc4cp0][_t0c1[1]];         // smt[0,1,2 or 3][...] with c0_=1
+    _ctx6 = &_context.smt[_bc4cp0][_t0c1[1]];         // smt[0,1,2 or 3][...] with c0=1
 
-    smt_[0x4][_ctx1] += (y2o - smt_[0x4][_ctx1]) >> 9;                      // P1
-    smt_[0x5][_ctx5] += (y2o - smt_[0x5][_ctx5]) * limits_15a(_ctx5) >> 9;  // P5
+    _context.smt[0x4][_ctx1] += (y2o - _context.smt[0x4][_ctx1]) >> 9;                      // P1
+    _context.smt[0x5][_ctx5] += (y2o - _context.smt[0x5][_ctx5]) * limits_15a(_ctx5) >> 9;  // P5
 
-    if (0x2000 == (0xFF00 & cx_)) {
+    if (0x2000 == (0xFF00 & _context.cx)) {
       y2o += 768;
-      smt_[0x7][_ctx2] += (y2o - smt_[0x7][_ctx2]) >> 10;  // P2
-      smt_[0x9][_ctx3] += (y2o - smt_[0x9][_ctx3]) >> 11;  // P3
-      smt_[0xB][_ctx4] += (y2o - smt_[0xB][_ctx4]) >> 11;  // P4
+      _context.smt[0x7][_ctx2] += (y2o - _context.smt[0x7][_ctx2]) >> 10;  // P2
+      _context.smt[0x9][_ctx3] += (y2o - _context.smt[0x9][_ctx3]) >> 11;  // P3
+      _context.smt[0xB][_ctx4] += (y2o - _context.smt[0xB][_ctx4]) >> 11;  // P4
     } else {
       y2o += 384;
-      smt_[0x6][_ctx2] += (y2o - smt_[0x6][_ctx2]) >> 9;   // P2
-      smt_[0x8][_ctx3] += (y2o - smt_[0x8][_ctx3]) >> 10;  // P3
-      smt_[0xA][_ctx4] += (y2o - smt_[0xA][_ctx4]) >> 9;   // P4
+      _context.smt[0x6][_ctx2] += (y2o - _context.smt[0x6][_ctx2]) >> 9;   // P2
+      _context.smt[0x8][_ctx3] += (y2o - _context.smt[0x8][_ctx3]) >> 10;  // P3
+      _context.smt[0xA][_ctx4] += (y2o - _context.smt[0xA][_ctx4]) >> 9;   // P4
     }
 
-    _ctx1 = *cp_[0x0];
-    _ctx2 = *cp_[0x1];
-    _ctx3 = *cp_[0x2];
-    _ctx4 = *cp_[0x3];
-    _ctx5 = *cp_[0x4];
+    _ctx1 = *_context.cp[0x0];
+    _ctx2 = *_context.cp[0x1];
+    _ctx3 = *_context.cp[0x2];
+    _ctx4 = *_context.cp[0x3];
+    _ctx5 = *_context.cp[0x4];
 
-    Mixer_t::tx_[1] = Stretch256(smt_[0x4][_ctx1]);  // Conversion from 0..1048575 into -2048..2047
-    Mixer_t::tx_[2] = Stretch256(smt_[0x6][_ctx2]);  // Conversion from 0..1048575 into -2048..2047
-    Mixer_t::tx_[3] = Stretch256(smt_[0x8][_ctx3]);  // Conversion from 0..1048575 into -2048..2047
-    Mixer_t::tx_[4] = Stretch256(smt_[0xA][_ctx4]);  // Conversion from 0..1048575 into -2048..2047
-    Mixer_t::tx_[5] = Stretch256(smt_[0x5][_ctx5]);  // Conversion from 0..1048575 into -2048..2047
-    Mixer_t::tx_[6] = Stretch256(_ctx6[0]);          // Conversion from 0..1048575 into -2048..2047
+    _context.tx[1] = Stretch256(_context.smt[0x4][_ctx1]);  // Conversion from 0..1048575 into -2048..2047
+    _context.tx[2] = Stretch256(_context.smt[0x6][_ctx2]);  // Conversion from 0..1048575 into -2048..2047
+    _context.tx[3] = Stretch256(_context.smt[0x8][_ctx3]);  // Conversion from 0..1048575 into -2048..2047
+    _context.tx[4] = Stretch256(_context.smt[0xA][_ctx4]);  // Conversion from 0..1048575 into -2048..2047
+    _context.tx[5] = Stretch256(_context.smt[0x5][_ctx5]);  // Conversion from 0..1048575 into -2048..2047
+    _context.tx[6] = Stretch256(_ctx6[0]);          // Conversion from 0..1048575 into -2048..2047
 
+    _lap(Profile::Model::Context);
     const auto pr{_mixer.Predict()};
-    const auto px{_ax1.Predict(bit, pr, c2_ | c0_)};
+    _lap(Profile::Model::Mixer);
+    const auto px{_ax1.Predict(bit, pr, _context.c2 | _context.c0)};
     _mxr_pr = Balance(2u, Squash(pr), px);  // Conversion from -2048..2047 (clamped) into 0..4095, Weight of 2 is based on enwik9
 
-    const auto py{_ax2.Predict(bit, Stretch(px), (fails_ * 8) + 7)};  // Conversion from 0..4095 into -2048..2047
+    const auto py{_ax2.Predict(bit, Stretch(px), (_context.fails * 8) + 7)};  // Conversion from 0..4095 into -2048..2047
     const auto pz{Balance(8u, _mxr_pr, py)};                          // Weight of 8 is based on enwik9
+    _lap(Profile::Model::APM);
     assert(pz < 0x1000);
     return pz;
   }
@@ -2525,36 +2712,37 @@ private:
   [[nodiscard]] auto Predict_was32(const bool bit) noexcept -> uint32_t {
     auto y2o{(bit << 20) - bit};
 
-    const auto len{_lzp.Predict(bit)};        // len --> 0..9
-    _mixer.Context(_add2order + (64 * len));  // len --> 0..576 --> 10800+576+(9*8)
     _ctx6[0] += (y2o - _ctx6[0]) >> 7;        // (8) 7 is based on enwik9 (little influence)
-    _ctx6 = &smt_[1][_t0c1[c0_]];
+    _ctx6 = &_context.smt[1][_t0c1[_context.c0]];
 
-    smt_[0x5][_ctx5] += (y2o - smt_[0x5][_ctx5]) * limits_15b(_ctx5) >> 10;  // P5
+    _context.smt[0x5][_ctx5] += (y2o - _context.smt[0x5][_ctx5]) * limits_15b(_ctx5) >> 10;  // P5
     y2o += 768;                                                              //
-    smt_[0x4][_ctx1] += (y2o - smt_[0x4][_ctx1]) >> 14;                      // P1
-    smt_[0x7][_ctx2] += (y2o - smt_[0x7][_ctx2]) >> 10;                      // P2
-    smt_[0x9][_ctx3] += (y2o - smt_[0x9][_ctx3]) >> 11;                      // P3
-    smt_[0xB][_ctx4] += (y2o - smt_[0xB][_ctx4]) >> 10;                      // P4
-
-    _ctx1 = *cp_[0x0];
-    _ctx2 = *cp_[0x1];
-    _ctx3 = *cp_[0x2];
-    _ctx4 = *cp_[0x3];
-    _ctx5 = *cp_[0x4];
-
-    Mixer_t::tx_[1] = Stretch256(smt_[0x4][_ctx1]);  // Conversion from 0..1048575 into -2048..2047
-    Mixer_t::tx_[2] = Stretch256(smt_[0x7][_ctx2]);  // Conversion from 0..1048575 into -2048..2047
-    Mixer_t::tx_[3] = Stretch256(smt_[0x9][_ctx3]);  // Conversion from 0..1048575 into -2048..2047
-    Mixer_t::tx_[4] = Stretch256(smt_[0xB][_ctx4]);  // Conversion from 0..1048575 into -2048..2047
-    Mixer_t::tx_[5] = Stretch256(smt_[0x5][_ctx5]);  // Conversion from 0..1048575 into -2048..2047
-    Mixer_t::tx_[6] = Stretch256(_ctx6[0]);          // Conversion from 0..1048575 into -2048..2047
-
+    _context.smt[0x4][_ctx1] += (y2o - _context.smt[0x4][_ctx1]) >> 14;                      // P1
+    _context.smt[0x7][_ctx2] += (y2o - _context.smt[0x7][_ctx2]) >> 10;                      // P2
+    _context.smt[0x9][_ctx3] += (y2o - _context.smt[0x9][_ctx3]) >> 11;                      // P3
+    _context.smt[0xB][_ctx4] += (y2o - _context.smt[0xB][_ctx4]) >> 10;                      // P4
+
+    _ctx1 = *_context.cp[0x0];
+    _ctx2 = *_context.cp[0x1];
+    _ctx3 = *_context.cp[0x2];
+    _ctx4 = *_context.cp[0x3];
+    _ctx5 = *_context.cp[0x4];
+
+    _context.tx[1] = Stretch256(_context.smt[0x4][_ctx1]);  // Conversion from 0..1048575 into -2048..2047
+    _context.tx[2] = Stretch256(_context.smt[0x7][_ctx2]);  // Conversion from 0..1048575 into -2048..2047
+    _context.tx[3] = Stretch256(_context.smt[0x9][_ctx3]);  // Conversion from 0..1048575 into -2048..2047
+    _context.tx[4] = Stretch256(_context.smt[0xB][_ctx4]);  // Conversion from 0..1048575 into -2048..2047
+    _context.tx[5] = Stretch256(_context.smt[0x5][_ctx5]);  // Conversion from 0..1048575 into -2048..2047
+    _context.tx[6] = Stretch256(_ctx6[0]);          // Conversion from 0..1048575 into -2048..2047
+
+    _lap(Profile::Model::Context);
     const auto pr{_mixer.Predict()};
-    _mxr_pr = _ax1.Predict(bit, pr, c2_ | c0_);
+    _lap(Profile::Model::Mixer);
+    _mxr_pr = _ax1.Predict(bit, pr, _context.c2 | _context.c0);
     const auto px{Balance(12u, Squash(pr), _mxr_pr)};                            // Conversion from -2048..2047 (clamped) into 0..4095, Weight of 12 is based on enwik9
-    const auto py{_ax2.Predict(bit, Stretch(_mxr_pr), (fails_ * 8) + bcount_)};  // Conversion from 0..4095 into -2048..2047
+    const auto py{_ax2.Predict(bit, Stretch(_mxr_pr), (_context.fails * 8) + _context.bcount)};  // Conversion from 0..4095 into -2048..2047
     const auto pz{Balance(6u, px, py)};                                          // Weight of 6 is based on enwik9
+    _lap(Profile::Model::APM);
     assert(pz < 0x1000);
     return pz;
   }
@@ -2562,48 +2750,64 @@ private:
   [[nodiscard]] auto Predict_was32s(const bool bit) noexcept -> uint32_t {
     auto y2o{(bit << 20) - bit};
 
-    const auto len{_lzp.Predict(bit)};        // len --> 0..9
-    _mixer.Context(_add2order + (64 * len));  // len --> 0..576 --> 10800+576+(9*8)
     _ctx6[0] += (y2o - _ctx6[0]) >> 13;       // (12) 13 is based on enwik9 (little influence)
-    _ctx6 = &smt_[1][_t0c1[1]];               // c0_=1
+    _ctx6 = &_context.smt[1][_t0c1[1]];               // c0=1
 
-    smt_[0x5][_ctx5] += (y2o - smt_[0x5][_ctx5]) * limits_15b(_ctx5) >> 14;  // P5
+    _context.smt[0x5][_ctx5] += (y2o - _context.smt[0x5][_ctx5]) * limits_15b(_ctx5) >> 14;  // P5
     y2o += 6144;                                                             //
-    smt_[4][_ctx1] += (y2o - smt_[4][_ctx1]) >> 14;                          // P1
+    _context.smt[4][_ctx1] += (y2o - _context.smt[4][_ctx1]) >> 14;                          // P1
 
-    if (0x2000 == (0xFF00 & cx_)) {
-      smt_[0x7][_ctx2] += (y2o - smt_[0x7][_ctx2]) >> 13;  // P2
-      smt_[0x9][_ctx3] += (y2o - smt_[0x9][_ctx3]) >> 14;  // P3
-      smt_[0xB][_ctx4] += (y2o - smt_[0xB][_ctx4]) >> 13;  // P4
+    if (0x2000 == (0xFF00 & _context.cx)) {
+      _context.smt[0x7][_ctx2] += (y2o - _context.smt[0x7][_ctx2]) >> 13;  // P2
+      _context.smt[0x9][_ctx3] += (y2o - _context.smt[0x9][_ctx3]) >> 14;  // P3
+      _context.smt[0xB][_ctx4] += (y2o - _context.smt[0xB][_ctx4]) >> 13;  // P4
     } else {
-      smt_[0x6][_ctx2] += (y2o - smt_[0x6][_ctx2]) >> 13;  // P2
-      smt_[0x8][_ctx3] += (y2o - smt_[0x8][_ctx3]) >> 14;  // P3
-      smt_[0xA][_ctx4] += (y2o - smt_[0xA][_ctx4]) >> 13;  // P4
+      _context.smt[0x6][_ctx2] += (y2o - _context.smt[0x6][_ctx2]) >> 13;  // P2
+      _context.smt[0x8][_ctx3] += (y2o - _context.smt[0x8][_ctx3]) >> 14;  // P3
+      _context.smt[0xA][_ctx4] += (y2o - _context.smt[0xA][_ctx4]) >> 13;  // P4
     }
 
-    _ctx1 = *cp_[0x0];
-    _ctx2 = *cp_[0x1];
-    _ctx3 = *cp_[0x2];
-    _ctx4 = *cp_[0x3];
-    _ctx5 = *cp_[0x4];
+    _ctx1 = *_context.cp[0x0];
+    _ctx2 = *_context.cp[0x1];
+    _ctx3 = *_context.cp[0x2];
+    _ctx4 = *_context.cp[0x3];
+    _ctx5 = *_context.cp[0x4];
 
-    Mixer_t::tx_[1] = Stretch256(smt_[0x4][_ctx1]);  // Conversion from 0..1048575 into -2048..2047
-    Mixer_t::tx_[2] = Stretch256(smt_[0x6][_ctx2]);  // Conversion from 0..1048575 into -2048..2047
-    Mixer_t::tx_[3] = Stretch256(smt_[0x8][_ctx3]);  // Conversion from 0..1048575 into -2048..2047
-    Mixer_t::tx_[4] = Stretch256(smt_[0xA][_ctx4]);  // Conversion from 0..1048575 into -2048..2047
-    Mixer_t::tx_[5] = Stretch256(smt_[0x5][_ctx5]);  // Conversion from 0..1048575 into -2048..2047
-    Mixer_t::tx_[6] = Stretch256(_ctx6[0]);          // Conversion from 0..1048575 into -2048..2047
+    _context.tx[1] = Stretch256(_context.smt[0x4][_ctx1]);  // Conversion from 0..1048575 into -2048..2047
+    _context.tx[2] = Stretch256(_context.smt[0x6][_ctx2]);  // Conversion from 0..1048575 into -2048..2047
+    _context.tx[3] = Stretch256(_context.smt[0x8][_ctx3]);  // Conversion from 0..1048575 into -2048..2047
+    _context.tx[4] = Stretch256(_context.smt[0xA][_ctx4]);  // Conversion from 0..1048575 into -2048..2047
+    _context.tx[5] = Stretch256(_context.smt[0x5][_ctx5]);  // Conversion from 0..1048575 into -2048..2047
+    _context.tx[6] = Stretch256(_ctx6[0]);          // Conversion from 0..1048575 into -2048..2047
 
+    _lap(Profile::Model::Context);
     const auto pr{_mixer.Predict()};
-    const auto px{_ax1.Predict(bit, pr, c2_ | c0_)};
+    _lap(Profile::Model::Mixer);
+    const auto px{_ax1.Predict(bit, pr, _context.c2 | _context.c0)};
     _mxr_pr = Balance(6u, Squash(pr), px);  // Conversion from -2048..2047 (clamped) into 0..4095, Weight of 6 is based on enwik9
 
-    const auto py{_ax2.Predict(bit, Stretch(px), (fails_ * 8) + 7)};  // Conversion from 0..4095 into -2048..2047
+    const auto py{_ax2.Predict(bit, Stretch(px), (_context.fails * 8) + 7)};  // Conversion from 0..4095 into -2048..2047
     const auto pz{Balance(12u, _mxr_pr, py)};                         // Weight of 12 is based on enwik9
+    _lap(Profile::Model::APM);
     assert(pz < 0x1000);
     return pz;
   }
 
+  /**
+   * Prefetch the slots of the lookups with the current hashes (hh), before they are needed
+   * @param zq Slot offset of the get1x() lookups, the get3a() and get3b() lookups use twice the offset
+   */
+  ALWAYS_INLINE void PrefetchSlots(const uint32_t zq) const noexcept {
+    if (_stalls.Cold()) {
+      return;  // --profile, lookups without prefetch to compare with
+    }
+    _t4b.Prefetch(zq + _context.hh[0]);
+    _t4a.Prefetch(zq + _context.hh[1]);
+    _t4a.Prefetch((zq * 2) + _context.hh[2]);
+    _t4b.Prefetch((zq * 2) + _context.hh[3]);
+    _t4b.Prefetch(zq + _context.hh[4]);
+  }
+
   void UpdateStates(const bool bit, int32_t context) noexcept {
     const auto& p{bit ? state_table_y1_ : state_table_y0_};
     int32_t r{1 & context};
@@ -2615,23 +2819,23 @@ private:
     toc[context] = q[2][toc[context]];
     r = r ^ ~0;  // 0 --> -1    1 --> -2
 
-    auto* const __restrict cp0{cp_[0]};
+    auto* const __restrict cp0{_context.cp[0]};
     cp0[0] = p[1][cp0[0]];
     cp0[r] = q[1][cp0[r]];
 
-    auto* const __restrict cp1{cp_[1]};
+    auto* const __restrict cp1{_context.cp[1]};
     cp1[0] = p[0][cp1[0]];  // in lpaq9m 4 for was32
     cp1[r] = q[0][cp1[r]];
 
-    auto* const __restrict cp2{cp_[2]};
+    auto* const __restrict cp2{_context.cp[2]};
     cp2[0] = p[3][cp2[0]];
     cp2[r] = q[3][cp2[r]];
 
-    auto* const __restrict cp3{cp_[3]};
+    auto* const __restrict cp3{_context.cp[3]};
     cp3[0] = p[4][cp3[0]];
     cp3[r] = q[4][cp3[r]];
 
-    auto* const __restrict cp4{cp_[4]};
+    auto* const __restrict cp4{_context.cp[4]};
     cp4[0] = p[5][cp4[0]];  // In lpaq9m cycles between 5,3,1,5,..
     cp4[r] = q[5][cp4[r]];  // Staying in 5 performs better
   }
@@ -2641,10 +2845,10 @@ private:
 #if 0
     static constexpr std::array<const uint8_t, 16> lvl{{24, 44, 25, 45, 25, 64, 2, 26, 22, 51, 0, 44, 0, 3, 25, 42}};  // based on enwik9
     err /= 64;
-    const uint32_t v{(err >= lvl[(2 * bcount_) + 1]) ? 3u : (err >= lvl[2 * bcount_]) ? 1u : 0u};
+    const uint32_t v{(err >= lvl[(2 * _context.bcount) + 1]) ? 3u : (err >= lvl[2 * _context.bcount]) ? 1u : 0u};
 #elif 0
     uint32_t v{0};
-    switch (bcount_) {  // clang-format off
+    switch (_context.bcount) {  // clang-format off
     default:
     case 0: if (err >= (24 * 64)) { v = 1; } if (err >= (44 * 64)) { v = 3; } break;
     case 1: if (err >= (25 * 64)) { v = 1; } if (err >= (45 * 64)) { v = 3; } break;
@@ -2666,95 +2870,131 @@ private:
         0xFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFD5_xxl,
         0xFFFFFFFFFFF555555554000000000000_xxl,
     }};
-    const uint32_t v{3u & uint32_t(cf[bcount_] >> (2 * (err / 64)))};
+    const uint32_t v{3u & uint32_t(cf[_context.bcount] >> (2 * (err / 64)))};
 #endif
     return v;
   }
 
   [[nodiscard]] auto Predict(const bool bit) noexcept -> uint32_t {
 #if 1
-    const auto MU{static_cast<int8_t>(INT64_C(0x06100F101A15282D) >> (8 * bcount_))};  // based on enwik9
+    const auto MU{static_cast<int8_t>(INT64_C(0x06100F101A15282D) >> (8 * _context.bcount))};  // based on enwik9
 #else
     //                                                 2D  28  15  1A  10  0F  10  6
     static constexpr std::array<const int8_t, 8> flaw{{45, 40, 21, 26, 16, 15, 16, 6}};  // based on enwik9
-    const int8_t MU{flaw[bcount_]};
+    const int8_t MU{flaw[_context.bcount]};
 #endif
 
-    fails_ += fails_;
-    bcount_ = 7 & (bcount_ - 1);
+    _context.fails += _context.fails;
+    _context.bcount = 7 & (_context.bcount - 1);
     // bpos_ = (bpos_ + 1) & 7;
 
     {
       const auto err{(bit << 12) - static_cast<int32_t>(_mxr_pr) - bit};
       const auto fail{(std::abs)(err)};
       if (fail >= MU) {
-        fails_ |= calcfails(uint32_t(fail));
+        _context.fails |= calcfails(uint32_t(fail));
         _mixer.Update(err);
       }
     }
+    _lap(Profile::Model::Mixer);
 
-    const auto cx{static_cast<int32_t>(c0_)};
-    c0_ += c0_ + static_cast<uint32_t>(bit);
+    const auto cx{static_cast<int32_t>(_context.c0)};
+    _context.c0 += _context.c0 + static_cast<uint32_t>(bit);
     _add2order += Mixer_t::N_LAYERS;
 
-    switch (bcount_) {
-      case 6:    // c0_ contains 1 bit
-      case 4:    // c0_ contains 3 bits
-      case 2:    // c0_ contains 5 bits
-      case 0: {  // c0_ contains 7 bits
+    switch (_context.bcount) {
+      case 6:    // c0 contains 1 bit
+      case 4:    // c0 contains 3 bits
+      case 2:    // c0 contains 5 bits
+      case 0: {  // c0 contains 7 bits
         const auto z{bit ? 2 : 1};
-        cp_[0] += z;
-        cp_[1] += z;
-        cp_[2] += z;
-        cp_[3] += z;
-        cp_[4] += z;
+        _context.cp[0] += z;
+        _context.cp[1] += z;
+        _context.cp[2] += z;
+        _context.cp[3] += z;
+        _context.cp[4] += z;
       } break;
 
-      case 5: {  // c0_ contains 2 bits
+      case 5: {  // c0 contains 2 bits
         UpdateStates(bit, cx);
-        auto zq{2 + (c0_ & 0x03) * 2};
-        cp_[0] = _t4b.get1x(0x00, zq + hh_[0]);  // 000 (0)
-        cp_[1] = _t4a.get1x(0x80, zq + hh_[1]);  // 100 (4)
-        cp_[4] = _t4b.get1x(0x00, zq + hh_[4]);  // 000 (0)
+        auto zq{2 + (_context.c0 & 0x03) * 2};
+        const auto start{_stalls.Start()};
+        _context.cp[0] = _t4b.get1x(0x00, zq + _context.hh[0]);  // 000 (0)
+        _context.cp[1] = _t4a.get1x(0x80, zq + _context.hh[1]);  // 100 (4)
+        _context.cp[4] = _t4b.get1x(0x00, zq + _context.hh[4]);  // 000 (0)
         zq *= 2;
-        cp_[2] = _t4a.get3a(0x00, zq + hh_[2]);  // 000 (0)
-        cp_[3] = _t4b.get3a(0x80, zq + hh_[3]);  // 100 (4)
+        _context.cp[2] = _t4a.get3a(0x00, zq + _context.hh[2]);  // 000 (0)
+        _context.cp[3] = _t4b.get3a(0x80, zq + _context.hh[3]);  // 100 (4)
+        _stalls.Stop(start, 5);
       } break;
 
-      case 1: {  // c0_ contains 6 bits
+      case 1: {  // c0 contains 6 bits
         UpdateStates(bit, cx);
-        auto zq{2 + (c0_ & 0x3F) * 2};
-        cp_[0] = _t4b.get1x(0xC0, zq + hh_[0]);  // 110 (6)
-        cp_[1] = _t4a.get1x(0x40, zq + hh_[1]);  // 010 (2)
-        cp_[4] = _t4b.get1x(0xC0, zq + hh_[4]);  // 110 (6)
+        auto zq{2 + (_context.c0 & 0x3F) * 2};
+        const auto start{_stalls.Start()};
+        _context.cp[0] = _t4b.get1x(0xC0, zq + _context.hh[0]);  // 110 (6)
+        _context.cp[1] = _t4a.get1x(0x40, zq + _context.hh[1]);  // 010 (2)
+        _context.cp[4] = _t4b.get1x(0xC0, zq + _context.hh[4]);  // 110 (6)
         zq *= 2;
-        cp_[2] = _t4a.get3b(0xC0, zq + hh_[2]);  // 110 (6)
-        cp_[3] = _t4b.get3b(0x40, zq + hh_[3]);  // 010 (2)
+        _context.cp[2] = _t4a.get3b(0xC0, zq + _context.hh[2]);  // 110 (6)
+        _context.cp[3] = _t4b.get3b(0x40, zq + _context.hh[3]);  // 010 (2)
+        _stalls.Stop(start, 5);
       } break;
 
-      case 3: {  // c0_ contains 4 bits
+      case 3: {  // c0 contains 4 bits
         UpdateStates(bit, cx);
-        const auto zq{2 + (c0_ & 0x0F) * 2};
+        const auto zq{2 + (_context.c0 & 0x0F) * 2};
         const auto blur{Utilities::PHI32 * zq};
-        const auto c4{cx_ & 0xFFFFFFFF};
-        const auto c8{cx_ >> 32};
-        hh_[0] = Finalise64(Hash(zq - hh_[0]), 32);
-        hh_[1] ^= blur;
-        hh_[2] = Finalise64(Hash(zq, c4, c8 & 0x000080FF), 32);
-        hh_[3] = Finalise64(Hash(zq, c4, c8 & 0x00FFFFFF), 32);
-        hh_[4] ^= blur;
-        cp_[0] = _t4b.get1x(0xA0, hh_[0]);  // 101 (5)
-        cp_[1] = _t4a.get1x(0x20, hh_[1]);  // 001 (1)
-        cp_[2] = _t4a.get3b(0xA0, hh_[2]);  // 101 (5)
-        cp_[3] = _t4b.get3b(0x20, hh_[3]);  // 001 (1)
-        cp_[4] = _t4b.get1x(0xA0, hh_[4]);  // 101 (5)
+        const auto c4{_context.cx & 0xFFFFFFFF};
+        const auto c8{_context.cx >> 32};
+        _context.hh[0] = Finalise64(Hash(zq - _context.hh[0]), 32);
+        _context.hh[1] ^= blur;
+        _context.hh[2] = Finalise64(Hash(zq, c4, c8 & 0x000080FF), 32);
+        _context.hh[3] = Finalise64(Hash(zq, c4, c8 & 0x00FFFFFF), 32);
+        _context.hh[4] ^= blur;
+        const auto start{_stalls.Start()};
+        _context.cp[0] = _t4b.get1x(0xA0, _context.hh[0]);  // 101 (5)
+        _context.cp[1] = _t4a.get1x(0x20, _context.hh[1]);  // 001 (1)
+        _context.cp[2] = _t4a.get3b(0xA0, _context.hh[2]);  // 101 (5)
+        _context.cp[3] = _t4b.get3b(0x20, _context.hh[3]);  // 001 (1)
+        _context.cp[4] = _t4b.get1x(0xA0, _context.hh[4]);  // 101 (5)
+        _stalls.Stop(start, 5);
+        PrefetchSlots((zq * 4) - 6);  // Slot range for c0 containing 6 bits
+        PrefetchSlots(zq * 4);
       } break;
 
       case 7:
-      default: {  // c0_ contains 8 bits (from previous cycle) --> Reset to 1 for new cycle
+      default: {  // c0 contains 8 bits (from previous cycle) --> Reset to 1 for new cycle
+        const auto ch{static_cast<uint8_t>(_context.c0)};
+        if (!_replay) {
+          _buf.Add(ch);
+        }
+        _context.cx = (_context.cx << 8) | ch;
+
+        if (const auto pc{static_cast<uint8_t>(_context.cx >> 8)}; (ch > 127) ||                  //
+                                                           (Utilities::is_lower(ch)) ||   //
+                                                           (Utilities::is_number(ch)) ||  //
+                                                           (Utilities::is_number(pc) && ('.' == ch))) {
+          _context.word = Combine64(_context.word, ch);
+        } else if (Utilities::is_upper(ch)) {
+          _context.word = Combine64(_context.word, Utilities::to_lower(ch));
+        } else {
+          _context.word = 0;
+        }
+
+        const auto c4{_context.cx & 0xFFFFFFFF};
+        const auto c8{_context.cx >> 32};
+        const auto ctx{_is_binary ? ExeContext(_buf) : (_context.cx & 0x0080FFFF)};
+        _context.hh[0] = Finalise64(Hash(ctx), 32);
+        _context.hh[1] = Finalise64(Hash(c4, WRT_mxr[static_cast<uint8_t>(_context.cx >> 24)]), 32);
+        _context.hh[2] = Finalise64(Hash(c4, c8 & 0x0000C0FF), 32);
+        _context.hh[3] = Finalise64(Hash(c4, c8 & 0x00FEFFFF, WRT_mxr[static_cast<uint8_t>(_context.cx >> 56)]), 32);
+        _context.hh[4] = Finalise64(Combine64(_context.word, WRT_mxr[ch]), 32);
+        _stalls.NextByte();
+        PrefetchSlots(0);  // Ahead of UpdateStates() and the rest of the byte bookkeeping, none of it depends on the new hashes
+
         UpdateStates(bit, cx);
-        const auto ch{static_cast<uint8_t>(c0_)};
-        c0_ = ch;
+        _context.c0 = ch;
         const auto idx{Mixer_t::N_LAYERS * 10u * 4u * WRT_mxr[ch]};  // 9*10*4*(0..30) --> 10800
         _add2order = idx;
 
@@ -2776,14 +3016,12 @@ private:
                                                                  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,    // E0-EF . . . . . . . . . . . . . . . .
                                                                  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7}};  // F0-FF . . . . . . . . . . . . . . . .
         if (!(0xFF & _pw)) {
-          c1_ = (static_cast<uint32_t>(WRT_mtt[ch]) << 2) + 33u;  // 0..61
+          _context.c1 = (static_cast<uint32_t>(WRT_mtt[ch]) << 2) + 33u;  // 0..61
         } else {
-          c1_ = (static_cast<uint32_t>(WRT_mtt[ch]) << 5) | (0x1F & _pw);  // 0..224 | (0..31)
+          _context.c1 = (static_cast<uint32_t>(WRT_mtt[ch]) << 5) | (0x1F & _pw);  // 0..224 | (0..31)
         }
-        c2_ = c1_ * 256;
+        _context.c2 = _context.c1 * 256;
 
-        _buf.Add(ch);
-        cx_ = (cx_ << 8) | ch;
         _t0c1 = &_t0[ch * 256];
 
         if (!(ch & 0x80)) {
@@ -2815,15 +3053,15 @@ private:
 
           if (const auto& filter{_is_binary ? ExeFilter : TxtFilter}; filter[ch]) {
 #endif
-            tt_ = (tt_ & UINT32_C(-8)) + 1;
-            w5_ = (w5_ << 8) | 0x3FF;
-            x5_ = (x5_ << 8) + ch;
+            _context.tt = (_context.tt & UINT32_C(-8)) + 1;
+            _context.w5 = (_context.w5 << 8) | 0x3FF;
+            _context.x5 = (_context.x5 << 8) + ch;
           }
         }
 
-        tt_ = (tt_ * 8) + WRT_mtt[ch];
-        w5_ = (w5_ * 4) + static_cast<uint32_t>(0xFU & (0x21000000111111111111224333144402_xxl >> (4 * (ch >> 3))));  // WRT_mpw
-        x5_ = (x5_ << 8) + ch;
+        _context.tt = (_context.tt * 8) + WRT_mtt[ch];
+        _context.w5 = (_context.w5 * 4) + static_cast<uint32_t>(0xFU & (0x21000000111111111111224333144402_xxl >> (4 * (ch >> 3))));  // WRT_mpw
+        _context.x5 = (_context.x5 << 8) + ch;
 
         //                                                       0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F              0 1 2 3 4 5 6 7 8 9 A B C D E F
         static constexpr std::array<const uint8_t, 256> WRT_wrd{{2, 3, 1, 1, 0, 1, 3, 0, 0, 0, 0, 1, 0, 0, 1, 0,    // 00-0F . . . . . . . . . . . . . . . .
@@ -2845,58 +3083,68 @@ private:
         _bc4cp0 = WRT_wrd[ch];
         _pw += _pw + (_bc4cp0 ? 1 : 0);
 
-        if (const auto pc{static_cast<uint8_t>(cx_ >> 8)}; (ch > 127) ||                  //
-                                                           (Utilities::is_lower(ch)) ||   //
-                                                           (Utilities::is_number(ch)) ||  //
-                                                           (Utilities::is_number(pc) && ('.' == ch))) {
-          word_ = Combine64(word_, ch);
-        } else if (Utilities::is_upper(ch)) {
-          word_ = Combine64(word_, Utilities::to_lower(ch));
-        } else {
-          word_ = 0;
+        const auto start{_stalls.Start()};
+        _context.cp[0] = _t4b.get1x(0xE0, _context.hh[0]);  // 111 (7)
+        _context.cp[1] = _t4a.get1x(0x60, _context.hh[1]);  // 011 (3)
+        _context.cp[2] = _t4a.get3a(0xE0, _context.hh[2]);  // 111 (7)
+        _context.cp[3] = _t4b.get3a(0x60, _context.hh[3]);  // 011 (3)
+        _context.cp[4] = _t4b.get1x(0xE0, _context.hh[4]);  // 111 (7)
+        _stalls.Stop(start, 5);
+        PrefetchSlots(2);  // Slot range for c0 containing 2 bits
+        PrefetchSlots(8);
+
+        _lap(Profile::Model::Context);
+        if constexpr (Set::HAS_DMC) {
+          _dmc->Update();
+          _lap(Profile::Model::DMC);
         }
-
-        const auto c4{cx_ & 0xFFFFFFFF};
-        const auto c8{cx_ >> 32};
-        const auto ctx{_is_binary ? ExeContext(_buf) : (cx_ & 0x0080FFFF)};
-        hh_[0] = Finalise64(Hash(ctx), 32);
-        hh_[1] = Finalise64(Hash(c4, WRT_mxr[static_cast<uint8_t>(cx_ >> 24)]), 32);
-        hh_[2] = Finalise64(Hash(c4, c8 & 0x0000C0FF), 32);
-        hh_[3] = Finalise64(Hash(c4, c8 & 0x00FEFFFF, WRT_mxr[static_cast<uint8_t>(cx_ >> 56)]), 32);
-        hh_[4] = Finalise64(Combine64(word_, WRT_mxr[ch]), 32);
-        cp_[0] = _t4b.get1x(0xE0, hh_[0]);  // 111 (7)
-        cp_[1] = _t4a.get1x(0x60, hh_[1]);  // 011 (3)
-        cp_[2] = _t4a.get3a(0xE0, hh_[2]);  // 111 (7)
-        cp_[3] = _t4b.get3a(0x60, hh_[3]);  // 011 (3)
-        cp_[4] = _t4b.get1x(0xE0, hh_[4]);  // 111 (7)
-
-        _dmc.Update();
         _lzp.Update();
-        _smm.Update();
+        _lap(Profile::Model::LZP);
+        if constexpr (Set::HAS_SMM) {
+          _smm->Update();
+          _lap(Profile::Model::SMM);
+        }
         _txt.Update();
+        _lap(Profile::Model::Txt);
 
         if (const auto pos{_buf.Pos()}; 0 == (pos & (256 * 1024 - 1))) {
-          if (((16 == dp_shift_) && (pos == (25 * 256 * 1024))) ||  // 22 or 25 based on enwik9 (little influence)
-              ((15 == dp_shift_) && (pos == (4 * 256 * 1024))) ||   // 2 or 4 based on enwik9 (little influence)
-              (14 == dp_shift_)) {
-            ++dp_shift_;
+          if (((16 == _context.dp_shift) && (pos == (25 * 256 * 1024))) ||  // 22 or 25 based on enwik9 (little influence)
+              ((15 == _context.dp_shift) && (pos == (4 * 256 * 1024))) ||   // 2 or 4 based on enwik9 (little influence)
+              (14 == _context.dp_shift)) {
+            ++_context.dp_shift;
             _mixer.ScaleUp();
           }
         }
 
-        c0_ = 1;
+        _context.c0 = 1;
       } break;
     }
 
-    _dmc.Predict(bit);
-    _smm.Predict(bit);
+    _lap(Profile::Model::Context);
+    if constexpr (Set::HAS_DMC) {
+      _dmc->Predict(bit);
+      _lap(Profile::Model::DMC);
+    }
+    if constexpr (Set::HAS_SMM) {
+      _smm->Predict(bit);
+      _lap(Profile::Model::SMM);
+    }
+    const auto len{_lzp.Predict(bit)};        // len --> 0..9
+    _lap(Profile::Model::LZP);
+    _mixer.Context(_add2order + (64 * len));  // len --> 0..576 --> 10800+576+(9*8)
+
+    const auto& px{_blend3x8.Predict((_context.w5 << 3) | _context.bcount)};
+    _context.tx[0] = px[static_cast<uint32_t>(Blend3x8_t::Lane::LZP)];
+    _context.tx[7] = px[static_cast<uint32_t>(Blend3x8_t::Lane::DMC)];
+    _context.tx[8] = px[static_cast<uint32_t>(Blend3x8_t::Lane::SMM)];
+    _lap(Profile::Model::Blend);
 
     uint32_t pr;
 
     if (32 == _buf(1)) {
-      pr = (7 == bcount_) ? Predict_was32s(bit) : Predict_was32(bit);
+      pr = (7 == _context.bcount) ? Predict_was32s(bit) : Predict_was32(bit);
     } else {
-      pr = (7 == bcount_) ? Predict_not32s(bit) : Predict_not32(bit);
+      pr = (7 == _context.bcount) ? Predict_not32s(bit) : Predict_not32(bit);
     }
 
     if (const auto [has_prediction, prediction]{_txt.Predict(bit)}; has_prediction) {
@@ -2905,64 +3153,296 @@ private:
     } else {
       _pt = 0x7FF;  // No prediction
     }
+    _lap(Profile::Model::Txt);
     assert(pr < 0x1000);
     return pr;
   }
 };
-Predict_t::~Predict_t() noexcept = default;
+template <typename Set>
+Predict_t<Set>::~Predict_t() noexcept = default;
 
 /**
- * @class Encoder_t
- * @brief Arithmetic coding
+ * @class Bypass_t
+ * @brief Codes incompressible data (compressed media, encrypted data) without running the models
  *
- * Arithmetic coding, encoder and decoder
+ * The cost of the model predictions is measured over windows of MODEL_WINDOW bytes, after a window costing at
+ * least ENTER per byte the following bytes are coded as stored bytes (probability of 1/2) and only added to the
+ * buffer. During the bypass an order-0 model measures the data in shorter windows, a compressible window ends the
+ * bypass quickly (e.g. at the decoded data of an embedded stream), otherwise the models are probed again after a
+ * span that doubles up to MAX_SPAN bytes.
+ * Data can look random at order 0 and still be full of matches (e.g. object files), an order-4 match predictor runs
+ * in both modes: a window with more than 1 in MATCH_RATIO bytes predicted keeps or brings the models in, and a span
+ * with such matches does not double.
+ * All decisions depend on coded data only, so the decoder switches at the same bits as the encoder.
  */
-class Encoder_t final : public iEncoder_t {
+class Bypass_t final {
 public:
-  explicit Encoder_t(Buffer_t& __restrict buf, bool encode, File_t& file) noexcept
-      : _stream{file},  //
-        _predict{std::make_unique<Predict_t>(buf)} {
-    if (!encode) {
-      _x = _stream.get32();
+  Bypass_t() noexcept = default;
+  ~Bypass_t() noexcept = default;
+
+  Bypass_t(const Bypass_t&) = delete;
+  Bypass_t(Bypass_t&&) = delete;
+  auto operator=(const Bypass_t&) -> Bypass_t& = delete;
+  auto operator=(Bypass_t&&) -> Bypass_t& = delete;
+
+  [[nodiscard]] auto Active() const noexcept -> bool {
+    return _active;
+  }
+
+  /**
+   * Update with a coded bit, at the end of a byte decide if the next byte is bypassed
+   * @param bit The coded bit
+   * @param pr16 Prediction of the models for the bit 0..65535, not used during the bypass
+   * @return The completed byte, -1 within a byte
+   */
+  [[nodiscard]] auto Update(const bool bit, const uint32_t pr16) noexcept -> int32_t {
+    if (_active) {
+      auto& pr{_order0[_c0]};
+      _cost += Cost(bit, pr);
+      pr = bit ? (pr + ((0x10000 - pr) >> 5)) : (pr - (pr >> 5));
+    } else {
+      _cost += Cost(bit, pr16);
     }
+    _c0 += _c0 + bit;
+    if (_c0 < 0x100) {
+      return -1;
+    }
+    const auto ch{static_cast<int32_t>(0xFF & _c0)};
+    _c0 = 1;
+    Match(static_cast<uint8_t>(ch));
+    Decide();
+    return ch;
+  }
 
-    std::fill(&smt_[0][0], &smt_[0][0] + sizeof(smt_) / sizeof(smt_[0][0]), 0x07FFFF);
+private:
+  static constexpr uint32_t MODEL_WINDOW{4096};           // Bytes
+  static constexpr uint32_t BYPASS_WINDOW{256};           // Bytes
+  static constexpr uint32_t ENTER{(8 * 256) - 8};         // 7.97 bits per byte in 1/256 bits, on incompressible data the models hover around 8
+  static constexpr uint32_t LEAVE{(7 * 256) + 128};       // 7.5 bits per byte in 1/256 bits, of the order-0 model
+  static constexpr uint32_t MIN_SPAN{UINT32_C(1) << 16};  // Bytes
+  static constexpr uint32_t MAX_SPAN{UINT32_C(1) << 20};  // Bytes
+  static constexpr uint32_t MATCH_RATIO{32};              // On random data about 1 in 256 bytes is predicted
 
-    for (uint32_t i{6}; i-- > 0;) {
-      int32_t* j{&smt_[0xF & (0x578046 >> (i * 4))][0]};
-      uint8_t p1{state_table_y0_[i][0]};
-      uint8_t p2{state_table_y0_[i][0]};
-      uint8_t p3{state_table_y1_[i][0]};
-      uint8_t p4{state_table_y1_[i][0]};
-      p1 = state_table_y0_[i][p1];
-      j[p1] = (0xFFFFF * 1) / 4;
-      p2 = state_table_y1_[i][p2];
-      j[p2] = (0xFFFFF * 2) / 4;
-      p3 = state_table_y0_[i][p3];
-      j[p3] = (0xFFFFF * 2) / 4;
-      p4 = state_table_y1_[i][p4];
-      j[p4] = (0xFFFFF * 3) / 4;
-      uint8_t p5{p4};
-      uint8_t p6{p1};
-      for (auto z{5}; z < 70; ++z) {
-        uint8_t px;
-        // clang-format off
-        px = p1; p1 = state_table_y0_[i][p1];                           if (p1 != px) { j[p1] = (0xFFFFF * (    1)) / z; }
-        px = p2; p2 = state_table_y1_[i][p2];                           if (p2 != px) { j[p2] = (0xFFFFF * (z - 2)) / z; }
-        px = p3; p3 = state_table_y0_[i][p3];                           if (p3 != px) { j[p3] = (0xFFFFF * (    2)) / z; }
-        px = p4; p4 = state_table_y1_[i][p4];                           if (p4 != px) { j[p4] = (0xFFFFF * (z - 1)) / z; }
-        px = p5; p5 = state_table_y0_[i][p5]; if (p5 < px) { p5 = px; } if (p5 != px) { j[p5] = (0xFFFFF * (    3)) / z; }
-        px = p6; p6 = state_table_y1_[i][p6]; if (p6 < px) { p6 = px; } if (p6 != px) { j[p6] = (0xFFFFF * (z - 3)) / z; }
-        // clang-format on
+  /**
+   * Cost of a coded bit, integer only as the encoder and decoder must always agree
+   * @param bit The coded bit
+   * @param pr16 Prediction for the bit 0..65535
+   * @return The cost in 1/256 bits
+   */
+  [[nodiscard]] static auto Cost(const bool bit, const uint32_t pr16) noexcept -> uint32_t {
+    static constexpr std::array<const uint8_t, 256> LOG2{{  0,   1,   3,   4,   6,   7,   9,  10,  11,  13,  14,  16,  17,  18,  20,  21,
+                                                            22,  24,  25,  26,  28,  29,  30,  32,  33,  34,  36,  37,  38,  40,  41,  42,
+                                                            44,  45,  46,  47,  49,  50,  51,  52,  54,  55,  56,  57,  59,  60,  61,  62,
+                                                            63,  65,  66,  67,  68,  69,  71,  72,  73,  74,  75,  77,  78,  79,  80,  81,
+                                                            82,  84,  85,  86,  87,  88,  89,  90,  92,  93,  94,  95,  96,  97,  98,  99,
+                                                           100, 102, 103, 104, 105, 106, 107, 108, 109, 110, 111, 112, 113, 114, 116, 117,
+                                                           118, 119, 120, 121, 122, 123, 124, 125, 126, 127, 128, 129, 130, 131, 132, 133,
+                                                           134, 135, 136, 137, 138, 139, 140, 141, 142, 143, 144, 145, 146, 147, 148, 149,
+                                                           150, 151, 152, 153, 154, 155, 155, 156, 157, 158, 159, 160, 161, 162, 163, 164,
+                                                           165, 166, 167, 168, 169, 169, 170, 171, 172, 173, 174, 175, 176, 177, 178, 178,
+                                                           179, 180, 181, 182, 183, 184, 185, 185, 186, 187, 188, 189, 190, 191, 192, 192,
+                                                           193, 194, 195, 196, 197, 198, 198, 199, 200, 201, 202, 203, 203, 204, 205, 206,
+                                                           207, 208, 208, 209, 210, 211, 212, 212, 213, 214, 215, 216, 216, 217, 218, 219,
+                                                           220, 220, 221, 222, 223, 224, 224, 225, 226, 227, 228, 228, 229, 230, 231, 231,
+                                                           232, 233, 234, 234, 235, 236, 237, 238, 238, 239, 240, 241, 241, 242, 243, 244,
+                                                           244, 245, 246, 247, 247, 248, 249, 249, 250, 251, 252, 252, 253, 254, 255, 255}};  // round(256 * log2(1 + (i / 256)))
+    const auto p{(std::max)(UINT32_C(1), bit ? pr16 : 0x10000 - pr16)};  // 1..65536
+    const auto msb{static_cast<uint32_t>(31 - std::countl_zero(p))};
+    const auto log2p{(msb << 8) + LOG2[0xFF & ((p << 8) >> msb)]};
+    return (16u << 8) - log2p;
+  }
+
+  /**
+   * Count the byte when it is the one that followed the last 4 bytes before
+   * @param ch The completed byte
+   */
+  void Match(const uint8_t ch) noexcept {
+    auto& expected{_expected[(_last4 * UINT32_C(0x9E3779B1)) >> 16]};
+    if (expected == ch) {
+      ++_hits;
+      ++_span_hits;
+    }
+    expected = ch;
+    _last4 = (_last4 << 8) | ch;
+  }
+
+  void Decide() noexcept {
+    if (_active && (0 == --_remaining)) {  // Probe the models again
+      _active = false;
+      _span = ((_span_hits * MATCH_RATIO) < _span) ? (std::min)(2 * _span, MAX_SPAN) : MIN_SPAN;
+      Restart();
+      return;
+    }
+    if (++_bytes < (_active ? BYPASS_WINDOW : MODEL_WINDOW)) {
+      return;
+    }
+    const auto cost{_cost / _bytes};
+    const auto matching{(_hits * MATCH_RATIO) >= _bytes};
+    if (_active) {
+      if ((cost < LEAVE) || matching) {
+        _active = false;
+        _span = MIN_SPAN;
+      }
+    } else if ((cost >= ENTER) && !matching) {
+      _active = true;
+      _remaining = _span;
+      _span_hits = 0;
+    } else {
+      _span = MIN_SPAN;
+    }
+    Restart();
+  }
+
+  void Restart() noexcept {
+    _cost = 0;
+    _bytes = 0;
+    _hits = 0;
+  }
+
+  std::array<uint32_t, 0x100> _order0{[]() {
+    std::array<uint32_t, 0x100> order0{};
+    order0.fill(0x8000);
+    return order0;
+  }()};
+  std::array<uint8_t, 0x10000> _expected{};  // Byte that followed the hash of the last 4 bytes
+  uint32_t _c0{1};
+  uint32_t _cost{0};   // Of the current window, in 1/256 bits
+  uint32_t _bytes{0};  // In the current window
+  uint32_t _hits{0};   // Predicted bytes in the current window
+  uint32_t _last4{0};
+  uint32_t _span{MIN_SPAN};
+  uint32_t _span_hits{0};  // Predicted bytes in the bypass
+  uint32_t _remaining{0};  // Bytes left in the bypass
+  bool _active{false};
+  int32_t : 24;  // Padding
+};
+
+/**
+ * @class Run_t
+ * @brief Codes long runs of a byte or of a short pattern (zero fill, padding) without running the models
+ *
+ * After MIN_RUN bytes equal to the byte MAX_PERIOD or fewer bytes back, each bit of the following bytes is
+ * predicted to continue the pattern with a probability that grows with the length of the run, a run of n bits
+ * costs about log2(n) bits in total. The bytes of the run are only added to the buffer, the bit that breaks
+ * the run hands the coding back to the models, which first catch up on the pattern (see Predict_t::CatchUp).
+ * All decisions depend on coded data only, so the decoder switches at the same bits as the encoder.
+ * Like Bypass_t only used when the format byte has FORMAT_BYPASS, files of the original format are coded by the models alone.
+ */
+class Run_t final {
+public:
+  Run_t() noexcept = default;
+  ~Run_t() noexcept = default;
+
+  Run_t(const Run_t&) = delete;
+  Run_t(Run_t&&) = delete;
+  auto operator=(const Run_t&) -> Run_t& = delete;
+  auto operator=(Run_t&&) -> Run_t& = delete;
+
+  [[nodiscard]] auto Active() const noexcept -> bool {
+    return _period > 0;
+  }
+
+  /**
+   * @return Prediction of the next bit of the run 0..65535
+   */
+  [[nodiscard]] auto Pr() const noexcept -> uint32_t {
+    const auto width{static_cast<uint32_t>(32 - std::countl_zero(_hits))};
+    const auto miss{0x10000u >> (std::min)(width, 16u)};  // 1/65536..1/2
+    return (1 & (Expected() >> _bit)) ? 0x10000 - miss : miss;
+  }
+
+  /**
+   * Update with a coded bit of a run byte
+   * @param bit The coded bit
+   * @return false when the bit breaks the run
+   */
+  [[nodiscard]] auto Next(const bool bit) noexcept -> bool {
+    _c0 += _c0 + bit;
+    if (bit != (1 & (Expected() >> _bit))) {
+      _lag = _skipped % _period;
+      _period = 0;
+      return false;
+    }
+    --_bit;
+    ++_hits;
+    return true;
+  }
+
+  /**
+   * Update with a completed byte, decide if the next byte is coded as part of a run
+   * @param ch The byte
+   */
+  void Add(const uint8_t ch) noexcept {
+    const auto hit{_period > 0};
+    for (uint32_t p{0}; p < MAX_PERIOD; ++p) {
+      _matches[p] = (ch == static_cast<uint8_t>(_history >> (8 * p))) ? _matches[p] + 1 : 0;
+    }
+    _history = (_history << 8) | ch;
+    _c0 = 1;
+    _bit = 7;
+    if (hit) {
+      ++_skipped;
+      return;
+    }
+    for (uint32_t p{0}; p < MAX_PERIOD; ++p) {  // The shortest pattern
+      if (_matches[p] >= MIN_RUN) {
+        _period = p + 1;
+        _hits = 8 * _matches[p];
+        _skipped = 0;
+        return;
       }
     }
+  }
 
-    memcpy(&smt_[0x1], &smt_[0x0], smt_[0x0].size());
-    memcpy(&smt_[0x2], &smt_[0x0], smt_[0x0].size());
-    memcpy(&smt_[0x3], &smt_[0x0], smt_[0x0].size());
-    memcpy(&smt_[0x9], &smt_[0x8], smt_[0x8].size());
-    memcpy(&smt_[0xA], &smt_[0x7], smt_[0x7].size());
-    memcpy(&smt_[0xB], &smt_[0x7], smt_[0x7].size());
+  /**
+   * @return Skipped bytes the models need to learn to be in phase with the pattern, when the run is broken
+   */
+  [[nodiscard]] auto Lag() const noexcept -> uint32_t {
+    return _lag;
+  }
+
+  /**
+   * @return The coded bits of the current byte, with a leading 1
+   */
+  [[nodiscard]] auto Partial() const noexcept -> uint32_t {
+    return _c0;
+  }
+
+private:
+  static constexpr uint32_t MAX_PERIOD{8};   // Bytes
+  static constexpr uint32_t MIN_RUN{16384};  // Bytes, the models predict shorter runs better than Pr() does
+
+  [[nodiscard]] auto Expected() const noexcept -> uint32_t {
+    return static_cast<uint8_t>(_history >> (8 * (_period - 1)));
+  }
+
+  uint64_t _history{0};  // Last MAX_PERIOD bytes
+  std::array<uint32_t, MAX_PERIOD> _matches{};  // Bytes equal to the byte 1..MAX_PERIOD bytes back
+  uint32_t _period{0};   // Of the run, 0 when there is none
+  uint32_t _hits{0};     // Bits in the run
+  uint32_t _skipped{0};  // Bytes in the run not seen by the models
+  uint32_t _lag{0};
+  uint32_t _c0{1};
+  uint32_t _bit{7};
+};
+
+/**
+ * @class Encoder_t
+ * @brief Arithmetic coding
+ * @tparam Set The models of Predict_t, a ModelSet_t
+ *
+ * Arithmetic coding, encoder and decoder
+ */
+template <typename Set>
+class Encoder_t final : public iEncoder_t {
+public:
+  explicit Encoder_t(Buffer_t& __restrict buf, bool encode, File_t& file, const int32_t level, const bool bypass) noexcept
+      : _stream{file},  //
+        _predict{std::make_unique<Predict_t<Set>>(buf, level)},
+        _bypassing{bypass} {
+    if (!encode) {
+      _x = _stream.get32();
+    }
   }
   ~Encoder_t() noexcept override;
 
@@ -2973,12 +3453,14 @@ public:
   auto operator=(Encoder_t&&) -> Encoder_t& = delete;
 
   void Compress(const int32_t c) noexcept final {
+    const Profile::Scope_t scope{Profile::Phase::CmLoop};
     for (auto n{8}; n-- > 0;) {
       Code((c >> n) & 1);
     }
   }
 
   [[nodiscard]] auto Decompress() noexcept -> int32_t final {
+    const Profile::Scope_t scope{Profile::Phase::CmLoop};
     auto c{0};
     for (auto n{8}; n-- > 0;) {
       c += c + Code();
@@ -3046,13 +3528,72 @@ public:
   }
 
 private:
+  enum class Mode : uint32_t {
+    Model,   // Predict_t
+    Bypass,  // Bypass_t
+    Run      // Run_t
+  };
+
   static constexpr auto _mask{UINT32_C(0xFF000000)};
   File_t& _stream;
-  std::unique_ptr<Predict_t> _predict;
+  std::unique_ptr<Predict_t<Set>> _predict;
+  Bypass_t _bypass{};
+  Run_t _run{};
   uint32_t _high{UINT32_C(~0)};
   uint32_t _low{0};
   uint32_t _x{0};
-  uint32_t _pr{0x7FFF};  // Prediction 0x0000..0xFFFF
+  uint32_t _pr{0x7FFF};        // Prediction 0x0000..0xFFFF
+  uint32_t _model_pr{0x7FFF};  // Prediction of the models, also during the bypass
+  Mode _mode{Mode::Model};     // Of the current byte
+  const bool _bypassing;       // Bypass_t and Run_t are used, not in files of the original format
+  int32_t : 24;                // Padding
+
+  /**
+   * Update the models, or only the buffer during a bypass or run, with a coded bit
+   * @param bit The coded bit
+   * @return Prediction of the next bit 0x0000..0xFFFF
+   */
+  [[nodiscard]] auto Next(const bool bit) noexcept -> uint32_t {
+    if (!_bypassing) {
+      return _predict->Next(bit);
+    }
+    if (Mode::Model == _mode) {
+      _model_pr = _predict->Next(bit);  // Update models and Predict next bit probability
+    } else if ((Mode::Run == _mode) && !_run.Next(bit)) {
+      _model_pr = CatchUp();
+      _mode = Mode::Model;
+    }
+    if (const auto ch{_bypass.Update(bit, _pr)}; ch >= 0) {
+      if (Mode::Model != _mode) {
+        _predict->Skip(static_cast<uint8_t>(ch));
+      }
+      _run.Add(static_cast<uint8_t>(ch));
+      _mode = _run.Active() ? Mode::Run : (_bypass.Active() ? Mode::Bypass : Mode::Model);
+    }
+    switch (_mode) {
+      case Mode::Run:
+        return _run.Pr();
+      case Mode::Bypass:
+        return 0x8000;
+      case Mode::Model:
+      default:
+        return _model_pr;
+    }
+  }
+
+  /**
+   * The run is broken, the models learn the skipped bytes needed to be in phase and the bits of the current byte
+   * @return Prediction of the models for the next bit 0x0000..0xFFFF
+   */
+  [[nodiscard]] auto CatchUp() noexcept -> uint32_t {
+    _predict->CatchUp(_run.Lag());
+    const auto partial{_run.Partial()};
+    uint32_t pr{0x7FFF};
+    for (auto n{31 - std::countl_zero(partial)}; n-- > 0;) {
+      pr = _predict->Next((partial >> n) & 1);
+    }
+    return pr;
+  }
 
   [[nodiscard]] ALWAYS_INLINE constexpr auto Rescale() const noexcept -> uint32_t {
     assert(_pr < 0x10000);
@@ -3080,7 +3621,7 @@ private:
       _high = (_high << 8) | 0xFF;
       _low <<= 8;
     }
-    _pr = _predict->Next(bit);  // Update models and Predict next bit probability
+    _pr = Next(bit);
   }
 
   [[nodiscard]] auto Code() noexcept -> bool {
@@ -3097,11 +3638,12 @@ private:
       _low <<= 8;
       _x = (_x << 8) | (_stream.getc() & 0xFF);  // EOF is OK
     }
-    _pr = _predict->Next(bit);  // Update models and Predict next bit probability
+    _pr = Next(bit);
     return bit;
   }
 };
-Encoder_t::~Encoder_t() noexcept = default;
+template <typename Set>
+Encoder_t<Set>::~Encoder_t() noexcept = default;
 iEncoder_t::~iEncoder_t() noexcept = default;
 
 /**
@@ -3145,6 +3687,51 @@ private:
 };
 Monitor_t::~Monitor_t() noexcept = default;
 
+/**
+ * @class BlockMonitor_t
+ * @brief Monitor interface for tracking block-parallel encode/decode progress
+ *
+ * Monitor interface for tracking block-parallel encode/decode progress,
+ * the worker threads add the bytes they processed
+ */
+class BlockMonitor_t final : public iMonitor_t {
+public:
+  explicit BlockMonitor_t(const int64_t workLength, const int64_t layoutLength) noexcept
+      : _workLength{workLength},  //
+        _layoutLength{layoutLength} {}
+  ~BlockMonitor_t() noexcept override;
+
+  BlockMonitor_t(const BlockMonitor_t&) = delete;
+  BlockMonitor_t(BlockMonitor_t&&) = delete;
+  auto operator=(const BlockMonitor_t&) -> BlockMonitor_t& = delete;
+  auto operator=(BlockMonitor_t&&) -> BlockMonitor_t& = delete;
+
+  void Update(const int64_t in, const int64_t out) noexcept {
+    _in.fetch_add(in, std::memory_order_relaxed);
+    _out.fetch_add(out, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] auto InputLength() const noexcept -> int64_t final {
+    return _in.load(std::memory_order_relaxed);
+  }
+  [[nodiscard]] auto OutputLength() const noexcept -> int64_t final {
+    return _out.load(std::memory_order_relaxed);
+  }
+  [[nodiscard]] auto WorkLength() const noexcept -> int64_t final {
+    return _workLength;
+  }
+  [[nodiscard]] auto LayoutLength() const noexcept -> int64_t final {
+    return _layoutLength;
+  }
+
+private:
+  std::atomic<int64_t> _in{0};
+  std::atomic<int64_t> _out{0};
+  const int64_t _workLength;
+  const int64_t _layoutLength;
+};
+BlockMonitor_t::~BlockMonitor_t() noexcept = default;
+
 namespace {
   [[nodiscard]] auto Checksum(const uint8_t* __restrict data, size_t len) noexcept -> uint8_t {
     uint8_t sum{0};
@@ -3154,134 +3741,610 @@ namespace {
     return sum;
   }
 
-  constexpr std::array<const char, 17> short_options{{"cdhvV0123456789x"}};
-  constexpr std::array<const struct option, 10> long_options{{{"verbose", no_argument, &verbose_, 1},     //
-                                                              {"brief", no_argument, &verbose_, 0},       //
-                                                              {"compress", no_argument, nullptr, 'c'},    //
-                                                              {"decompress", no_argument, nullptr, 'd'},  //
-                                                              {"best", no_argument, nullptr, '9'},        //
-                                                              {"fast", no_argument, nullptr, '0'},        //
-                                                              {"help", no_argument, nullptr, 'h'},        //
-                                                              {"version", no_argument, nullptr, 'V'},     //
-#if defined(TUNING) || defined(GENERATE_SQUASH_STRETCH)
-                                                              {"xx", required_argument, nullptr, 'x'},
-#else
-                                                              {nullptr, no_argument, nullptr, 0},
-#endif
-                                                              {nullptr, no_argument, nullptr, 0}}};
-};  // namespace
-
-auto main(int32_t argc, char* const argv[]) -> int32_t {
-  // clang-format off
-  std::set_new_handler([]() { fprintf(stderr, "\nFailed to allocate memory!"); std::abort(); });
-  std::set_terminate  ([]() { fprintf(stderr, "\nUnhandled exception");        std::abort(); });
-  // clang-format on
-
-  fprintf(stdout,
-          "Moruga compressor (C) 2023, M.W. Hessel.\n"
-          "Based on PAQ compressor series by M. Mahoney.\n"
-          "Free under GPL, https://www.gnu.org/licenses/\n"
-          "https://github.com/the-m-master/Moruga/\n");
+  constexpr int32_t BLOCK_MARKER{0x80};                  // Set in the memory level byte when the file holds a block table
+  constexpr int32_t STREAM_MARKER{0x40};                 // Set in the memory level byte when the file holds a stream of frames
+  constexpr int32_t FORMAT_MARKER{0x20};                 // Set in the memory level byte when a format byte follows, files of the original format have none
+  constexpr int32_t MODEL_SET_MASK{0x10};                // Bits of the model set in the memory level byte
+  constexpr int32_t MODEL_SET_SHIFT{4};                  // Lowest bit of the model set in the memory level byte
+  constexpr int32_t LEVEL_MASK{0x0F};                    // Bits of the memory option in the memory level byte
+  constexpr int32_t FORMAT_BYPASS{0x01};                 // Set in the format byte when Bypass_t and Run_t are used
+  constexpr int32_t FORMAT_KNOWN{FORMAT_BYPASS};         // All bits of the format byte this version can decode
+  constexpr int64_t STREAM_FRAME_SIZE{INT64_C(16) << 20};  // Default frame size of a stream
+  constexpr int64_t MIN_BLOCK_SIZE{INT64_C(1) << 20};      // Smallest block of a block file, only the last block can be shorter
 
-  level_ = DEFAULT_OPTION;
-  bool help{false};
-  bool compress{true};
+  /**
+   * Write the memory level byte, including the model set, followed by the format byte.
+   * Without bypass the original format is written, only the memory level byte.
+   * @param outfile The compressed file
+   * @param marker BLOCK_MARKER, STREAM_MARKER or 0
+   * @param options The settings
+   */
+  void PutLevel(const File_t& outfile, const int32_t marker, const Options_t& options) noexcept {
+    assert((options.level >= 0) && (options.level <= 12));
+    const auto level{marker | (static_cast<int32_t>(options.model_set) << MODEL_SET_SHIFT) | options.level};
+    if (options.bypass) {
+      outfile.putc(FORMAT_MARKER | level);
+      outfile.putc(FORMAT_BYPASS);
+    } else {
+      outfile.putc(level);
+    }
+  }
 
-  for (int32_t command{0}; -1 != (command = getopt_long(argc, argv, short_options.data(), long_options.data(), nullptr));) {
-    switch (command) {  // clang-format off
-      case 0:                     break;
-      case 'h':                          // --help
-      default: help = true;       break;
-      case 'c': compress = true;  break; // --compress
-      case 'd': compress = false; break; // --decompress
-      case 'v': verbose_ = 1;     break; // --verbose
-      case 'V': return EXIT_SUCCESS;     // --version
-      case '0':                          // --fast
-      case '1': case '2': case '3': case '4':
-      case '5': case '6': case '7': case '8':
-      case '9': {                        // --best
-        try {
-          const auto level{std::clamp((std::abs)(std::stoi(argv[optind - 1], nullptr, 10)), 0, 12)};
-          level_ = level;
-          compress = true;
-        } catch(...) {}
-      } break;
-#if defined(GENERATE_SQUASH_STRETCH)
-      case 'x': {                        // --xx
-        const double value{double(std::stoi(optarg, nullptr, 10)) / 10.0};
-        fprintf(stdout, "\nValue : %g\n", value);
-        _squash = new Squash_t(598.0); // 756.1, 598.0
-        _stretch = new Stretch_t(738.2);    // 738.2
-      } break;
-#elif defined(TUNING)
-      case 'x': {
-#if 1
-        // clang-format on
-        {
-          File_t result("WRT_mxr.bin", "rb");
-          result.Read(&WRT_mxr, 256);
-        }
+  /**
+   * Create the encoder/decoder of a model set, the model set is chosen here once instead of on every bit
+   * @param buf The buffer of the model
+   * @param encode Set when encoding, otherwise decoding
+   * @param file The compressed data
+   * @param options The memory level and the model set
+   * @return The encoder/decoder
+   */
+  [[nodiscard]] auto MakeEncoder(Buffer_t& __restrict buf, const bool encode, File_t& file, const Options_t& options) noexcept -> std::unique_ptr<iEncoder_t> {
+    switch (options.model_set) {
+      case ModelSet::Fast:
+        return std::make_unique<Encoder_t<FastModel_t>>(buf, encode, file, options.level, options.bypass);
+      case ModelSet::Full:
+      case ModelSet::SIZE:
+      default:
+        return std::make_unique<Encoder_t<FullModel_t>>(buf, encode, file, options.level, options.bypass);
+    }
+  }
 
-        const auto XX{std::stoul(optarg, nullptr, 16)};
-        const uint8_t index = uint8_t(XX >> 8);
-        const uint8_t value = uint8_t(XX >> 0);
+  /**
+   * @struct TxtPrep_t
+   * @brief Text preparation settings, as given to the model
+   */
+  struct TxtPrep_t final {
+    int64_t data_pos;          // Start point text preparation
+    int64_t dic_start_offset;  // Start of the dictionary
+    int64_t dic_end_offset;    // End of the dictionary
+    int64_t dic_words;         // Number of words in the dictionary
+  };
 
-        WRT_mxr[index] = value;
+  /**
+   * @struct Block_t
+   * @brief One independently coded block in a block-parallel file
+   */
+  struct Block_t final {
+    int64_t offset;         // Position of the block in the (text prepared) data
+    int64_t length;         // Number of bytes in the block
+    int64_t packed_offset;  // Position of the coded block in the file
+    int64_t packed_length;  // Number of coded bytes of the block
+    uint32_t checksum;      // CRC-32 of the bytes of the block, verifies the decoded block
+    int32_t : 32;           // Padding
+  };
 
-        // clang-format off
-#else
-          extern uint32_t XX;
-          XX = std::stoul(optarg, nullptr, 10);
-          fprintf(stdout, "\nValue : %" PRIu32 "\n", XX);
-#endif
-      } break;
-#endif
-    }  // clang-format on
-  }
-  while (optind < argc) {
-    if (nullptr != inFileName_) {
-      outFileName_ = argv[optind++];
-    } else {
-      inFileName_ = argv[optind++];
-    }
+  /**
+   * Continue the checksum of a block
+   * @param crc Checksum of the bytes before these, 0 at the start of the block
+   * @param data The next bytes of the block
+   * @param size Number of bytes
+   * @return Checksum including these bytes
+   */
+  [[nodiscard]] auto BlockChecksum(const uint32_t crc, const uint8_t* const data, const size_t size) noexcept -> uint32_t {
+    return static_cast<uint32_t>(crc32(crc, data, static_cast<uInt>(size)));
   }
 
-  if (help || (nullptr == inFileName_) || (nullptr == outFileName_)) {
-    static constexpr std::array<const uint32_t, 11> use{{85, 115, 177, 303, 554, 1057, 1933, 3687, 7193, 14207, 27209}};  // TODO verify this base on ewik8
-    fprintf(stderr,                                                                                                       // clang-format off
-            "\nUsage: Moruga <option> <infile> <outfile>\n\n"
-            "  -c, --compress   Compress a file (default)\n"
-            "  -d, --decompress Decompress a file\n"
-            "  -h, --help       Display this short help and exit\n"
-            "  -v, --verbose    Verbose mode\n"
-            "  -V, --version    Display the version number and exit\n"
-            "  -0 ... -10       Uses about %" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",\n"
-            "                   %" PRIu32 ",%" PRIu32 ",%" PRIu32 " or %" PRIu32 " MiB memory\n"
-            "                   Default is option %" PRIu32 ", uses %" PRIu32 " MiB of memory\n", use[0], use[1], use[2], use[3], use[4], use[5], use[6],
-                                                                                                  use[7], use[8], use[9], use[10],
-                                                                                                  DEFAULT_OPTION, use[DEFAULT_OPTION]);
-    // clang-format on
-    return EXIT_SUCCESS;
+  /**
+   * Configure a fresh model for a block, text preparation can only be followed from the start of the data
+   * @param en Encoder/decoder of the block
+   * @param txtprep Text preparation settings, nullptr when there was no text preparation
+   * @param first Set when this is the first block
+   */
+  void SetupBlock(iEncoder_t& en, const TxtPrep_t* const txtprep, const bool first) noexcept {
+    if ((nullptr != txtprep) && first) {
+      en.SetDataPos(txtprep->data_pos);
+      en.SetDicStartOffset(txtprep->dic_start_offset);
+      en.SetDicEndOffset(txtprep->dic_end_offset);
+      en.SetDicWords(txtprep->dic_words);
+    }
+    en.SetBinary(nullptr == txtprep);
+    en.SetStart((nullptr != txtprep) && first);
   }
 
-#if defined(__linux__) || defined(_MSC_VER)
-  if (!strcmp(inFileName_, outFileName_)) {
-#else
-  if (!strcasecmp(inFileName_, outFileName_)) {
-#endif
-    fprintf(stderr, "\n<infile> and <outfile> can not be identical!");
-    return EXIT_FAILURE;
+  /**
+   * Number of worker threads to use for the given number of blocks
+   */
+  [[nodiscard]] auto WorkerCount(const Options_t& options, const size_t blocks) noexcept -> size_t {
+    const auto threads{(options.threads > 0) ? static_cast<size_t>(options.threads) : static_cast<size_t>(std::max(1U, std::thread::hardware_concurrency()))};
+    return std::min(threads, blocks);
   }
 
-  File_t infile{inFileName_, "rb"};
-  File_t outfile{outFileName_, "wb+"};  // write/read otherwise decode will fail
+  /**
+   * Encode one block with its own model, the result is written to its own stream.
+   * Binary data goes through the filters as in file mode, they read ahead so the block is copied to a file of its own first.
+   * @return Checksum of the bytes of the block
+   */
+  [[nodiscard]] auto EncodeBlock(const File_t& infile, const Block_t& block, File_t& stream, const TxtPrep_t* const txtprep, const bool first, const Options_t& options, BlockMonitor_t& monitor,
+                                 Recompressions_t& recompressions) noexcept -> uint32_t {
+    Buffer_t buf{};
+    const auto encoder{MakeEncoder(buf, true, stream, options)};
+    auto& en{*encoder};
+
+    // Increasing the buffer size above the block length is not useful
+    buf.Resize(static_cast<uint64_t>(block.length), options.MEM());
+
+    SetupBlock(en, txtprep, first);
+
+    std::vector<uint8_t> chunk(static_cast<size_t>(std::min(block.length, INT64_C(0x10000))));
+    int64_t out{0};
+    uint32_t checksum{0};
+    if (nullptr == txtprep) {
+      File_t data{};
+      for (int64_t pos{0}; pos < block.length;) {
+        const auto size{static_cast<size_t>(std::min(block.length - pos, static_cast<int64_t>(chunk.size())))};
+        const auto n{infile.ReadAt(chunk.data(), size, block.offset + pos)};
+        if (0 == n) {
+          break;  // Should never happen...
+        }
+        data.Write(chunk.data(), n);
+        checksum = BlockChecksum(checksum, chunk.data(), n);
+        pos += static_cast<int64_t>(n);
+      }
+      data.Rewind();
 
-  const auto originalLength{infile.Size()};
+      Filter_t filter{buf, block.length, data, &en, &recompressions};
+      int64_t in{0};
+      for (int32_t ch; EOF != (ch = data.getc());) {
+        if (!filter.Scan(ch)) {
+          en.Compress(ch);
+        }
+        if (const auto position{data.Position()}; (position - in) >= static_cast<int64_t>(chunk.size())) {
+          const auto packed{stream.Position()};
+          monitor.Update(position - in, packed - out);
+          in = position;
+          out = packed;
+        }
+      }
+      monitor.Update(block.length - in, stream.Position() - out);
+    } else {
+      for (int64_t pos{0}; pos < block.length;) {
+        const auto size{static_cast<size_t>(std::min(block.length - pos, static_cast<int64_t>(chunk.size())))};
+        const auto n{infile.ReadAt(chunk.data(), size, block.offset + pos)};
+        if (0 == n) {
+          break;  // Should never happen...
+        }
+        for (size_t i{0}; i < n; ++i) {
+          en.Compress(chunk[i]);
+        }
+        checksum = BlockChecksum(checksum, chunk.data(), n);
+        pos += static_cast<int64_t>(n);
 
-  const auto start_time{std::chrono::high_resolution_clock::now()};
+        const auto position{stream.Position()};
+        monitor.Update(static_cast<int64_t>(n), position - out);
+        out = position;
+      }
+    }
+    en.Flush();
+    return checksum;
+  }
 
-  if (compress) {
-    fprintf(stdout, "\nEncoding file '%s' ... with memory option %d\n", inFileName_, level_);
+  /**
+   * Split the data in blocks and encode each block on a worker thread.
+   * Layout: level | BLOCK_MARKER | FORMAT_MARKER, format, iLen, len, [txtprep], number of blocks, {length, packed length, CRC-32}..., checksum, blocks...
+   */
+  void EncodeBlocks(const File_t& infile, const File_t& outfile, const int64_t original_length, const int64_t iLen, const int64_t len, const TxtPrep_t* const txtprep,
+                    const Options_t& options) noexcept {
+    const auto workers{WorkerCount(options, SIZE_MAX)};
+    auto block_size{options.block_size * INT64_C(0x100000)};
+    if (block_size <= 0) {
+      block_size = std::max(MIN_BLOCK_SIZE, (len + static_cast<int64_t>(workers) - 1) / static_cast<int64_t>(workers));
+    }
+
+    std::vector<Block_t> blocks{};
+    for (int64_t offset{0}; offset < len; offset += block_size) {
+      blocks.push_back({offset, std::min(block_size, len - offset), 0, 0, 0});
+    }
+
+    std::vector<std::unique_ptr<File_t>> streams(blocks.size());
+    for (auto& stream : streams) {
+      stream = std::make_unique<File_t>();
+    }
+
+    infile.Flush();  // Mandatory before reading at positions
+
+    if (!Progress_t::IsSilent()) {
+      fprintf(stdout, "%zu blocks of %" PRId64 " KiB on %zu threads\n", blocks.size(), block_size / 1024, WorkerCount(options, blocks.size()));
+    }
+
+    BlockMonitor_t monitor{len, iLen};
+    {
+      const Progress_t progress{"ENC", true, monitor};
+
+      Recompressions_t recompressions{};
+      std::atomic<size_t> next{0};
+      std::vector<std::thread> pool{};
+      for (size_t n{WorkerCount(options, blocks.size())}; n-- > 0;) {
+        pool.emplace_back([&]() noexcept {
+          for (size_t i; (i = next.fetch_add(1)) < blocks.size();) {
+            blocks[i].checksum = EncodeBlock(infile, blocks[i], *streams[i], txtprep, 0 == i, options, monitor, recompressions);
+          }
+        });
+      }
+      for (auto& worker : pool) {
+        worker.join();
+      }
+    }
+
+    PutLevel(outfile, BLOCK_MARKER, options);  // Write memory level and block marker
+
+    if (original_length != iLen) {  // Deduplicated, a zero length is followed by the original file length
+      outfile.putVLI(0);
+      outfile.putVLI(original_length);
+    }
+    outfile.putVLI(iLen);  // File length (after deduplication)
+    outfile.putVLI(len);   // File length after text preparation (successful or not)
+    if (nullptr != txtprep) {
+      outfile.putVLI(txtprep->data_pos);
+      outfile.putVLI(txtprep->dic_start_offset);
+      outfile.putVLI(txtprep->dic_end_offset);
+      outfile.putVLI(txtprep->dic_words);
+    }
+
+    outfile.putVLI(static_cast<int64_t>(blocks.size()));
+    for (size_t i{0}; i < blocks.size(); ++i) {
+      blocks[i].packed_length = streams[i]->Size();
+      outfile.putVLI(blocks[i].length);
+      outfile.putVLI(blocks[i].packed_length);
+      outfile.put32(blocks[i].checksum);
+    }
+
+    uint8_t csum{Checksum(reinterpret_cast<const uint8_t*>(&iLen), sizeof(iLen))};
+    csum = static_cast<uint8_t>(csum + Checksum(reinterpret_cast<const uint8_t*>(&len), sizeof(len)));
+    outfile.putc(csum);
+
+    std::vector<uint8_t> data(0x10000);
+    for (auto& stream : streams) {
+      stream->Rewind();
+      for (size_t n; (n = stream->Read(data.data(), data.size())) > 0;) {
+        outfile.Write(data.data(), n);
+      }
+      stream->Close();
+    }
+  }
+
+  /**
+   * Decode one block with its own model, the coded block is read into its own stream first.
+   * The decoded bytes are written at the position of the block, so blocks can be decoded in any order.
+   * The filters read back what they decoded, so binary data is decoded to a file of its own first.
+   * @return Checksum of the decoded bytes, differs from Block_t::checksum when the block is damaged
+   */
+  [[nodiscard]] auto DecodeBlock(const File_t& infile, const Block_t& block, const File_t& outfile, const TxtPrep_t* const txtprep, const bool first, const Options_t& options,
+                                 BlockMonitor_t& monitor) noexcept -> uint32_t {
+    File_t stream{};
+    std::vector<uint8_t> chunk(static_cast<size_t>(std::min(std::max(block.packed_length, block.length), INT64_C(0x10000))));
+    for (int64_t pos{0}; pos < block.packed_length;) {
+      const auto size{static_cast<size_t>(std::min(block.packed_length - pos, static_cast<int64_t>(chunk.size())))};
+      const auto n{infile.ReadAt(chunk.data(), size, block.packed_offset + pos)};
+      if (0 == n) {
+        break;  // Damaged file, the decoder reads EOF from here on
+      }
+      stream.Write(chunk.data(), n);
+      pos += static_cast<int64_t>(n);
+    }
+    stream.Rewind();
+
+    Buffer_t buf{};
+    const auto encoder{MakeEncoder(buf, false, stream, options)};
+    auto& en{*encoder};
+
+    // Increasing the buffer size above the block length is not useful
+    buf.Resize(static_cast<uint64_t>(block.length), options.MEM());
+
+    SetupBlock(en, txtprep, first);
+
+    uint32_t checksum{0};
+    if (nullptr == txtprep) {
+      File_t data{};
+      Filter_t filter{buf, block.length, data, nullptr, nullptr};
+      int64_t out{0};
+      for (int64_t pos{0}; pos < block.length; ++pos) {
+        auto ch{en.Decompress()};
+        if (!filter.Scan(ch, pos)) {
+          assert(data.Position() == pos);
+          data.putc(ch);
+        }
+        if ((pos - out) >= static_cast<int64_t>(chunk.size())) {
+          monitor.Update(0, pos - out);
+          out = pos;
+        }
+      }
+      monitor.Update(0, block.length - out);
+
+      data.Rewind();
+      for (int64_t pos{0}; pos < block.length;) {
+        const auto n{data.Read(chunk.data(), static_cast<size_t>(std::min(block.length - pos, static_cast<int64_t>(chunk.size()))))};
+        if (0 == n) {
+          break;  // Damaged file
+        }
+        outfile.WriteAt(chunk.data(), n, block.offset + pos);
+        checksum = BlockChecksum(checksum, chunk.data(), n);
+        pos += static_cast<int64_t>(n);
+      }
+    } else {
+      for (int64_t pos{0}; pos < block.length;) {
+        const auto size{static_cast<size_t>(std::min(block.length - pos, static_cast<int64_t>(chunk.size())))};
+        for (size_t i{0}; i < size; ++i) {
+          chunk[i] = static_cast<uint8_t>(en.Decompress());
+        }
+        outfile.WriteAt(chunk.data(), size, block.offset + pos);
+        checksum = BlockChecksum(checksum, chunk.data(), size);
+        pos += static_cast<int64_t>(size);
+        monitor.Update(0, static_cast<int64_t>(size));
+      }
+    }
+    monitor.Update(block.packed_length, 0);
+    return checksum;
+  }
+
+  /**
+   * Decode a block-parallel file, the memory level byte is already read
+   * @return Validity, original file length, file length after deduplication and after text preparation
+   */
+  [[nodiscard]] auto DecodeBlocks(const File_t& infile, const File_t& outfile, const Options_t& options) noexcept -> std::tuple<bool, int64_t, int64_t, int64_t> {
+    auto iLen{infile.getVLI()};
+    auto original_length{iLen};
+    if (0 == iLen) {  // Deduplicated
+      original_length = infile.getVLI();
+      iLen = infile.getVLI();
+    }
+    const auto len{infile.getVLI()};
+
+    const bool is_txtprep{iLen != len};  // Set if there was text preparation done
+
+    TxtPrep_t txtprep{0, 0, 0, 0};
+    if (is_txtprep) {
+      txtprep.data_pos = infile.getVLI();
+      txtprep.dic_start_offset = infile.getVLI();
+      txtprep.dic_end_offset = infile.getVLI();
+      txtprep.dic_words = infile.getVLI();
+    }
+
+    // A damaged header may not lead to a huge block table, each entry of the table takes at least 6 bytes
+    const auto count{infile.getVLI()};
+    const auto left{infile.Size() - infile.Position()};
+    if ((iLen <= 0) || (len <= 0) || (count <= 0) || (count > (left / 6)) || (count > (((len - 1) / MIN_BLOCK_SIZE) + 1))) {
+      return {false, original_length, iLen, len};
+    }
+
+    std::vector<Block_t> blocks(static_cast<size_t>(count));
+    int64_t offset{0};
+    for (auto& block : blocks) {
+      block.offset = offset;
+      block.length = infile.getVLI();
+      block.packed_length = infile.getVLI();
+      block.checksum = infile.get32();
+      offset += block.length;
+    }
+
+    uint8_t csum{Checksum(reinterpret_cast<const uint8_t*>(&iLen), sizeof(iLen))};
+    csum = static_cast<uint8_t>(csum + Checksum(reinterpret_cast<const uint8_t*>(&len), sizeof(len)));
+    if ((offset != len) || (csum != static_cast<uint8_t>(infile.getc()))) {
+      return {false, original_length, iLen, len};
+    }
+
+    auto packed_offset{infile.Position()};
+    for (auto& block : blocks) {
+      block.packed_offset = packed_offset;
+      packed_offset += block.packed_length;
+    }
+
+    BlockMonitor_t monitor{len, iLen};
+    {
+      const Progress_t progress{"DEC", false, monitor};
+
+      std::atomic<size_t> next{0};
+      std::atomic<bool> valid{true};
+      std::vector<std::thread> pool{};
+      for (size_t n{WorkerCount(options, blocks.size())}; n-- > 0;) {
+        pool.emplace_back([&]() noexcept {
+          for (size_t i; valid && ((i = next.fetch_add(1)) < blocks.size());) {
+            if (blocks[i].checksum != DecodeBlock(infile, blocks[i], outfile, is_txtprep ? &txtprep : nullptr, 0 == i, options, monitor)) {
+              valid = false;  // Damaged block, the remaining blocks are not decoded
+            }
+          }
+        });
+      }
+      for (auto& worker : pool) {
+        worker.join();
+      }
+      if (!valid) {
+        return {false, original_length, iLen, len};
+      }
+    }
+    return {true, original_length, iLen, len};
+  }
+
+  /**
+   * Checksum of a frame header, detects damaged and truncated streams
+   */
+  [[nodiscard]] auto FrameChecksum(const int64_t length, const int64_t packed_length) noexcept -> int32_t {
+    const uint8_t csum{Checksum(reinterpret_cast<const uint8_t*>(&length), sizeof(length))};
+    return static_cast<uint8_t>(csum + Checksum(reinterpret_cast<const uint8_t*>(&packed_length), sizeof(packed_length)));
+  }
+
+  /**
+   * Copy a (temporary) file from the start to the output
+   */
+  void CopyFile(const File_t& file, const File_t& outfile) noexcept {
+    file.Rewind();
+    std::vector<uint8_t> chunk(UINT32_C(1) << 16);
+    for (size_t n; (n = file.Read(chunk.data(), chunk.size())) > 0;) {
+      outfile.Write(chunk.data(), n);
+    }
+  }
+
+#if !defined(MORUGA_LIBRARY) || defined(MORUGA_BENCH)  // Only main() compresses stdin, the round trip tests use files
+  /**
+   * Compress a stream (e.g. stdin) of unknown length in independent frames, no seeking is done.
+   * Text preparation is skipped, it needs to see the whole file, the filters run per frame.
+   * Layout: level | STREAM_MARKER | FORMAT_MARKER, format, {length, packed length, checksum, CRC-32, frame}..., 0, 0, checksum
+   * @return EXIT_SUCCESS or EXIT_FAILURE
+   */
+  [[nodiscard]] auto EncodeStream(const File_t& infile, const File_t& outfile, const Options_t& options) noexcept -> int32_t {
+    const auto frame_size{(options.block_size > 0) ? (options.block_size * INT64_C(0x100000)) : STREAM_FRAME_SIZE};
+    const auto workers{static_cast<size_t>(std::max(1, options.threads))};
+
+    PutLevel(outfile, STREAM_MARKER, options);  // Write memory level and stream marker
+
+    BlockMonitor_t monitor{0, 0};
+    Recompressions_t recompressions{};
+    std::vector<uint8_t> chunk(UINT32_C(1) << 16);
+    for (bool end{false}; !end;) {
+      // Read a frame for each worker, then encode them at the same time
+      std::vector<std::unique_ptr<File_t>> frames{};
+      std::vector<Block_t> blocks{};
+      while (!end && (frames.size() < workers)) {
+        auto frame{std::make_unique<File_t>()};
+        int64_t length{0};
+        while (length < frame_size) {
+          const auto n{infile.Read(chunk.data(), static_cast<size_t>(std::min(frame_size - length, static_cast<int64_t>(chunk.size()))))};
+          if (0 == n) {
+            end = true;
+            break;
+          }
+          frame->Write(chunk.data(), n);
+          length += static_cast<int64_t>(n);
+        }
+        if (length > 0) {
+          frame->Flush();
+          frames.push_back(std::move(frame));
+          blocks.push_back({0, length, 0, 0, 0});
+        }
+      }
+
+      std::vector<std::unique_ptr<File_t>> streams(frames.size());
+      for (auto& stream : streams) {
+        stream = std::make_unique<File_t>();
+      }
+      std::vector<std::thread> pool{};
+      for (size_t i{0}; i < frames.size(); ++i) {
+        pool.emplace_back([&, i]() noexcept { blocks[i].checksum = EncodeBlock(*frames[i], blocks[i], *streams[i], nullptr, false, options, monitor, recompressions); });
+      }
+      for (auto& worker : pool) {
+        worker.join();
+      }
+
+      for (size_t i{0}; i < frames.size(); ++i) {
+        blocks[i].packed_length = streams[i]->Size();
+        outfile.putVLI(blocks[i].length);
+        outfile.putVLI(blocks[i].packed_length);
+        outfile.putc(FrameChecksum(blocks[i].length, blocks[i].packed_length));
+        outfile.put32(blocks[i].checksum);
+        CopyFile(*streams[i], outfile);
+      }
+      outfile.Flush();
+    }
+
+    outfile.putVLI(0);  // End of stream
+    outfile.putVLI(0);
+    outfile.putc(FrameChecksum(0, 0));
+    return EXIT_SUCCESS;
+  }
+#endif
+
+  /**
+   * Decode a stream of frames, the memory level byte is already read.
+   * The output is written sequentially, so it can be a pipe.
+   * @return EXIT_SUCCESS or EXIT_FAILURE
+   */
+  [[nodiscard]] auto DecodeStream(const File_t& infile, const File_t& outfile, const Options_t& options) noexcept -> int32_t {
+    const auto workers{static_cast<size_t>(std::max(1, options.threads))};
+
+    BlockMonitor_t monitor{0, 0};
+    std::vector<uint8_t> chunk(UINT32_C(1) << 16);
+    for (bool end{false}; !end;) {
+      // Read a frame for each worker, then decode them at the same time
+      std::vector<std::unique_ptr<File_t>> frames{};
+      std::vector<Block_t> blocks{};
+      while (!end && (frames.size() < workers)) {
+        const auto length{infile.getVLI()};
+        const auto packed_length{infile.getVLI()};
+        if ((FrameChecksum(length, packed_length) != infile.getc()) || (length < 0) || (length > (INT64_C(1024) << 20)) || (packed_length < 0)) {
+          return EXIT_FAILURE;
+        }
+        if (0 == length) {
+          end = true;
+          break;
+        }
+        const auto checksum{infile.get32()};
+        auto frame{std::make_unique<File_t>()};
+        for (int64_t pos{0}; pos < packed_length;) {
+          const auto n{infile.Read(chunk.data(), static_cast<size_t>(std::min(packed_length - pos, static_cast<int64_t>(chunk.size()))))};
+          if (0 == n) {
+            return EXIT_FAILURE;  // Truncated stream
+          }
+          frame->Write(chunk.data(), n);
+          pos += static_cast<int64_t>(n);
+        }
+        frame->Flush();
+        frames.push_back(std::move(frame));
+        blocks.push_back({0, length, 0, packed_length, checksum});
+      }
+
+      std::vector<std::unique_ptr<File_t>> decoded(frames.size());
+      for (auto& stream : decoded) {
+        stream = std::make_unique<File_t>();
+      }
+      std::atomic<bool> valid{true};
+      std::vector<std::thread> pool{};
+      for (size_t i{0}; i < frames.size(); ++i) {
+        pool.emplace_back([&, i]() noexcept {
+          if (blocks[i].checksum != DecodeBlock(*frames[i], blocks[i], *decoded[i], nullptr, false, options, monitor)) {
+            valid = false;
+          }
+        });
+      }
+      for (auto& worker : pool) {
+        worker.join();
+      }
+      if (!valid) {
+        return EXIT_FAILURE;  // Damaged frame, the frames read with it are not written
+      }
+
+      for (const auto& stream : decoded) {
+        CopyFile(*stream, outfile);
+      }
+      outfile.Flush();
+    }
+    return EXIT_SUCCESS;
+  }
+
+  /**
+   * Replace the input by its deduplicated data, when this saves at least 1/64 of it
+   * @param infile The file to compress, replaced by a temporary file
+   */
+  void Deduplicate(File_t& infile) noexcept {
+    File_t tmp{};
+    const auto saved{EncodeDedup(infile, tmp)};
+    if ((saved > 0) && (saved >= (infile.Size() / 64))) {
+      if (!Progress_t::IsSilent()) {
+        fprintf(stdout, "<%" PRId64 " bytes repeated>\n", saved);
+      }
+      infile.Close();
+      infile = tmp;
+      tmp = nullptr;
+    }
+    infile.Rewind();
+  }
+
+  /**
+   * Compress a file, with text preparation and filters or in independent blocks
+   * @param infile The file to compress
+   * @param outfile Receives the compressed data, only written sequentially
+   * @param options The settings
+   * @return EXIT_SUCCESS or EXIT_FAILURE
+   */
+  [[nodiscard]] auto EncodeFile(File_t& infile, File_t& outfile, const Options_t& options) noexcept -> int32_t {
+    inFileName_ = options.in_file_name;
+    outFileName_ = options.out_file_name;
+    if (!Progress_t::IsSilent()) {
+      fprintf(stdout, "\nEncoding file '%s' ... with memory option %d\n", inFileName_, options.level);
+    }
+
+    const auto original_length{infile.Size()};
+    if (options.dedup && (original_length > 0)) {
+      Deduplicate(infile);
+    }
 
 #if !defined(DISABLE_TEXT_PREP)
     File_t tmp{};  // {"_tmp_.txt", "wb+"};
@@ -3303,7 +4366,9 @@ auto main(int32_t argc, char* const argv[]) -> int32_t {
       infile = tmp;
       tmp = nullptr;
     } else {
-      fprintf(stdout, "<binary file>\n");
+      if (!Progress_t::IsSilent()) {
+        fprintf(stdout, "<binary file>\n");
+      }
       tmp.Close();
     }
 #else
@@ -3316,166 +4381,241 @@ auto main(int32_t argc, char* const argv[]) -> int32_t {
 #endif
     infile.Rewind();
 
-    assert((level_ >= 0) && (level_ <= 12));
-    outfile.putc(level_);  // Write memory level
+    if ((options.threads > 0) || (options.block_size > 0)) {
+      const auto len{infile.Size()};
+#if !defined(DISABLE_TEXT_PREP)
+      const TxtPrep_t txtprep{data_pos, dic_start_offset, dic_end_offset, dic_words};
+#else
+      const TxtPrep_t txtprep{data_pos, 0, 0, 0};
+#endif
+      EncodeBlocks(infile, outfile, original_length, iLen, len, (iLen != len) ? &txtprep : nullptr, options);
+    } else {
+      PutLevel(outfile, 0, options);  // Write memory level
+
+      Buffer_t _buf{};
+      const auto encoder{MakeEncoder(_buf, true, outfile, options)};
+      auto& en{*encoder};
 
-    Buffer_t _buf{};
-    Encoder_t en{_buf, true, outfile};
+      if (original_length != iLen) {  // Deduplicated, a zero length is followed by the original file length
+        en.CompressVLI(0);
+        en.CompressVLI(original_length);
+      }
 
-    // Original file length
-    en.CompressVLI(iLen);
+      // File length (after deduplication)
+      en.CompressVLI(iLen);
 
-    // Increasing the buffer size above the file length is not useful
-    _buf.Resize(static_cast<uint64_t>(iLen), MEM());
+      // Increasing the buffer size above the file length is not useful
+      _buf.Resize(static_cast<uint64_t>(iLen), options.MEM());
 
-    // File length after text preparation (successful or not)
-    const auto len{infile.Size()};
-    en.CompressVLI(len);
+      // File length after text preparation (successful or not)
+      const auto len{infile.Size()};
+      en.CompressVLI(len);
 
-    const bool is_txtprep{iLen != len};  // Set if there was text preparation done
+      const bool is_txtprep{iLen != len};  // Set if there was text preparation done
 
-    if (is_txtprep) {
-      en.CompressVLI(data_pos);  // Start point text preparation
+      if (is_txtprep) {
+        en.CompressVLI(data_pos);  // Start point text preparation
 #if !defined(DISABLE_TEXT_PREP)
-      en.CompressVLI(dic_start_offset);
-      en.CompressVLI(dic_end_offset);
-      en.CompressVLI(dic_words);
+        en.CompressVLI(dic_start_offset);
+        en.CompressVLI(dic_end_offset);
+        en.CompressVLI(dic_words);
 #endif
 
-      en.SetDataPos(data_pos);
+        en.SetDataPos(data_pos);
 #if !defined(DISABLE_TEXT_PREP)
-      en.SetDicStartOffset(dic_start_offset);
-      en.SetDicEndOffset(dic_end_offset);
-      en.SetDicWords(dic_words);
+        en.SetDicStartOffset(dic_start_offset);
+        en.SetDicEndOffset(dic_end_offset);
+        en.SetDicWords(dic_words);
 #endif
-    }
+      }
 
-    uint8_t csum{Checksum(reinterpret_cast<const uint8_t*>(&originalLength), sizeof(originalLength))};
-    csum = static_cast<uint8_t>(csum + Checksum(reinterpret_cast<const uint8_t*>(&len), sizeof(len)));
-    en.Compress(csum);
+      uint8_t csum{Checksum(reinterpret_cast<const uint8_t*>(&iLen), sizeof(iLen))};
+      csum = static_cast<uint8_t>(csum + Checksum(reinterpret_cast<const uint8_t*>(&len), sizeof(len)));
+      en.Compress(csum);
 
-    const Monitor_t monitor{infile, outfile, len, iLen};
-    const Progress_t progress{"ENC", true, monitor};
+      const Monitor_t monitor{infile, outfile, len, iLen};
+      const Progress_t progress{"ENC", true, monitor};
 
-    en.SetBinary(!is_txtprep);
-    en.SetStart(is_txtprep);
+      en.SetBinary(!is_txtprep);
+      en.SetStart(is_txtprep);
 
 #if defined(DEBUG_WRITE_ANALYSIS_ENCODER)
-    File_t analysis("Analysis.csv", "wb");
+      File_t analysis("Analysis.csv", "wb");
 #endif
 
-    if (is_txtprep) {
+      if (is_txtprep) {
 #if defined(DEBUG_WRITE_ANALYSIS_ENCODER)
-      int64_t pos{0};
+        int64_t pos{0};
 #endif
-      for (int32_t ch; EOF != (ch = infile.getc());) {
-        en.Compress(ch);
+        for (int32_t ch; EOF != (ch = infile.getc());) {
+          en.Compress(ch);
 
 #if defined(DEBUG_WRITE_ANALYSIS_ENCODER)
-        if (!(++pos % (1 << 12))) {
-          fprintf(analysis, "%" PRIi64 ",%" PRIi64 "\n", pos, outfile.Position());
-        }
+          if (!(++pos % (1 << 12))) {
+            fprintf(analysis, "%" PRIi64 ",%" PRIi64 "\n", pos, outfile.Position());
+          }
 #endif
-      }
-    } else {
+        }
+      } else {
 #if defined(DEBUG_WRITE_ANALYSIS_ENCODER)
-      int64_t pos{0};
+        int64_t pos{0};
 #endif
-      Filter_t filter{_buf, len, infile, &en};
+        Recompressions_t recompressions{};
+        Filter_t filter{_buf, len, infile, &en, &recompressions};
 
-      for (int32_t ch; EOF != (ch = infile.getc());) {
-        if (filter.Scan(ch)) {
-          continue;
+        // Recompress the embedded streams on an other core while the encoder is busy, the file itself is read again
+        std::unique_ptr<PreScan_t> prescan{};
+        if (infile.isMapped() && strcmp(options.in_file_name, "-") && (std::thread::hardware_concurrency() > 1)) {
+          prescan = std::make_unique<PreScan_t>(options.in_file_name, len, recompressions);
         }
-        en.Compress(ch);
+
+        for (int32_t ch; EOF != (ch = infile.getc());) {
+          if (filter.Scan(ch)) {
+            continue;
+          }
+          en.Compress(ch);
 
 #if defined(DEBUG_WRITE_ANALYSIS_ENCODER)
-        if (!(++pos % (1 << 12))) {
-          fprintf(analysis, "%" PRIi64 ",%" PRIi64 "\n", pos, outfile.Position());
-        }
+          if (!(++pos % (1 << 12))) {
+            fprintf(analysis, "%" PRIi64 ",%" PRIi64 "\n", pos, outfile.Position());
+          }
 #endif
+        }
       }
+      en.Flush();
     }
-    en.Flush();
-  } else {
-    if (infile.Size() <= 0) {
+
+    return EXIT_SUCCESS;
+  }
+
+  /**
+   * Decompress a file, the memory option is read from the file
+   * @param infile The file to decompress
+   * @param outfile Receives the decompressed data, must be readable and seekable
+   * @param options The settings, the memory option and model set are replaced by those of the file
+   * @return EXIT_SUCCESS or EXIT_FAILURE
+   */
+  [[nodiscard]] auto DecodeFile(File_t& infile, File_t& outfile, const Options_t& options) noexcept -> int32_t {
+    inFileName_ = options.in_file_name;
+    outFileName_ = options.out_file_name;
+    const auto marker{infile.getc()};  // Read memory level and block or stream marker
+    if (EOF == marker) {
       fprintf(stderr, "\nFile '%s' has no length, decoding not possible!", inFileName_);
       return EXIT_FAILURE;
     }
-
-    level_ = infile.getc();  // Read memory level
-    if (!((level_ >= 0) && (level_ <= 12))) {
+    Options_t coded{options};
+    coded.model_set = static_cast<ModelSet>((MODEL_SET_MASK & marker) >> MODEL_SET_SHIFT);
+    coded.level = LEVEL_MASK & marker;
+    if ((coded.level > 12) || (coded.model_set >= ModelSet::SIZE)) {
       fprintf(stderr, "\nFile '%s' is damaged, decoding not possible!", inFileName_);
       return EXIT_FAILURE;
     }
+    const auto format{(FORMAT_MARKER & marker) ? infile.getc() : 0};  // Files of the original format have no format byte
+    if ((EOF == format) || (~FORMAT_KNOWN & format)) {
+      fprintf(stderr, "\nFile '%s' has an unknown format, decoding not possible!", inFileName_);
+      return EXIT_FAILURE;
+    }
+    coded.bypass = 0 != (FORMAT_BYPASS & format);
 
-    fprintf(stdout, "\nDecoding file '%s' ... with memory option %d\n", inFileName_, level_);
+    if (STREAM_MARKER & marker) {
+      if (EXIT_SUCCESS != DecodeStream(infile, outfile, coded)) {
+        fprintf(stderr, "\nFile '%s' is damaged, decoding not possible!", inFileName_);
+        return EXIT_FAILURE;
+      }
+      return EXIT_SUCCESS;
+    }
 
-    Buffer_t _buf{};
-    Encoder_t en{_buf, false, infile};
+    if (!Progress_t::IsSilent()) {
+      fprintf(stdout, "\nDecoding file '%s' ... with memory option %d\n", inFileName_, coded.level);
+    }
 
-    // Original file length
-    const auto iLen{en.DecompressVLI()};
+    int64_t original_length{0};
+    int64_t iLen{0};
+    int64_t len{0};
+    if (BLOCK_MARKER & marker) {
+      if (infile.Position() < 0) {
+        fprintf(stderr, "\nBlock file '%s' can not be decoded from a pipe!", inFileName_);
+        return EXIT_FAILURE;
+      }
+      bool valid{false};
+      std::tie(valid, original_length, iLen, len) = DecodeBlocks(infile, outfile, coded);
+      if (!valid) {
+        fprintf(stderr, "\nFile '%s' is damaged, decoding not possible!", inFileName_);
+        return EXIT_FAILURE;
+      }
+    } else {
+      Buffer_t _buf{};
+      const auto encoder{MakeEncoder(_buf, false, infile, coded)};
+      auto& en{*encoder};
+
+      // File length (after deduplication)
+      iLen = en.DecompressVLI();
+      original_length = iLen;
+      if (0 == iLen) {  // Deduplicated
+        original_length = en.DecompressVLI();
+        iLen = en.DecompressVLI();
+      }
 
-    // Increasing the buffer size above the file length is not useful
-    _buf.Resize(static_cast<uint64_t>(iLen), MEM());
+      // Increasing the buffer size above the file length is not useful
+      _buf.Resize(static_cast<uint64_t>(iLen), coded.MEM());
 
-    // File length after text preparation (successful or not)
-    auto len{en.DecompressVLI()};
+      // File length after text preparation (successful or not)
+      len = en.DecompressVLI();
 
-    const bool is_txtprep{iLen != len};  // Set if there was text preparation done
+      const bool is_txtprep{iLen != len};  // Set if there was text preparation done
 
-    if (is_txtprep) {
-      const auto data_pos{en.DecompressVLI()};  // Start point text preparation
-      assert((data_pos >= 0) && (data_pos < 0x07FFFFFF));
-      en.SetDataPos(data_pos);
+      if (is_txtprep) {
+        const auto data_pos{en.DecompressVLI()};  // Start point text preparation
+        assert((data_pos >= 0) && (data_pos < 0x07FFFFFF));
+        en.SetDataPos(data_pos);
 
 #if !defined(DISABLE_TEXT_PREP)
-      const auto dic_start_offset{en.DecompressVLI()};
-      const auto dic_end_offset{en.DecompressVLI()};
-      const auto dic_words{en.DecompressVLI()};
+        const auto dic_start_offset{en.DecompressVLI()};
+        const auto dic_end_offset{en.DecompressVLI()};
+        const auto dic_words{en.DecompressVLI()};
 
-      assert(dic_start_offset >= 0);
-      assert(dic_end_offset >= 0);
-      assert(dic_words >= 0);
+        assert(dic_start_offset >= 0);
+        assert(dic_end_offset >= 0);
+        assert(dic_words >= 0);
 
-      en.SetDicStartOffset(dic_start_offset);
-      en.SetDicEndOffset(dic_end_offset);
-      en.SetDicWords(dic_words);
+        en.SetDicStartOffset(dic_start_offset);
+        en.SetDicEndOffset(dic_end_offset);
+        en.SetDicWords(dic_words);
 #endif
-    }
+      }
 
-    uint8_t csum{Checksum(reinterpret_cast<const uint8_t*>(&iLen), sizeof(iLen))};
-    csum = static_cast<uint8_t>(csum + Checksum(reinterpret_cast<const uint8_t*>(&len), sizeof(len)));
-    const auto valid{static_cast<uint8_t>(en.Decompress())};
-    if (csum != valid) {
-      fprintf(stderr, "\nFile '%s' is damaged, decoding not possible!", inFileName_);
-      return EXIT_FAILURE;
-    }
+      uint8_t csum{Checksum(reinterpret_cast<const uint8_t*>(&iLen), sizeof(iLen))};
+      csum = static_cast<uint8_t>(csum + Checksum(reinterpret_cast<const uint8_t*>(&len), sizeof(len)));
+      const auto valid{static_cast<uint8_t>(en.Decompress())};
+      if (csum != valid) {
+        fprintf(stderr, "\nFile '%s' is damaged, decoding not possible!", inFileName_);
+        return EXIT_FAILURE;
+      }
 
-    const Monitor_t monitor{infile, outfile, len, iLen};
+      const Monitor_t monitor{infile, outfile, len, iLen};
 
-    {
-      const Progress_t progress{"DEC", false, monitor};
+      {
+        const Progress_t progress{"DEC", false, monitor};
 
-      en.SetBinary(!is_txtprep);
-      en.SetStart(is_txtprep);
+        en.SetBinary(!is_txtprep);
+        en.SetStart(is_txtprep);
 
-      if (is_txtprep) {
-        for (int64_t pos{0}; pos < len; ++pos) {
-          auto ch{en.Decompress()};
-          outfile.putc(ch);
-        }
-      } else {
-        Filter_t filter{_buf, len, outfile, nullptr};
+        if (is_txtprep) {
+          for (int64_t pos{0}; pos < len; ++pos) {
+            auto ch{en.Decompress()};
+            outfile.putc(ch);
+          }
+        } else {
+          Filter_t filter{_buf, len, outfile, nullptr, nullptr};
 
-        for (int64_t pos{0}; pos < len; ++pos) {
-          auto ch{en.Decompress()};
-          if (filter.Scan(ch, pos)) {
-            continue;
+          for (int64_t pos{0}; pos < len; ++pos) {
+            auto ch{en.Decompress()};
+            if (filter.Scan(ch, pos)) {
+              continue;
+            }
+            assert(outfile.Position() == pos);
+            outfile.putc(ch);
           }
-          assert(outfile.Position() == pos);
-          outfile.putc(ch);
         }
       }
     }
@@ -3496,6 +4636,336 @@ auto main(int32_t argc, char* const argv[]) -> int32_t {
       }
       tmp.Close();
     }
+
+    if (original_length != iLen) {
+      outfile.Rewind();
+      File_t tmp{};
+      if (original_length != DecodeDedup(outfile, tmp)) {
+        fprintf(stderr, "\nFile '%s' is damaged, decoding not possible!", inFileName_);
+        return EXIT_FAILURE;
+      }
+      outfile.Rewind();
+      CopyFile(tmp, outfile);
+    }
+    return EXIT_SUCCESS;
+  }
+
+  constexpr std::array<const char, 23> short_options{{"cdhvV0123456789xT:B:M:"}};
+  constexpr std::array<const struct option, 18> long_options{{{"verbose", no_argument, &verbose_, 1},           //
+                                                              {"brief", no_argument, &verbose_, 0},             //
+                                                              {"compress", no_argument, nullptr, 'c'},          //
+                                                              {"decompress", no_argument, nullptr, 'd'},        //
+                                                              {"best", no_argument, nullptr, '9'},              //
+                                                              {"fast", no_argument, nullptr, '0'},              //
+                                                              {"help", no_argument, nullptr, 'h'},              //
+                                                              {"version", no_argument, nullptr, 'V'},           //
+                                                              {"threads", required_argument, nullptr, 'T'},     //
+                                                              {"block-size", required_argument, nullptr, 'B'},  //
+                                                              {"tmp-memory", required_argument, nullptr, 'M'},  //
+                                                              {"profile", no_argument, nullptr, 'P'},           //
+                                                              {"simd", required_argument, nullptr, 'S'},        //
+                                                              {"self-test", no_argument, nullptr, 'K'},         //
+                                                              {"fast-model", no_argument, nullptr, 'F'},        //
+                                                              {"dedup", no_argument, nullptr, 'D'},             //
+#if defined(TUNING) || defined(GENERATE_SQUASH_STRETCH)
+                                                              {"xx", required_argument, nullptr, 'x'},
+#else
+                                                              {nullptr, no_argument, nullptr, 0},
+#endif
+                                                              {nullptr, no_argument, nullptr, 0}}};
+};  // namespace
+
+#if defined(MORUGA_LIBRARY)
+namespace {
+  /**
+   * @struct Sink_t
+   * @brief Destination of the produced data
+   *
+   * Destination of the produced data
+   */
+  struct Sink_t {
+    moruga_sink_t write;
+    void* user;
+  };
+
+  /**
+   * Open a memory buffer as a read only stream
+   * @param data The bytes to read
+   * @param size Number of bytes to read
+   * @return The opened stream
+   */
+  [[nodiscard]] auto OpenMemory(const void* const data, const size_t size) noexcept -> FILE* {
+#if defined(__linux__) || defined(__APPLE__) || defined(__CYGWIN__)
+    return fmemopen(const_cast<void*>(data), size, "rb");
+#else
+    File_t tmp{};
+    tmp.Write(data, size);
+    tmp.Rewind();
+    FILE* const stream{tmp};
+    tmp = nullptr;  // Keep the stream open
+    return stream;
+#endif
+  }
+
+  /**
+   * Copy a file from the start to the sink
+   * @param file The file to copy
+   * @param sink Receives the data
+   * @return EXIT_SUCCESS or EXIT_FAILURE
+   */
+  [[nodiscard]] auto CopyToSink(const File_t& file, const Sink_t& sink) noexcept -> int32_t {
+    file.Rewind();
+    std::vector<uint8_t> chunk(UINT32_C(1) << 16);
+    for (size_t n; (n = file.Read(chunk.data(), chunk.size())) > 0;) {
+      if (0 != sink.write(sink.user, chunk.data(), n)) {
+        return EXIT_FAILURE;
+      }
+    }
+    return EXIT_SUCCESS;
+  }
+
+#if defined(__linux__)
+  auto SinkWrite(void* const cookie, const char* const data, const size_t size) noexcept -> ssize_t {
+    const auto* const sink{static_cast<const Sink_t*>(cookie)};
+    return (0 == sink->write(sink->user, data, size)) ? static_cast<ssize_t>(size) : -1;
+  }
+#endif
+
+  /**
+   * @param level The memory option
+   * @return The settings of a (de)compression in memory, several can run at the same time
+   */
+  [[nodiscard]] auto LibraryOptions(const int32_t level) noexcept -> Options_t {
+    Progress_t::SetSilent(true);
+    return Options_t{.in_file_name = "<memory>", .out_file_name = "<sink>", .block_size = 0, .level = level, .model_set = ModelSet::Full, .threads = 0, .dedup = false, .bypass = true};
+  }
+};  // namespace
+
+auto moruga_compress(const void* const data, const size_t size, const int32_t level, const moruga_sink_t sink, void* const user) -> int32_t {
+  if ((nullptr == data) || (0 == size) || (nullptr == sink) || (level < 0) || (level > 12)) {
+    return EXIT_FAILURE;
+  }
+  const auto options{LibraryOptions(level)};
+
+  Sink_t destination{sink, user};
+  File_t infile{OpenMemory(data, size)};
+#if defined(__linux__)
+  // The encoder only writes sequentially, stream directly into the sink
+  File_t outfile{fopencookie(&destination, "wb", {nullptr, SinkWrite, nullptr, nullptr})};
+  auto result{EncodeFile(infile, outfile, options)};
+  if ((0 != outfile.Flush()) || ferror(outfile)) {
+    result = EXIT_FAILURE;
+  }
+#else
+  File_t outfile{};
+  auto result{EncodeFile(infile, outfile, options)};
+  if (EXIT_SUCCESS == result) {
+    result = CopyToSink(outfile, destination);
+  }
+#endif
+  return result;
+}
+
+auto moruga_decompress(const void* const data, const size_t size, const moruga_sink_t sink, void* const user) -> int32_t {
+  if ((nullptr == data) || (0 == size) || (nullptr == sink)) {
+    return EXIT_FAILURE;
+  }
+  const auto options{LibraryOptions(DEFAULT_OPTION)};
+
+  const Sink_t destination{sink, user};
+  File_t infile{OpenMemory(data, size)};
+  File_t outfile{};  // The decoder (filters, text preparation) reads back what is written
+  auto result{DecodeFile(infile, outfile, options)};
+  if (EXIT_SUCCESS == result) {
+    result = CopyToSink(outfile, destination);
+  }
+  return result;
+}
+#elif !defined(MORUGA_BENCH)  // The microbenchmarks (src/bench) bring their own main()
+auto main(int32_t argc, char* const argv[]) -> int32_t {
+  // clang-format off
+  std::set_new_handler([]() { fprintf(stderr, "\nFailed to allocate memory!"); std::abort(); });
+  std::set_terminate  ([]() { fprintf(stderr, "\nUnhandled exception");        std::abort(); });
+  // clang-format on
+
+  // With stdin/stdout ("-") nothing is written to the console, stdout may carry the data
+  if (std::any_of(argv + 1, argv + argc, [](const char* const arg) { return !strcmp(arg, "-"); })) {
+    Progress_t::SetSilent(true);
+  } else {
+    fprintf(stdout,
+            "Moruga compressor (C) 2023, M.W. Hessel.\n"
+            "Based on PAQ compressor series by M. Mahoney.\n"
+            "Free under GPL, https://www.gnu.org/licenses/\n"
+            "https://github.com/the-m-master/Moruga/\n");
+  }
+
+  Options_t options{};
+  bool help{false};
+  bool compress{true};
+
+  for (int32_t command{0}; -1 != (command = getopt_long(argc, argv, short_options.data(), long_options.data(), nullptr));) {
+    switch (command) {  // clang-format off
+      case 0:                     break;
+      case 'h':                          // --help
+      default: help = true;       break;
+      case 'c': compress = true;  break; // --compress
+      case 'd': compress = false; break; // --decompress
+      case 'v': verbose_ = 1;     break; // --verbose
+      case 'V': return EXIT_SUCCESS;     // --version
+      case 'P': Profile::Enable(); break; // --profile
+      case 'S': {                        // --simd
+        auto level{Simd::Level::Scalar};
+        while ((level < Simd::Level::SIZE) && strcasecmp(optarg, Simd::Name(level))) {
+          level = static_cast<Simd::Level>(static_cast<uint32_t>(level) + 1);
+        }
+        if (!Simd::Select(level)) {
+          fprintf(stderr, "\nSIMD level '%s' is not supported by this CPU (best is %s)\n", optarg, Simd::Name(Simd::Detect()));
+          return EXIT_FAILURE;
+        }
+      } break;
+      case 'K':                          // --self-test
+        return Simd::SelfTest() ? EXIT_SUCCESS : EXIT_FAILURE;
+      case 'F': options.model_set = ModelSet::Fast; break; // --fast-model
+      case 'D': options.dedup = true; break; // --dedup
+      case 'T': {                        // --threads
+        try {
+          options.threads = std::clamp(std::stoi(optarg, nullptr, 10), 1, 1024);
+        } catch(...) { help = true; }
+      } break;
+      case 'B': {                        // --block-size
+        try {
+          options.block_size = std::clamp(std::stoll(optarg, nullptr, 10), 1LL, 1024LL);
+        } catch(...) { help = true; }
+      } break;
+      case 'M': {                        // --tmp-memory
+        try {
+          File_t::TemporaryLimit(std::clamp(std::stoll(optarg, nullptr, 10), 0LL, 65536LL) << 20);
+        } catch(...) { help = true; }
+      } break;
+      case '0':                          // --fast
+      case '1': case '2': case '3': case '4':
+      case '5': case '6': case '7': case '8':
+      case '9': {                        // --best
+        try {
+          const auto level{std::clamp((std::abs)(std::stoi(argv[optind - 1], nullptr, 10)), 0, 12)};
+          options.level = level;
+          compress = true;
+        } catch(...) {}
+      } break;
+#if defined(GENERATE_SQUASH_STRETCH)
+      case 'x': {                        // --xx
+        const double value{double(std::stoi(optarg, nullptr, 10)) / 10.0};
+        fprintf(stdout, "\nValue : %g\n", value);
+        _squash = new Squash_t(598.0); // 756.1, 598.0
+        _stretch = new Stretch_t(738.2);    // 738.2
+      } break;
+#elif defined(TUNING)
+      case 'x': {
+#if 1
+        // clang-format on
+        {
+          File_t result("WRT_mxr.bin", "rb");
+          result.Read(&WRT_mxr, 256);
+        }
+
+        const auto XX{std::stoul(optarg, nullptr, 16)};
+        const uint8_t index = uint8_t(XX >> 8);
+        const uint8_t value = uint8_t(XX >> 0);
+
+        WRT_mxr[index] = value;
+
+        // clang-format off
+#else
+          extern uint32_t XX;
+          XX = std::stoul(optarg, nullptr, 10);
+          fprintf(stdout, "\nValue : %" PRIu32 "\n", XX);
+#endif
+      } break;
+#endif
+    }  // clang-format on
+  }
+  while (optind < argc) {
+    if (nullptr != options.in_file_name) {
+      options.out_file_name = argv[optind++];
+    } else {
+      options.in_file_name = argv[optind++];
+    }
+  }
+
+  if (help || (nullptr == options.in_file_name) || (nullptr == options.out_file_name)) {
+    static constexpr std::array<const uint32_t, 11> use{{85, 115, 177, 303, 554, 1057, 1933, 3687, 7193, 14207, 27209}};  // TODO verify this base on ewik8
+    fprintf(stderr,                                                                                                       // clang-format off
+            "\nUsage: Moruga <option> <infile> <outfile>\n"
+            "       Use - as <infile> or <outfile> for stdin or stdout, this compresses\n"
+            "       in frames (see --block-size) without text preparation\n\n"
+            "  -c, --compress   Compress a file (default)\n"
+            "  -d, --decompress Decompress a file\n"
+            "  -h, --help       Display this short help and exit\n"
+            "  -v, --verbose    Verbose mode\n"
+            "  -V, --version    Display the version number and exit\n"
+            "  -T, --threads <n>\n"
+            "                   Compress in independent blocks using <n> threads,\n"
+            "                   each thread uses the memory of the selected option,\n"
+            "                   when decoding a block file <n> threads are used (default all cores)\n"
+            "  -B, --block-size <MiB>\n"
+            "                   Block size of the block mode (default input size / threads),\n"
+            "                   frame size when using stdin or stdout (default 16)\n"
+            "  -M, --tmp-memory <MiB>\n"
+            "                   Keep temporary files up to <MiB> in memory (default 64),\n"
+            "                   larger ones move to disk, 0 keeps them all on disk\n"
+            "      --profile    Report the time per phase and per model component on stderr,\n"
+            "                   and the stall time saved by prefetching the context slots\n"
+            "      --simd <level>\n"
+            "                   Use the scalar, SSE2, AVX2 or AVX-512 kernels (default the best of the CPU)\n"
+            "      --self-test  Verify that all SIMD kernels of the CPU give the same results and exit\n"
+            "      --fast-model Compress up to twice as fast with a reduced model set,\n"
+            "                   at the cost of a few percent of compression\n"
+            "      --dedup      Replace repeated chunks by references before compressing,\n"
+            "                   finds repeats at any distance (e.g. in disk images)\n"
+            "  -0 ... -10       Uses about %" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",\n"
+            "                   %" PRIu32 ",%" PRIu32 ",%" PRIu32 " or %" PRIu32 " MiB memory\n"
+            "                   Default is option %" PRIu32 ", uses %" PRIu32 " MiB of memory\n", use[0], use[1], use[2], use[3], use[4], use[5], use[6],
+                                                                                                  use[7], use[8], use[9], use[10],
+                                                                                                  DEFAULT_OPTION, use[DEFAULT_OPTION]);
+    // clang-format on
+    return EXIT_SUCCESS;
+  }
+
+  const bool streaming{!strcmp(options.in_file_name, "-") || !strcmp(options.out_file_name, "-")};
+
+#if defined(__linux__) || defined(_MSC_VER)
+  if (strcmp(options.in_file_name, "-") && !strcmp(options.in_file_name, options.out_file_name)) {
+#else
+  if (strcmp(options.in_file_name, "-") && !strcasecmp(options.in_file_name, options.out_file_name)) {
+#endif
+    fprintf(stderr, "\n<infile> and <outfile> can not be identical!");
+    return EXIT_FAILURE;
+  }
+
+  File_t infile{options.in_file_name, "rb"};
+  File_t outfile{options.out_file_name, "wb+"};  // write/read otherwise decode will fail
+
+  const auto originalLength{infile.Size()};
+
+  const auto start_time{std::chrono::high_resolution_clock::now()};
+
+  if (compress) {
+    if (const auto result{streaming ? EncodeStream(infile, outfile, options) : EncodeFile(infile, outfile, options)}; EXIT_SUCCESS != result) {
+      return result;
+    }
+  } else if (streaming && !(STREAM_MARKER & infile.Peek())) {
+    File_t tmp{};  // Filters and text preparation read back their output, stdout can not be used for that
+    if (const auto result{DecodeFile(infile, tmp, options)}; EXIT_SUCCESS != result) {
+      return result;
+    }
+    CopyFile(tmp, outfile);
+  } else if (const auto result{DecodeFile(infile, outfile, options)}; EXIT_SUCCESS != result) {
+    return result;
+  }
+
+  if (streaming) {
+    Profile::Report();
+    return EXIT_SUCCESS;
   }
 
   int64_t bytes_done{0};
@@ -3522,6 +4992,9 @@ auto main(int32_t argc, char* const argv[]) -> int32_t {
   const auto duration_ns{double(std::chrono::duration_cast<std::chrono::nanoseconds>(delta_time.time_since_epoch()).count())};
 
   fprintf(stdout, "\nTotal time %3.1f sec (%3.0f ns/byte)\n\n", duration_ns / 1e9, round(duration_ns / double(bytes_done)));
+  fflush(stdout);
+  Profile::Report();
 
   return EXIT_SUCCESS;
 }
+#endif  // MORUGA_LIBRARY
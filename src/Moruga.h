@@ -0,0 +1,64 @@
+/* Moruga, library interface for in memory compression and decompression
+ *
+ * Copyright (c) 2019-2023 Marwijn Hessel
+ *
+ * Moruga is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Moruga is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file LICENSE.
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ * https://github.com/the-m-master/Moruga
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * Receives the produced data, called as often as needed
+ * @param user The user pointer given to moruga_compress() or moruga_decompress()
+ * @param data The produced bytes
+ * @param size Number of produced bytes
+ * @return Zero to continue, any other value aborts the (de)compression
+ */
+typedef int32_t (*moruga_sink_t)(void* user, const void* data, size_t size);
+
+/**
+ * Compress a memory buffer, the result is the same as the Moruga application produces
+ * Can be called from several threads at the same time, each call uses the memory of its option level
+ * @param data The bytes to compress
+ * @param size Number of bytes to compress (must be larger than zero)
+ * @param level Memory option 0 to 12
+ * @param sink Receives the compressed data
+ * @param user Passed unmodified to the sink
+ * @return Zero on success, otherwise non-zero
+ */
+int32_t moruga_compress(const void* data, size_t size, int32_t level, moruga_sink_t sink, void* user);
+
+/**
+ * Decompress a memory buffer produced by moruga_compress() or the Moruga application
+ * Can be called from several threads at the same time, each call uses the memory of its option level
+ * @param data The compressed bytes
+ * @param size Number of compressed bytes
+ * @param sink Receives the decompressed data
+ * @param user Passed unmodified to the sink
+ * @return Zero on success, otherwise non-zero
+ */
+int32_t moruga_decompress(const void* data, size_t size, moruga_sink_t sink, void* user);
+
+#if defined(__cplusplus)
+}
+#endif
@@ -0,0 +1,199 @@
+/* Profile, timing of the compression phases and model components
+ *
+ * Copyright (c) 2019-2023 Marwijn Hessel
+ *
+ * Moruga is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Moruga is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file LICENSE.
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ * https://github.com/the-m-master/Moruga
+ */
+#include "Profile.h"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <mutex>
+#include <string_view>
+
+namespace {
+  constexpr auto PHASES{static_cast<size_t>(Profile::Phase::SIZE)};
+  constexpr auto MODELS{static_cast<size_t>(Profile::Model::SIZE)};
+
+  constexpr std::array<const std::string_view, PHASES> PHASE_NAMES{{"Dedup", "CaseSpace_t::Encode", "Dictionary::Create", "TxtPrep::Encode", "Header_t::Scan", "DecodeEncodeCompare", "CM loop"}};
+  constexpr std::array<const std::string_view, MODELS> MODEL_NAMES{{"Context slots", "_dmc", "_smm", "_lzp", "_txt", "_mixer", "APM chain", "Blend_t, Blend3x8_t", "SSE_t", "Coder and other"}};
+
+  struct Totals_t final {
+    std::array<uint64_t, PHASES> cycles;
+    std::array<uint64_t, PHASES> calls;
+    std::array<uint64_t, MODELS> model_cycles;
+    uint64_t bits;
+    uint64_t sampled;
+    std::array<uint64_t, 2> lookup_cycles;  // With and without prefetches
+    std::array<uint64_t, 2> lookups;        // With and without prefetches
+  };
+
+  std::mutex mutex_;   // Blocks are encoded on several threads
+  Totals_t totals_{};  // Of the finished threads and models
+  uint64_t start_cycles_{0};
+  int64_t start_ns_{0};
+
+  [[nodiscard]] auto Now() noexcept -> int64_t {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  /**
+   * @struct Counters_t
+   * @brief Phase times of one thread, added to the totals when the thread ends
+   */
+  struct Counters_t final {
+    Counters_t() noexcept = default;
+    ~Counters_t() noexcept {
+      Merge();
+    }
+
+    Counters_t(const Counters_t&) = delete;
+    Counters_t(Counters_t&&) = delete;
+    auto operator=(const Counters_t&) -> Counters_t& = delete;
+    auto operator=(Counters_t&&) -> Counters_t& = delete;
+
+    void Merge() noexcept {
+      const std::lock_guard<std::mutex> lock{mutex_};
+      for (size_t n{0}; n < PHASES; ++n) {
+        totals_.cycles[n] += cycles[n];
+        totals_.calls[n] += calls[n];
+      }
+      cycles.fill(0);
+      calls.fill(0);
+    }
+
+    std::array<uint64_t, PHASES> cycles{};
+    std::array<uint64_t, PHASES> calls{};
+    Profile::Scope_t* current{nullptr};
+  };
+
+  thread_local Counters_t counters_{};
+
+  [[nodiscard]] auto Share(const uint64_t part, const uint64_t total) noexcept -> double {
+    return (total > 0) ? (100.0 * static_cast<double>(part)) / static_cast<double>(total) : 0.0;
+  }
+};  // namespace
+
+bool Profile::enabled_{false};
+uint64_t Profile::overhead_{0};
+
+void Profile::Enable() noexcept {
+  overhead_ = UINT64_MAX;
+  for (uint32_t n{0}; n < 64; ++n) {  // The fastest of several tries, without interruptions
+    const auto start{Cycles()};
+    overhead_ = (std::min)(overhead_, Cycles() - start);
+  }
+  start_ns_ = Now();
+  start_cycles_ = Cycles();
+  enabled_ = true;
+}
+
+void Profile::Scope_t::Enter() noexcept {
+  _parent = counters_.current;
+  counters_.current = this;
+  _active = true;
+  _start = Cycles();
+}
+
+void Profile::Scope_t::Leave() noexcept {
+  const auto elapsed{Cycles() - _start};
+  const auto phase{static_cast<size_t>(_phase)};
+  counters_.cycles[phase] += elapsed - (std::min)(elapsed, _nested);
+  counters_.calls[phase] += 1;
+  if (nullptr != _parent) {
+    _parent->_nested += elapsed;
+  }
+  counters_.current = _parent;
+}
+
+Profile::Sampler_t::~Sampler_t() noexcept {
+  if (_bits > 0) {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    for (size_t n{0}; n < MODELS; ++n) {
+      totals_.model_cycles[n] += _cycles[n];
+    }
+    totals_.bits += _bits;
+    totals_.sampled += _sampled;
+  }
+}
+
+Profile::Stalls_t::~Stalls_t() noexcept {
+  if ((_lookups[0] + _lookups[1]) > 0) {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    for (size_t n{0}; n < 2; ++n) {
+      totals_.lookup_cycles[n] += _cycles[n];
+      totals_.lookups[n] += _lookups[n];
+    }
+  }
+}
+
+void Profile::Report() noexcept {
+  if (!enabled_) {
+    return;
+  }
+  counters_.Merge();
+
+  const std::lock_guard<std::mutex> lock{mutex_};
+  const auto total{Cycles() - start_cycles_};
+  const auto elapsed_ns{(std::max)(INT64_C(1), Now() - start_ns_)};
+  const auto cycles_per_ms{(1e6 * static_cast<double>(total)) / static_cast<double>(elapsed_ns)};
+
+  // Phases of several threads can add up to more than the elapsed time
+  uint64_t phases{0};
+  for (const auto cycles : totals_.cycles) {
+    phases += cycles;
+  }
+  const auto sum{(std::max)(total, phases)};
+
+  fprintf(stderr, "\nProfile (%.2f cycles/ns)          ms     Mcycles   share       calls\n", cycles_per_ms / 1e6);
+  const auto line{[&](const std::string_view indent, const std::string_view name, const uint64_t cycles, const uint64_t of, const uint64_t calls) noexcept {
+    fprintf(stderr, "%.*s%-*.*s %10.1f %11.1f %6.1f%%", static_cast<int32_t>(indent.size()), indent.data(), static_cast<int32_t>(30 - indent.size()),  //
+            static_cast<int32_t>(name.size()), name.data(), static_cast<double>(cycles) / cycles_per_ms, static_cast<double>(cycles) / 1e6, Share(cycles, of));
+    if (calls > 0) {
+      fprintf(stderr, " %11" PRIu64, calls);
+    }
+    fprintf(stderr, "\n");
+  }};
+  for (size_t n{0}; n < PHASES; ++n) {
+    if (totals_.calls[n] > 0) {
+      line("  ", PHASE_NAMES[n], totals_.cycles[n], sum, totals_.calls[n]);
+    }
+  }
+  line("  ", "Other", sum - phases, sum, 0);
+
+  if (totals_.sampled > 0) {
+    const auto cm_loop{totals_.cycles[static_cast<size_t>(Phase::CmLoop)]};
+    uint64_t sampled{0};
+    for (const auto cycles : totals_.model_cycles) {
+      sampled += cycles;
+    }
+    fprintf(stderr, "  CM loop, sampled %" PRIu64 " of %" PRIu64 " bits\n", totals_.sampled, totals_.bits);
+    for (size_t n{0}; n < MODELS; ++n) {
+      const auto cycles{static_cast<uint64_t>((static_cast<double>(cm_loop) * Share(totals_.model_cycles[n], sampled)) / 100.0)};
+      line("    ", MODEL_NAMES[n], cycles, cm_loop, 0);
+    }
+  }
+
+  if ((totals_.lookups[0] > 0) && (totals_.lookups[1] > 0)) {
+    const auto with{static_cast<double>(totals_.lookup_cycles[0]) / static_cast<double>(totals_.lookups[0])};
+    const auto without{static_cast<double>(totals_.lookup_cycles[1]) / static_cast<double>(totals_.lookups[1])};
+    const auto saved{(without - with) * static_cast<double>(totals_.lookups[0])};
+    fprintf(stderr, "  Context slot lookups, %.1f cycles with prefetch, %.1f without (1 of %" PRIu32 " bytes)\n", with, without, Stalls_t::COLD_PERIOD);
+    fprintf(stderr, "    Stall time saved %.1f ms (%.1f Mcycles) in %" PRIu64 " lookups\n", saved / cycles_per_ms, saved / 1e6, totals_.lookups[0]);
+  }
+}
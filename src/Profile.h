@@ -0,0 +1,242 @@
+/* Profile, timing of the compression phases and model components
+ *
+ * Copyright (c) 2019-2023 Marwijn Hessel
+ *
+ * Moruga is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Moruga is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file LICENSE.
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ * https://github.com/the-m-master/Moruga
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#if defined(__x86_64__)
+#  include <x86intrin.h>
+#else
+#  include <chrono>
+#endif
+
+/**
+ * @namespace Profile
+ * @brief Timing of the compression phases and model components (--profile)
+ *
+ * Phases are timed with a scope object, the time of a nested phase is not counted in the
+ * enclosing one (e.g. the CM loop of a recompressed stream is not part of DecodeEncodeCompare).
+ * Timing a model component per bit would cost more than the component itself, therefore the
+ * split of the CM loop across the components is sampled on one of SAMPLE_PERIOD bits, and
+ * the measured shares divide the time of the CM loop.
+ * Without --profile each scope or lap costs a single (predictable) branch.
+ */
+namespace Profile {
+  enum class Phase : uint32_t {
+    Dedup,       // EncodeDedup and DecodeDedup
+    CaseSpace,   // CaseSpace_t::Encode
+    Dictionary,  // Dictionary::Create
+    TxtPrep,     // TxtPrep::Encode (without the dictionary)
+    Detection,   // Header_t::Scan
+    Recompress,  // DecodeEncodeCompare (without the CM loop of the stream)
+    CmLoop,      // Encoder_t, Compress() or Decompress() of a byte
+    SIZE
+  };
+
+  enum class Model : uint32_t {
+    Context,  // Context slot updates, hashing and state maps
+    DMC,      // _dmc.Predict and _dmc.Update
+    SMM,      // _smm.Predict and _smm.Update
+    LZP,      // _lzp.Predict and _lzp.Update
+    Txt,      // _txt.Predict and _txt.Update
+    Mixer,    // Mixer_t, Predict and Update
+    APM,      // APM chain
+    Blend,    // Blend_t and Blend3x8_t
+    SSE,      // SSE_t
+    Coder,    // Arithmetic coder and the loop around it
+    SIZE
+  };
+
+  static constexpr uint32_t SAMPLE_PERIOD{61};  // A prime, so all bit positions are sampled alike
+
+  extern bool enabled_;       // Set by Enable(), not changed during activity
+  extern uint64_t overhead_;  // Cycles of reading the cycle counter, set by Enable()
+
+  /**
+   * Start profiling, call before any work is done
+   */
+  void Enable() noexcept;
+
+  /**
+   * Print the time spent per phase and per model component to stderr
+   */
+  void Report() noexcept;
+
+  /**
+   * Read the cycle counter (nanoseconds where there is no cycle counter)
+   * @return Current count
+   */
+  [[nodiscard]] inline auto Cycles() noexcept -> uint64_t {
+#if defined(__x86_64__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+  }
+
+  /**
+   * @class Scope_t
+   * @brief Times a phase during the lifetime of the object
+   */
+  class Scope_t final {
+  public:
+    explicit Scope_t(const Phase phase) noexcept : _phase{phase} {
+      if (enabled_) {
+        Enter();
+      }
+    }
+
+    ~Scope_t() noexcept {
+      if (_active) {
+        Leave();
+      }
+    }
+
+    Scope_t() = delete;
+    Scope_t(const Scope_t&) = delete;
+    Scope_t(Scope_t&&) = delete;
+    auto operator=(const Scope_t&) -> Scope_t& = delete;
+    auto operator=(Scope_t&&) -> Scope_t& = delete;
+
+  private:
+    void Enter() noexcept;
+    void Leave() noexcept;
+
+    Scope_t* _parent{nullptr};
+    uint64_t _start{0};
+    uint64_t _nested{0};  // Cycles of nested phases
+    Phase _phase;
+    bool _active{false};
+    int32_t : 24;  // Padding
+  };
+
+  /**
+   * @class Sampler_t
+   * @brief Splits the time of a bit across the model components
+   *
+   * Next() is called once per bit, on a sampled bit each lap adds the cycles
+   * since the previous lap to the given model component.
+   */
+  class Sampler_t final {
+  public:
+    Sampler_t() noexcept = default;
+    ~Sampler_t() noexcept;
+
+    Sampler_t(const Sampler_t&) = delete;
+    Sampler_t(Sampler_t&&) = delete;
+    auto operator=(const Sampler_t&) -> Sampler_t& = delete;
+    auto operator=(Sampler_t&&) -> Sampler_t& = delete;
+
+    void Next() noexcept {
+      if (enabled_) {
+        operator()(Model::Coder);  // Since the end of the previous (sampled) bit
+        ++_bits;
+        _active = 0 == --_countdown;
+        if (_active) {
+          _countdown = SAMPLE_PERIOD;
+          ++_sampled;
+          _last = Cycles();
+        }
+      }
+    }
+
+    void operator()(const Model model) noexcept {
+      if (_active) {
+        const auto now{Cycles()};
+        const auto delta{now - _last};
+        _cycles[static_cast<size_t>(model)] += (delta > overhead_) ? delta - overhead_ : 0;
+        _last = now;
+      }
+    }
+
+  private:
+    std::array<uint64_t, static_cast<size_t>(Model::SIZE)> _cycles{};
+    uint64_t _last{0};
+    uint64_t _bits{0};
+    uint64_t _sampled{0};
+    uint32_t _countdown{SAMPLE_PERIOD};
+    bool _active{false};
+    int32_t : 24;  // Padding
+  };
+
+  /**
+   * @class Stalls_t
+   * @brief Measures the stall time saved by prefetching the context slots
+   *
+   * Times the context slot lookups of a model. On one of COLD_PERIOD bytes the prefetches are
+   * left out, the difference in cycles per lookup with the other bytes is the stall time a
+   * prefetch saves. The prefetches only move memory, the output is the same either way.
+   */
+  class Stalls_t final {
+  public:
+    Stalls_t() noexcept = default;
+    ~Stalls_t() noexcept;
+
+    Stalls_t(const Stalls_t&) = delete;
+    Stalls_t(Stalls_t&&) = delete;
+    auto operator=(const Stalls_t&) -> Stalls_t& = delete;
+    auto operator=(Stalls_t&&) -> Stalls_t& = delete;
+
+    static constexpr uint32_t COLD_PERIOD{8};
+    static constexpr uint64_t MAX_CYCLES{UINT64_C(1) << 15};  // Of a group of lookups, several misses all the way to memory
+
+    void NextByte() noexcept {
+      if (enabled_) {
+        _cold = 0 == --_countdown;
+        if (_cold) {
+          _countdown = COLD_PERIOD;
+        }
+      }
+    }
+
+    /**
+     * @return True when the prefetches of this byte are left out
+     */
+    [[nodiscard]] auto Cold() const noexcept -> bool {
+      return _cold;
+    }
+
+    [[nodiscard]] auto Start() const noexcept -> uint64_t {
+      return enabled_ ? Cycles() : 0;
+    }
+
+    /**
+     * @param start Value of Start() before the lookups
+     * @param lookups Number of lookups since Start()
+     */
+    void Stop(const uint64_t start, const uint32_t lookups) noexcept {
+      if (enabled_) {
+        if (const auto delta{Cycles() - start}; delta < MAX_CYCLES) {  // Longer when the thread was interrupted, not stalled
+          _cycles[_cold] += (delta > overhead_) ? delta - overhead_ : 0;
+          _lookups[_cold] += lookups;
+        }
+      }
+    }
+
+  private:
+    std::array<uint64_t, 2> _cycles{};   // With and without prefetches
+    std::array<uint64_t, 2> _lookups{};  // With and without prefetches
+    uint32_t _countdown{COLD_PERIOD};
+    bool _cold{false};
+    int32_t : 24;  // Padding
+  };
+};  // namespace Profile
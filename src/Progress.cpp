@@ -21,6 +21,7 @@
 #include "Progress.h"
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <cinttypes>
@@ -87,6 +88,22 @@ namespace {
   }
 
   auto GetMemoryUseInKiB() noexcept -> uint32_t {
+#  if defined(__linux__)
+    // Same value as ru_maxrss, but this one can be reset (see ResetPeakMemoryUse)
+    if (FILE* const status{fopen("/proc/self/status", "r")}; nullptr != status) {
+      std::array<char, 256> line{};
+      uint32_t hwm{0};
+      while (nullptr != fgets(line.data(), static_cast<int32_t>(line.size()), status)) {
+        if (1 == sscanf(line.data(), "VmHWM: %" SCNu32, &hwm)) {
+          break;
+        }
+      }
+      fclose(status);
+      if (hwm > 0) {
+        return hwm;  // Maximum resident set size utilised in KiB
+      }
+    }
+#  endif
     struct rusage rUsage;
     memset(&rUsage, 0, sizeof(rUsage));
     getrusage(RUSAGE_SELF, &rUsage);
@@ -147,7 +164,7 @@ namespace {
 
 #endif
 
-  uint32_t peakMemoryUse_{0};  // in KiB
+  std::atomic<uint32_t> peakMemoryUse_{0};  // in KiB, sampled by every progress bar, also the silent ones of library calls
 
   struct Status_t {
     volatile uint32_t nFilters;
@@ -169,7 +186,8 @@ namespace {
     volatile uint32_t nWAV;
   };
 
-  Status_t state_;
+  Status_t state_;  // Only kept when not silent, library calls may run at the same time
+  std::atomic<bool> silent_{false};
 
   void FiltersToString(std::string& filters, uint32_t count, const std::string_view text) noexcept {
     if (count > 0) {
@@ -186,6 +204,15 @@ namespace {
   }
 
   void ProgressBar(const volatile TraceProgress_t* const tracer) noexcept {
+    auto mem_use{GetMemoryUseInKiB()};
+    for (auto peak{peakMemoryUse_.load(std::memory_order_relaxed)}; peak < mem_use;) {
+      if (peakMemoryUse_.compare_exchange_weak(peak, mem_use, std::memory_order_relaxed)) {
+        break;
+      }
+    }
+    if (silent_) {
+      return;
+    }
     const auto end_time{std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now().time_since_epoch()).count()};
     const auto deltaTime{end_time - tracer->start};
     if (deltaTime > MIN_TIME) {
@@ -208,8 +235,6 @@ namespace {
         speed = ((speed / 512) + 1) / 2;          // 1/1024
       }
 
-      auto mem_use{GetMemoryUseInKiB()};
-      peakMemoryUse_ = (std::max)(peakMemoryUse_, mem_use);
       std::string_view mem_dim{MEM_DIMS[0]};     // KiB
       if (mem_use > 9999999) {                   //
         mem_dim = MEM_DIMS[2];                   // GiB
@@ -334,7 +359,9 @@ Progress_t::Progress_t(std::string_view workType, bool encode, const iMonitor_t&
               .monitor = monitor,
               .start = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now().time_since_epoch()).count()},  //
       _monitor_worker{MonitorWorker, &_tracer} {
-  memset(&state_, 0, sizeof(state_));
+  if (!silent_) {
+    memset(&state_, 0, sizeof(state_));
+  }
   ProgressBar(&_tracer);
 }
 
@@ -342,15 +369,40 @@ Progress_t::~Progress_t() noexcept {
   _tracer.isRunning = false;
   _monitor_worker.join();
   ProgressBar(&_tracer);  // Flush!
-  fputc('\n', stdout);
-  fflush(stdout);
+  if (!silent_) {
+    fputc('\n', stdout);
+    fflush(stdout);
+  }
 }
 
 auto Progress_t::PeakMemoryUse() noexcept -> uint32_t {
-  return peakMemoryUse_;
+  return peakMemoryUse_.load(std::memory_order_relaxed);
+}
+
+void Progress_t::ResetPeakMemoryUse() noexcept {
+#if defined(__linux__)
+  // Reset the resident set size high water mark of the process (Linux 4.0 and later)
+  if (FILE* const clear_refs{fopen("/proc/self/clear_refs", "w")}; nullptr != clear_refs) {
+    fputs("5", clear_refs);
+    fclose(clear_refs);
+  }
+#endif
+  peakMemoryUse_.store(0, std::memory_order_relaxed);
+}
+
+void Progress_t::SetSilent(const bool silent) noexcept {
+  silent_ = silent;
+}
+
+auto Progress_t::IsSilent() noexcept -> bool {
+  return silent_;
 }
 
 void Progress_t::FoundType(const Filter& type) noexcept {
+  if (IsPreScan() || silent_) {
+    return;  // Found again by the encoder, or not shown
+  }
+
   state_.nFilters = state_.nFilters + 1;
 
   switch (type) {  // clang-format off
@@ -377,6 +429,10 @@ void Progress_t::FoundType(const Filter& type) noexcept {
 }
 
 void Progress_t::Cancelled(const Filter& type) noexcept {
+  if (IsPreScan() || silent_) {
+    return;  // Not counted, see FoundType()
+  }
+
   if (state_.nFilters > 0) {
     state_.nFilters = state_.nFilters - 1;
   }
@@ -58,10 +58,16 @@ public:
 
   [[nodiscard]] static auto PeakMemoryUse() noexcept -> uint32_t;  // in KiB
 
+  static void ResetPeakMemoryUse() noexcept;  // Start a new measurement (benchmarks doing several runs)
+
   static void FoundType(const Filter& type) noexcept;
 
   static void Cancelled(const Filter& type) noexcept;
 
+  static void SetSilent(bool silent) noexcept;  // No console output at all (library use)
+
+  [[nodiscard]] static auto IsSilent() noexcept -> bool;
+
 private:
   Progress_t() = delete;
   Progress_t(const Progress_t& other) = delete;
@@ -0,0 +1,375 @@
+/* Simd, kernels of the neural networks selected at runtime
+ *
+ * Copyright (c) 2019-2023 Marwijn Hessel
+ *
+ * Moruga is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Moruga is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file LICENSE.
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ * https://github.com/the-m-master/Moruga
+ */
+#include "Simd.h"
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+
+#if defined(__x86_64__)
+#  include <immintrin.h>
+#endif
+
+namespace {
+  using Simd::BLEND3X8_STRIDE;
+  using Simd::MIXER_INPUTS;
+
+  //------------------------------------------------------------------------------------------
+  // Scalar, the reference of all other levels
+
+  void MixerTrainScalar(const int32_t* const __restrict t, int32_t* const __restrict w, const int32_t err) noexcept {
+    const auto* __restrict tt{t};
+    auto* __restrict ww{w};
+    for (auto n{MIXER_INPUTS}; n-- > 0;) {
+      *ww++ += (((*tt++ * err) >> 13) + 1) >> 1;
+    }
+  }
+
+  [[nodiscard]] auto MixerDotScalar(const int32_t* const __restrict t, const int32_t* const __restrict w) noexcept -> int32_t {
+    int32_t sum{0};
+    const auto* __restrict tt{t};
+    const auto* __restrict ww{w};
+    for (auto n{MIXER_INPUTS}; n-- > 0;) {
+      sum += *ww++ * *tt++;
+    }
+    return sum;
+  }
+
+  template <const uint32_t N_LAYERS>
+  void BlendTrainScalar(const int16_t* const __restrict t, int16_t* const __restrict w, const int32_t err) noexcept {
+    const auto* __restrict tt{t};
+    auto* __restrict ww{w};
+    for (auto n{N_LAYERS}; n-- > 0;) {
+      const int32_t wt{*ww + ((((*tt++ * err) >> 16) + 1) >> 1)};
+      *ww++ = static_cast<int16_t>(std::clamp(wt, SHRT_MIN, SHRT_MAX));
+    }
+  }
+
+  template <const uint32_t N_LAYERS>
+  [[nodiscard]] auto BlendDotScalar(const int16_t* const __restrict t, const int16_t* const __restrict w) noexcept -> int32_t {
+    int32_t sum{0};
+    const auto* __restrict tt{t};
+    const auto* __restrict ww{w};
+    for (auto n{N_LAYERS}; n-- > 0;) {
+      sum += *ww++ * *tt++;
+    }
+    return sum;
+  }
+
+  void Blend3x8TrainScalar(const int16_t* const __restrict t, int16_t* const __restrict w, const int16_t* const __restrict err) noexcept {
+    for (uint32_t n{0}; n < BLEND3X8_STRIDE; ++n) {
+      const int32_t wt{w[n] + ((((t[n] * err[n]) >> 16) + 1) >> 1)};
+      w[n] = static_cast<int16_t>(std::clamp(wt, SHRT_MIN, SHRT_MAX));
+    }
+  }
+
+  void Blend3x8DotScalar(const int16_t* const __restrict t, const int16_t* const __restrict w, int32_t* const __restrict sum) noexcept {
+    for (uint32_t n{0}; n < (BLEND3X8_STRIDE / 8); ++n) {
+      sum[n] = BlendDotScalar<8>(&t[8 * n], &w[8 * n]);
+    }
+  }
+
+#if defined(__x86_64__)
+  //------------------------------------------------------------------------------------------
+  // SSE2, part of every x86-64 CPU
+  // Blend_t has 4 or 8 inputs, these fit in one 128 bit register, the wider levels use these kernels too.
+
+  [[nodiscard]] auto MulLo(const __m128i a, const __m128i b) noexcept -> __m128i {  // _mm_mullo_epi32 is SSE4.1
+    const auto even{_mm_mul_epu32(a, b)};                                            // Low 32 bits are the same for signed values
+    const auto odd{_mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4))};
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+  }
+
+  [[nodiscard]] auto MixerDelta(const __m128i t, const __m128i err, const __m128i one) noexcept -> __m128i {
+    return _mm_srai_epi32(_mm_add_epi32(_mm_srai_epi32(MulLo(t, err), 13), one), 1);  // (((t * err) >> 13) + 1) >> 1
+  }
+
+  void MixerTrainSSE2(const int32_t* const __restrict t, int32_t* const __restrict w, const int32_t err) noexcept {
+    const auto e{_mm_set1_epi32(err)};
+    const auto one{_mm_set1_epi32(1)};
+    auto* const w0{reinterpret_cast<__m128i*>(w)};
+    auto* const w1{reinterpret_cast<__m128i*>(w + 4)};
+    _mm_storeu_si128(w0, _mm_add_epi32(_mm_loadu_si128(w0), MixerDelta(_mm_loadu_si128(reinterpret_cast<const __m128i*>(t)), e, one)));
+    _mm_storeu_si128(w1, _mm_add_epi32(_mm_loadu_si128(w1), MixerDelta(_mm_loadu_si128(reinterpret_cast<const __m128i*>(t + 4)), e, one)));
+    w[8] += (((t[8] * err) >> 13) + 1) >> 1;
+  }
+
+  [[nodiscard]] auto MixerDotSSE2(const int32_t* const __restrict t, const int32_t* const __restrict w) noexcept -> int32_t {
+    auto sum{_mm_add_epi32(MulLo(_mm_loadu_si128(reinterpret_cast<const __m128i*>(t)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(w))),  //
+                           MulLo(_mm_loadu_si128(reinterpret_cast<const __m128i*>(t + 4)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(w + 4))))};
+    sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 8));
+    sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 4));
+    return _mm_cvtsi128_si32(sum) + (w[8] * t[8]);
+  }
+
+  [[nodiscard]] auto BlendDelta(const __m128i t, const int32_t err) noexcept -> __m128i {
+    const auto var{_mm_mulhi_epi16(t, _mm_set1_epi16(static_cast<int16_t>(err)))};  //   (t * err) >> 16
+    return _mm_srai_epi16(_mm_adds_epi16(var, _mm_set1_epi16(1)), 1);                // (((t * err) >> 16) + 1) >> 1
+  }
+
+  void Blend4TrainSSE2(const int16_t* const __restrict t, int16_t* const __restrict w, const int32_t err) noexcept {
+    auto* const ww{reinterpret_cast<__m128i*>(w)};
+    const auto delta{BlendDelta(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(t)), err)};
+    _mm_storel_epi64(ww, _mm_adds_epi16(_mm_loadl_epi64(ww), delta));  // Saturation, like clamping to SHRT_MIN..SHRT_MAX
+  }
+
+  [[nodiscard]] auto Blend4DotSSE2(const int16_t* const __restrict t, const int16_t* const __restrict w) noexcept -> int32_t {
+    auto dp{_mm_madd_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(t)), _mm_loadl_epi64(reinterpret_cast<const __m128i*>(w)))};
+    dp = _mm_add_epi32(dp, _mm_srli_si128(dp, 4));
+    return _mm_cvtsi128_si32(dp);
+  }
+
+  void Blend8TrainSSE2(const int16_t* const __restrict t, int16_t* const __restrict w, const int32_t err) noexcept {
+    auto* const ww{reinterpret_cast<__m128i*>(w)};
+    const auto delta{BlendDelta(_mm_loadu_si128(reinterpret_cast<const __m128i*>(t)), err)};
+    _mm_storeu_si128(ww, _mm_adds_epi16(_mm_loadu_si128(ww), delta));  // Saturation, like clamping to SHRT_MIN..SHRT_MAX
+  }
+
+  [[nodiscard]] auto Blend8DotSSE2(const int16_t* const __restrict t, const int16_t* const __restrict w) noexcept -> int32_t {
+    auto dp{_mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(t)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(w)))};
+    dp = _mm_add_epi32(dp, _mm_srli_si128(dp, 8));
+    dp = _mm_add_epi32(dp, _mm_srli_si128(dp, 4));
+    return _mm_cvtsi128_si32(dp);
+  }
+
+  void Blend3x8TrainSSE2(const int16_t* const __restrict t, int16_t* const __restrict w, const int16_t* const __restrict err) noexcept {
+    const auto one{_mm_set1_epi16(1)};
+    for (uint32_t n{0}; n < BLEND3X8_STRIDE; n += 8) {
+      auto* const ww{reinterpret_cast<__m128i*>(&w[n])};
+      const auto var{_mm_mulhi_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&t[n])), _mm_loadu_si128(reinterpret_cast<const __m128i*>(&err[n])))};
+      _mm_storeu_si128(ww, _mm_adds_epi16(_mm_loadu_si128(ww), _mm_srai_epi16(_mm_adds_epi16(var, one), 1)));
+    }
+  }
+
+  void Blend3x8DotSSE2(const int16_t* const __restrict t, const int16_t* const __restrict w, int32_t* const __restrict sum) noexcept {
+    const auto* const tt{reinterpret_cast<const __m128i*>(t)};
+    const auto* const ww{reinterpret_cast<const __m128i*>(w)};
+    const auto d0{_mm_madd_epi16(_mm_loadu_si128(&tt[0]), _mm_loadu_si128(&ww[0]))};
+    const auto d1{_mm_madd_epi16(_mm_loadu_si128(&tt[1]), _mm_loadu_si128(&ww[1]))};
+    const auto d2{_mm_madd_epi16(_mm_loadu_si128(&tt[2]), _mm_loadu_si128(&ww[2]))};
+    const auto d3{_mm_madd_epi16(_mm_loadu_si128(&tt[3]), _mm_loadu_si128(&ww[3]))};
+    const auto d01{_mm_add_epi32(_mm_unpacklo_epi32(d0, d1), _mm_unpackhi_epi32(d0, d1))};  // Transpose and add the partial sums
+    const auto d23{_mm_add_epi32(_mm_unpacklo_epi32(d2, d3), _mm_unpackhi_epi32(d2, d3))};
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(sum), _mm_add_epi32(_mm_unpacklo_epi64(d01, d23), _mm_unpackhi_epi64(d01, d23)));
+  }
+
+  //------------------------------------------------------------------------------------------
+  // AVX2, 8 of the 9 mixer inputs in one register, the 32 inputs of Blend3x8_t in two (the AVX-512 level uses these too)
+
+  __attribute__((target("avx2"))) void MixerTrainAVX2(const int32_t* const __restrict t, int32_t* const __restrict w, const int32_t err) noexcept {
+    auto* const ww{reinterpret_cast<__m256i*>(w)};
+    auto delta{_mm256_mullo_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(t)), _mm256_set1_epi32(err))};
+    delta = _mm256_srai_epi32(_mm256_add_epi32(_mm256_srai_epi32(delta, 13), _mm256_set1_epi32(1)), 1);  // (((t * err) >> 13) + 1) >> 1
+    _mm256_storeu_si256(ww, _mm256_add_epi32(_mm256_loadu_si256(ww), delta));
+    w[8] += (((t[8] * err) >> 13) + 1) >> 1;
+  }
+
+  __attribute__((target("avx2"))) auto MixerDotAVX2(const int32_t* const __restrict t, const int32_t* const __restrict w) noexcept -> int32_t {
+    const auto dp{_mm256_mullo_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(t)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w)))};
+    auto sum{_mm_add_epi32(_mm256_castsi256_si128(dp), _mm256_extracti128_si256(dp, 1))};
+    sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 8));
+    sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 4));
+    return _mm_cvtsi128_si32(sum) + (w[8] * t[8]);
+  }
+
+  __attribute__((target("avx2"))) void Blend3x8TrainAVX2(const int16_t* const __restrict t, int16_t* const __restrict w, const int16_t* const __restrict err) noexcept {
+    const auto one{_mm256_set1_epi16(1)};
+    for (uint32_t n{0}; n < BLEND3X8_STRIDE; n += 16) {
+      auto* const ww{reinterpret_cast<__m256i*>(&w[n])};
+      const auto var{_mm256_mulhi_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&t[n])), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&err[n])))};
+      _mm256_storeu_si256(ww, _mm256_adds_epi16(_mm256_loadu_si256(ww), _mm256_srai_epi16(_mm256_adds_epi16(var, one), 1)));
+    }
+  }
+
+  __attribute__((target("avx2"))) void Blend3x8DotAVX2(const int16_t* const __restrict t, const int16_t* const __restrict w, int32_t* const __restrict sum) noexcept {
+    const auto* const tt{reinterpret_cast<const __m256i*>(t)};
+    const auto* const ww{reinterpret_cast<const __m256i*>(w)};
+    const auto d0{_mm256_madd_epi16(_mm256_loadu_si256(&tt[0]), _mm256_loadu_si256(&ww[0]))};  // Sums 0 and 1, 4 parts each
+    const auto d1{_mm256_madd_epi16(_mm256_loadu_si256(&tt[1]), _mm256_loadu_si256(&ww[1]))};  // Sums 2 and 3, 4 parts each
+    auto dp{_mm256_hadd_epi32(d0, d1)};
+    dp = _mm256_hadd_epi32(dp, dp);  // Sums 0 and 2 in the low half, 1 and 3 in the high half
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(sum), _mm_unpacklo_epi32(_mm256_castsi256_si128(dp), _mm256_extracti128_si256(dp, 1)));
+  }
+
+  //------------------------------------------------------------------------------------------
+  // AVX-512, all 9 mixer inputs in one (masked) register
+
+  constexpr __mmask16 MIXER_MASK{(1u << MIXER_INPUTS) - 1};
+
+  __attribute__((target("avx512f"))) void MixerTrainAVX512(const int32_t* const __restrict t, int32_t* const __restrict w, const int32_t err) noexcept {
+    auto delta{_mm512_mullo_epi32(_mm512_maskz_loadu_epi32(MIXER_MASK, t), _mm512_set1_epi32(err))};
+    delta = _mm512_add_epi32(_mm512_maskz_srai_epi32(MIXER_MASK, delta, 13), _mm512_set1_epi32(1));
+    delta = _mm512_maskz_srai_epi32(MIXER_MASK, delta, 1);  // (((t * err) >> 13) + 1) >> 1
+    _mm512_mask_storeu_epi32(w, MIXER_MASK, _mm512_add_epi32(_mm512_maskz_loadu_epi32(MIXER_MASK, w), delta));
+  }
+
+  __attribute__((target("avx512f"))) auto MixerDotAVX512(const int32_t* const __restrict t, const int32_t* const __restrict w) noexcept -> int32_t {
+    const auto dp{_mm512_mullo_epi32(_mm512_maskz_loadu_epi32(MIXER_MASK, t), _mm512_maskz_loadu_epi32(MIXER_MASK, w))};
+    const auto half{_mm256_add_epi32(_mm512_maskz_extracti64x4_epi64(0xF, dp, 0), _mm512_maskz_extracti64x4_epi64(0xF, dp, 1))};
+    auto sum{_mm_add_epi32(_mm256_castsi256_si128(half), _mm256_extracti128_si256(half, 1))};
+    sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 8));
+    sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 4));
+    return _mm_cvtsi128_si32(sum);
+  }
+#endif  // __x86_64__
+
+  constexpr std::array<const Simd::Kernels_t, static_cast<size_t>(Simd::Level::SIZE)> LEVELS{{
+      {MixerTrainScalar, MixerDotScalar, BlendTrainScalar<4>, BlendDotScalar<4>, BlendTrainScalar<8>, BlendDotScalar<8>, Blend3x8TrainScalar, Blend3x8DotScalar},
+#if defined(__x86_64__)
+      {MixerTrainSSE2, MixerDotSSE2, Blend4TrainSSE2, Blend4DotSSE2, Blend8TrainSSE2, Blend8DotSSE2, Blend3x8TrainSSE2, Blend3x8DotSSE2},
+      {MixerTrainAVX2, MixerDotAVX2, Blend4TrainSSE2, Blend4DotSSE2, Blend8TrainSSE2, Blend8DotSSE2, Blend3x8TrainAVX2, Blend3x8DotAVX2},
+      {MixerTrainAVX512, MixerDotAVX512, Blend4TrainSSE2, Blend4DotSSE2, Blend8TrainSSE2, Blend8DotSSE2, Blend3x8TrainAVX2, Blend3x8DotAVX2},
+#else
+      {MixerTrainScalar, MixerDotScalar, BlendTrainScalar<4>, BlendDotScalar<4>, BlendTrainScalar<8>, BlendDotScalar<8>, Blend3x8TrainScalar, Blend3x8DotScalar},
+      {MixerTrainScalar, MixerDotScalar, BlendTrainScalar<4>, BlendDotScalar<4>, BlendTrainScalar<8>, BlendDotScalar<8>, Blend3x8TrainScalar, Blend3x8DotScalar},
+      {MixerTrainScalar, MixerDotScalar, BlendTrainScalar<4>, BlendDotScalar<4>, BlendTrainScalar<8>, BlendDotScalar<8>, Blend3x8TrainScalar, Blend3x8DotScalar},
+#endif
+  }};
+
+  constexpr std::array<const char*, static_cast<size_t>(Simd::Level::SIZE)> NAMES{{"scalar", "SSE2", "AVX2", "AVX-512"}};
+
+  Simd::Level selected_{Simd::Detect()};
+
+  /**
+   * @class Random_t
+   * @brief Reproducible pseudo random numbers for the self-test (xorshift)
+   */
+  class Random_t final {
+  public:
+    [[nodiscard]] auto operator()(const int32_t low, const int32_t high) noexcept -> int32_t {  // low..high
+      _state ^= _state << 13;
+      _state ^= _state >> 7;
+      _state ^= _state << 17;
+      return low + static_cast<int32_t>((_state >> 32) % static_cast<uint64_t>(high - low + 1));
+    }
+
+  private:
+    uint64_t _state{UINT64_C(0x9E3779B97F4A7C15)};
+  };
+
+  /**
+   * Compare the kernels of a level with the scalar ones, using the ranges that occur in the models
+   * @param level The level
+   * @return Number of differences
+   */
+  [[nodiscard]] auto Compare(const Simd::Level level) noexcept -> uint32_t {
+    const auto& scalar{LEVELS[static_cast<size_t>(Simd::Level::Scalar)]};
+    const auto& other{LEVELS[static_cast<size_t>(level)]};
+    Random_t random{};
+    uint32_t differences{0};
+
+    for (uint32_t n{0}; n < 100000; ++n) {
+      alignas(64) std::array<int32_t, 16> tx{};  // Room for the widest load
+      alignas(64) std::array<int32_t, 16> wa{};
+      alignas(64) std::array<int32_t, 16> wb{};
+      for (uint32_t i{0}; i < MIXER_INPUTS; ++i) {
+        tx[i] = random(-2047, 2047);  // Stretched probabilities
+        wa[i] = wb[i] = random(-65536, 65536);
+      }
+      differences += (scalar.mixer_dot(tx.data(), wa.data()) != other.mixer_dot(tx.data(), wb.data())) ? 1u : 0u;
+      const auto err{random(-4095, 4095)};
+      scalar.mixer_train(tx.data(), wa.data(), err);
+      other.mixer_train(tx.data(), wb.data(), err);
+      differences += (wa != wb) ? 1u : 0u;
+
+      alignas(16) std::array<int16_t, 8> pr{};
+      alignas(16) std::array<int16_t, 8> va{};
+      alignas(16) std::array<int16_t, 8> vb{};
+      for (uint32_t i{0}; i < pr.size(); ++i) {
+        pr[i] = static_cast<int16_t>(random(-2047, 2047));
+        va[i] = vb[i] = static_cast<int16_t>(random(SHRT_MIN, SHRT_MAX));
+      }
+      const auto mismatch{random(SHRT_MIN, SHRT_MAX)};
+      differences += (scalar.blend4_dot(pr.data(), va.data()) != other.blend4_dot(pr.data(), vb.data())) ? 1u : 0u;
+      differences += (scalar.blend8_dot(pr.data(), va.data()) != other.blend8_dot(pr.data(), vb.data())) ? 1u : 0u;
+      scalar.blend4_train(pr.data(), va.data(), mismatch);
+      other.blend4_train(pr.data(), vb.data(), mismatch);
+      differences += (va != vb) ? 1u : 0u;
+      scalar.blend8_train(pr.data(), va.data(), mismatch);
+      other.blend8_train(pr.data(), vb.data(), mismatch);
+      differences += (va != vb) ? 1u : 0u;
+
+      alignas(64) std::array<int16_t, BLEND3X8_STRIDE> px{};
+      alignas(64) std::array<int16_t, BLEND3X8_STRIDE> xa{};
+      alignas(64) std::array<int16_t, BLEND3X8_STRIDE> xb{};
+      alignas(64) std::array<int16_t, BLEND3X8_STRIDE> errors{};
+      for (uint32_t i{0}; i < px.size(); ++i) {
+        px[i] = static_cast<int16_t>(random(-2047, 2047));
+        xa[i] = xb[i] = static_cast<int16_t>(random(SHRT_MIN, SHRT_MAX));
+        errors[i] = static_cast<int16_t>(random(SHRT_MIN, SHRT_MAX));
+      }
+      std::array<int32_t, BLEND3X8_STRIDE / 8> sa{};
+      std::array<int32_t, BLEND3X8_STRIDE / 8> sb{};
+      scalar.blend3x8_dot(px.data(), xa.data(), sa.data());
+      other.blend3x8_dot(px.data(), xb.data(), sb.data());
+      differences += (sa != sb) ? 1u : 0u;
+      scalar.blend3x8_train(px.data(), xa.data(), errors.data());
+      other.blend3x8_train(px.data(), xb.data(), errors.data());
+      differences += (xa != xb) ? 1u : 0u;
+    }
+    return differences;
+  }
+};  // namespace
+
+Simd::Kernels_t Simd::kernels_{LEVELS[static_cast<size_t>(selected_)]};
+
+auto Simd::Detect() noexcept -> Level {
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return Level::AVX512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return Level::AVX2;
+  }
+  return Level::SSE2;
+#else
+  return Level::Scalar;
+#endif
+}
+
+auto Simd::Select(const Level level) noexcept -> bool {
+  if ((level >= Level::SIZE) || (level > Detect())) {
+    return false;
+  }
+  selected_ = level;
+  kernels_ = LEVELS[static_cast<size_t>(level)];
+  return true;
+}
+
+auto Simd::Selected() noexcept -> Level {
+  return selected_;
+}
+
+auto Simd::Name(const Level level) noexcept -> const char* {
+  return (level < Level::SIZE) ? NAMES[static_cast<size_t>(level)] : "unknown";
+}
+
+auto Simd::SelfTest() noexcept -> bool {
+  bool ok{true};
+  for (auto level{Level::SSE2}; level <= Detect(); level = static_cast<Level>(static_cast<uint32_t>(level) + 1)) {
+    const auto differences{Compare(level)};
+    fprintf(stdout, "%-8s %s\n", Name(level), (0 == differences) ? "identical to scalar" : "DIFFERS from scalar");
+    ok = ok && (0 == differences);
+  }
+  return ok;
+}
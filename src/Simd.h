@@ -0,0 +1,90 @@
+/* Simd, kernels of the neural networks selected at runtime
+ *
+ * Copyright (c) 2019-2023 Marwijn Hessel
+ *
+ * Moruga is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Moruga is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file LICENSE.
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ * https://github.com/the-m-master/Moruga
+ */
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @namespace Simd
+ * @brief Kernels of Mixer_t and Blend_t, selected at startup for the CPU in use
+ *
+ * Every variant computes exactly the same as the scalar one (archive compatibility
+ * depends on it), SelfTest() verifies this for all variants the CPU supports.
+ */
+namespace Simd {
+  static constexpr uint32_t MIXER_INPUTS{9};     // Inputs of Mixer_t (Context_t::N_LAYERS)
+  static constexpr uint32_t BLEND3X8_STRIDE{32};  // Inputs of Blend3x8_t, 3 blends of 8 inputs padded to 64 bytes
+
+  enum class Level : uint32_t {
+    Scalar,
+    SSE2,
+    AVX2,
+    AVX512,
+    SIZE
+  };
+
+  /**
+   * @struct Kernels_t
+   * @brief The kernels of one level
+   */
+  struct Kernels_t final {
+    void (*mixer_train)(const int32_t* __restrict t, int32_t* __restrict w, int32_t err) noexcept;
+    int32_t (*mixer_dot)(const int32_t* __restrict t, const int32_t* __restrict w) noexcept;
+    void (*blend4_train)(const int16_t* __restrict t, int16_t* __restrict w, int32_t err) noexcept;
+    int32_t (*blend4_dot)(const int16_t* __restrict t, const int16_t* __restrict w) noexcept;
+    void (*blend8_train)(const int16_t* __restrict t, int16_t* __restrict w, int32_t err) noexcept;
+    int32_t (*blend8_dot)(const int16_t* __restrict t, const int16_t* __restrict w) noexcept;
+    void (*blend3x8_train)(const int16_t* __restrict t, int16_t* __restrict w, const int16_t* __restrict err) noexcept;  // An error per input
+    void (*blend3x8_dot)(const int16_t* __restrict t, const int16_t* __restrict w, int32_t* __restrict sum) noexcept;    // 4 sums, of 8 inputs each
+  };
+
+  extern Kernels_t kernels_;  // In use, the best level of the CPU unless Select() changed it
+
+  /**
+   * Find the best level supported by the CPU
+   * @return The level
+   */
+  [[nodiscard]] auto Detect() noexcept -> Level;
+
+  /**
+   * Use the kernels of a level, call before any model is created
+   * @param level The level
+   * @return true when the CPU supports the level
+   */
+  [[nodiscard]] auto Select(Level level) noexcept -> bool;
+
+  /**
+   * @return The level in use
+   */
+  [[nodiscard]] auto Selected() noexcept -> Level;
+
+  /**
+   * @param level The level
+   * @return Name of the level, e.g. "AVX2"
+   */
+  [[nodiscard]] auto Name(Level level) noexcept -> const char*;
+
+  /**
+   * Compare the kernels of every level the CPU supports with the scalar ones
+   * @return true when all give identical results
+   */
+  [[nodiscard]] auto SelfTest() noexcept -> bool;
+};  // namespace Simd
@@ -36,6 +36,7 @@
 #include "CaseSpace.h"
 #include "File.h"
 #include "IntegerXXL.h"
+#include "Profile.h"
 #include "Progress.h"
 #include "TxtWords.h"
 #include "Utilities.h"
@@ -83,7 +84,7 @@ namespace {
   constexpr auto LOW_SECTION{UINT32_C(0x000000FF)};
   constexpr auto UNUSED{UINT32_C(~0)};
 
-  bool to_numbers_{false};
+  thread_local bool to_numbers_{false};  // Of the text preparation running on this thread (library calls run at the same time)
 
   template <typename T>
   ALWAYS_INLINE constexpr auto is_word_char(const T ch) noexcept -> bool {
@@ -317,6 +318,7 @@ public:
   }
 
   void Create(const File_t& in, File_t& out, const std::array<int8_t, 256>& quote, const size_t quoteLength) noexcept {
+    const Profile::Scope_t scope{Profile::Phase::Dictionary};
     _original_length = in.Size();
     const Progress_t progress("DIC", true, *this);
 
@@ -841,6 +843,7 @@ public:
   auto operator=(TxtPrep&&) -> TxtPrep& = delete;
 
   [[nodiscard]] auto Encode() noexcept -> std::tuple<int64_t, int64_t, int64_t, int64_t> {
+    const Profile::Scope_t scope{Profile::Phase::TxtPrep};
     _original_length = _in.Size();
     _out.putVLI(_original_length);
     Putc(static_cast<uint8_t>(_quote_length));
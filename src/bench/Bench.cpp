@@ -0,0 +1,479 @@
+/* Bench, microbenchmarks of the model components
+ *
+ * Copyright (c) 2019-2023 Marwijn Hessel
+ *
+ * Moruga is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Moruga is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file LICENSE.
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ * https://github.com/the-m-master/Moruga
+ */
+
+// The model components live in Moruga.cpp only, MORUGA_BENCH leaves out main()
+#include "Moruga.cpp"
+//
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__linux__)
+#  include <linux/perf_event.h>
+#  include <sys/ioctl.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+namespace {
+  constexpr auto DATA_SIZE{UINT32_C(1) << 20};  // Synthetic input of 1 MiB
+  constexpr auto CODE_SIZE{UINT32_C(1) << 18};  // Encoder_t runs the complete model, use less input
+
+  std::vector<uint8_t> data_{};                               // Same input for every run, every component
+  std::array<int16_t, 0x1000 * Mixer_t::N_LAYERS> inputs_{};  // Fixed mixer/blend inputs, range -2048..2047
+  int32_t bench_level_{2};                                    // Memory option of the tables that depend on it
+  volatile uint64_t sink_{0};                                 // Keeps the results alive
+
+  /**
+   * @class CacheMisses_t
+   * @brief Counts the cache misses of the running thread
+   *
+   * Counts the cache misses of the running thread (Linux perf events).
+   * When the counter is not available (other platforms, perf_event_paranoid) -1 is reported.
+   */
+  class CacheMisses_t final {
+  public:
+    explicit CacheMisses_t() noexcept {
+#if defined(__linux__)
+      perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.size = sizeof(attr);
+      attr.config = PERF_COUNT_HW_CACHE_MISSES;
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      _fd = static_cast<int32_t>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+    ~CacheMisses_t() noexcept {
+#if defined(__linux__)
+      if (_fd >= 0) {
+        close(_fd);
+      }
+#endif
+    }
+
+    CacheMisses_t(const CacheMisses_t&) = delete;
+    CacheMisses_t(CacheMisses_t&&) = delete;
+    auto operator=(const CacheMisses_t&) -> CacheMisses_t& = delete;
+    auto operator=(CacheMisses_t&&) -> CacheMisses_t& = delete;
+
+    void Start() const noexcept {
+#if defined(__linux__)
+      if (_fd >= 0) {
+        ioctl(_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(_fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+#endif
+    }
+
+    [[nodiscard]] auto Stop() const noexcept -> int64_t {
+      int64_t count{-1};
+#if defined(__linux__)
+      if (_fd >= 0) {
+        ioctl(_fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (sizeof(count) != read(_fd, &count, sizeof(count))) {
+          count = -1;
+        }
+      }
+#endif
+      return count;
+    }
+
+  private:
+    int32_t _fd{-1};
+    int32_t : 32;  // Padding
+  };
+
+  /**
+   * Text like input, words of a small vocabulary with a skewed distribution, gives the match models something to find
+   */
+  void Generate() noexcept {
+    uint64_t seed{UINT64_C(0x9E3779B97F4A7C15)};
+    const auto random{[&seed]() noexcept -> uint32_t {
+      seed ^= seed << 13;
+      seed ^= seed >> 7;
+      seed ^= seed << 17;
+      return static_cast<uint32_t>(seed >> 32);
+    }};
+
+    std::vector<std::string> words(512);
+    for (auto& word : words) {
+      for (auto n{2 + (random() % 9)}; n-- > 0;) {
+        word += static_cast<char>('a' + (random() % 26));
+      }
+    }
+
+    data_.clear();
+    data_.reserve(DATA_SIZE + 16);
+    while (data_.size() < DATA_SIZE) {
+      const auto r{random()};
+      const auto& word{words[(r & 3) ? (r >> 8) % 64 : (r >> 8) % words.size()]};
+      data_.insert(data_.end(), word.begin(), word.end());
+      data_.push_back((0 == (r % 13)) ? '\n' : ' ');
+    }
+    data_.resize(DATA_SIZE);
+
+    for (auto& input : inputs_) {
+      input = static_cast<int16_t>(static_cast<int32_t>(random() % 4096) - 2048);
+    }
+  }
+
+  /**
+   * Advance the shared context by one bit, like Predict_t::Predict() does
+   * @param context The context to update
+   * @param buf History of whole bytes
+   * @param bit The coded bit
+   * @return True when a whole byte was completed
+   */
+  auto Step(Context_t& context, Buffer_t& buf, const bool bit) noexcept -> bool {
+    context.bcount = 7 & (context.bcount - 1);
+    context.c0 += context.c0 + static_cast<uint32_t>(bit);
+    if (7 != context.bcount) {
+      return false;
+    }
+    const auto ch{static_cast<uint8_t>(context.c0)};
+    buf.Add(ch);
+    context.cx = (context.cx << 8) | ch;
+    context.c1 = ch;
+    context.tt = (context.tt * 8) + (ch >> 5);
+    context.w5 = (context.w5 * 4) + (0x3 & (ch >> 3));
+    context.x5 = (context.x5 << 8) + ch;
+    context.word = Utilities::is_lower(ch) ? Combine64(context.word, ch) : 0;
+    context.c0 = 1;
+    return true;
+  }
+
+  /**
+   * Call the work for every bit of the first bytes of the input
+   * @param size Number of bytes
+   * @param work Called with the bit and its position
+   */
+  template <typename Work>
+  void ForEachBit(const uint32_t size, Work&& work) noexcept {
+    uint32_t pos{0};
+    for (uint32_t i{0}; i < size; ++i) {
+      const auto ch{data_[i]};
+      for (auto n{8}; n-- > 0;) {
+        work(1 == (1 & (ch >> n)), pos++);
+      }
+    }
+  }
+
+  /**
+   * Check whether a benchmark is selected
+   * @param filter Only run when the name contains this text (empty runs all)
+   * @param name Name of the component
+   * @return True when the benchmark must run
+   */
+  [[nodiscard]] auto Selected(const std::string_view filter, const std::string_view name) noexcept -> bool {
+    return filter.empty() || (std::string_view::npos != name.find(filter));
+  }
+
+  /**
+   * Time and report one benchmark, the construction of the tables is done before and not measured
+   * @param name Name of the component
+   * @param ops Number of operations done by the work
+   * @param work The benchmark, returns a checksum of the results
+   */
+  template <typename Work>
+  void Measure(const std::string_view name, const uint64_t ops, Work&& work) noexcept {
+    const CacheMisses_t misses{};
+    const auto start{std::chrono::steady_clock::now()};
+    misses.Start();
+    const uint64_t check{work()};
+    const auto count{misses.Stop()};
+    const auto ns{std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()};
+    sink_ = sink_ + check;
+
+    const auto ns_op{static_cast<double>(ns) / static_cast<double>(ops)};
+    if (count >= 0) {
+      fprintf(stdout, "%-32.*s %9.2f ns/op %9.4f misses/op %10" PRIu64 " ops\n", static_cast<int32_t>(name.size()), name.data(), ns_op,
+              static_cast<double>(count) / static_cast<double>(ops), ops);
+    } else {
+      fprintf(stdout, "%-32.*s %9.2f ns/op %9s misses/op %10" PRIu64 " ops\n", static_cast<int32_t>(name.size()), name.data(), ns_op, "n/a", ops);
+    }
+    fflush(stdout);
+  }
+
+  template <const uint32_t N_LAYERS>
+  void BenchBlend(const std::string_view filter, const std::string_view name) noexcept {
+    if (!Selected(filter, name)) {
+      return;
+    }
+    const auto blend{std::make_unique<Blend_t<N_LAYERS>>(UINT32_C(1) << 19, 4096)};
+    Measure(name, uint64_t(DATA_SIZE) * 8, [&blend]() noexcept -> uint64_t {
+      uint64_t check{0};
+      uint32_t pr16{0x7FFF};
+      uint32_t w5{0};
+      ForEachBit(DATA_SIZE, [&](const bool bit, const uint32_t pos) noexcept {
+        auto& pr{blend->Get()};
+        const auto* const input{&inputs_[(pos & 0xFFF) * Mixer_t::N_LAYERS]};
+        for (uint32_t i{0}; i < N_LAYERS; ++i) {
+          pr[i] = input[i];
+        }
+        const int32_t err{((bit << 16) - static_cast<int32_t>(pr16)) / 8};
+        pr16 = static_cast<uint32_t>(blend->Predict(err, w5)) << 4;
+        w5 = (w5 * 2) + bit;
+        check += pr16;
+      });
+      return check;
+    });
+  }
+
+  void BenchBlend3x8(const std::string_view filter, const std::string_view name) noexcept {
+    if (!Selected(filter, name)) {
+      return;
+    }
+    const auto blend{std::make_unique<Blend3x8_t>(UINT32_C(1) << 19, std::array<int16_t, Blend3x8_t::N_LANES>{{512, 4096, 4096}})};
+    Measure(name, uint64_t(DATA_SIZE) * 8, [&blend]() noexcept -> uint64_t {
+      uint64_t check{0};
+      std::array<int32_t, Blend3x8_t::N_LANES> last{};
+      uint32_t w5{0};
+      ForEachBit(DATA_SIZE, [&](const bool bit, const uint32_t pos) noexcept {
+        for (uint32_t lane{0}; lane < Blend3x8_t::N_LANES; ++lane) {
+          auto& pr{blend->Get(static_cast<Blend3x8_t::Lane>(lane))};
+          const auto* const input{&inputs_[((pos + lane) & 0xFFF) * Mixer_t::N_LAYERS]};
+          for (uint32_t i{0}; i < Blend3x8_t::N_LAYERS; ++i) {
+            pr[i] = input[i];
+          }
+          blend->Error(static_cast<Blend3x8_t::Lane>(lane), ((bit << 12) - static_cast<int32_t>(Squash(last[lane]))) * 10);
+        }
+        const auto& px{blend->Predict(w5)};
+        for (uint32_t lane{0}; lane < Blend3x8_t::N_LANES; ++lane) {
+          last[lane] = px[lane];
+          check += static_cast<uint32_t>(px[lane] + 2048);
+        }
+        w5 = (w5 * 2) + bit;
+      });
+      return check;
+    });
+  }
+
+  template <typename Lookup>
+  void BenchHashTable(const std::string_view filter, const std::string_view name, Lookup&& lookup) noexcept {
+    if (!Selected(filter, name)) {
+      return;
+    }
+    const auto context{std::make_unique<Context_t>(bench_level_)};
+    const HashTable_t table{context->MEM(23)};
+    Measure(name, DATA_SIZE, [&table, &lookup]() noexcept -> uint64_t {
+      uint64_t check{0};
+      uint64_t h{0};
+      for (uint32_t i{0}; i < DATA_SIZE; ++i) {
+        h = Combine64(h, data_[i]);
+        uint8_t* const slot{lookup(table, Finalise64(h, 32))};
+        check += slot[0];
+        slot[0] = static_cast<uint8_t>(slot[0] + 1);
+      }
+      return check;
+    });
+  }
+
+  /**
+   * Benchmark a model that is updated per byte and predicts per bit, using the shared context
+   * @param filter Only run when the name contains this text (empty runs all)
+   * @param name Name of the component
+   * @param create Creates the model from the context and the history
+   * @param update Called with the model at the start of every byte
+   * @param predict Called with the model and the bit for every bit, returns a checksum
+   */
+  template <typename Create, typename Update, typename Predict>
+  void BenchModel(const std::string_view filter, const std::string_view name, Create&& create, Update&& update, Predict&& predict) noexcept {
+    if (!Selected(filter, name)) {
+      return;
+    }
+    const auto context{std::make_unique<Context_t>(bench_level_)};
+    std::array<uint8_t, 4> slot{};  // Predict_t points these to the HashTable_t slots, only LempelZivPredict_t reads them
+    context->cp.fill(slot.data());
+    Buffer_t buf{};
+    buf.Resize(DATA_SIZE, DATA_SIZE);
+    const auto model{create(*context, buf)};
+    Measure(name, uint64_t(DATA_SIZE) * 8, [&]() noexcept -> uint64_t {
+      uint64_t check{0};
+      ForEachBit(DATA_SIZE, [&](const bool bit, const uint32_t) noexcept {
+        if (Step(*context, buf, bit)) {
+          update(*model);
+        }
+        check += predict(*model, *context, buf, bit);
+      });
+      return check;
+    });
+  }
+
+  void BenchAll(const std::string_view filter) noexcept {
+    BenchModel(
+        filter, "APM_t::Predict",  //
+        [](const Context_t&, const Buffer_t&) noexcept { return std::make_unique<APM_t>(0x10000, 9216, 9); },
+        [](APM_t&) noexcept {},
+        [pr = UINT32_C(2048)](APM_t& apm, const Context_t& context, const Buffer_t& buf, const bool bit) mutable noexcept -> uint64_t {
+          pr = apm.Predict(bit, Stretch(pr), context.c0 | (buf(1) << 8)) >> 4;
+          return pr;
+        });
+
+    if (const auto name{"Mixer_t::Predict/Update"sv}; Selected(filter, name)) {
+      const auto context{std::make_unique<Context_t>(bench_level_)};
+      const auto mixer{std::make_unique<Mixer_t>(*context)};
+      Measure(name, uint64_t(DATA_SIZE) * 8, [&context, &mixer]() noexcept -> uint64_t {
+        uint64_t check{0};
+        uint32_t c0{1};
+        ForEachBit(DATA_SIZE, [&](const bool bit, const uint32_t pos) noexcept {
+          const auto* const input{&inputs_[(pos & 0xFFF) * Mixer_t::N_LAYERS]};
+          for (uint32_t i{0}; i < Mixer_t::N_LAYERS; ++i) {
+            context->tx[i] = input[i];
+          }
+          mixer->Context(Mixer_t::N_LAYERS * c0);
+          const auto pr{mixer->Predict()};
+          mixer->Update((bit << 12) - pr - bit);
+          c0 = (c0 >= 0x80) ? 1 : (c0 + c0 + bit);
+          check += static_cast<uint32_t>(pr);
+        });
+        return check;
+      });
+    }
+
+    BenchBlend<4>(filter, "Blend_t<4>::Predict");
+    BenchBlend<8>(filter, "Blend_t<8>::Predict");
+    BenchBlend3x8(filter, "Blend3x8_t::Predict");
+
+    BenchModel(
+        filter, "StateMap_t::Update",  //
+        [](const Context_t&, const Buffer_t&) noexcept { return std::make_unique<StateMap_t<0x10000>>(); },
+        [](StateMap_t<0x10000>&) noexcept {},
+        [](StateMap_t<0x10000>& sm, const Context_t& context, const Buffer_t& buf, const bool bit) noexcept -> uint64_t {
+          return static_cast<uint32_t>(sm.Update(bit, context.c0 | (buf(1) << 8), 5));
+        });
+
+    using ContextMap = ContextMap_t<0x4000, 0xE, 0xD, 0x7>;
+    BenchModel(
+        filter, "ContextMap_t::Predict",  //
+        [](const Context_t& context, const Buffer_t&) noexcept { return std::make_unique<ContextMap>(context); },
+        [](ContextMap&) noexcept {},  // Set() is done in predict, it needs the context
+        [](ContextMap& cm, const Context_t& context, const Buffer_t&, const bool bit) noexcept -> uint64_t {
+          if (7 == context.bcount) {
+            cm.Set(context.tt);
+          }
+          const auto [p0, p1, p2]{cm.Predict(bit)};
+          return static_cast<uint32_t>(p0 + p1 + p2);
+        });
+
+    BenchHashTable(filter, "HashTable_t::get1x", [](const HashTable_t& table, const uint32_t i) noexcept { return table.get1x(0xE0, i); });
+    BenchHashTable(filter, "HashTable_t::get3a", [](const HashTable_t& table, const uint32_t i) noexcept { return table.get3a(0x60, i); });
+    BenchHashTable(filter, "HashTable_t::get3b", [](const HashTable_t& table, const uint32_t i) noexcept { return table.get3b(0x20, i); });
+
+    if (const auto name{"HashMap_t::operator[]"sv}; Selected(filter, name)) {
+      HashMap_t map{UINT32_C(1) << (16 + bench_level_)};
+      Measure(name, DATA_SIZE, [&map]() noexcept -> uint64_t {
+        uint64_t check{0};
+        uint64_t h{0};
+        for (uint32_t i{0}; i < DATA_SIZE; ++i) {
+          h = Combine64(h, data_[i]);
+          auto* const node{map[Finalise64(h, 32)]};
+          check += node->value;
+          node->count = static_cast<uint8_t>(node->count + 1);
+          node->value = data_[i];
+        }
+        return check;
+      });
+    }
+
+    // The models leave the blending to Blend3x8_t, like in Predict_t it is part of the benchmark
+    const auto blend{std::make_unique<Blend3x8_t>(UINT32_C(1) << 19, std::array<int16_t, Blend3x8_t::N_LANES>{{512, 4096, 4096}})};
+    const auto blended{[&blend](Context_t& context, const Blend3x8_t::Lane lane, const uint32_t tx) noexcept -> uint64_t {
+      context.tx[tx] = blend->Predict((context.w5 << 3) | context.bcount)[static_cast<uint32_t>(lane)];
+      return static_cast<uint32_t>(context.tx[tx]);
+    }};
+
+    BenchModel(
+        filter, "DynamicMarkovModel_t::Predict",  //
+        [&blend](Context_t& context, const Buffer_t&) noexcept { return std::make_unique<DynamicMarkovModel_t>(context, *blend, context.MEM()); },
+        [](DynamicMarkovModel_t& dmc) noexcept { dmc.Update(); },
+        [&blended](DynamicMarkovModel_t& dmc, Context_t& context, const Buffer_t&, const bool bit) noexcept -> uint64_t {
+          dmc.Predict(bit);
+          return blended(context, Blend3x8_t::Lane::DMC, 7);
+        });
+
+    BenchModel(
+        filter, "LempelZivPredict_t::Predict",  //
+        [&blend](Context_t& context, const Buffer_t& buf) noexcept { return std::make_unique<LempelZivPredict_t>(context, *blend, buf, context.MEM(20)); },
+        [](LempelZivPredict_t& lzp) noexcept { lzp.Update(); },
+        [&blended](LempelZivPredict_t& lzp, Context_t& context, const Buffer_t&, const bool bit) noexcept -> uint64_t {
+          return lzp.Predict(bit) + blended(context, Blend3x8_t::Lane::LZP, 0);
+        });
+
+    BenchModel(
+        filter, "SparseMatchModel_t::Predict",  //
+        [&blend](Context_t& context, const Buffer_t& buf) noexcept { return std::make_unique<SparseMatchModel_t>(context, *blend, buf); },
+        [](SparseMatchModel_t& smm) noexcept { smm.Update(); },
+        [&blended](SparseMatchModel_t& smm, Context_t& context, const Buffer_t&, const bool bit) noexcept -> uint64_t {
+          smm.Predict(bit);
+          return blended(context, Blend3x8_t::Lane::SMM, 8);
+        });
+
+    if (const auto name{"Encoder_t::Code"sv}; Selected(filter, name)) {
+      Buffer_t buf{};
+      buf.Resize(CODE_SIZE, CODE_SIZE);
+      File_t out{};
+      const auto en{std::make_unique<Encoder_t<FullModel_t>>(buf, true, out, bench_level_, true)};
+      Measure(name, uint64_t(CODE_SIZE) * 8, [&en, &out]() noexcept -> uint64_t {
+        for (uint32_t i{0}; i < CODE_SIZE; ++i) {
+          en->Compress(data_[i]);
+        }
+        en->Flush();
+        return static_cast<uint64_t>(out.Position());
+      });
+    }
+  }
+};  // namespace
+
+auto main(int32_t argc, char* argv[]) -> int32_t {
+  std::string_view filter{};
+  for (int32_t n{1}; n < argc; ++n) {
+    const std::string_view arg{argv[n]};
+    if ((arg.size() >= 2) && ('-' == arg[0]) && std::isdigit(static_cast<uint8_t>(arg[1]))) {
+      bench_level_ = std::clamp(std::stoi(std::string{arg.substr(1)}), 0, 12);
+    } else if (("-h" == arg) || ("--help" == arg)) {
+      fprintf(stdout, "Usage: %s [-level] [component]\n", argv[0]);
+      fprintf(stdout, "  -level     Memory option 0 to 12 of the level dependent tables (default 2)\n");
+      fprintf(stdout, "  component  Run only the benchmarks whose name contains this text\n");
+      return EXIT_SUCCESS;
+    } else {
+      filter = arg;
+    }
+  }
+
+  Progress_t::SetSilent(true);
+  Generate();
+
+  fprintf(stdout, "Moruga microbenchmarks, %u KiB synthetic input, level %d\n", DATA_SIZE / 1024, bench_level_);
+  BenchAll(filter);
+  return (0 == sink_) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,615 @@
+/* Check, round trip tests that the corpora do not reach
+ *
+ * Copyright (c) 2019-2023 Marwijn Hessel
+ *
+ * Moruga is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Moruga is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file LICENSE.
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ * https://github.com/the-m-master/Moruga
+ */
+
+// EncodeFile() and DecodeFile() live in Moruga.cpp only, MORUGA_BENCH leaves out main()
+// Built with MORUGA_LIBRARY as well, for moruga_compress() and moruga_decompress()
+#include "Moruga.cpp"
+//
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+
+namespace {
+  using Data_t = std::vector<uint8_t>;
+
+  /**
+   * @class Random_t
+   * @brief Reproducible pseudo random numbers (xorshift)
+   */
+  class Random_t final {
+  public:
+    explicit Random_t(const uint64_t seed) noexcept : _state{seed} {}
+
+    [[nodiscard]] auto Below(const uint32_t n) noexcept -> uint32_t {
+      _state ^= _state << 13;
+      _state ^= _state >> 7;
+      _state ^= _state << 17;
+      return static_cast<uint32_t>(_state >> 32) % n;
+    }
+
+  private:
+    uint64_t _state;
+  };
+
+  constexpr std::array<const std::string_view, 32> WORDS{{"the",  "of",   "and",  "to",    "in",   "is",     "was",   "that", "for",   "on",    "as",
+                                                          "with", "by",   "he",   "it",    "at",   "from",   "his",   "an",   "were",  "are",   "which",
+                                                          "this", "also", "be",   "first", "time", "during", "there", "city", "later", "state"}};
+
+  [[nodiscard]] auto Text(const size_t size) noexcept -> Data_t {
+    Random_t random{0x5EED};
+    Data_t data{};
+    data.reserve(size + 16);
+    while (data.size() < size) {
+      for (auto n{4 + random.Below(12)}; n-- > 0;) {
+        const auto word{WORDS[random.Below(WORDS.size())]};
+        data.insert(data.end(), word.begin(), word.end());
+        data.push_back(n ? ' ' : '.');
+      }
+      data.push_back(random.Below(4) ? ' ' : '\n');
+    }
+    data.resize(size);
+    return data;
+  }
+
+  [[nodiscard]] auto Now() noexcept -> int64_t {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  /**
+   * @return true when both files have the same content
+   */
+  [[nodiscard]] auto Same(const std::string& a, const std::string& b) noexcept -> bool {
+    File_t fa{a.c_str(), "rb"};
+    File_t fb{b.c_str(), "rb"};
+    if (fa.Size() != fb.Size()) {
+      return false;
+    }
+    Data_t da(UINT32_C(1) << 20);
+    Data_t db(da.size());
+    for (;;) {
+      const auto na{fa.Read(da.data(), da.size())};
+      const auto nb{fb.Read(db.data(), db.size())};
+      if ((na != nb) || !std::equal(da.begin(), da.begin() + static_cast<ptrdiff_t>(na), db.begin())) {
+        return false;
+      }
+      if (0 == na) {
+        return true;
+      }
+    }
+  }
+
+  /**
+   * Compress a file, like the application does
+   * @param original Path of the file
+   * @param packed Path of the compressed file
+   * @param level Memory option
+   * @return true on success
+   */
+  [[nodiscard]] auto Encode(const std::string& original, const std::string& packed, const int32_t level) noexcept -> bool {
+    const Options_t options{.in_file_name = original.c_str(), .out_file_name = packed.c_str(), .block_size = 0, .level = level, .model_set = ModelSet::Full, .threads = 0, .dedup = false, .bypass = true};
+    File_t infile{original.c_str(), "rb"};
+    File_t outfile{packed.c_str(), "wb+"};
+    return EXIT_SUCCESS == EncodeFile(infile, outfile, options);
+  }
+
+  /**
+   * Decompress a file, like the application does
+   * @param packed Path of the compressed file
+   * @param unpacked Path of the decompressed file
+   * @return true on success
+   */
+  [[nodiscard]] auto Decode(const std::string& packed, const std::string& unpacked) noexcept -> bool {
+    const Options_t options{.in_file_name = packed.c_str(), .out_file_name = unpacked.c_str(), .block_size = 0, .level = 0, .model_set = ModelSet::Full, .threads = 0, .dedup = false, .bypass = true};
+    File_t infile{packed.c_str(), "rb"};
+    File_t outfile{unpacked.c_str(), "wb+"};
+    return EXIT_SUCCESS == DecodeFile(infile, outfile, options);
+  }
+
+  /**
+   * Compress and decompress a file
+   * @param original Path of the file
+   * @param level Memory option
+   * @return true when the decompressed file equals the original
+   */
+  [[nodiscard]] auto RoundTrip(const std::string& original, const int32_t level) noexcept -> bool {
+    const auto packed{original + ".mor"};
+    const auto unpacked{original + ".out"};
+    const auto ok{Encode(original, packed, level) && Decode(packed, unpacked) && Same(original, unpacked)};
+    std::remove(packed.c_str());
+    std::remove(unpacked.c_str());
+    return ok;
+  }
+
+  /**
+   * Write and read back a temporary file that moves to disk, while an other thread keeps asking
+   * for its position the way the progress thread does
+   * @return true when the content read back is the content written
+   */
+  [[nodiscard]] auto Tell() noexcept -> bool {
+    File_t file{};
+    std::atomic<bool> done{false};
+    std::thread monitor{[&file, &done]() noexcept {
+      for (int64_t sum{0}; !done.load(std::memory_order_relaxed);) {
+        sum += file.Position();
+      }
+    }};
+    Data_t block(4093);  // Not aligned with the stream buffer
+    uint32_t n{0};
+    for (; n < 16384; ++n) {
+      std::fill(block.begin(), block.end(), static_cast<uint8_t>(n));
+      file.Write(block.data(), block.size());
+    }
+    file.Seek(0);
+    bool ok{true};
+    for (uint32_t i{0}; ok && (i < n); ++i) {
+      ok = (block.size() == file.Read(block.data(), block.size())) &&
+           std::all_of(block.begin(), block.end(), [i](const uint8_t c) noexcept { return static_cast<uint8_t>(i) == c; });
+    }
+    done = true;
+    monitor.join();
+    return ok;
+  }
+
+  /**
+   * Temporary files grow past the in memory limit and move to disk, while the progress thread
+   * keeps asking for their position, also for the files of the text preparation
+   */
+  [[nodiscard]] auto Spill(const std::string& work) noexcept -> bool {
+    File_t::TemporaryLimit(INT64_C(1) << 20);
+    if (!Tell()) {
+      File_t::TemporaryLimit(INT64_C(64) << 20);
+      return false;
+    }
+    const auto original{work + "/check_spill.txt"};
+    {
+      const auto data{Text(UINT32_C(3) << 20)};
+      const File_t file{original.c_str(), "wb"};
+      file.Write(data.data(), data.size());
+    }
+    Progress_t::SetSilent(false);
+    const auto ok{RoundTrip(original, 1)};
+    Progress_t::SetSilent(true);
+    File_t::TemporaryLimit(INT64_C(64) << 20);
+    std::remove(original.c_str());
+    return ok;
+  }
+
+  /**
+   * Several compressions run at the same time in one process (as the library allows), each archive must be
+   * identical to the one made alone and decompress again, also at the same time
+   */
+  [[nodiscard]] auto Threads(const std::string& work) noexcept -> bool {
+    static constexpr size_t N{4};
+    const auto original{work + "/check_threads.txt"};
+    {
+      const auto data{Text(UINT32_C(512) << 10)};
+      const File_t file{original.c_str(), "wb"};
+      file.Write(data.data(), data.size());
+    }
+    const auto serial{original + ".mor"};
+    bool ok{Encode(original, serial, 0)};
+
+    std::array<std::string, N> packed{};
+    std::array<bool, N> passed{};
+    std::vector<std::thread> pool{};
+    for (size_t i{0}; i < N; ++i) {
+      packed[i] = original + "." + std::to_string(i) + ".mor";
+      pool.emplace_back([&, i]() noexcept {
+        const auto unpacked{packed[i] + ".out"};
+        passed[i] = Encode(original, packed[i], 0) && Decode(packed[i], unpacked) && Same(original, unpacked);
+        std::remove(unpacked.c_str());
+      });
+    }
+    for (auto& worker : pool) {
+      worker.join();
+    }
+    for (size_t i{0}; i < N; ++i) {
+      ok = ok && passed[i] && Same(serial, packed[i]);
+      std::remove(packed[i].c_str());
+    }
+    std::remove(serial.c_str());
+    std::remove(original.c_str());
+    return ok;
+  }
+
+  /**
+   * A file of more than 4 GiB, a hole between a short head and tail, the positions must not wrap at 32 bits
+   */
+  [[nodiscard]] auto Sparse(const std::string& work) noexcept -> bool {
+    static constexpr int64_t HOLE{(INT64_C(4) << 30) + 12345};  // Bytes
+    const auto original{work + "/check_sparse.bin"};
+    {
+      const auto data{Text(UINT32_C(64) << 10)};
+      const File_t file{original.c_str(), "wb"};
+      file.Write(data.data(), data.size());
+      file.Seek(static_cast<int64_t>(data.size()) + HOLE);  // A hole of zeros, the file system does not store it (when supported)
+      file.Write(data.data(), data.size());
+    }
+    Progress_t::SetSilent(false);
+    const auto ok{RoundTrip(original, 0)};
+    Progress_t::SetSilent(true);
+    std::remove(original.c_str());
+    return ok;
+  }
+
+  /**
+   * FNV-1a hash of a file
+   */
+  [[nodiscard]] auto Hash(const std::string& name) noexcept -> uint64_t {
+    File_t file{name.c_str(), "rb"};
+    uint64_t hash{UINT64_C(0xCBF29CE484222325)};
+    for (int32_t ch; EOF != (ch = file.getc());) {
+      hash = (hash ^ static_cast<uint8_t>(ch)) * UINT64_C(0x100000001B3);
+    }
+    return hash;
+  }
+
+  /**
+   * A file of the original format (without format byte), random data around a long run of zeros, decodes without
+   * the bypass and run mode. The file must be the one the original version writes, ORIGINAL_HASH is its hash.
+   */
+  [[nodiscard]] auto Original(const std::string& work) noexcept -> bool {
+    static constexpr uint64_t ORIGINAL_HASH{UINT64_C(0x7904F85469E47BE6)};
+    const auto original{work + "/check_original.bin"};
+    {
+      Random_t random{0x0219};
+      Data_t data(UINT32_C(340) << 10);
+      std::generate(data.begin(), data.begin() + (20 << 10), [&random]() noexcept { return static_cast<uint8_t>(random.Below(256)); });
+      std::generate(data.end() - (20 << 10), data.end(), [&random]() noexcept { return static_cast<uint8_t>(random.Below(256)); });
+      const File_t file{original.c_str(), "wb"};
+      file.Write(data.data(), data.size());
+    }
+    const auto packed{original + ".mor"};
+    const auto unpacked{original + ".out"};
+    bool ok{false};
+    {
+      const Options_t options{.in_file_name = original.c_str(), .out_file_name = packed.c_str(), .block_size = 0, .level = 0, .model_set = ModelSet::Full, .threads = 0, .dedup = false, .bypass = false};
+      File_t infile{original.c_str(), "rb"};
+      File_t outfile{packed.c_str(), "wb+"};
+      ok = EXIT_SUCCESS == EncodeFile(infile, outfile, options);
+    }
+    ok = ok && (ORIGINAL_HASH == Hash(packed)) && Decode(packed, unpacked) && Same(original, unpacked);
+    std::remove(unpacked.c_str());
+    std::remove(packed.c_str());
+    std::remove(original.c_str());
+    return ok;
+  }
+
+  /**
+   * Random data with many short repeats, at order 0 it looks incompressible but the models find the repeats. The
+   * bypass must leave such data to the models, the archive may not be more than 1% larger than the one without it.
+   */
+  [[nodiscard]] auto Matches(const std::string& work) noexcept -> bool {
+    const auto original{work + "/check_matches.bin"};
+    {
+      Random_t random{0x0017};
+      Data_t data{};
+      data.reserve((UINT32_C(1) << 20) + 64);
+      while (data.size() < (UINT32_C(1) << 20)) {
+        if ((data.size() > (UINT32_C(1) << 16)) && (0 == random.Below(32))) {  // A repeat of 6..15 bytes from up to 64 KiB back
+          const auto from{data.size() - 1 - random.Below(UINT32_C(1) << 16)};
+          for (size_t n{0}, length{6 + random.Below(10)}; n < length; ++n) {
+            data.push_back(data[from + n]);
+          }
+        } else {
+          data.push_back(static_cast<uint8_t>(random.Below(256)));
+        }
+      }
+      const File_t file{original.c_str(), "wb"};
+      file.Write(data.data(), data.size());
+    }
+    const auto packed{original + ".mor"};
+    const auto unpacked{original + ".out"};
+    int64_t bypass{0};
+    int64_t models{0};
+    bool ok{Encode(original, packed, 0) && Decode(packed, unpacked) && Same(original, unpacked)};
+    if (ok) {
+      bypass = File_t{packed.c_str(), "rb"}.Size();
+      const Options_t options{.in_file_name = original.c_str(), .out_file_name = packed.c_str(), .block_size = 0, .level = 0, .model_set = ModelSet::Full, .threads = 0, .dedup = false, .bypass = false};
+      File_t infile{original.c_str(), "rb"};
+      File_t outfile{packed.c_str(), "wb+"};
+      ok = EXIT_SUCCESS == EncodeFile(infile, outfile, options);
+      models = outfile.Size();
+    }
+    ok = ok && ((100 * bypass) <= (101 * models));
+    std::remove(unpacked.c_str());
+    std::remove(packed.c_str());
+    std::remove(original.c_str());
+    return ok;
+  }
+
+  /**
+   * A gzip stream cut in half at the end of the file, as a block boundary cuts it. Inflating may not run on past the
+   * end of the input, zeros after it decode to endless output.
+   */
+  [[nodiscard]] auto Cut(const std::string& work) noexcept -> bool {
+    const auto original{work + "/check_cut.bin"};
+    {
+      const auto text{Text(UINT32_C(64) << 10)};
+      Data_t packed(compressBound(text.size()) + 32);
+      z_stream strm{};
+      if (Z_OK != deflateInit2(&strm, Z_BEST_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY)) {  // With a gzip header
+        return false;
+      }
+      strm.next_in = const_cast<Bytef*>(text.data());
+      strm.avail_in = static_cast<uInt>(text.size());
+      strm.next_out = packed.data();
+      strm.avail_out = static_cast<uInt>(packed.size());
+      const auto status{deflate(&strm, Z_FINISH)};
+      packed.resize(strm.total_out);
+      deflateEnd(&strm);
+      if (Z_STREAM_END != status) {
+        return false;
+      }
+
+      Random_t random{0x0C07};
+      Data_t data(4096);
+      std::generate(data.begin(), data.end(), [&random]() noexcept { return static_cast<uint8_t>(random.Below(256)); });
+      data.insert(data.end(), packed.begin(), packed.begin() + static_cast<ptrdiff_t>(packed.size() / 2));
+      const File_t file{original.c_str(), "wb"};
+      file.Write(data.data(), data.size());
+    }
+    const auto ok{RoundTrip(original, 0)};
+    std::remove(original.c_str());
+    return ok;
+  }
+
+  /**
+   * A file of one byte and a last block of one byte, in file and in block mode. The coded stream of such a block is
+   * shorter than the 4 bytes the decoder starts with, the bytes past its end may not spoil the ones in it.
+   */
+  [[nodiscard]] auto Tiny(const std::string& work) noexcept -> bool {
+    struct Case_t {
+      size_t size;
+      int32_t threads;
+      int32_t block_size;  // MiB
+    };
+    static constexpr std::array<const Case_t, 3> CASES{{{1, 0, 0}, {1, 4, 0}, {(UINT32_C(1) << 20) + 1, 0, 1}}};
+
+    const auto original{work + "/check_tiny.bin"};
+    const auto packed{original + ".mor"};
+    const auto unpacked{original + ".out"};
+    bool ok{true};
+    for (const auto& test : CASES) {
+      {
+        Random_t random{0x0001};
+        Data_t data(test.size);
+        std::generate(data.begin(), data.end(), [&random]() noexcept { return static_cast<uint8_t>(random.Below(256)); });
+        const File_t file{original.c_str(), "wb"};
+        file.Write(data.data(), data.size());
+      }
+      {
+        const Options_t options{.in_file_name = original.c_str(), .out_file_name = packed.c_str(), .block_size = test.block_size, .level = 0, .model_set = ModelSet::Full, .threads = test.threads, .dedup = false, .bypass = true};
+        File_t infile{original.c_str(), "rb"};
+        File_t outfile{packed.c_str(), "wb+"};
+        ok = ok && (EXIT_SUCCESS == EncodeFile(infile, outfile, options));
+      }
+      ok = ok && Decode(packed, unpacked) && Same(original, unpacked);
+    }
+    std::remove(unpacked.c_str());
+    std::remove(packed.c_str());
+    std::remove(original.c_str());
+    return ok;
+  }
+
+  /**
+   * Streams (stdin to stdout) of a few bytes and a last frame of one byte. As in the tiny check, the coded frames are
+   * shorter than the 4 bytes the decoder starts with.
+   */
+  [[nodiscard]] auto Stream(const std::string& work) noexcept -> bool {
+    static constexpr std::array<const size_t, 6> SIZES{{0, 1, 2, 3, 5, (UINT32_C(1) << 20) + 1}};
+
+    const auto original{work + "/check_stream.bin"};
+    const auto packed{original + ".mor"};
+    const auto unpacked{original + ".out"};
+    bool ok{true};
+    for (const auto size : SIZES) {
+      {
+        Random_t random{0x0007};
+        Data_t data(size);
+        std::generate(data.begin(), data.end(), [&random]() noexcept { return static_cast<uint8_t>(random.Below(256)); });
+        const File_t file{original.c_str(), "wb"};
+        file.Write(data.data(), data.size());
+      }
+      {
+        const Options_t options{.in_file_name = original.c_str(), .out_file_name = packed.c_str(), .block_size = 1, .level = 0, .model_set = ModelSet::Full, .threads = 2, .dedup = false, .bypass = true};
+        const File_t infile{original.c_str(), "rb"};
+        const File_t outfile{packed.c_str(), "wb"};
+        ok = ok && (EXIT_SUCCESS == EncodeStream(infile, outfile, options));
+      }
+      ok = ok && Decode(packed, unpacked) && Same(original, unpacked);
+    }
+    std::remove(unpacked.c_str());
+    std::remove(packed.c_str());
+    std::remove(original.c_str());
+    return ok;
+  }
+
+  /**
+   * A block file with a damaged block, the decoding must fail instead of writing wrong data
+   */
+  [[nodiscard]] auto Damaged(const std::string& work) noexcept -> bool {
+    const auto original{work + "/check_damaged.bin"};
+    {
+      Random_t random{0x0002};
+      Data_t data((UINT32_C(3) << 19) + 1);  // 2 blocks
+      std::generate(data.begin(), data.end(), [&random]() noexcept { return static_cast<uint8_t>(random.Below(256)); });
+      const File_t file{original.c_str(), "wb"};
+      file.Write(data.data(), data.size());
+    }
+    const auto packed{original + ".mor"};
+    const auto unpacked{original + ".out"};
+    bool ok{false};
+    {
+      const Options_t options{.in_file_name = original.c_str(), .out_file_name = packed.c_str(), .block_size = 1, .level = 0, .model_set = ModelSet::Full, .threads = 0, .dedup = false, .bypass = true};
+      File_t infile{original.c_str(), "rb"};
+      File_t outfile{packed.c_str(), "wb+"};
+      ok = EXIT_SUCCESS == EncodeFile(infile, outfile, options);
+    }
+    if (ok) {
+      const File_t file{packed.c_str(), "rb+"};
+      const auto position{file.Size() - 1000};  // In the last block
+      file.Seek(position);
+      const auto ch{file.getc()};
+      file.Seek(position);
+      file.putc(ch ^ 0x10);
+    }
+    ok = ok && !Decode(packed, unpacked);
+    std::remove(unpacked.c_str());
+    std::remove(packed.c_str());
+    std::remove(original.c_str());
+    return ok;
+  }
+
+  /**
+   * Sink of the library calls, collects the produced data
+   */
+  auto Collect(void* const user, const void* const data, const size_t size) noexcept -> int32_t {
+    auto* const out{static_cast<Data_t*>(user)};
+    const auto* const bytes{static_cast<const uint8_t*>(data)};
+    out->insert(out->end(), bytes, bytes + size);
+    return 0;
+  }
+
+  /**
+   * Sink of the library calls that refuses the data, counts how often it is called
+   */
+  auto Refuse(void* const user, const void* /*data*/, const size_t /*size*/) noexcept -> int32_t {
+    ++*static_cast<uint32_t*>(user);
+    return 1;
+  }
+
+  /**
+   * The library interface (src/Moruga.h) on several threads at the same time, each archive must be identical to the
+   * one of the application and decompress again. A sink that returns non-zero must abort the call with a failure.
+   */
+  [[nodiscard]] auto Library(const std::string& work) noexcept -> bool {
+    static constexpr size_t N{4};
+    const auto original{work + "/check_library.txt"};
+    const auto data{Text(UINT32_C(256) << 10)};
+    {
+      const File_t file{original.c_str(), "wb"};
+      file.Write(data.data(), data.size());
+    }
+    const auto serial{original + ".mor"};
+    bool ok{Encode(original, serial, 0)};
+    Data_t archive{};
+    if (ok) {
+      const File_t file{serial.c_str(), "rb"};
+      archive.resize(static_cast<size_t>(file.Size()));
+      ok = archive.size() == file.Read(archive.data(), archive.size());
+    }
+    std::remove(serial.c_str());
+    std::remove(original.c_str());
+
+    std::array<bool, N> passed{};
+    std::vector<std::thread> pool{};
+    for (size_t i{0}; i < N; ++i) {
+      pool.emplace_back([&, i]() noexcept {
+        Data_t packed{};
+        Data_t unpacked{};
+        passed[i] = (0 == moruga_compress(data.data(), data.size(), 0, Collect, &packed)) && (archive == packed) &&  //
+                    (0 == moruga_decompress(packed.data(), packed.size(), Collect, &unpacked)) && (data == unpacked);
+      });
+    }
+    for (auto& worker : pool) {
+      worker.join();
+    }
+    ok = ok && std::all_of(passed.begin(), passed.end(), [](const bool p) noexcept { return p; });
+
+    uint32_t compress_calls{0};
+    uint32_t decompress_calls{0};
+    ok = ok && (0 != moruga_compress(data.data(), data.size(), 0, Refuse, &compress_calls)) && (compress_calls > 0);
+    ok = ok && (0 != moruga_decompress(archive.data(), archive.size(), Refuse, &decompress_calls)) && (1 == decompress_calls);
+    return ok;
+  }
+
+  struct Check_t {
+    std::string_view name;
+    auto (*run)(const std::string& work) noexcept -> bool;
+    bool slow;     // Only run when named
+    int32_t : 24;  // Padding
+    int32_t : 32;  // Padding
+  };
+
+  constexpr std::array<const Check_t, 10> CHECKS{{{"spill", Spill, false},
+                                                  {"threads", Threads, false},
+                                                  {"original", Original, false},
+                                                  {"matches", Matches, false},
+                                                  {"cut", Cut, false},
+                                                  {"tiny", Tiny, false},
+                                                  {"stream", Stream, false},
+                                                  {"damaged", Damaged, false},
+                                                  {"library", Library, false},
+                                                  {"sparse", Sparse, true}}};
+
+  void Usage(const char* const name) noexcept {
+    fprintf(stdout,
+            "Usage: %s [options] [checks]\n"
+            "  -w, --work-dir <dir>   Directory for the temporary files (default .)\n"
+            "  -h, --help             Display this short help and exit\n"
+            "Checks (default all but the slow ones): spill, threads, original, matches, cut, tiny, stream, damaged, library\n"
+            "Slow checks, only run when named: sparse (round trip of more than 4 GiB, a few minutes)\n",
+            name);
+  }
+};  // namespace
+
+auto main(int32_t argc, char* argv[]) -> int32_t {
+  std::string work{"."};
+
+  static constexpr std::array<const char, 5> short_options{"w:h"};
+  static constexpr std::array<const struct option, 3> long_options{{{"work-dir", required_argument, nullptr, 'w'},  //
+                                                                    {"help", no_argument, nullptr, 'h'},            //
+                                                                    {nullptr, 0, nullptr, 0}}};
+
+  for (int32_t command{0}; -1 != (command = getopt_long(argc, argv, short_options.data(), long_options.data(), nullptr));) {
+    switch (command) {  // clang-format off
+      case 'w': work = optarg; break;
+      case 'h':
+      default: Usage(argv[0]); return EXIT_SUCCESS;
+    }  // clang-format on
+  }
+
+  Progress_t::SetSilent(true);
+
+  int32_t failed{0};
+  for (const auto& check : CHECKS) {
+    const auto named{std::any_of(argv + optind, argv + argc, [&check](const char* const arg) noexcept { return check.name == arg; })};
+    if (((optind < argc) || check.slow) && !named) {
+      continue;
+    }
+    const auto start{Now()};
+    const auto ok{check.run(work)};
+    fprintf(stderr, "\n%-8.*s %s (%" PRId64 " ms)\n", static_cast<int32_t>(check.name.size()), check.name.data(), ok ? "passed" : "FAILED", Now() - start);
+    failed += ok ? 0 : 1;
+  }
+  return (0 == failed) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
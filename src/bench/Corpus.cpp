@@ -0,0 +1,772 @@
+/* Corpus, end-to-end benchmark on synthetic corpora with JSON results
+ *
+ * Copyright (c) 2019-2023 Marwijn Hessel
+ *
+ * Moruga is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Moruga is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file LICENSE.
+ * If not, see <https://www.gnu.org/licenses/>
+ *
+ * https://github.com/the-m-master/Moruga
+ */
+
+// EncodeFile() and DecodeFile() live in Moruga.cpp only, MORUGA_BENCH leaves out main()
+#include "Moruga.cpp"
+//
+#include <zlib.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace gzip {  // gzip/gzip.h can not be combined with Buffer.h (ISPOWEROF2)
+  auto Zip(FILE* const in, const uint32_t size, FILE* const out, const uint32_t level) noexcept -> uint32_t;
+};  // namespace gzip
+
+namespace {
+  using Data_t = std::vector<uint8_t>;
+
+  /**
+   * @class Random_t
+   * @brief Reproducible pseudo random numbers (xorshift)
+   *
+   * Reproducible pseudo random numbers (xorshift), the corpora must be identical on every run and platform
+   */
+  class Random_t final {
+  public:
+    explicit Random_t(const uint64_t seed) noexcept : _state{seed} {}
+
+    [[nodiscard]] auto operator()() noexcept -> uint32_t {
+      _state ^= _state << 13;
+      _state ^= _state >> 7;
+      _state ^= _state << 17;
+      return static_cast<uint32_t>(_state >> 32);
+    }
+
+    [[nodiscard]] auto Below(const uint32_t n) noexcept -> uint32_t {
+      return operator()() % n;
+    }
+
+    [[nodiscard]] auto Skewed(const uint32_t n) noexcept -> uint32_t {  // Low values are more likely
+      return static_cast<uint32_t>((uint64_t(Below(n)) * Below(n)) / n);
+    }
+
+  private:
+    uint64_t _state;
+  };
+
+  constexpr std::array<const std::string_view, 64> WORDS{
+      {"the",    "of",     "and",   "to",    "in",      "is",       "was",     "that",    "for",     "on",      "as",     "with",  "by",
+       "he",     "it",     "at",    "from",  "his",     "an",       "were",    "are",     "which",   "this",    "also",   "be",    "had",
+       "or",     "has",    "first", "one",   "their",   "its",      "new",     "after",   "who",     "they",    "two",    "her",   "she",
+       "been",   "other",  "when",  "time",  "during",  "there",    "into",    "school",  "more",    "may",     "years",  "over",  "only",
+       "year",   "most",   "would", "world", "city",    "some",     "where",   "between", "later",   "three",   "state",  "such"}};
+
+  void Put(Data_t& data, const std::string_view text) noexcept {
+    data.insert(data.end(), text.begin(), text.end());
+  }
+
+  void Put16(Data_t& data, const uint32_t value) noexcept {  // Little endian
+    data.push_back(static_cast<uint8_t>(value));
+    data.push_back(static_cast<uint8_t>(value >> 8));
+  }
+
+  void Put32(Data_t& data, const uint32_t value) noexcept {  // Little endian
+    Put16(data, value & 0xFFFF);
+    Put16(data, value >> 16);
+  }
+
+  void Put64(Data_t& data, const uint64_t value) noexcept {  // Little endian
+    Put32(data, static_cast<uint32_t>(value));
+    Put32(data, static_cast<uint32_t>(value >> 32));
+  }
+
+  void PutBE32(Data_t& data, const uint32_t value) noexcept {  // Big endian
+    data.push_back(static_cast<uint8_t>(value >> 24));
+    data.push_back(static_cast<uint8_t>(value >> 16));
+    data.push_back(static_cast<uint8_t>(value >> 8));
+    data.push_back(static_cast<uint8_t>(value));
+  }
+
+  void Set32(Data_t& data, const size_t pos, const uint32_t value) noexcept {  // Little endian
+    data[pos + 0] = static_cast<uint8_t>(value);
+    data[pos + 1] = static_cast<uint8_t>(value >> 8);
+    data[pos + 2] = static_cast<uint8_t>(value >> 16);
+    data[pos + 3] = static_cast<uint8_t>(value >> 24);
+  }
+
+  [[nodiscard]] auto Crc32(const uint8_t* const data, const size_t size, const uLong crc = 0) noexcept -> uint32_t {
+    return static_cast<uint32_t>(crc32(crc, data, static_cast<uInt>(size)));
+  }
+
+  void Sentence(Data_t& data, Random_t& random) noexcept {
+    for (auto n{4 + random.Below(14)}, i{UINT32_C(0)}; i < n; ++i) {
+      const auto word{WORDS[random.Skewed(WORDS.size())]};
+      if (0 == i) {
+        data.push_back(Utilities::to_upper(static_cast<uint8_t>(word[0])));
+        Put(data, word.substr(1));
+      } else {
+        data.push_back(' ');
+        Put(data, word);
+        if ((i + 1 < n) && (0 == random.Below(9))) {
+          data.push_back(',');
+        }
+      }
+    }
+    data.push_back('.');
+  }
+
+  [[nodiscard]] auto MakeText(const size_t size) noexcept -> Data_t {
+    Random_t random{UINT64_C(0x1234567890ABCDEF)};
+    Data_t data{};
+    while (data.size() < size) {
+      for (auto n{3 + random.Below(5)}; n-- > 0;) {
+        Sentence(data, random);
+        data.push_back(n ? ' ' : '\n');
+      }
+      data.push_back('\n');
+    }
+    data.resize(size);
+    return data;
+  }
+
+  [[nodiscard]] auto MakeXml(const size_t size) noexcept -> Data_t {
+    static constexpr std::array<const std::string_view, 3> status{{"active", "sold", "hidden"}};
+    Random_t random{UINT64_C(0x0F1E2D3C4B5A6978)};
+    Data_t data{};
+    Put(data, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<catalog>\n");
+    for (uint32_t id{1000}; data.size() < size; id += 1 + random.Below(3)) {
+      Put(data, "  <item id=\"" + std::to_string(id) + "\" status=\"" + std::string{status[random.Skewed(status.size())]} + "\">\n");
+      Put(data, "    <name>" + std::string{WORDS[random.Below(WORDS.size())]} + " " + std::string{WORDS[random.Below(WORDS.size())]} + "</name>\n");
+      Put(data, "    <price currency=\"EUR\">" + std::to_string(1 + random.Skewed(500)) + "." + std::to_string(10 + random.Below(90)) + "</price>\n");
+      Put(data, "    <quantity>" + std::to_string(random.Skewed(100)) + "</quantity>\n");
+      Put(data, "    <description>");
+      Sentence(data, random);
+      Put(data, "</description>\n  </item>\n");
+    }
+    data.resize(size);
+    return data;
+  }
+
+  [[nodiscard]] auto MakeSource(const size_t size) noexcept -> Data_t {
+    Random_t random{UINT64_C(0x5A5A5A5A12345678)};
+    Data_t data{};
+    std::vector<std::string> functions{};
+    Put(data, "#include <stddef.h>\n#include <stdint.h>\n\n");
+    while (data.size() < size) {
+      const auto name{std::string{WORDS[random.Below(WORDS.size())]} + "_" + std::string{WORDS[random.Below(WORDS.size())]}};
+      Put(data, "/* Returns the " + std::string{WORDS[random.Skewed(WORDS.size())]} + " of the " + std::string{WORDS[random.Skewed(WORDS.size())]} + " data */\n");
+      Put(data, "static int32_t " + name + "(const uint8_t* data, size_t length) {\n  int32_t result = " + std::to_string(random.Skewed(64)) + ";\n");
+      Put(data, "  for (size_t i = 0; i < length; ++i) {\n");
+      for (auto n{1 + random.Below(4)}; n-- > 0;) {
+        const auto value{std::to_string(random.Skewed(256))};
+        switch (random.Below(4)) {
+          case 0:
+            Put(data, "    if (data[i] > " + value + ") {\n      result += data[i] * " + value + ";\n    } else {\n      result -= " + value + ";\n    }\n");
+            break;
+          case 1:
+            Put(data, "    result ^= (result << " + std::to_string(1 + random.Below(7)) + ") + data[i];\n");
+            break;
+          case 2:
+            if (!functions.empty()) {
+              Put(data, "    result += " + functions[random.Skewed(static_cast<uint32_t>(functions.size()))] + "(data + i, length - i);\n");
+              break;
+            }
+            [[fallthrough]];
+          default:
+            Put(data, "    switch (data[i]) {\n      case " + value + ":\n        return result;\n      default:\n        break;\n    }\n");
+            break;
+        }
+      }
+      Put(data, "  }\n  return result;\n}\n\n");
+      functions.push_back(name);
+    }
+    data.resize(size);
+    return data;
+  }
+
+  [[nodiscard]] auto MakeElf(const size_t size) noexcept -> Data_t {
+    static constexpr uint32_t EHDR_SIZE{64};
+    static constexpr uint32_t SHDR_SIZE{64};
+    static constexpr uint64_t BASE{0x401000};
+    static constexpr std::string_view shstrtab{"\0.shstrtab\0.text\0", 17};
+
+    Random_t random{UINT64_C(0x7F454C4602010100)};
+    Data_t data(EHDR_SIZE, 0);
+    std::vector<uint32_t> functions{};
+    const auto end{(size > 1024) ? size - 512 : size / 2};
+    while (data.size() < end) {  // x86-64 code, functions calling previous functions
+      functions.push_back(static_cast<uint32_t>(data.size()));
+      Put(data, "\x55\x48\x89\xE5\x48\x83\xEC");  // push rbp; mov rbp,rsp; sub rsp,imm8
+      data.push_back(static_cast<uint8_t>(16 * (1 + random.Below(4))));
+      for (auto n{4 + random.Below(24)}; n-- > 0;) {
+        const auto disp{static_cast<uint8_t>(-4 * static_cast<int32_t>(1 + random.Skewed(8)))};
+        switch (random.Below(8)) {  // clang-format off
+          case 0: data.push_back(0xB8); Put32(data, random.Skewed(4096));   break;  // mov eax,imm32
+          case 1: Put(data, "\x89\x45"); data.push_back(disp);             break;  // mov [rbp-d],eax
+          case 2: Put(data, "\x8B\x45"); data.push_back(disp);             break;  // mov eax,[rbp-d]
+          case 3: Put(data, "\x01\xD0");                                   break;  // add eax,edx
+          case 4: Put(data, "\x83\xF8"); data.push_back(static_cast<uint8_t>(random.Skewed(128)));
+                  data.push_back(static_cast<uint8_t>(0x70 + random.Below(16)));
+                  data.push_back(static_cast<uint8_t>(random.Below(32)));  break;  // cmp eax,imm8; jcc rel8
+          case 5: Put(data, "\x48\x8D\x3D"); Put32(data, 0x2000 + (random.Skewed(256) * 8)); break;  // lea rdi,[rip+disp32]
+          case 6: Put(data, "\x48\x89\xC7");                               break;  // mov rdi,rax
+          default:
+            if (!functions.empty()) {  // call rel32
+              const auto target{functions[random.Skewed(static_cast<uint32_t>(functions.size()))]};
+              data.push_back(0xE8);
+              Put32(data, target - static_cast<uint32_t>(data.size() + 4));
+            }
+            break;
+        }  // clang-format on
+      }
+      Put(data, "\xC9\xC3");  // leave; ret
+      while (data.size() & 15) {
+        data.push_back(0xCC);  // int3 padding
+      }
+    }
+    const auto text_size{data.size() - EHDR_SIZE};
+    const auto shstrtab_offset{data.size()};
+    Put(data, shstrtab);
+    while (data.size() & 7) {
+      data.push_back(0);
+    }
+    const auto shoff{data.size()};
+
+    Data_t header{};
+    Put(header, std::string_view{"\x7F" "ELF\x02\x01\x01\0\0\0\0\0\0\0\0\0", 16});
+    Put16(header, 2);                                           // e_type ET_EXEC
+    Put16(header, 0x3E);                                        // e_machine EM_X86_64
+    Put32(header, 1);                                           // e_version
+    Put64(header, BASE);                                        // e_entry
+    Put64(header, 0);                                           // e_phoff
+    Put64(header, shoff);                                       // e_shoff
+    Put32(header, 0);                                           // e_flags
+    Put16(header, EHDR_SIZE);                                   // e_ehsize
+    Put16(header, 56);                                          // e_phentsize
+    Put16(header, 0);                                           // e_phnum
+    Put16(header, SHDR_SIZE);                                   // e_shentsize
+    Put16(header, 3);                                           // e_shnum
+    Put16(header, 2);                                           // e_shstrndx
+    std::copy(header.begin(), header.end(), data.begin());
+
+    const auto section{[&data](const uint32_t name, const uint32_t type, const uint64_t flags, const uint64_t addr, const uint64_t offset, const uint64_t length) noexcept {
+      Put32(data, name);
+      Put32(data, type);
+      Put64(data, flags);
+      Put64(data, addr);
+      Put64(data, offset);
+      Put64(data, length);
+      Put32(data, 0);  // link
+      Put32(data, 0);  // info
+      Put64(data, 16);
+      Put64(data, 0);
+    }};
+    section(0, 0, 0, 0, 0, 0);                                    // SHN_UNDEF
+    section(11, 1, 6, BASE, EHDR_SIZE, text_size);                // .text, SHT_PROGBITS, SHF_ALLOC|SHF_EXECINSTR
+    section(1, 3, 0, 0, shstrtab_offset, shstrtab.size());        // .shstrtab, SHT_STRTAB
+    return data;
+  }
+
+  [[nodiscard]] auto MakeBmp(const size_t size) noexcept -> Data_t {
+    static constexpr uint32_t width{256};
+    const auto height{static_cast<uint32_t>((std::max)(size_t(16), (size - 54) / (width * 3)))};
+    const auto image_size{width * height * 3};
+
+    Random_t random{UINT64_C(0x424D424D424D424D)};
+    Data_t data{};
+    Put(data, "BM");
+    Put32(data, 54 + image_size);  // File size
+    Put32(data, 0);                // Reserved
+    Put32(data, 54);               // Offset to the image data
+    Put32(data, 40);               // BITMAPINFOHEADER
+    Put32(data, width);
+    Put32(data, height);
+    Put16(data, 1);   // Planes
+    Put16(data, 24);  // Bits per pixel
+    Put32(data, 0);   // BI_RGB
+    Put32(data, image_size);
+    Put32(data, 2835);  // 72 DPI
+    Put32(data, 2835);
+    Put32(data, 0);
+    Put32(data, 0);
+    for (uint32_t y{0}; y < height; ++y) {  // Smooth gradients with some noise, like a photo
+      for (uint32_t x{0}; x < width; ++x) {
+        const auto noise{random.Below(5)};
+        data.push_back(static_cast<uint8_t>(((x + y) / 2) + noise));
+        data.push_back(static_cast<uint8_t>(((x * y) >> 8) + noise));
+        data.push_back(static_cast<uint8_t>((128 + ((x ^ y) & 0x3F)) - noise));
+      }
+    }
+    return data;
+  }
+
+  [[nodiscard]] auto MakeWav(const size_t size) noexcept -> Data_t {
+    static constexpr uint32_t rate{44100};
+    const auto samples{static_cast<uint32_t>((size - 44) / 4)};
+
+    std::array<int16_t, 4096> sine{};
+    for (uint32_t i{0}; i < sine.size(); ++i) {
+      sine[i] = static_cast<int16_t>(std::lround(std::sin((6.283185307179586 * i) / sine.size()) * 8000.0));
+    }
+
+    Random_t random{UINT64_C(0x5249464657415645)};
+    Data_t data{};
+    Put(data, "RIFF");
+    Put32(data, 36 + (samples * 4));
+    Put(data, "WAVEfmt ");
+    Put32(data, 16);
+    Put16(data, 1);  // PCM
+    Put16(data, 2);  // Stereo
+    Put32(data, rate);
+    Put32(data, rate * 4);
+    Put16(data, 4);
+    Put16(data, 16);
+    Put(data, "data");
+    Put32(data, samples * 4);
+    uint32_t phase1{0};
+    uint32_t phase2{0};
+    for (uint32_t i{0}; i < samples; ++i) {  // Two tones, the second one changes pitch slowly
+      phase1 += 40;
+      phase2 += 60 + ((i / rate) % 7) * 9;
+      const auto noise{static_cast<int32_t>(random.Below(64)) - 32};
+      const auto left{sine[(phase1 >> 2) & 0xFFF] + (sine[(phase2 >> 2) & 0xFFF] / 2) + noise};
+      const auto right{(sine[(phase1 >> 2) & 0xFFF] / 2) + sine[(phase2 >> 2) & 0xFFF] - noise};
+      Put16(data, static_cast<uint32_t>(left) & 0xFFFF);
+      Put16(data, static_cast<uint32_t>(right) & 0xFFFF);
+    }
+    return data;
+  }
+
+  [[nodiscard]] auto Deflate(const Data_t& input, const int32_t level, const int32_t window_bits) noexcept -> Data_t {
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    Data_t data(deflateBound(&strm, input.size()) + 1024);
+    if (Z_OK != deflateInit2(&strm, level, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY)) {
+      return {};
+    }
+    strm.next_in = const_cast<Bytef*>(input.data());
+    strm.avail_in = static_cast<uInt>(input.size());
+    strm.next_out = data.data();
+    strm.avail_out = static_cast<uInt>(data.size());
+    deflate(&strm, Z_FINISH);
+    data.resize(strm.total_out);
+    deflateEnd(&strm);
+    return data;
+  }
+
+  [[nodiscard]] auto MakeGz(const size_t size) noexcept -> Data_t {  // Text, deflated by the bundled gzip code (as gzip -9)
+    const auto text{MakeText(size + (size / 2))};
+    File_t in{};
+    in.Write(text.data(), text.size());
+    in.Flush();
+    in.Seek(0);
+    File_t out{};
+    gzip::Zip(in, static_cast<uint32_t>(text.size()), out, 9);
+    out.Flush();
+
+    Data_t data{0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 2, 3};  // Deflate, no name, no time, maximum compression, Unix
+    const auto length{static_cast<size_t>(out.Size())};
+    data.resize(data.size() + length);
+    out.Seek(0);
+    out.Read(&data[10], length);
+    Put32(data, Crc32(text.data(), text.size()));
+    Put32(data, static_cast<uint32_t>(text.size()));
+    return data;
+  }
+
+  [[nodiscard]] auto MakeZip(const size_t size) noexcept -> Data_t {  // Source code, deflated by zlib
+    const auto source{MakeSource(size + (size / 2))};
+    const auto deflated{Deflate(source, 6, -15)};
+    const auto crc{Crc32(source.data(), source.size())};
+    static constexpr std::string_view name{"source.c"};
+
+    Data_t data{};
+    const auto local{[&](const uint32_t signature) noexcept {
+      Put32(data, signature);
+      if (0x02014B50 == signature) {
+        Put16(data, 20);  // Version made by
+      }
+      Put16(data, 20);          // Version needed to extract
+      Put16(data, 0);           // Flags
+      Put16(data, 8);           // Deflate
+      Put16(data, 0x6000);      // Time
+      Put16(data, 0x5721);      // Date
+      Put32(data, crc);
+      Put32(data, static_cast<uint32_t>(deflated.size()));
+      Put32(data, static_cast<uint32_t>(source.size()));
+      Put16(data, static_cast<uint32_t>(name.size()));
+      Put16(data, 0);           // Extra field length
+    }};
+    local(0x04034B50);
+    Put(data, name);
+    data.insert(data.end(), deflated.begin(), deflated.end());
+    const auto central{data.size()};
+    local(0x02014B50);
+    Put16(data, 0);  // Comment length
+    Put16(data, 0);  // Disk number
+    Put16(data, 0);  // Internal attributes
+    Put32(data, 0);  // External attributes
+    Put32(data, 0);  // Offset of local header
+    Put(data, name);
+    const auto central_size{data.size() - central};
+    Put32(data, 0x06054B50);
+    Put16(data, 0);
+    Put16(data, 0);
+    Put16(data, 1);
+    Put16(data, 1);
+    Put32(data, static_cast<uint32_t>(central_size));
+    Put32(data, static_cast<uint32_t>(central));
+    Put16(data, 0);
+    return data;
+  }
+
+  [[nodiscard]] auto MakePng(const size_t size) noexcept -> Data_t {  // Image, deflated by zlib (as most encoders do)
+    static constexpr uint32_t width{256};
+    const auto height{static_cast<uint32_t>((std::max)(size_t(16), size / (width * 2)))};
+    Random_t random{UINT64_C(0x89504E470D0A1A0A)};
+    Data_t raw{};
+    for (uint32_t y{0}; y < height; ++y) {
+      raw.push_back(0);  // Filter type none
+      for (uint32_t x{0}; x < width; ++x) {
+        const auto noise{random.Below(3)};
+        raw.push_back(static_cast<uint8_t>(((x + y) / 2) + noise));
+        raw.push_back(static_cast<uint8_t>(((x * y) >> 8) + noise));
+        raw.push_back(static_cast<uint8_t>((x ^ y) + noise));
+      }
+    }
+
+    Data_t data{0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    const auto chunk{[&data](const std::string_view type, const Data_t& content) noexcept {
+      PutBE32(data, static_cast<uint32_t>(content.size()));
+      const auto start{data.size()};
+      Put(data, type);
+      data.insert(data.end(), content.begin(), content.end());
+      PutBE32(data, Crc32(&data[start], data.size() - start));
+    }};
+    Data_t ihdr{};
+    PutBE32(ihdr, width);
+    PutBE32(ihdr, height);
+    ihdr.insert(ihdr.end(), {8, 2, 0, 0, 0});  // 8 bits, RGB, deflate, adaptive filtering, no interlace
+    chunk("IHDR", ihdr);
+    chunk("IDAT", Deflate(raw, Z_DEFAULT_COMPRESSION, 15));
+    chunk("IEND", {});
+    return data;
+  }
+
+  /**
+   * @struct Corpus_t
+   * @brief A synthetic corpus
+   */
+  struct Corpus_t final {
+    std::string_view name;
+    Data_t (*make)(size_t size) noexcept;
+  };
+
+  constexpr std::array<const Corpus_t, 9> CORPORA{{{"text", MakeText},
+                                                  {"xml", MakeXml},
+                                                  {"source", MakeSource},
+                                                  {"elf", MakeElf},
+                                                  {"bmp", MakeBmp},
+                                                  {"wav", MakeWav},
+                                                  {"gz", MakeGz},
+                                                  {"zip", MakeZip},
+                                                  {"png", MakePng}}};
+
+  /**
+   * @struct Result_t
+   * @brief Outcome of one round trip
+   */
+  struct Result_t final {
+    std::string corpus;
+    int32_t level;
+    int32_t : 32;  // Padding
+    int64_t size;
+    int64_t packed;
+    double compress_ns;    // ns/byte of the original size
+    double decompress_ns;  // ns/byte of the original size
+    uint32_t peak_kib;
+    bool roundtrip;
+    int32_t : 24;  // Padding
+  };
+
+  [[nodiscard]] auto Now() noexcept -> int64_t {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  /**
+   * Compress and decompress one corpus, like the application does with files
+   * @param corpus Name of the corpus
+   * @param data Content of the corpus
+   * @param level Memory option
+   * @param work Directory for the temporary files
+   * @return The measurements
+   */
+  [[nodiscard]] auto RoundTrip(const std::string_view corpus, const Data_t& data, const int32_t level, const std::string& work) noexcept -> Result_t {
+    const auto base{work + "/corpus_" + std::string{corpus}};
+    const auto original{base + ".bin"};
+    const auto packed{base + ".mor"};
+    const auto unpacked{base + ".out"};
+    {
+      const File_t file{original.c_str(), "wb"};
+      file.Write(data.data(), data.size());
+    }
+
+    Result_t result{.corpus = std::string{corpus},
+                    .level = level,
+                    .size = static_cast<int64_t>(data.size()),
+                    .packed = 0,
+                    .compress_ns = 0.0,
+                    .decompress_ns = 0.0,
+                    .peak_kib = 0,
+                    .roundtrip = false};
+    Progress_t::ResetPeakMemoryUse();
+
+    bool ok{false};
+    {
+      const Options_t options{.in_file_name = original.c_str(), .out_file_name = packed.c_str(), .block_size = 0, .level = level, .model_set = ModelSet::Full, .threads = 0, .dedup = false, .bypass = true};
+      File_t infile{original.c_str(), "rb"};
+      File_t outfile{packed.c_str(), "wb+"};
+      const auto start{Now()};
+      ok = EXIT_SUCCESS == EncodeFile(infile, outfile, options);
+      result.compress_ns = static_cast<double>(Now() - start) / static_cast<double>(data.size());
+      result.packed = outfile.Size();
+    }
+    if (ok) {
+      const Options_t options{.in_file_name = packed.c_str(), .out_file_name = unpacked.c_str(), .block_size = 0, .level = level, .model_set = ModelSet::Full, .threads = 0, .dedup = false, .bypass = true};
+      File_t infile{packed.c_str(), "rb"};
+      File_t outfile{unpacked.c_str(), "wb+"};
+      const auto start{Now()};
+      ok = EXIT_SUCCESS == DecodeFile(infile, outfile, options);
+      result.decompress_ns = static_cast<double>(Now() - start) / static_cast<double>(data.size());
+
+      if (ok && (static_cast<int64_t>(data.size()) == outfile.Size())) {
+        Data_t check(data.size());
+        outfile.Seek(0);
+        result.roundtrip = (check.size() == outfile.Read(check.data(), check.size())) && (check == data);
+      }
+    }
+    result.peak_kib = Progress_t::PeakMemoryUse();
+
+    std::remove(original.c_str());
+    std::remove(packed.c_str());
+    std::remove(unpacked.c_str());
+    return result;
+  }
+
+  void WriteJson(FILE* const out, const std::vector<Result_t>& results, const size_t corpus_size) noexcept {
+    fprintf(out, "{\n  \"compiler\": \"%s\",\n  \"corpus_size\": %zu,\n  \"results\": [\n", __VERSION__, corpus_size);
+    for (size_t n{0}; n < results.size(); ++n) {
+      const auto& r{results[n]};
+      fprintf(out,
+              "    {\"corpus\": \"%s\", \"level\": %d, \"size\": %" PRId64 ", \"packed\": %" PRId64 ", \"ratio\": %.4f, \"compress_ns_byte\": %.1f, "
+              "\"decompress_ns_byte\": %.1f, \"peak_kib\": %" PRIu32 ", \"roundtrip\": %s}%s\n",
+              r.corpus.c_str(), r.level, r.size, r.packed, static_cast<double>(r.packed) / static_cast<double>(r.size), r.compress_ns, r.decompress_ns, r.peak_kib,
+              r.roundtrip ? "true" : "false", (n + 1 < results.size()) ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+  }
+
+  /**
+   * Find a value in one result line as written by WriteJson()
+   * @param line The line
+   * @param key The key
+   * @return The value text without quotes, empty when not found
+   */
+  [[nodiscard]] auto Value(const std::string_view line, const std::string_view key) noexcept -> std::string_view {
+    const auto quoted{"\"" + std::string{key} + "\": "};
+    auto pos{line.find(quoted)};
+    if (std::string_view::npos == pos) {
+      return {};
+    }
+    pos += quoted.size();
+    if ('"' == line[pos]) {
+      const auto end{line.find('"', pos + 1)};
+      return line.substr(pos + 1, end - pos - 1);
+    }
+    const auto end{line.find_first_of(",}", pos)};
+    return line.substr(pos, end - pos);
+  }
+
+  [[nodiscard]] auto ReadBaseline(const char* const path) noexcept -> std::vector<Result_t> {
+    std::vector<Result_t> baseline{};
+    FILE* const file{fopen(path, "r")};
+    if (nullptr == file) {
+      fprintf(stderr, "Baseline '%s' can not be opened!\n", path);
+      return baseline;
+    }
+    std::array<char, 1024> buffer{};
+    while (nullptr != fgets(buffer.data(), static_cast<int32_t>(buffer.size()), file)) {
+      const std::string_view line{buffer.data()};
+      if (const auto corpus{Value(line, "corpus")}; !corpus.empty()) {
+        baseline.push_back({.corpus = std::string{corpus},
+                            .level = atoi(std::string{Value(line, "level")}.c_str()),
+                            .size = atoll(std::string{Value(line, "size")}.c_str()),
+                            .packed = atoll(std::string{Value(line, "packed")}.c_str()),
+                            .compress_ns = atof(std::string{Value(line, "compress_ns_byte")}.c_str()),
+                            .decompress_ns = atof(std::string{Value(line, "decompress_ns_byte")}.c_str()),
+                            .peak_kib = static_cast<uint32_t>(atol(std::string{Value(line, "peak_kib")}.c_str())),
+                            .roundtrip = "true" == Value(line, "roundtrip")});
+      }
+    }
+    fclose(file);
+    return baseline;
+  }
+
+  [[nodiscard]] auto Change(const double now, const double before) noexcept -> double {  // in percent
+    return (before > 0.0) ? ((now - before) * 100.0) / before : 0.0;
+  }
+
+  /**
+   * Compare the results with a baseline, a larger result or a slower phase (above the threshold) is a regression
+   * @param results The new results
+   * @param baseline The stored results
+   * @param threshold Allowed slow down in percent
+   * @return Number of regressions
+   */
+  [[nodiscard]] auto Compare(const std::vector<Result_t>& results, const std::vector<Result_t>& baseline, const double threshold) noexcept -> int32_t {
+    int32_t regressions{0};
+    fprintf(stderr, "\n%-8s %5s %10s %10s %10s %10s\n", "corpus", "level", "packed", "compress", "decompress", "peak");
+    for (const auto& r : results) {
+      const auto base{std::find_if(baseline.begin(), baseline.end(), [&r](const Result_t& b) noexcept {  //
+        return (b.corpus == r.corpus) && (b.level == r.level) && (b.size == r.size);
+      })};
+      if (baseline.end() == base) {
+        fprintf(stderr, "%-8s %5d %43s\n", r.corpus.c_str(), r.level, "not in baseline");
+        continue;
+      }
+      const auto packed{Change(static_cast<double>(r.packed), static_cast<double>(base->packed))};
+      const auto compress{Change(r.compress_ns, base->compress_ns)};
+      const auto decompress{Change(r.decompress_ns, base->decompress_ns)};
+      const auto peak{Change(r.peak_kib, base->peak_kib)};
+      const bool regression{(r.packed > base->packed) || (compress > threshold) || (decompress > threshold) || !r.roundtrip};
+      fprintf(stderr, "%-8s %5d %+9.2f%% %+9.1f%% %+9.1f%% %+9.1f%%%s\n", r.corpus.c_str(), r.level, packed, compress, decompress, peak, regression ? "  REGRESSION" : "");
+      regressions += regression ? 1 : 0;
+    }
+    return regressions;
+  }
+
+  [[nodiscard]] auto Split(const std::string_view list) noexcept -> std::vector<std::string> {
+    std::vector<std::string> items{};
+    size_t start{0};
+    while (start <= list.size()) {
+      const auto end{(std::min)(list.find(',', start), list.size())};
+      if (end > start) {
+        items.emplace_back(list.substr(start, end - start));
+      }
+      start = end + 1;
+    }
+    return items;
+  }
+
+  void Usage(const char* const name) noexcept {
+    fprintf(stdout,
+            "Usage: %s [options]\n"
+            "  -l, --levels <list>    Memory options to test, comma separated (default 1)\n"
+            "  -s, --size <KiB>       Size of each corpus (default 256)\n"
+            "  -c, --corpus <list>    Corpora to test, comma separated (default all)\n"
+            "                         text, xml, source, elf, bmp, wav, gz, zip, png\n"
+            "  -o, --output <file>    Write the JSON results to <file> (default stdout)\n"
+            "  -b, --baseline <file>  Compare with JSON results of an earlier run\n"
+            "  -t, --threshold <%%>    Allowed slow down compared to the baseline (default 10)\n"
+            "  -w, --work-dir <dir>   Directory for the temporary files (default .)\n"
+            "  -h, --help             Display this short help and exit\n",
+            name);
+  }
+};  // namespace
+
+auto main(int32_t argc, char* argv[]) -> int32_t {
+  std::vector<int32_t> levels{1};
+  size_t corpus_size{256 * 1024};
+  std::vector<std::string> selection{};
+  const char* output{nullptr};
+  const char* baseline{nullptr};
+  double threshold{10.0};
+  std::string work{"."};
+
+  static constexpr std::array<const char, 17> short_options{"l:s:c:o:b:t:w:h"};
+  static constexpr std::array<const struct option, 9> long_options{{{"levels", required_argument, nullptr, 'l'},     //
+                                                                    {"size", required_argument, nullptr, 's'},       //
+                                                                    {"corpus", required_argument, nullptr, 'c'},     //
+                                                                    {"output", required_argument, nullptr, 'o'},     //
+                                                                    {"baseline", required_argument, nullptr, 'b'},   //
+                                                                    {"threshold", required_argument, nullptr, 't'},  //
+                                                                    {"work-dir", required_argument, nullptr, 'w'},   //
+                                                                    {"help", no_argument, nullptr, 'h'},             //
+                                                                    {nullptr, 0, nullptr, 0}}};
+
+  for (int32_t command{0}; -1 != (command = getopt_long(argc, argv, short_options.data(), long_options.data(), nullptr));) {
+    try {
+      switch (command) {  // clang-format off
+        case 'l': levels.clear();
+                  for (const auto& level : Split(optarg)) { levels.push_back(std::clamp(std::stoi(level), 0, 12)); }
+                  break;
+        case 's': corpus_size = static_cast<size_t>(std::clamp(std::stoll(optarg), 1LL, 1048576LL)) * 1024; break;
+        case 'c': selection = Split(optarg);               break;
+        case 'o': output = optarg;                         break;
+        case 'b': baseline = optarg;                       break;
+        case 't': threshold = (std::max)(0.0, std::stod(optarg)); break;
+        case 'w': work = optarg;                           break;
+        case 'h':
+        default: Usage(argv[0]); return EXIT_SUCCESS;
+      }  // clang-format on
+    } catch (...) {
+      Usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  Progress_t::SetSilent(true);
+
+  std::vector<Result_t> results{};
+  bool ok{true};
+  for (const auto& corpus : CORPORA) {
+    if (!selection.empty() && (selection.end() == std::find(selection.begin(), selection.end(), corpus.name))) {
+      continue;
+    }
+    const auto data{corpus.make(corpus_size)};
+    for (const auto level : levels) {
+      fprintf(stderr, "%-8.*s level %2d ...", static_cast<int32_t>(corpus.name.size()), corpus.name.data(), level);
+      fflush(stderr);
+      const auto& result{results.emplace_back(RoundTrip(corpus.name, data, level, work))};
+      fprintf(stderr, " %" PRId64 " -> %" PRId64 " bytes, %.0f/%.0f ns/byte, %" PRIu32 " KiB%s\n", result.size, result.packed, result.compress_ns, result.decompress_ns,
+              result.peak_kib, result.roundtrip ? "" : ", ROUND TRIP FAILED");
+      ok = ok && result.roundtrip;
+    }
+  }
+
+  FILE* const out{output ? fopen(output, "w") : stdout};
+  if (nullptr == out) {
+    fprintf(stderr, "Output '%s' can not be created!\n", output);
+    return EXIT_FAILURE;
+  }
+  WriteJson(out, results, corpus_size);
+  if (stdout != out) {
+    fclose(out);
+  }
+
+  if (nullptr != baseline) {
+    const auto stored{ReadBaseline(baseline)};
+    if (stored.empty() || (Compare(results, stored, threshold) > 0)) {
+      ok = false;
+    }
+  }
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
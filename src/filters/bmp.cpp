@@ -100,7 +100,7 @@ auto Header_t::ScanBMP(int32_t /*ch*/) noexcept -> Filter {
               _di.bytes_per_pixel = bits_per_pixel / 8;  // 3 or 4 bytes
               _di.padding_bytes = (3 == _di.bytes_per_pixel) ? (width % 4) : 0;
               _di.image_width = width;
-              _di.filter_end = static_cast<int32_t>((width * height * _di.bytes_per_pixel) + (_di.padding_bytes * height));
+              _di.filter_end = static_cast<int64_t>((static_cast<uint64_t>(width) * height * _di.bytes_per_pixel) + (_di.padding_bytes * height));
               _di.offset_to_start = static_cast<int32_t>(_buf.i4(offset - 10) - offset);
 #if 0
               fprintf(stderr, "BMP %ux%ux%u   \n", width, height, _di.bytes_per_pixel);
@@ -21,7 +21,6 @@
 #include "bz2.h"
 #include <cassert>
 #include <cinttypes>
-#include <climits>
 #include <cstdint>
 #include "Buffer.h"
 #include "File.h"
@@ -59,7 +58,7 @@ auto Header_t::ScanBZ2(int32_t /*ch*/) noexcept -> Filter {
     const auto bzlevel = (0xFF & header) - '0';
     if ((bzlevel >= 1) && (bzlevel <= 9)) {
       _di.offset_to_start = 0;   // start now!
-      _di.filter_end = INT_MAX;  // end never..
+      _di.filter_end = FILTER_END_NEVER;  // end never..
       return Filter::BZ2;
     }
   }
@@ -67,10 +66,11 @@ auto Header_t::ScanBZ2(int32_t /*ch*/) noexcept -> Filter {
   return Filter::NOFILTER;
 }
 
-BZ2_filter::BZ2_filter(File_t& stream, iEncoder_t* const coder, DataInfo_t& di, const int64_t original_length) noexcept
+BZ2_filter::BZ2_filter(File_t& stream, iEncoder_t* const coder, Recompressions_t* const recompressions, DataInfo_t& di, const int64_t original_length) noexcept
     : _original_length{original_length},  //
       _stream{stream},
       _coder{coder},
+      _recompressions{recompressions},
       _di{di} {}
 
 BZ2_filter::~BZ2_filter() noexcept = default;
@@ -81,7 +81,7 @@ auto BZ2_filter::Handle(int32_t ch) noexcept -> bool {  // encoding
     Progress_t::Cancelled(Filter::BZ2);
   }
   _coder->Compress(ch);  // Encode last character
-  DecodeEncodeCompare(_stream, _coder, safe_pos, _original_length, 0);
+  DecodeEncodeCompare(_stream, _coder, _recompressions, safe_pos, _original_length, 0);
   _di.filter_end = 0;
   return true;
 }
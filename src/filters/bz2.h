@@ -24,6 +24,7 @@
 #include "filter.h"
 class File_t;
 class iEncoder_t;
+class Recompressions_t;
 
 /**
  * @class BZ2_filter
@@ -33,7 +34,7 @@ class iEncoder_t;
  */
 class BZ2_filter final : public iFilter_t {
 public:
-  explicit BZ2_filter(File_t& stream, iEncoder_t* const coder, DataInfo_t& di, const int64_t original_length) noexcept;
+  explicit BZ2_filter(File_t& stream, iEncoder_t* const coder, Recompressions_t* const recompressions, DataInfo_t& di, const int64_t original_length) noexcept;
   virtual ~BZ2_filter() noexcept override;
 
   BZ2_filter() = delete;
@@ -51,6 +52,7 @@ private:
   const int64_t _original_length;
   File_t& _stream;
   iEncoder_t* const _coder;
+  Recompressions_t* const _recompressions;  // Of the run, nullptr when decoding
   DataInfo_t& _di;
   int32_t _block_length{0};
   uint32_t _length{0};
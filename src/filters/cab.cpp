@@ -20,7 +20,6 @@
  */
 #include "cab.h"
 #include <cinttypes>
-#include <climits>
 #include <cstdint>
 #include "Buffer.h"
 #include "File.h"
@@ -71,7 +70,7 @@ auto Header_t::ScanCAB(int32_t /*ch*/) noexcept -> Filter {
       _di.cfiles = files;
       _di.cflags = _buf.i2(offset - 30);
       _di.offset_to_start = 0;
-      _di.filter_end = INT_MAX;  // end never..
+      _di.filter_end = FILTER_END_NEVER;  // end never..
 #  if 0
       return Filter::CAB; // TODO does not work yet
 #  endif
@@ -82,9 +81,10 @@ auto Header_t::ScanCAB(int32_t /*ch*/) noexcept -> Filter {
   return Filter::NOFILTER;
 }
 
-CAB_filter::CAB_filter(File_t& stream, iEncoder_t* const coder, DataInfo_t& di) noexcept
+CAB_filter::CAB_filter(File_t& stream, iEncoder_t* const coder, Recompressions_t* const recompressions, DataInfo_t& di) noexcept
     : _stream{stream},  //
       _coder{coder},
+      _recompressions{recompressions},
       _di{di} {}
 
 CAB_filter::~CAB_filter() noexcept = default;
@@ -330,9 +330,9 @@ auto CAB_filter::Handle(int32_t ch) noexcept -> bool {  // encoding
               _stream.Seek(safe_pos);
             }
 #endif
-            DecodeEncodeCompare(_stream, _coder, safe_pos, data_.compressedDataLength, data_.uncompressedDataLength);
+            DecodeEncodeCompare(_stream, _coder, _recompressions, safe_pos, data_.compressedDataLength, data_.uncompressedDataLength);
 #if 0
-            if (0 == DecodeEncodeCompare(_stream, _coder, safe_pos, data_.compressedDataLength, data_.uncompressedDataLength)) {
+            if (0 == DecodeEncodeCompare(_stream, _coder, _recompressions, safe_pos, data_.compressedDataLength, data_.uncompressedDataLength)) {
               for (int32_t n{data_.compressedDataLength - 2}; n--;) {
                 const int32_t c{_stream.getc()};
                 _coder->Compress(c);
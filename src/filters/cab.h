@@ -25,6 +25,7 @@
 #include "filter.h"
 class File_t;
 class iEncoder_t;
+class Recompressions_t;
 
 /**
  * @class CAB_filter
@@ -34,7 +35,7 @@ class iEncoder_t;
  */
 class CAB_filter final : public iFilter_t {
 public:
-  explicit CAB_filter(File_t& stream, iEncoder_t* const coder, DataInfo_t& di) noexcept;
+  explicit CAB_filter(File_t& stream, iEncoder_t* const coder, Recompressions_t* const recompressions, DataInfo_t& di) noexcept;
   virtual ~CAB_filter() noexcept override;
 
   CAB_filter() = delete;
@@ -49,6 +50,7 @@ public:
 private:
   File_t& _stream;
   iEncoder_t* const _coder;
+  Recompressions_t* const _recompressions;  // Of the run, nullptr when decoding
   DataInfo_t& _di;
   uint32_t byte_counter_{0};
   uint32_t skip_counter_{0};
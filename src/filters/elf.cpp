@@ -21,7 +21,6 @@
 #include "elf.h"
 #include <array>
 #include <cassert>
-#include <climits>
 #include <cstdint>
 #include <utility>
 #include "Buffer.h"
@@ -354,15 +353,15 @@ auto Header_t::ScanELF(int32_t /*ch*/) noexcept -> Filter {
         (1 == _buf.i4(offset - 20))) {                     // version
       const uint16_t type{_buf.i2(offset - 16)};
       if ((ET_NONE == type) || (ET_REL == type) || (ET_EXEC == type) || (ET_DYN == type) || (ET_CORE == type)) {
-        const uint32_t i{_buf.Pos() - offset};
+        const auto i{_buf.Pos() - offset};
         if (ELFCLASS64 == clss) {
           const Elf64_entry_t* entry = reinterpret_cast<Elf64_entry_t*>(&_buf[i]);
-          _di.location = static_cast<int32_t>(entry->shoff + (entry->shstrndx * sizeof(Elf64_section_t)));
+          _di.location = static_cast<int64_t>(entry->shoff) + static_cast<int64_t>(entry->shstrndx * sizeof(Elf64_section_t));
           entry_32 = nullptr;
           entry_64 = entry;
         } else {
           const Elf32_entry_t* entry = reinterpret_cast<Elf32_entry_t*>(&_buf[i]);
-          _di.location = static_cast<int32_t>(entry->shoff + (entry->shstrndx * sizeof(Elf32_section_t)));
+          _di.location = static_cast<int64_t>(entry->shoff) + static_cast<int64_t>(entry->shstrndx * sizeof(Elf32_section_t));
           entry_32 = entry;
           entry_64 = nullptr;
         }
@@ -370,7 +369,7 @@ auto Header_t::ScanELF(int32_t /*ch*/) noexcept -> Filter {
         if (_di.location > 0) {
           _di.clss = clss;
           _di.offset_to_start = 0;
-          _di.filter_end = INT_MAX;
+          _di.filter_end = FILTER_END_NEVER;
           return Filter::ELF;
         }
       }
@@ -408,7 +407,7 @@ void ELF_filter::Detect(const int32_t ch) noexcept {
 auto ELF_filter::Handle(int32_t ch) noexcept -> bool {  // encoding
   bool status{false};
 
-  if (INT_MAX == (1 + _di.filter_end)) {
+  if (FILTER_END_NEVER == (1 + _di.filter_end)) {
     const auto origin{_stream.Position()};
     const int64_t section_location{origin + _di.location - offset - 1};
     _stream.Seek(section_location);
@@ -514,7 +513,7 @@ auto ELF_filter::Handle(int32_t ch) noexcept -> bool {  // encoding
 auto ELF_filter::Handle(int32_t ch, int64_t& pos) noexcept -> bool {  // decoding
   bool status{false};
 
-  if (INT_MAX == (1 + _di.filter_end)) {
+  if (FILTER_END_NEVER == (1 + _di.filter_end)) {
     status = true;
     _location = (_location << 8) | ch;
     ++_length;
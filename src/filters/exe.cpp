@@ -239,7 +239,7 @@ auto Header_t::ScanEXE(int32_t /*ch*/) noexcept -> Filter {
       uint32_t number_of_sections{0};
       int32_t sizeof_headers{0};
 
-      uint32_t i{_buf.Pos() - (offset - lfanew)};
+      auto i{_buf.Pos() - (offset - lfanew)};
 
       if (PROCESSOR_AMD == machine) {
         const IMAGE_NT_HEADERS64_t* _ntHeader = reinterpret_cast<IMAGE_NT_HEADERS64_t*>(&_buf[i]);
@@ -285,7 +285,7 @@ auto Header_t::ScanEXE(int32_t /*ch*/) noexcept -> Filter {
 EXE_filter::EXE_filter(File_t& stream, iEncoder_t* const coder, const DataInfo_t& di) noexcept
     : _stream{stream},  //
       _coder{coder},
-      _location{di.location} {}
+      _location{static_cast<int32_t>(di.location)} {}
 
 EXE_filter::~EXE_filter() noexcept = default;
 
@@ -20,6 +20,10 @@
  */
 #include "filter.h"
 #include <cstdint>
+#include <cstdio>
+#include "Buffer.h"
+#include "File.h"
+#include "Profile.h"
 #include "Progress.h"
 #include "bmp.h"
 #include "bz2.h"
@@ -28,6 +32,7 @@
 #include "exe.h"
 #include "gif.h"
 #include "gzp.h"
+#include "iEncoder.h"
 #include "pbm.h"
 #include "pdf.h"
 #include "pkz.h"
@@ -37,6 +42,77 @@
 #include "tif.h"
 #include "wav.h"
 
+namespace {
+  static constexpr auto PRESCAN_BUFFER_SIZE{UINT64_C(1) << 20};  // The headers look back only a little
+
+  thread_local bool prescan_{false};  // Set on the thread of PreScan_t
+
+  /**
+   * @class ScanEncoder_t
+   * @brief Encoder of the pre-scan
+   *
+   * Nothing is coded, the bytes only go to the buffer the filters look back in, as the encoder does
+   */
+  class ScanEncoder_t final : public iEncoder_t {
+  public:
+    explicit ScanEncoder_t(Buffer_t& buf) noexcept : _buf{buf} {}
+    ~ScanEncoder_t() noexcept override = default;
+
+    ScanEncoder_t() = delete;
+    ScanEncoder_t(const ScanEncoder_t&) = delete;
+    ScanEncoder_t(ScanEncoder_t&&) = delete;
+    auto operator=(const ScanEncoder_t&) -> ScanEncoder_t& = delete;
+    auto operator=(ScanEncoder_t&&) -> ScanEncoder_t& = delete;
+
+    void Compress(const int32_t c) noexcept final {
+      CompressN(8, c);
+    }
+
+    [[nodiscard]] auto Decompress() noexcept -> int32_t final {
+      return 0;
+    }
+
+    void CompressN(const int32_t N, const int64_t c) noexcept final {
+      for (auto n{N}; n-- > 0;) {
+        _c0 = (_c0 << 1) | static_cast<uint32_t>((c >> n) & 1);
+        if (_c0 >= 256) {
+          _buf.Add(static_cast<uint8_t>(_c0));
+          _c0 = 1;
+        }
+      }
+    }
+
+    [[nodiscard]] auto DecompressN(const int32_t /*N*/) noexcept -> int64_t final {
+      return 0;
+    }
+
+    void CompressVLI(int64_t c) noexcept final {
+      while (c > 0x7F) {
+        Compress(static_cast<int32_t>(0x80 | (0x7F & c)));
+        c >>= 7;
+      }
+      Compress(static_cast<int32_t>(c));
+    }
+
+    [[nodiscard]] auto DecompressVLI() noexcept -> int64_t final {
+      return 0;
+    }
+
+    void Flush() noexcept final {}
+    void SetBinary(const bool /*is_binary*/) noexcept final {}
+    void SetDataPos(const int64_t /*data_pos*/) noexcept final {}
+    void SetStart(const bool /*state*/) noexcept final {}
+    void SetDicStartOffset(const int64_t /*dictionary_length*/) noexcept final {}
+    void SetDicEndOffset(const int64_t /*dictionary_offset*/) noexcept final {}
+    void SetDicWords(const int64_t /*number_of_words*/) noexcept final {}
+
+  private:
+    Buffer_t& _buf;
+    uint32_t _c0{1};  // Bits of the current byte, after a leading one
+    int32_t : 32;     // Padding
+  };
+};  // namespace
+
 iFilter_t::~iFilter_t() noexcept = default;
 
 Header_t::Header_t(const Buffer_t& __restrict buf, DataInfo_t& __restrict di, const bool encode) noexcept
@@ -67,11 +143,12 @@ auto Header_t::Scan(int32_t ch) noexcept -> Filter {
   return type;
 }
 
-Filter_t::Filter_t(const Buffer_t& __restrict buf, const int64_t original_length, File_t& stream, iEncoder_t* const encoder) noexcept
+Filter_t::Filter_t(const Buffer_t& __restrict buf, const int64_t original_length, File_t& stream, iEncoder_t* const encoder, Recompressions_t* const recompressions) noexcept
     : _buf{buf},  //
       _original_length{original_length},
       _stream{stream},
       _encoder{encoder},
+      _recompressions{recompressions},
       _header{new Header_t{buf, _di, nullptr != encoder}} {}
 
 Filter_t::~Filter_t() noexcept {
@@ -87,16 +164,16 @@ auto Filter_t::Create(const Filter& type) noexcept -> iFilter_t* {
   switch (type) {
       // clang-format off
     case Filter::BMP: return new BMP_filter(_stream, _encoder, _di);
-    case Filter::BZ2: return new BZ2_filter(_stream, _encoder, _di, _original_length);
-    case Filter::CAB: return new CAB_filter(_stream, _encoder, _di);
+    case Filter::BZ2: return new BZ2_filter(_stream, _encoder, _recompressions, _di, _original_length);
+    case Filter::CAB: return new CAB_filter(_stream, _encoder, _recompressions, _di);
     case Filter::ELF: return new ELF_filter(_stream, _encoder, _di);
     case Filter::EXE: return new EXE_filter(_stream, _encoder, _di);
     case Filter::GIF: return new GIF_filter(_stream, _encoder, _di, _buf, _original_length);
-    case Filter::GZP: return new GZP_filter(_stream, _encoder, _di, _original_length);
+    case Filter::GZP: return new GZP_filter(_stream, _encoder, _recompressions, _di, _original_length);
     case Filter::PBM: return new PBM_filter(_stream, _encoder, _di);
-    case Filter::PDF: return new PDF_filter(_stream, _encoder, _di);
-    case Filter::PKZ: return new PKZ_filter(_stream, _encoder, _di, _buf);
-    case Filter::PNG: return new PNG_filter(_stream, _encoder, _di, _buf);
+    case Filter::PDF: return new PDF_filter(_stream, _encoder, _recompressions, _di);
+    case Filter::PKZ: return new PKZ_filter(_stream, _encoder, _recompressions, _di, _buf);
+    case Filter::PNG: return new PNG_filter(_stream, _encoder, _recompressions, _di, _buf);
     case Filter::SGI: return new SGI_filter(_stream, _encoder, _di);
     case Filter::TGA: return new TGA_filter(_stream, _encoder, _di);
     case Filter::TIF: return new TIF_filter(_stream, _encoder, _di);
@@ -111,7 +188,10 @@ auto Filter_t::Create(const Filter& type) noexcept -> iFilter_t* {
 
 auto Filter_t::Scan(int32_t ch) noexcept -> bool {  // encoding
   if (nullptr == _filter) {
-    const Filter type = _header->Scan(ch);
+    const Filter type{[this, ch]() noexcept {
+      const Profile::Scope_t scope{Profile::Phase::Detection};
+      return _header->Scan(ch);
+    }()};
     if (Filter::NOFILTER != type) {
       Progress_t::FoundType(type);
       _filter = Create(type);
@@ -134,7 +214,10 @@ auto Filter_t::Scan(int32_t ch) noexcept -> bool {  // encoding
 
 auto Filter_t::Scan(int32_t ch, int64_t& pos) noexcept -> bool {  // decoding
   if (nullptr == _filter) {
-    const Filter type = _header->Scan(ch);
+    const Filter type{[this, ch]() noexcept {
+      const Profile::Scope_t scope{Profile::Phase::Detection};
+      return _header->Scan(ch);
+    }()};
     if (Filter::NOFILTER != type) {
       Progress_t::FoundType(type);
       _filter = Create(type);
@@ -153,3 +236,33 @@ auto Filter_t::Scan(int32_t ch, int64_t& pos) noexcept -> bool {  // decoding
   }
   return false;
 }
+
+auto IsPreScan() noexcept -> bool {
+  return prescan_;
+}
+
+PreScan_t::PreScan_t(const char* const path, const int64_t original_length, Recompressions_t& recompressions) noexcept
+    : _path{path},  //
+      _original_length{original_length},
+      _recompressions{recompressions},
+      _thread{[this]() noexcept { Run(); }} {}
+
+PreScan_t::~PreScan_t() noexcept {
+  _stop = true;  // The stream at hand is finished first
+  _thread.join();
+}
+
+void PreScan_t::Run() noexcept {
+  prescan_ = true;
+  File_t stream{_path.c_str(), "rb"};
+  Buffer_t buf{};
+  buf.Resize(static_cast<uint64_t>(_original_length), PRESCAN_BUFFER_SIZE);
+  ScanEncoder_t encoder{buf};
+  Filter_t filter{buf, _original_length, stream, &encoder, &_recompressions};
+  for (int32_t ch; !_stop.load(std::memory_order_relaxed) && (EOF != (ch = stream.getc()));) {
+    if (filter.Scan(ch)) {
+      continue;
+    }
+    encoder.Compress(ch);
+  }
+}
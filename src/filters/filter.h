@@ -20,13 +20,19 @@
  */
 #pragma once
 
+#include <atomic>
 #include <cstdint>
+#include <string>
+#include <thread>
 #if !defined(_MSC_VER)
 #  include "IntegerXXL.h"
 #endif
 class Buffer_t;
 class File_t;
 class iEncoder_t;
+class Recompressions_t;
+
+static constexpr int64_t FILTER_END_NEVER{INT64_MAX};  // DataInfo_t::filter_end of a filter that ends itself
 
 /**
  * @enum Filter
@@ -87,15 +93,15 @@ struct DataInfo_t final {
   uint128_t tag{0};
 #endif
 
-  int32_t offset_to_start{0};
-  int32_t filter_end{0};
+  int64_t offset_to_start{0};
+  int64_t filter_end{0};  // FILTER_END_NEVER when the filter ends itself
   uint32_t bytes_per_pixel{0};
   uint32_t padding_bytes{0};
   uint32_t image_width{0};
   uint32_t image_height{0};
 
-  uint32_t pkzippos{0};
-  int32_t pkziplen{0};
+  uint64_t pkzippos{0};
+  int64_t pkziplen{0};
   uint32_t cycles{0};
 
   bool lzw_encoded{false};
@@ -103,7 +109,7 @@ struct DataInfo_t final {
   uint8_t clss{0};
   uint8_t flags{0};  // GZ flags
 
-  int32_t location{0};
+  int64_t location{0};  // ELF: offset of the section name table header, EXE: offset of the NT header
 
   uint32_t resetIntervalBits{0};
   uint8_t windowSizeBits{0};
@@ -115,7 +121,6 @@ struct DataInfo_t final {
   uint16_t cflags{0};    // CAB flags
 
   int32_t : 32;  // Padding
-  int32_t : 32;  // Padding
 };
 
 /**
@@ -168,7 +173,7 @@ private:
  */
 class Filter_t final {
 public:
-  explicit Filter_t(const Buffer_t& __restrict buf, const int64_t original_length, File_t& stream, iEncoder_t* encoder) noexcept;
+  explicit Filter_t(const Buffer_t& __restrict buf, const int64_t original_length, File_t& stream, iEncoder_t* encoder, Recompressions_t* recompressions) noexcept;
   virtual ~Filter_t() noexcept;
 
   Filter_t() = delete;
@@ -187,9 +192,47 @@ private:
   const int64_t _original_length;
   File_t& _stream;
   iEncoder_t* const _encoder;
+  Recompressions_t* const _recompressions;  // Of the run, nullptr when decoding
   iFilter_t* _filter{nullptr};
   Header_t* _header{nullptr};
   int32_t : 32;  // Padding
   int32_t : 32;  // Padding
   DataInfo_t _di{};
 };
+
+/**
+ * @return True on the thread of PreScan_t, its filters only prepare DecodeEncodeCompare() and are not reported
+ */
+[[nodiscard]] auto IsPreScan() noexcept -> bool;
+
+/**
+ * @class PreScan_t
+ * @brief Running the filters ahead of the encoder
+ *
+ * Runs the filters over the whole file on an other thread, while the encoder is still coding earlier bytes.
+ * The embedded streams found are recompressed there, DecodeEncodeCompare() keeps the outcome of each stream in the
+ * Recompressions_t of the run. When the filters of the encoder reach the same stream the outcome is handed over, the
+ * search is not done again.
+ */
+class PreScan_t final {
+public:
+  explicit PreScan_t(const char* const path, const int64_t original_length, Recompressions_t& recompressions) noexcept;
+  ~PreScan_t() noexcept;
+
+  PreScan_t() = delete;
+  PreScan_t(const PreScan_t&) = delete;
+  PreScan_t(PreScan_t&&) = delete;
+  PreScan_t& operator=(const PreScan_t&) = delete;
+  PreScan_t& operator=(PreScan_t&&) = delete;
+
+private:
+  void Run() noexcept;
+
+  const std::string _path;  // Opened again, the stream of the encoder is not shared
+  const int64_t _original_length;
+  Recompressions_t& _recompressions;
+  std::atomic<bool> _stop{false};
+  int32_t : 24;  // Padding
+  int32_t : 32;  // Padding
+  std::thread _thread;
+};
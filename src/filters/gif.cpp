@@ -402,7 +402,7 @@ auto Header_t::ScanGIF(int32_t /*ch*/) noexcept -> Filter {
     const auto height{_buf.i2(offset - 8)};
     if ((width > 0) && (width < 0x4000) && (height > 0) && (height < 0x4000)) {
       _di.offset_to_start = 0;  // start now!
-      _di.filter_end = _encode ? 1 : 0x7FFFFFFF;
+      _di.filter_end = _encode ? 1 : FILTER_END_NEVER;
 #if 0
       fprintf(stderr, "GIF8%ca %ux%ux%u %u\n", _buf(offset - 4), width, height, (7 & _buf(offset - 10)) + 1, _buf.Pos());
       fflush(stderr);
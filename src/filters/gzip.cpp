@@ -22,14 +22,19 @@
 #include <zlib.h>
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <memory>
+#include <thread>
 #include <tuple>
+#include <vector>
 #include "File.h"
+#include "Profile.h"
+#include "Utilities.h"
 #include "bz2.h"
 #include "filter.h"
 #include "gzip/gzip.h"
@@ -38,6 +43,29 @@
 namespace {
   static constexpr auto DIFF_COUNT_LIMIT{1u << 7};      // Default 128, range 0 .. 255
   static constexpr auto BLOCK_SIZE{UINT32_C(1) << 16};  // Default block size of 65536 bytes for ZLib and BZip2
+  static constexpr auto PROBE_SIZE{UINT32_C(1) << 20};  // Inflated start of a ZLib stream, to rule out deflate parameters
+  static constexpr auto PROBE_MIN{UINT32_C(1) << 16};   // Smaller streams are not worth probing
+  static constexpr auto PROBE_STEP{UINT32_C(1) << 12};  // Deflate input between the comparisons of a probe
+
+  constexpr std::array<uint8_t, 9> MEM_LEVELS{{8, 9, 7, 6, 5, 4, 3, 2, 1}};  // The default of ZLib first
+
+  /**
+   * @struct Candidate_t
+   * @brief Deflate parameters to try on a ZLib stream
+   */
+  struct Candidate_t final {
+    int8_t clevel;     // 1..9
+    uint8_t memLevel;  // 1..9
+  };
+
+  /**
+   * Compression level class of a ZLib header (FLEVEL), as written by deflate
+   * @param clevel Compression level 1..9
+   * @return 0 fastest, 1 fast, 2 default or 3 maximum compression
+   */
+  [[nodiscard]] constexpr auto LevelFlags(const int32_t clevel) noexcept -> int32_t {
+    return (clevel < 2) ? 0 : (clevel < 6) ? 1 : (6 == clevel) ? 2 : 3;
+  }
 
 };  // namespace
 
@@ -49,7 +77,7 @@ namespace {
  */
 struct Config_t final {
   int8_t clevel{0};      // 1..9 for ZLib/GZip -1..-9 fir BZip2
-  int8_t windowBits{0};  // -15 or 15 ZLib otherwise 0
+  int8_t windowBits{0};  // -15 or 9..15 ZLib otherwise 0
   uint8_t memLevel{0};   // 1..9 for ZLib otherwise 0
   uint8_t diffCount{0};
 
@@ -60,7 +88,7 @@ struct Config_t final {
     diffCount = static_cast<uint8_t>(stream.getc());
 
     assert(((clevel >= -9) && (clevel <= -1)) || ((clevel >= 1) && (clevel <= 9)));
-    assert((MAX_WBITS == windowBits) || (-MAX_WBITS == windowBits) || (0 == windowBits));
+    assert(((windowBits >= 9) && (windowBits <= MAX_WBITS)) || (-MAX_WBITS == windowBits) || (0 == windowBits));
     assert(((memLevel >= 1) && (memLevel <= 9)) || (0 == memLevel));
     assert((diffCount >= 0) && (diffCount < DIFF_COUNT_LIMIT));
   }
@@ -149,43 +177,112 @@ private:
 };
 
 namespace {
-  auto GZipEncodeCompare(File_t& in, const uint32_t size, File_t& out) noexcept -> std::tuple<ZHeader_t*, uint32_t, uint8_t> {
-    const auto safe_ipos{in.Position()};
-    const auto safe_opos{out.Position()};
-    for (int8_t clevel{9}; clevel >= 1; --clevel) {  // --best .. --fast
+  static constexpr auto PARALLEL_TRIALS_MIN{UINT32_C(1) << 16};  // Smaller streams are not worth starting threads for
+
+  /**
+   * @struct Trial_t
+   * @brief Deflate at one compression level, compared with the original while it is produced
+   */
+  struct Trial_t final {
+    const File_t& original;
+    const int64_t offset;                // Of the original stream
+    const std::atomic<int32_t>& best;    // Highest level that reproduced the original, lower levels give up
+    std::unique_ptr<ZHeader_t> zheader;  // Differences with the original
+    uint32_t position;                   // In the original stream
+    uint32_t diff_count;
+    const int32_t clevel;  // 1..9
+    int32_t : 32;          // Padding
+    std::array<uint8_t, OUTBUFSIZ> chunk;  // Of the original stream
+  };
+
+  /**
+   * Compare deflated output with the original stream, called by gzip::Zip()
+   * @param buf Deflated output
+   * @param cnt Number of bytes of the output
+   * @param ptr The trial
+   * @return Number of bytes accepted, EOF to stop the trial
+   */
+  auto Compare(const void* buf, uint32_t cnt, void* ptr) noexcept -> uint32_t {
+    auto& trial{*static_cast<Trial_t*>(ptr)};
+    if (trial.best.load(std::memory_order_relaxed) > trial.clevel) {
+      return uint32_t(EOF);  // A better compression level is found already
+    }
+    const auto n{trial.original.ReadAt(trial.chunk.data(), cnt, trial.offset + trial.position)};
+    const auto* const data{static_cast<const uint8_t*>(buf)};
+    for (uint32_t i{0}; i < cnt; ++i, ++trial.position) {
+      const auto a{(i < n) ? int32_t(trial.chunk[i]) : EOF};
+      if (a != data[i]) {
+        if (trial.diff_count < DIFF_COUNT_LIMIT) {
+          trial.zheader->diffPos(trial.diff_count, trial.position);
+          trial.zheader->diffByte(trial.diff_count, static_cast<uint8_t>(a));
+          ++trial.diff_count;
+        } else {
+          return uint32_t(EOF);  // To many differences...
+        }
+      }
+    }
+    return cnt;
+  }
+
+  /**
+   * Find the compression level (--best .. --fast) that reproduces the original stream.
+   * All levels are tried at the same time, each trial stops at its first difference beyond the limit.
+   * @param in Reference to the decoded stream
+   * @param size Length of the decoded stream
+   * @param out Reference to the original stream, at the start of the stream, after success at the end of the stream
+   * @param only_clevel Compression level to try, zero to try all levels
+   * @return Differences with the original (nullptr on failure), length of the stream and compression level
+   */
+  auto GZipEncodeCompare(File_t& in, const uint32_t size, File_t& out, const int8_t only_clevel) noexcept -> std::tuple<ZHeader_t*, uint32_t, uint8_t> {
+    std::vector<uint8_t> data(size);
+    const auto length{static_cast<uint32_t>(in.Read(data.data(), size))};
+    const auto offset{out.Position()};
+
+    std::atomic<int32_t> best{0};
+    std::array<std::unique_ptr<Trial_t>, 9> trials{};
+    for (size_t i{0}; i < trials.size(); ++i) {
       Config_t config{};
-      config.clevel = clevel;
-      ZHeader_t* zheader{new ZHeader_t{config}};
-      const File_t deflate_tmp /*("_deflate_tmp_.bin", "wb+")*/;
-      if (GZip_OK == gzip::Zip(in, size, deflate_tmp, static_cast<uint8_t>(clevel))) {
-        const auto length{uint32_t(deflate_tmp.Size())};
-        deflate_tmp.Rewind();
-        uint32_t diff_count{0};
-        bool success{true};
-        for (uint32_t position{0}; position < length; ++position) {
-          const auto a{out.getc()};
-          const auto b{deflate_tmp.getc()};
-          if (a != b) {
-            if (diff_count < DIFF_COUNT_LIMIT) {
-              zheader->diffPos(diff_count, position);
-              zheader->diffByte(diff_count, static_cast<uint8_t>(a));
-              ++diff_count;
-            } else {
-              success = false;  // To many differences...
-              break;
-            }
-          }
+      config.clevel = static_cast<int8_t>(9 - i);
+      if ((0 != only_clevel) && (only_clevel != config.clevel)) {
+        continue;
+      }
+      trials[i] = std::make_unique<Trial_t>(out, offset, best, std::make_unique<ZHeader_t>(config), 0u, 0u, config.clevel);
+    }
+
+    std::atomic<size_t> next{0};
+    const auto work{[&]() noexcept {
+      const auto context{std::make_unique<gzip::Context_t>()};  // Of this worker, reused for each of its trials
+      for (size_t i; (i = next.fetch_add(1)) < trials.size();) {
+        if (!trials[i]) {
+          continue;
         }
-        if (success) {
-          zheader->DiffCount(static_cast<uint8_t>(diff_count));
-          return {zheader, length, clevel};
+        auto& trial{*trials[i]};
+        if ((best.load() < trial.clevel) && (GZip_OK == context->Zip(data.data(), length, Compare, &trial, static_cast<uint32_t>(trial.clevel)))) {
+          for (auto level{best.load()}; (level < trial.clevel) && !best.compare_exchange_weak(level, trial.clevel);) {
+          }
         }
       }
-      delete zheader;
-      zheader = nullptr;
-      in.Seek(safe_ipos);  // Failure, try with an other compression level
-      out.Seek(safe_opos);
+    }};
+    const auto workers{((length < PARALLEL_TRIALS_MIN) || (0 != only_clevel)) ? size_t{1} : (std::min)(trials.size(), static_cast<size_t>(std::thread::hardware_concurrency()))};
+    if (workers > 1) {
+      std::vector<std::thread> pool{};
+      for (size_t n{workers}; n-- > 0;) {
+        pool.emplace_back(work);
+      }
+      for (auto& worker : pool) {
+        worker.join();
+      }
+    } else {
+      work();
+    }
+
+    if (const auto clevel{best.load()}; clevel > 0) {
+      auto& trial{*trials[static_cast<size_t>(9 - clevel)]};
+      trial.zheader->DiffCount(static_cast<uint8_t>(trial.diff_count));
+      out.Seek(offset + trial.position);
+      return {trial.zheader.release(), trial.position, static_cast<uint8_t>(clevel)};
     }
+    out.Seek(offset);
     return {nullptr, 0, 0};
   }
 };  // namespace
@@ -212,7 +309,6 @@ public:
     if (Z_OK != inflateInit2(&strm_, windowBits)) {
       return {false, 0};
     }
-    zheader_.Config().windowBits = static_cast<int8_t>(windowBits);
     int32_t state{Z_STREAM_END};
     uint32_t length{block_length};
     for (uint32_t i{0}; i < length; i += BLOCK_SIZE) {
@@ -248,22 +344,127 @@ public:
     return {(Z_OK == state) || (Z_STREAM_END == state), strm_.total_out};
   }
 
+  /**
+   * Rank the deflate parameters by the ZLib header and inflate the start of the stream,
+   * the parameters are then probed on the start (see NextCandidate()).
+   * The header gives the window size and the class of the compression level (FLEVEL),
+   * the levels of that class are tried first.
+   * @param stream Reference to the compressed stream, at the start of the stream
+   * @param block_length Maximum length of the compressed stream
+   * @param windowBits As for Inflate()
+   * @param flush As for Inflate(), only a stream inflated with Z_FINISH is probed
+   * @return False when the start of the stream can not be inflated, true otherwise
+   */
+  [[nodiscard]] auto Probe(File_t& stream, const uint32_t block_length, const int32_t windowBits, const int32_t flush) noexcept -> bool {
+    std::array<uint8_t, 2> header{};  // CMF and FLG
+    const auto wrapped{(windowBits >= 0) && (header.size() == stream.ReadAt(header.data(), header.size(), stream.Position())) &&  //
+                       (Z_DEFLATED == (header[0] & 0x0F)) && (0 == (((header[0] << 8) | header[1]) % 31))};
+    const auto flevel{wrapped ? (header[1] >> 6) : -1};
+    const auto wbits{(header[0] >> 4) + 8};
+    zheader_.Config().windowBits = static_cast<int8_t>((wrapped && (wbits >= 9) && (wbits < MAX_WBITS)) ? wbits : windowBits);
+
+    size_t n{0};
+    for (const auto first : {true, false}) {
+      for (int8_t clevel{9}; clevel >= 1; --clevel) {  // --best .. --fast
+        if (first == (flevel == LevelFlags(clevel))) {
+          for (const auto memLevel : MEM_LEVELS) {
+            candidates_[n++] = {clevel, memLevel};
+          }
+        }
+      }
+    }
+    candidate_ = 0;
+    candidate_count_ = static_cast<uint16_t>(n);
+
+    probe_length_ = 0;
+    if (Z_FINISH != flush) {  // Inflate() stops such a stream after its first block of output, the start is of no use
+      return true;
+    }
+    memset(&strm_, 0, sizeof(strm_));
+    if (Z_OK != inflateInit2(&strm_, windowBits)) {
+      return false;
+    }
+    probe_.resize(PROBE_SIZE);
+    strm_.next_out = probe_.data();
+    strm_.avail_out = PROBE_SIZE;
+    int32_t state{Z_OK};
+    for (uint32_t i{0}; (Z_OK == state) && (strm_.avail_out > 0) && (i < block_length); i += BLOCK_SIZE) {
+      strm_.avail_in = static_cast<uint32_t>(stream.Read(zin_.data(), (std::min)(block_length - i, BLOCK_SIZE)));
+      strm_.next_in = zin_.data();
+      state = inflate(&strm_, Z_NO_FLUSH);
+    }
+    inflateEnd(&strm_);
+    if ((Z_OK != state) && (Z_STREAM_END != state) && (Z_BUF_ERROR != state)) {
+      return false;  // Inflate() fails on the same data
+    }
+    if (strm_.total_out >= PROBE_MIN) {
+      probe_length_ = static_cast<uint32_t>(strm_.total_out);
+    }
+    return true;
+  }
+
+  /**
+   * Select the next deflate parameters in the order of Probe().
+   * Parameters are skipped when the blocks they deflate from the start of the stream
+   * differ too much from the original, since the same blocks start the output of EncodeCompare().
+   * @param original Reference to the original stream
+   * @param offset Start of the compressed stream in the original
+   * @param first True to start with the first parameters, false to continue after the current ones
+   * @return True when parameters are selected, false when no parameters are left
+   */
+  [[nodiscard]] auto NextCandidate(const File_t& original, const int64_t offset, const bool first) noexcept -> bool {
+    if (!first) {
+      ++candidate_;
+    }
+    for (; candidate_ < candidate_count_; ++candidate_) {
+      zheader_.Config().clevel = candidates_[candidate_].clevel;
+      zheader_.Config().memLevel = candidates_[candidate_].memLevel;
+      if (ProbeDeflate(original, offset)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Select deflate parameters that are known to work, instead of Probe(), EncodeCompare() then only tries these
+   * @param windowBits As found by Probe()
+   * @param clevel Compression level 1..9
+   * @param memLevel Memory level 1..9
+   */
+  void Select(const int8_t windowBits, const int8_t clevel, const uint8_t memLevel) noexcept {
+    zheader_.Config().windowBits = windowBits;
+    zheader_.Config().clevel = clevel;
+    zheader_.Config().memLevel = memLevel;
+    candidates_[0] = {clevel, memLevel};
+    candidate_ = 0;
+    candidate_count_ = 1;
+    probe_length_ = 0;
+  }
+
+  [[nodiscard]] auto Config() noexcept -> const Config_t& {
+    return zheader_.Config();
+  }
+
+  /**
+   * Find the deflate parameters that reproduce the original stream, starting with the selected ones (see NextCandidate())
+   * @param in Reference to the inflated stream
+   * @param size Length of the inflated stream
+   * @param original Reference to the original stream, at the start of the stream
+   * @return True and the length of the stream on success, false otherwise
+   */
   [[nodiscard]] auto EncodeCompare(File_t& in, const size_t size, File_t& original) noexcept -> std::tuple<bool, int64_t> {
     const auto safe_ipos{in.Position()};
     const auto safe_opos{original.Position()};
 
-    for (int8_t clevel{9}; clevel >= 1; --clevel) {  // --best .. --fast
-      for (uint8_t memLevel{9}; memLevel >= 1; --memLevel) {
-        zheader_.Config().clevel = clevel;
-        zheader_.Config().memLevel = memLevel;
-        const auto [deflate_state, deflate_length]{Deflate(in, size, original, true)};
-        if ((Z_OK == deflate_state) && (deflate_length > 0)) {
-          return {true, deflate_length};
-        }
-        in.Seek(safe_ipos);  // Failure, try with an other compression level
-        original.Seek(safe_opos);
+    do {
+      const auto [deflate_state, deflate_length]{Deflate(in, size, original, true)};
+      if ((Z_OK == deflate_state) && (deflate_length > 0)) {
+        return {true, deflate_length};
       }
-    }
+      in.Seek(safe_ipos);  // Failure, try with an other compression level
+      original.Seek(safe_opos);
+    } while (NextCandidate(original, safe_opos, false));
     return {false, 0};
   }
 
@@ -284,6 +485,53 @@ private:
 
   std::array<uint8_t, BLOCK_SIZE> zin_{};
   std::array<uint8_t, BLOCK_SIZE> zout_{};
+  std::vector<uint8_t> probe_{};  // Inflated start of the stream
+  uint32_t probe_length_{0};      // Zero when the stream is not probed
+  uint32_t candidate_{0};         // Selected parameters
+  std::array<Candidate_t, 9 * MEM_LEVELS.size()> candidates_{};
+  uint16_t candidate_count_{0};
+  int32_t : 32;  // Padding
+
+  /**
+   * Deflate the start of the stream (see Probe()) with the selected parameters, compare the completed blocks with the original
+   * @param original Reference to the original stream
+   * @param offset Start of the compressed stream in the original
+   * @return False when the parameters can not reproduce the stream, true otherwise
+   */
+  [[nodiscard]] auto ProbeDeflate(const File_t& original, const int64_t offset) noexcept -> bool {
+    if (0 == probe_length_) {
+      return true;  // Nothing to go on
+    }
+    memset(&strm_, 0, sizeof(strm_));
+    const auto clevel{zheader_.Config().clevel};
+    const auto windowBits{(0 == zheader_.Config().windowBits) ? MAX_WBITS : zheader_.Config().windowBits};
+    const auto memLevel{zheader_.Config().memLevel};
+    if (Z_OK != deflateInit2(&strm_, clevel, Z_DEFLATED, windowBits, memLevel, Z_DEFAULT_STRATEGY)) {
+      return true;  // Let Deflate() decide
+    }
+    uint32_t diff_count{0};
+    bool usable{true};
+    for (uint32_t i{0}; usable && (0 == strm_.total_out) && (i < probe_length_); i += PROBE_STEP) {  // Up to the first completed block
+      strm_.next_in = &probe_[i];
+      strm_.avail_in = (std::min)(probe_length_ - i, PROBE_STEP);
+      do {
+        strm_.next_out = zout_.data();
+        strm_.avail_out = BLOCK_SIZE;
+        deflate(&strm_, Z_NO_FLUSH);  // Blocks completed without a flush are the same as in the output of the whole stream
+        const auto have{BLOCK_SIZE - strm_.avail_out};
+        const auto position{static_cast<uint32_t>(strm_.total_out) - have};
+        const auto n{original.ReadAt(zin_.data(), have, offset + position)};
+        for (uint32_t k{0}; usable && (k < have); ++k) {
+          const auto a{(k < n) ? int32_t(zin_[k]) : EOF};
+          if (a != zout_[k]) {
+            usable = diff_count++ < DIFF_COUNT_LIMIT;
+          }
+        }
+      } while (usable && (0 == strm_.avail_out));
+    }
+    deflateEnd(&strm_);
+    return usable;
+  }
 
   [[nodiscard]] auto Deflate_(File_t& source, const size_t size, File_t& dest, const bool compare) noexcept -> int32_t {  // encode
     memset(&strm_, 0, sizeof(strm_));
@@ -559,12 +807,81 @@ auto EncodeGZip(File_t& in, const int64_t size_, File_t& out) noexcept -> bool {
   return false;
 }
 
-auto DecodeEncodeCompare(File_t& stream,                        //
-                         iEncoder_t* const coder,               //
-                         const int64_t safe_pos,                //
-                         const int64_t compressed_data_length,  //
+namespace {
+  using Method_t = Recompressions_t::Method_t;
+  using Outcome_t = Recompressions_t::Outcome_t;
+  using Key_t = Recompressions_t::Key_t;
+
+  /**
+   * Key of an embedded stream, the outcome of DecodeEncodeCompare() depends on nothing else.
+   * Only streams with a known length are digested, a length up to the end of the file (GZ, BZip2) is not.
+   * @param stream Reference to the original stream
+   * @param safe_pos Start of the embedded stream
+   * @param compressed_data_length Length of the embedded stream
+   * @param uncompressed_data_length Expected length after decoding, zero when not known
+   * @return True and the key when the stream has a known length, false otherwise
+   */
+  [[nodiscard]] auto StreamKey(const File_t& stream, const int64_t safe_pos, const int64_t compressed_data_length, const uint32_t uncompressed_data_length) noexcept
+      -> std::tuple<bool, Key_t> {
+    if ((safe_pos + compressed_data_length) > stream.Size()) {
+      return {false, {}};
+    }
+    uint64_t head{0};
+    auto digest{(uint64_t(compressed_data_length) + (uint64_t(uncompressed_data_length) << 32)) * Utilities::PHI64};
+    const auto mix{[&digest](const uint8_t* data, size_t size) noexcept {
+      for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t), data += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        digest = (digest ^ word) * UINT64_C(0xFF51AFD7ED558CCD);
+        digest ^= digest >> 32;
+      }
+      for (; size > 0; --size) {
+        digest = (digest ^ *data++) * Utilities::PHI64;
+      }
+    }};
+
+    std::vector<uint8_t> block(BLOCK_SIZE);
+    if ((safe_pos >= BZ2_filter::BZ2_HEADER) && (BZ2_filter::BZ2_HEADER == stream.ReadAt(block.data(), BZ2_filter::BZ2_HEADER, safe_pos - BZ2_filter::BZ2_HEADER)) &&  //
+        (0 == memcmp(block.data(), "BZh", 3))) {
+      mix(block.data(), BZ2_filter::BZ2_HEADER);  // BZip2 decodes from the header on, without it the header is of no influence
+    }
+    for (int64_t i{0}; i < compressed_data_length; i += BLOCK_SIZE) {
+      const auto size{size_t((std::min)(compressed_data_length - i, int64_t(BLOCK_SIZE)))};
+      if (size != stream.ReadAt(block.data(), size, safe_pos + i)) {
+        return {false, {}};
+      }
+      if (0 == i) {
+        memcpy(&head, block.data(), (std::min)(size, sizeof(head)));
+      }
+      mix(block.data(), size);
+    }
+    return {true, {digest ^ (digest >> 29), compressed_data_length, head}};
+  }
+};  // namespace
+
+auto DecodeEncodeCompare(File_t& stream,                          //
+                         iEncoder_t* const coder,                 //
+                         Recompressions_t* const recompressions,  //
+                         const int64_t safe_pos,                  //
+                         const int64_t compressed_data_length,    //
                          const uint32_t uncompressed_data_length) noexcept -> int64_t {
-  if (compressed_data_length > 0) {
+  const Profile::Scope_t scope{Profile::Phase::Recompress};
+  const auto [cached, key]{(nullptr != recompressions) ? StreamKey(stream, safe_pos, compressed_data_length, uncompressed_data_length) : std::tuple<bool, Key_t>{false, {}}};
+  // A found GZip or ZLib outcome is still verified by its compare run below, a collision would only cost ratio.
+  // A found Unrecoverable is trusted without any trial, a collision would silently skip a stream that could be
+  // recompressed, therefore a 64-bit digest alone is not enough: the length and first bytes must match as well.
+  const auto outcome{cached ? recompressions->Find(key) : Outcome_t{}};  // Of an identical stream seen before, if any
+  if (IsPreScan() && (!cached || (Method_t::Unknown != outcome.method))) {
+    stream.Seek(safe_pos);
+    return 0;  // Nothing to hand over to the encoder
+  }
+  const auto remember{[&](const Outcome_t& result) noexcept {
+    if (cached && (Method_t::Unknown == outcome.method)) {
+      recompressions->Remember(key, result);
+    }
+  }};
+
+  if ((compressed_data_length > 0) && (compressed_data_length <= INT64_C(0xFFFFFFFF)) && (Method_t::Unrecoverable != outcome.method)) {  // Lengths are coded in 32 bits
     stream.Seek(safe_pos);
     File_t inflate_tmp /*("_inflate_tmp_.bin", "wb+")*/;
     auto length{uint32_t(compressed_data_length)};
@@ -577,7 +894,7 @@ auto DecodeEncodeCompare(File_t& stream,                        //
        \______  /_______ \|__|   __/
               \/        \/   |__|
 #endif
-    {
+    if ((Method_t::Unknown == outcome.method) || (Method_t::GZip == outcome.method)) {
       if (GZip_OK == gzip::Unzip(stream, inflate_tmp, length)) {  // Try to decode using GZIP
         inflate_tmp.Rewind();
         stream.Seek(safe_pos);
@@ -585,8 +902,9 @@ auto DecodeEncodeCompare(File_t& stream,                        //
         if ((0 != uncompressed_data_length) && (decoded_length != uncompressed_data_length)) {
           decoded_length = uncompressed_data_length;
         }
-        const auto [zheader, encoded_length, clevel]{GZipEncodeCompare(inflate_tmp, decoded_length, stream)};
+        const auto [zheader, encoded_length, clevel]{GZipEncodeCompare(inflate_tmp, decoded_length, stream, outcome.clevel)};
         if (nullptr != zheader) {
+          remember({Method_t::GZip, 0, static_cast<int8_t>(clevel), 0, 0});
           if (nullptr != coder) {
             zheader->Encode(*coder, decoded_length);
             inflate_tmp.Rewind();
@@ -608,7 +926,7 @@ auto DecodeEncodeCompare(File_t& stream,                        //
       /_______ \|_______ \__||___  /
               \/        \/       \/
 #endif
-    {
+    if ((Method_t::Unknown == outcome.method) || (Method_t::ZLib == outcome.method)) {
       const auto zlib{std::make_unique<ZLib_t>()};
 
       struct Table_t final {
@@ -618,7 +936,19 @@ auto DecodeEncodeCompare(File_t& stream,                        //
 
       constexpr std::array<const Table_t, 3> table{{{MAX_WBITS, Z_FINISH}, {-MAX_WBITS, Z_FINISH}, {0, Z_NO_FLUSH}}};
 
-      for (const auto& elem : table) {
+      for (uint8_t t{0}; t < table.size(); ++t) {
+        const auto& elem{table[t]};
+        if (Method_t::ZLib == outcome.method) {
+          if (outcome.table != t) {
+            continue;
+          }
+          zlib->Select(outcome.windowBits, outcome.clevel, outcome.memLevel);
+        } else {
+          stream.Seek(safe_pos);
+          if (!zlib->Probe(stream, uint32_t(compressed_data_length), elem.windowBits, elem.flush) || !zlib->NextCandidate(stream, safe_pos, true)) {
+            continue;  // Already the start of the stream can not be reproduced, do not inflate it all
+          }
+        }
         inflate_tmp.Rewind();
         stream.Seek(safe_pos);
         const auto [decode_succes, decoded_length]{zlib->Inflate(stream, uint32_t(compressed_data_length), inflate_tmp, elem.windowBits, elem.flush)};  // Try to decode using ZLIB
@@ -627,6 +957,8 @@ auto DecodeEncodeCompare(File_t& stream,                        //
           stream.Seek(safe_pos);
           const auto [encode_succes, encoded_length]{zlib->EncodeCompare(inflate_tmp, decoded_length, stream)};
           if (encode_succes) {
+            const auto& config{zlib->Config()};
+            remember({Method_t::ZLib, t, config.clevel, config.windowBits, config.memLevel});
             if (nullptr != coder) {
               zlib->HeaderEncode(*coder, decoded_length);
               inflate_tmp.Rewind();
@@ -648,7 +980,7 @@ auto DecodeEncodeCompare(File_t& stream,                        //
        |______  /_______ \|__|   __/\_______ \
               \/        \/   |__|           \/
 #endif
-    if (safe_pos >= BZ2_filter::BZ2_HEADER) {
+    if ((safe_pos >= BZ2_filter::BZ2_HEADER) && ((Method_t::Unknown == outcome.method) || (Method_t::BZip2 == outcome.method))) {
       const auto bzip{std::make_unique<BZip2_t>()};
       inflate_tmp.Rewind();
       stream.Seek(safe_pos - BZ2_filter::BZ2_HEADER);
@@ -658,6 +990,7 @@ auto DecodeEncodeCompare(File_t& stream,                        //
         stream.Seek(safe_pos - BZ2_filter::BZ2_HEADER);
         const auto [encode_succes, encoded_length]{bzip->EncodeCompare(inflate_tmp, decoded_length, stream, true)};
         if (encode_succes) {
+          remember({Method_t::BZip2, 0, 0, 0, 0});
           if (nullptr != coder) {
             bzip->HeaderEncode(*coder, decoded_length);
             inflate_tmp.Rewind();
@@ -673,6 +1006,7 @@ auto DecodeEncodeCompare(File_t& stream,                        //
 #if 0
     fprintf(stderr, "Failure in <%s> at %" PRIu64 ", length %" PRIu64 "\n", GetInFileName(), safe_pos, compressed_data_length);
 #endif
+    remember({Method_t::Unrecoverable, 0, 0, 0, 0});
   }
 
   if (nullptr != coder) {
@@ -18,11 +18,105 @@
  */
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <mutex>
+#include "ska/ska.h"
 
 class File_t;
 class iEncoder_t;
 
+/**
+ * @class Recompressions_t
+ * @brief Outcomes of DecodeEncodeCompare() in one run, keyed by the digest, length and first bytes of the embedded stream
+ *
+ * Owned by the run (EncodeFile, EncodeBlocks or EncodeStream), shared by its filters and its PreScan_t.
+ * At most MAX_OUTCOMES streams are kept, further streams are recompressed without being remembered.
+ */
+class Recompressions_t final {
+public:
+  /**
+   * @enum Method_t
+   * @brief Way an embedded stream is reproduced
+   */
+  enum class Method_t : uint8_t {
+    Unknown,        // Not seen before, try all
+    Unrecoverable,  // Seen before, no method reproduced it
+    GZip,
+    ZLib,
+    BZip2
+  };
+
+  /**
+   * @struct Outcome_t
+   * @brief Result of DecodeEncodeCompare() on an embedded stream
+   */
+  struct Outcome_t final {
+    Method_t method{Method_t::Unknown};
+    uint8_t table{0};      // Entry of the ZLib table
+    int8_t clevel{0};      // Compression level for GZip and ZLib
+    int8_t windowBits{0};  // ZLib only
+    uint8_t memLevel{0};   // ZLib only
+  };
+
+  /**
+   * @struct Key_t
+   * @brief Identifies an embedded stream, the digest selects the entry, length and head confirm it
+   */
+  struct Key_t final {
+    uint64_t digest{0};  // Of the whole stream
+    int64_t length{0};   // Of the stream
+    uint64_t head{0};    // First bytes of the stream
+  };
+
+  Recompressions_t() noexcept = default;
+  ~Recompressions_t() noexcept = default;
+
+  Recompressions_t(const Recompressions_t&) = delete;
+  Recompressions_t(Recompressions_t&&) = delete;
+  auto operator=(const Recompressions_t&) -> Recompressions_t& = delete;
+  auto operator=(Recompressions_t&&) -> Recompressions_t& = delete;
+
+  /**
+   * @param key Key of the embedded stream
+   * @return Outcome of an identical stream seen before, Method_t::Unknown when not seen
+   */
+  [[nodiscard]] auto Find(const Key_t& key) noexcept -> Outcome_t {
+    const std::lock_guard<std::mutex> lock{_mutex};
+    const auto it{_outcomes.find(key.digest)};
+    if ((_outcomes.end() == it) || (it->second.length != key.length) || (it->second.head != key.head)) {
+      return Outcome_t{};  // Not seen, or another stream with the same digest
+    }
+    return it->second.outcome;
+  }
+
+  void Remember(const Key_t& key, const Outcome_t& outcome) noexcept {
+    const std::lock_guard<std::mutex> lock{_mutex};
+    if (_outcomes.size() < MAX_OUTCOMES) {
+      _outcomes.emplace(key.digest, Entry_t{key.length, key.head, outcome});
+    }
+  }
+
+private:
+  static constexpr size_t MAX_OUTCOMES{size_t(1) << 16};  // About 3 MiB
+
+  struct Entry_t final {
+    int64_t length;
+    uint64_t head;
+    Outcome_t outcome;
+  };
+
+#if defined(USE_BYTELL_HASH_MAP)
+  using map_digest2outcome_t = ska::bytell_hash_map<uint64_t, Entry_t>;
+#else
+  using map_digest2outcome_t = std::unordered_map<uint64_t, Entry_t>;
+#endif
+
+  map_digest2outcome_t _outcomes{};
+  std::mutex _mutex{};  // Streams are also recompressed ahead of the encoder (see PreScan_t) and by the block threads
+};
+
 auto EncodeGZip(File_t& in, const int64_t size, File_t& out) noexcept -> bool;
 
-auto DecodeEncodeCompare(File_t& stream, iEncoder_t* const coder, const int64_t safe_pos, const int64_t compressed_data_length, const uint32_t uncompressed_data_length) noexcept -> int64_t;
+auto DecodeEncodeCompare(File_t& stream, iEncoder_t* const coder, Recompressions_t* const recompressions, const int64_t safe_pos, const int64_t compressed_data_length,
+                         const uint32_t uncompressed_data_length) noexcept -> int64_t;
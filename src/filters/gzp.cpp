@@ -21,7 +21,6 @@
 #include "gzp.h"
 #include <cassert>
 #include <cinttypes>
-#include <climits>
 #include <cstdint>
 #include "Buffer.h"
 #include "File.h"
@@ -121,7 +120,7 @@ auto Header_t::ScanGZP(int32_t /*ch*/) noexcept -> Filter {
     if ((0 == cm) || (2 == cm) || (4 == cm)) {
       _di.flags = _buf(offset - 3);
       _di.offset_to_start = 0;   // start now!
-      _di.filter_end = INT_MAX;  // end never..
+      _di.filter_end = FILTER_END_NEVER;  // end never..
       return Filter::GZP;
     }
   }
@@ -129,10 +128,11 @@ auto Header_t::ScanGZP(int32_t /*ch*/) noexcept -> Filter {
   return Filter::NOFILTER;
 }
 
-GZP_filter::GZP_filter(File_t& stream, iEncoder_t* const coder, DataInfo_t& di, const int64_t original_length) noexcept
+GZP_filter::GZP_filter(File_t& stream, iEncoder_t* const coder, Recompressions_t* const recompressions, DataInfo_t& di, const int64_t original_length) noexcept
     : _original_length{original_length},  //
       _stream{stream},
       _coder{coder},
+      _recompressions{recompressions},
       _di{di} {}
 
 GZP_filter::~GZP_filter() noexcept = default;
@@ -188,7 +188,7 @@ auto GZP_filter::Handle(int32_t ch) noexcept -> bool {  // encoding
       Progress_t::Cancelled(Filter::GZP);
     }
     _coder->Compress(ch);  // Encode last character
-    DecodeEncodeCompare(_stream, _coder, safe_pos, _original_length, 0);
+    DecodeEncodeCompare(_stream, _coder, _recompressions, safe_pos, _original_length, 0);
     _di.pkziplen = 0;
     _di.filter_end = 0;
     return true;
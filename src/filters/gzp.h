@@ -24,6 +24,7 @@
 #include "filter.h"
 class File_t;
 class iEncoder_t;
+class Recompressions_t;
 
 /**
  * @class GZP_filter
@@ -33,7 +34,7 @@ class iEncoder_t;
  */
 class GZP_filter final : public iFilter_t {
 public:
-  explicit GZP_filter(File_t& stream, iEncoder_t* const coder, DataInfo_t& di, const int64_t original_length) noexcept;
+  explicit GZP_filter(File_t& stream, iEncoder_t* const coder, Recompressions_t* const recompressions, DataInfo_t& di, const int64_t original_length) noexcept;
   virtual ~GZP_filter() noexcept override;
 
   GZP_filter() = delete;
@@ -51,6 +52,7 @@ private:
   const int64_t _original_length;
   File_t& _stream;
   iEncoder_t* const _coder;
+  Recompressions_t* const _recompressions;  // Of the run, nullptr when decoding
   DataInfo_t& _di;
   int32_t _block_length{0};
   uint32_t _extra_field_length{0};
@@ -85,7 +85,7 @@ auto Header_t::ScanPBM(int32_t /*ch*/) noexcept -> Filter {
         if (P4 == sig) {
           _di.bytes_per_pixel = 1;
           _di.offset_to_start = 0;  // start now!
-          _di.filter_end = static_cast<int32_t>((width * height) / 8);
+          _di.filter_end = static_cast<int64_t>((static_cast<uint64_t>(width) * height) / 8);
           return Filter::PBM;
         }
 
@@ -105,7 +105,7 @@ auto Header_t::ScanPBM(int32_t /*ch*/) noexcept -> Filter {
             _di.bytes_per_pixel = 3;
             _di.offset_to_start = static_cast<int32_t>((idx + 1) % _di.bytes_per_pixel);  // Sync with RGB
           }
-          _di.filter_end = static_cast<int32_t>(width * height * _di.bytes_per_pixel);
+          _di.filter_end = static_cast<int64_t>(static_cast<uint64_t>(width) * height * _di.bytes_per_pixel);
           return Filter::PBM;
         }
       }
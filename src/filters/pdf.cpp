@@ -20,7 +20,6 @@
  */
 #include "pdf.h"
 #include <cassert>
-#include <climits>
 #include <cstdint>
 #include <cstdio>
 #include "File.h"
@@ -78,16 +77,17 @@ auto Header_t::ScanPDF(int32_t ch) noexcept -> Filter {
       (endstream0A != (endstream0A_mask & _di.tag)) && (endstream0D0A != (endstream0D0A_mask & _di.tag))) {
     _di.tag = 0;
     _di.offset_to_start = 0;   // start now!
-    _di.filter_end = INT_MAX;  // end never..
+    _di.filter_end = FILTER_END_NEVER;  // end never..
     return Filter::PDF;
   }
 
   return Filter::NOFILTER;
 }
 
-PDF_filter::PDF_filter(File_t& stream, iEncoder_t* const coder, DataInfo_t& di) noexcept
+PDF_filter::PDF_filter(File_t& stream, iEncoder_t* const coder, Recompressions_t* const recompressions, DataInfo_t& di) noexcept
     : _stream{stream},  //
       _coder{coder},
+      _recompressions{recompressions},
       _di{di} {}
 
 PDF_filter::~PDF_filter() noexcept = default;
@@ -123,7 +123,7 @@ auto PDF_filter::Handle(int32_t ch) noexcept -> bool {  // encoding
     Progress_t::Cancelled(Filter::PDF);
   }
   _coder->Compress(ch);  // Encode last character
-  DecodeEncodeCompare(_stream, _coder, safe_pos, compressed_data_length, 0);
+  DecodeEncodeCompare(_stream, _coder, _recompressions, safe_pos, compressed_data_length, 0);
   return true;
 }
 
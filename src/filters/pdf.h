@@ -24,6 +24,7 @@
 #include "filter.h"
 class File_t;
 class iEncoder_t;
+class Recompressions_t;
 
 /**
  * @class PDF_filter
@@ -33,7 +34,7 @@ class iEncoder_t;
  */
 class PDF_filter final : public iFilter_t {
 public:
-  explicit PDF_filter(File_t& stream, iEncoder_t* const coder, DataInfo_t& di) noexcept;
+  explicit PDF_filter(File_t& stream, iEncoder_t* const coder, Recompressions_t* const recompressions, DataInfo_t& di) noexcept;
   virtual ~PDF_filter() noexcept override;
 
   PDF_filter() = delete;
@@ -48,6 +49,7 @@ public:
 private:
   File_t& _stream;
   iEncoder_t* const _coder;
+  Recompressions_t* const _recompressions;  // Of the run, nullptr when decoding
   DataInfo_t& _di;
   int32_t _block_length{0};
   uint32_t _length{0};
@@ -20,7 +20,6 @@
  */
 #include "pkz.h"
 #include <cassert>
-#include <climits>
 #include <cstdint>
 #include "Buffer.h"
 #include "File.h"
@@ -102,15 +101,15 @@ auto Header_t::ScanPKZ(int32_t /*ch*/) noexcept -> Filter {
     const int32_t nlen{_buf.i2(offset - 26) + _buf.i2(offset - 28)};
     if ((nlen > 0) && (nlen < 256)) {
       _di.pkzippos = _buf.Pos() + static_cast<uint32_t>(nlen) - (_encode ? 3 : 2);
-      _di.pkziplen = static_cast<int32_t>(_buf.i4(offset - 18));
-      const int32_t usize{static_cast<int32_t>(_buf.i4(offset - 22))};
+      _di.pkziplen = static_cast<int64_t>(_buf.i4(offset - 18));
+      const auto usize{static_cast<int64_t>(_buf.i4(offset - 22))};
       if ((usize > 0) && (_di.pkziplen > 0) && (usize < _di.pkziplen)) {  // Normally compressed size is less then uncompressed size
         _di.pkzippos = 0;
         _di.pkziplen = 0;
         _di.filter_end = 0;
       } else {
         _di.offset_to_start = 0;   // start now!
-        _di.filter_end = INT_MAX;  // end never..
+        _di.filter_end = FILTER_END_NEVER;  // end never..
         return Filter::PKZ;
       }
     }
@@ -118,10 +117,11 @@ auto Header_t::ScanPKZ(int32_t /*ch*/) noexcept -> Filter {
   return Filter::NOFILTER;
 }
 
-PKZ_filter::PKZ_filter(File_t& stream, iEncoder_t* const coder, DataInfo_t& di, const Buffer_t& __restrict buf) noexcept
+PKZ_filter::PKZ_filter(File_t& stream, iEncoder_t* const coder, Recompressions_t* const recompressions, DataInfo_t& di, const Buffer_t& __restrict buf) noexcept
     : _buf{buf},  //
       _stream{stream},
       _coder{coder},
+      _recompressions{recompressions},
       _di{di} {}
 
 PKZ_filter::~PKZ_filter() noexcept = default;
@@ -133,7 +133,7 @@ auto PKZ_filter::Handle(int32_t ch) noexcept -> bool {  // encoding
       Progress_t::Cancelled(Filter::PKZ);
     }
     _coder->Compress(ch);  // Encode last character
-    DecodeEncodeCompare(_stream, _coder, safe_pos, _di.pkziplen, 0);
+    DecodeEncodeCompare(_stream, _coder, _recompressions, safe_pos, _di.pkziplen, 0);
     _di.pkzippos = 0;
     _di.pkziplen = 0;
     _di.filter_end = 0;
@@ -25,6 +25,7 @@
 class Buffer_t;
 class File_t;
 class iEncoder_t;
+class Recompressions_t;
 
 /**
  * @class PKZ_filter
@@ -34,7 +35,7 @@ class iEncoder_t;
  */
 class PKZ_filter final : public iFilter_t {
 public:
-  explicit PKZ_filter(File_t& stream, iEncoder_t* const coder, DataInfo_t& di, const Buffer_t& __restrict buf) noexcept;
+  explicit PKZ_filter(File_t& stream, iEncoder_t* const coder, Recompressions_t* const recompressions, DataInfo_t& di, const Buffer_t& __restrict buf) noexcept;
   virtual ~PKZ_filter() noexcept override;
 
   PKZ_filter() = delete;
@@ -50,6 +51,7 @@ private:
   const Buffer_t& __restrict _buf;
   File_t& _stream;
   iEncoder_t* const _coder;
+  Recompressions_t* const _recompressions;  // Of the run, nullptr when decoding
   DataInfo_t& _di;
   int32_t _block_length{0};
   uint32_t _length{0};
@@ -20,7 +20,6 @@
  */
 #include "png.h"
 #include <cassert>
-#include <climits>
 #include <cstdint>
 #include "Buffer.h"
 #include "File.h"
@@ -80,24 +79,25 @@ auto Header_t::ScanPNG(int32_t /*ch*/) noexcept -> Filter {
 
   if ((UINT64_C(0x89504E470D0A1A0A) == _buf.m8(offset - 0)) && (0x0D == _buf.m4(offset - 8) && ('IHDR' == _buf.m4(offset - 12)))) {
     _di.offset_to_start = 0;   // start now!
-    _di.filter_end = INT_MAX;  // end never..
+    _di.filter_end = FILTER_END_NEVER;  // end never..
     return Filter::PNG;
   }
 
   return Filter::NOFILTER;
 }
 
-PNG_filter::PNG_filter(File_t& stream, iEncoder_t* const coder, DataInfo_t& di, const Buffer_t& __restrict buf) noexcept
+PNG_filter::PNG_filter(File_t& stream, iEncoder_t* const coder, Recompressions_t* const recompressions, DataInfo_t& di, const Buffer_t& __restrict buf) noexcept
     : _buf{buf},  //
       _stream{stream},
       _coder{coder},
+      _recompressions{recompressions},
       _di{di} {}
 
 PNG_filter::~PNG_filter() noexcept = default;
 
 auto PNG_filter::Handle(int32_t ch) noexcept -> bool {  // encoding
   if ('IDAT' == _buf.m4(4)) {
-    const uint32_t lpos{_buf.Pos() - 4};
+    const auto lpos{_buf.Pos() - 4};
     const int32_t length{_buf[lpos - 1] | (_buf[lpos - 2] << 8) | (_buf[lpos - 3] << 16) | (_buf[lpos - 4] << 24)};
     _di.pkzippos = 0;
     _di.pkziplen = length;
@@ -105,7 +105,7 @@ auto PNG_filter::Handle(int32_t ch) noexcept -> bool {  // encoding
 
   if (_di.pkziplen > 0) {
     const int64_t safe_pos{_stream.Position()};
-    DecodeEncodeCompare(_stream, _coder, safe_pos - 1, _di.pkziplen, 0);
+    DecodeEncodeCompare(_stream, _coder, _recompressions, safe_pos - 1, _di.pkziplen, 0);
     _di.pkziplen = 0;
     return true;
   }
@@ -150,7 +150,7 @@ auto PNG_filter::Handle(int32_t ch, int64_t& pos) noexcept -> bool {  // decodin
   }
 
   if ('IDAT' == _buf.m4(4)) {
-    const uint32_t lpos{_buf.Pos() - 4};
+    const auto lpos{_buf.Pos() - 4};
     const int32_t length{_buf[lpos - 1] | (_buf[lpos - 2] << 8) | (_buf[lpos - 3] << 16) | (_buf[lpos - 4] << 24)};
     if (length > 0) {
       _stream.putc(ch);
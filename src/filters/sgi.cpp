@@ -19,7 +19,6 @@
  * https://github.com/the-m-master/Moruga
  */
 #include "sgi.h"
-#include <climits>
 #include <cstdint>
 #include <cstdlib>
 #include "Buffer.h"
@@ -72,7 +71,7 @@ auto Header_t::ScanSGI(int32_t /*ch*/) noexcept -> Filter {
       _di.image_width = xsize;
       _di.image_height = ysize;
       _di.bytes_per_pixel = zsize;
-      _di.filter_end = INT_MAX;
+      _di.filter_end = FILTER_END_NEVER;
       _di.offset_to_start = static_cast<int32_t>(_di.image_height * _di.bytes_per_pixel * sizeof(uint32_t) * 2);  // Skip row start/size
 
 #if 0
@@ -308,7 +308,7 @@ namespace {
         (/*(0 == rgb) || (1 == rgb) ||*/ (2 == rgb)) &&  //  0/1=grey, 2=rgb
         (/*(1 == _di.bytes_per_pixel) ||*/ (3 == _di.bytes_per_pixel) || (4 == _di.bytes_per_pixel))) {
       /*_di.lzw_encoded = 5 == cmp;*/
-      _di.filter_end = static_cast<int32_t>(width * height * _di.bytes_per_pixel);
+      _di.filter_end = static_cast<int64_t>(static_cast<uint64_t>(width) * height * _di.bytes_per_pixel);
       ots -= static_cast<int32_t>(offset);
       _di.offset_to_start = (ots < 0) ? 0 : ots;
 #if 0
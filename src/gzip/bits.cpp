@@ -24,25 +24,15 @@
  * Area for GZIP handling
  */
 namespace gzip {
-  namespace {
-    uint16_t bi_buf{0};
-    /* Output buffer. bits are inserted starting at the bottom (least significant bits). */
-
 #define Buf_size (8 * 2)
-    /* Number of bits used within bi_buf. (bi_buf might be implemented on
-     * more than 16 bits on some systems.)
-     */
-
-    uint32_t bi_valid{0};
-    /* Number of valid bits in bi_buf.  All bits above the last valid bit
-     * are always zero.
-     */
-  };  // namespace
+  /* Number of bits used within bi_buf. (bi_buf might be implemented on
+   * more than 16 bits on some systems.)
+   */
 
   /* ===========================================================================
    * Initialise the bit string routines.
    */
-  void BitsInit() noexcept {
+  void Context_t::BitsInit() noexcept {
     bi_buf = 0;
     bi_valid = 0;
   }
@@ -51,7 +41,7 @@ namespace gzip {
    * Send a value on a given number of bits.
    * IN assertion: length <= 16 and value fits in length bits.
    */
-  void SendBits(const uint32_t value, const uint32_t length) noexcept {
+  void Context_t::SendBits(const uint32_t value, const uint32_t length) noexcept {
     /* If not enough room in bi_buf, use (valid) bits from bi_buf and
      * (16 - bi_valid) bits from value, leaving (width - (16-bi_valid))
      * unused bits in value.
@@ -85,7 +75,7 @@ namespace gzip {
   /* ===========================================================================
    * Write out any remaining bits in an incomplete byte.
    */
-  void BitsWindup() noexcept {
+  void Context_t::BitsWindup() noexcept {
     if (bi_valid > 8) {
       PutShort(bi_buf);
     } else if (bi_valid > 0) {
@@ -99,7 +89,7 @@ namespace gzip {
    * Copy a stored block to the zip file, storing first the length and its
    * one's complement if requested.
    */
-  void CopyBlock(char* buf, uint32_t len, int32_t header) noexcept {
+  void Context_t::CopyBlock(char* buf, uint32_t len, int32_t header) noexcept {
     BitsWindup(); /* align on byte boundary */
 
     if (header) {
@@ -78,67 +78,268 @@ typedef uint32_t (*write_buffer_t)(const void* buf, uint32_t cnt, void* ptr) noe
 #define BINARY 0
 #define ASCII 1
 
+#define MAX_BITS 15
+/* All codes must not exceed MAX_BITS bits */
+
+#define MAX_BL_BITS 7
+/* Bit length codes must not exceed MAX_BL_BITS bits */
+
+#define LENGTH_CODES 29
+/* number of length codes, not counting the special END_BLOCK code */
+
+#define LITERALS 256
+/* number of literal bytes 0..255 */
+
+#define L_CODES (LITERALS + 1 + LENGTH_CODES)
+/* number of Literal or Length codes, including the END_BLOCK code */
+
+#define D_CODES 30
+/* number of distance codes */
+
+#define BL_CODES 19
+/* number of codes used to transfer the bit lengths */
+
+#define HEAP_SIZE (2 * L_CODES + 1)
+/* maximum heap size */
+
+#define LIT_BUFSIZE 0x8000
+/* size of match buffer for literals/lengths, see tree.cpp */
+
 namespace gzip {
-  extern const uint8_t* imem;                        // Memory input
-  extern FILE* ifd;                                  // input file descriptor
-  extern FILE* ofd;                                  // output file descriptor
-  extern int32_t block_start;                        // window offset of current block
-  extern uint32_t level;                             // compression level
-  extern int32_t rsync;                              // deflate into rsyncable chunks
-  extern std::array<uint8_t, INBUFSIZ> inbuf;        // input buffer
-  extern std::array<uint8_t, OUTBUFSIZ> outbuf;      // output buffer
-  extern std::array<uint8_t, WSIZE + WSIZE> window;  // Sliding window and suffix table (unlzw)
-  extern uint32_t bytes_in;                          // number of input bytes
-  extern uint32_t bytes_out;                         // number of output bytes
-  extern uint32_t ifile_size;                        // input file size
-  extern uint32_t inptr;                             // index of next byte to be processed in inbuf
-  extern uint32_t insize;                            // valid bytes in inbuf
-  extern uint32_t outcnt;                            // bytes in output buffer
-  extern uint32_t strstart;                          // window offset of current string
-  extern void* this_pointer;                         // Optional helper pointer
-  extern write_buffer_t omem;                        // Write output data to memory
+  /* Data structure describing a single value and its code string. */
+  struct ct_data {
+    union {
+      uint16_t freq; /* frequency count */
+      uint16_t code; /* bit string */
+    } fc;
+    union {
+      uint16_t dad; /* father node in Huffman tree */
+      uint16_t len; /* length of bit string */
+    } dl;
+  };
+
+  /* extra bits for each length code */
+  constexpr std::array<uint32_t, LENGTH_CODES> extra_lbits{{0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0}};
+
+  /* extra bits for each distance code */
+  constexpr std::array<uint32_t, D_CODES> extra_dbits{{0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13}};
+
+  /* extra bits for each bit length code */
+  constexpr std::array<uint32_t, BL_CODES> extra_blbits{{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 3, 7}};
+
+  struct tree_desc {
+    ct_data* dyn_tree;           // the dynamic tree
+    ct_data* static_tree;        // corresponding static tree or nullptr
+    const uint32_t* extra_bits;  // extra bits for each code or nullptr
+    uint32_t extra_base;         // base index for extra_bits
+    uint32_t elems;              // max number of elements in the tree
+    uint32_t max_length;         // max bit length for the codes
+    uint32_t max_code;           // largest code with non zero frequency
+  };
+
+  struct huft;
 
   auto BitsReverse(uint32_t value, int32_t length) noexcept -> uint16_t;
-  auto CtTally(uint32_t dist, const uint32_t lc) noexcept -> int32_t;
-  auto Deflate(const uint32_t pack_level) noexcept -> uint32_t;
-  auto FileRead(void* buf, uint32_t size) noexcept -> int32_t;
-  auto fill_inbuf(int32_t eof_ok) noexcept -> int32_t;
-  auto FlushBlock(char* buf, uint32_t stored_len, int32_t pad, const uint32_t eof) noexcept -> uint32_t;
-  auto Inflate() noexcept -> uint32_t;
-  auto read_buffer(FILE* fd, void* buf, uint32_t cnt) noexcept -> uint32_t;
-  void BitsInit() noexcept;
-  void BitsWindup() noexcept;
-  void CopyBlock(char* buf, uint32_t len, int32_t header) noexcept;
-  void CtInit(uint16_t* attr) noexcept;
-  void flush_outbuf() noexcept;
-  void flush_window() noexcept;
-  void SendBits(const uint32_t value, const uint32_t length) noexcept;
-
-  inline static void PutByte(uint8_t c) noexcept {
-    outbuf[outcnt++] = c;
-    if (outcnt == OUTBUFSIZ) {
-      flush_outbuf();
+
+  /**
+   * @class Context_t
+   * @brief State of one deflate or inflate run
+   *
+   * State of one deflate or inflate run, so streams can be handled on several threads at once.
+   * A context can be used for any number of runs (one at a time), the buffers are reused.
+   * About 400 KiB, allocate it on the heap.
+   */
+  class Context_t final {
+  public:
+    Context_t() noexcept = default;
+    ~Context_t() noexcept = default;
+
+    Context_t(const Context_t&) = delete;
+    Context_t(Context_t&&) = delete;
+    auto operator=(const Context_t&) -> Context_t& = delete;
+    auto operator=(Context_t&&) -> Context_t& = delete;
+
+    auto Zip(FILE* const in, const uint32_t size, FILE* const out, const uint32_t clevel) noexcept -> uint32_t;
+    auto Zip(const uint8_t* const in, const uint32_t size, write_buffer_t out, void* const ptr, const uint32_t clevel) noexcept -> uint32_t;
+
+    auto Unzip(FILE* const in, FILE* const out, uint32_t& ilength) noexcept -> uint32_t;
+    auto Unzip(const uint8_t* const in, const uint32_t ilength, write_buffer_t out, void* const ptr) noexcept -> uint32_t;
+
+  private:
+    // Input and output (util.cpp)
+    std::array<uint8_t, INBUFSIZ> inbuf{};        // input buffer
+    std::array<uint8_t, OUTBUFSIZ> outbuf{};      // output buffer
+    std::array<uint8_t, WSIZE + WSIZE> window{};  // Sliding window and suffix table (unlzw)
+    const uint8_t* imem{nullptr};                 // Memory input
+    FILE* ifd{nullptr};                           // input file descriptor
+    FILE* ofd{nullptr};                           // output file descriptor
+    void* this_pointer{nullptr};                  // Optional helper pointer
+    write_buffer_t omem{nullptr};                 // Write output data to memory
+    uint32_t level{9};                            // compression level
+    int32_t rsync{0};                             // deflate into rsyncable chunks
+    uint32_t bytes_in{0};                         // number of input bytes
+    uint32_t bytes_out{0};                        // number of output bytes
+    uint32_t ifile_size{0};                       // input file size
+    uint32_t inptr{0};                            // index of next byte to be processed in inbuf
+    uint32_t insize{0};                           // valid bytes in inbuf
+    uint32_t outcnt{0};                           // bytes in output buffer
+    uint32_t past_end{0};                         // Zero bytes handed out after the end of the input
+    bool write_failed{false};                     // Output refused, Zip() ends the input early
+    int32_t : 8;                                  // Padding
+
+    // Bit output (bits.cpp)
+    uint16_t bi_buf{0};    // Output buffer. bits are inserted starting at the bottom (least significant bits).
+    uint32_t bi_valid{0};  // Number of valid bits in bi_buf. All bits above the last valid bit are always zero.
+
+    // Deflate (deflate.cpp)
+    std::array<uint16_t, 1u << BITS> prev{};  // prefix code, followed by the hash head
+    uint32_t window_size{WSIZE + WSIZE};      // window size, 2*WSIZE
+    uint32_t ins_h{0};                        // hash index of string to be inserted
+    uint32_t prev_length{0};                  // Length of the best match at previous step
+    uint32_t strstart{0};                     // start of string to insert
+    uint32_t match_start{0};                  // start of matching string
+    int32_t eofile{0};                        // flag set at end of input file
+    uint32_t lookahead{0};                    // number of valid bytes ahead in window
+    uint32_t max_chain_length{0};             // hash chains are never searched beyond this length
+    uint32_t max_lazy_match{0};               // lazy search only when the current match is smaller than this
+    uint32_t good_match{0};                   // Use a faster search when the previous match is longer than this
+    uint32_t nice_match{0};                   // Stop searching when current match exceeds this
+    uint32_t rsync_sum{0};                    // rolling sum of rsync window
+    uint32_t rsync_chunk_end{0};              // next rsync sequence point
+    int32_t block_start{0};                   // window position at the beginning of the current output block
+
+    // Huffman trees (tree.cpp)
+    std::array<ct_data, HEAP_SIZE> dyn_ltree{};          // literal and length tree
+    std::array<ct_data, 2 * D_CODES + 1> dyn_dtree{};    // distance tree
+    std::array<ct_data, L_CODES + 2> static_ltree{};     // The static literal tree
+    std::array<ct_data, D_CODES> static_dtree{};         // The static distance tree
+    std::array<ct_data, 2 * BL_CODES + 1> bl_tree{};     // Huffman tree for the bit lengths
+    std::array<uint16_t, MAX_BITS + 1> bl_count{};       // number of codes at each bit length for an optimal tree
+    std::array<uint32_t, 2 * L_CODES + 1> heap{};        // heap used to build the Huffman trees
+    std::array<uint8_t, 2 * L_CODES + 1> depth{};        // Depth of each subtree used as tie breaker for trees of equal frequency
+    std::array<uint8_t, MAX_MATCH - MIN_MATCH + 1> length_code{};  // length code for each normalised match length (0 == MIN_MATCH)
+    std::array<uint8_t, 512> dist_code{};                // distance codes, distances 3 .. 258 and the top 8 bits of the 15 bit distances
+    int32_t : 24;                                        // Padding
+    std::array<uint32_t, LENGTH_CODES> base_length{};    // First normalised length for each code (0 = MIN_MATCH)
+    std::array<uint32_t, D_CODES> base_dist{};           // First normalised distance for each code (0 = distance of 1)
+    std::array<uint16_t, DIST_BUFSIZE> d_buf{};          // buffer for distances
+    std::array<uint8_t, LIT_BUFSIZE / 8> flag_buf{};     // distinguishes literals from lengths in l_buf
+    int32_t : 32;                                        // Padding
+    tree_desc l_desc{.dyn_tree = dyn_ltree.data(),  //
+                     .static_tree = static_ltree.data(),
+                     .extra_bits = extra_lbits.data(),
+                     .extra_base = LITERALS + 1,
+                     .elems = L_CODES,
+                     .max_length = MAX_BITS,
+                     .max_code = 0};
+    tree_desc d_desc{.dyn_tree = dyn_dtree.data(),  //
+                     .static_tree = static_dtree.data(),
+                     .extra_bits = extra_dbits.data(),
+                     .extra_base = 0,
+                     .elems = D_CODES,
+                     .max_length = MAX_BITS,
+                     .max_code = 0};
+    tree_desc bl_desc{.dyn_tree = bl_tree.data(),  //
+                      .static_tree = nullptr,
+                      .extra_bits = extra_blbits.data(),
+                      .extra_base = 0,
+                      .elems = BL_CODES,
+                      .max_length = MAX_BL_BITS,
+                      .max_code = 0};
+    uint16_t* file_type{nullptr};                        // pointer to UNKNOWN, BINARY or ASCII
+    uint32_t heap_len{0};                                // number of elements in the heap
+    uint32_t heap_max{0};                                // element of largest frequency
+    uint32_t last_lit{0};                                // running index in l_buf
+    uint32_t last_dist{0};                               // running index in d_buf
+    uint32_t last_flags{0};                              // running index in flag_buf
+    uint32_t opt_len{0};                                 // bit length of current block with optimal trees
+    uint32_t static_len{0};                              // bit length of current block with static trees
+    uint32_t compressed_len{0};                          // total bit length of compressed file
+    uint8_t flags{0};                                    // current flags not yet saved in flag_buf
+    uint8_t flag_bit{0};                                 // current bit used in flags
+    int32_t : 16;                                        // Padding
+
+    // Inflate (inflate.cpp)
+    uint32_t bb{0};     // bit buffer
+    uint32_t bk{0};     // bits in bit buffer
+    uint32_t hufts{0};  // track memory usage
+
+    auto Zip_(const uint32_t size, const uint32_t clevel) noexcept -> uint32_t;
+
+    auto FileRead(void* buf, uint32_t size) noexcept -> int32_t;
+    auto fill_inbuf(int32_t eof_ok) noexcept -> int32_t;
+    auto read_buffer(FILE* fd, void* buf, uint32_t cnt) noexcept -> uint32_t;
+    auto write_buffer(FILE* fd, void* buf, uint32_t cnt) noexcept -> uint32_t;
+    void write_buf(FILE* fd, void* buf, uint32_t cnt) noexcept;
+    void flush_outbuf() noexcept;
+    void flush_window() noexcept;
+
+    void BitsInit() noexcept;
+    void BitsWindup() noexcept;
+    void CopyBlock(char* buf, uint32_t len, int32_t header) noexcept;
+    void SendBits(const uint32_t value, const uint32_t length) noexcept;
+
+    void FillWindow() noexcept;
+    void LongestMatchInit(uint32_t pack_level) noexcept;
+    auto LongestMatch(uint32_t cur_match) noexcept -> uint32_t;
+#ifndef NDEBUG
+    void CheckMatch(uint32_t start, uint32_t match, uint32_t length) noexcept;
+#endif
+    void RsyncRoll(uint32_t start, uint32_t num) noexcept;
+    auto DeflateFast() noexcept -> uint32_t;
+    auto Deflate(const uint32_t pack_level) noexcept -> uint32_t;
+
+    void InitBlock() noexcept;
+    void GenerateCodes(ct_data* tree, const uint32_t max_code) noexcept;
+    void CtInit(uint16_t* attr) noexcept;
+    void PqDownHeap(ct_data* tree, uint32_t k) noexcept;
+    void GenerateBitLengths(tree_desc* desc) noexcept;
+    void BuildTree(tree_desc* desc) noexcept;
+    void ScanTree(ct_data* tree, const uint32_t max_code) noexcept;
+    void SendTree(ct_data* tree, const uint32_t max_code) noexcept;
+    auto BuildBitLengthTree() noexcept -> uint32_t;
+    void SendAllTrees(uint32_t lcodes, uint32_t dcodes, uint32_t blcodes) noexcept;
+    void SetFileType() noexcept;
+    void CompressBlock(ct_data* ltree, ct_data* dtree) noexcept;
+    auto FlushBlock(char* buf, uint32_t stored_len, int32_t pad, const uint32_t eof) noexcept -> uint32_t;
+    auto CtTally(uint32_t dist, const uint32_t lc) noexcept -> int32_t;
+
+    auto HuftBuild(uint32_t* b, uint32_t n, uint32_t s, const uint16_t* d, const uint16_t* e, huft** t, uint32_t* m) noexcept -> uint32_t;
+    auto InflateCodes(huft* tl, huft* td, const uint32_t bl, const uint32_t bd) noexcept -> int32_t;
+    auto InflateStored() noexcept -> uint32_t;
+    auto InflateFixed() noexcept -> uint32_t;
+    auto InflateDynamic() noexcept -> uint32_t;
+    auto InflateBlock(int32_t* e) noexcept -> uint32_t;
+    auto Inflate() noexcept -> uint32_t;
+
+    void PutByte(uint8_t c) noexcept {
+      outbuf[outcnt++] = c;
+      if (outcnt == OUTBUFSIZ) {
+        flush_outbuf();
+      }
     }
-  }
-
-  /* Output a 16 bit value, lsb first */
-  inline static void PutShort(const uint16_t w) noexcept {
-    if (outcnt < OUTBUFSIZ - 2) {
-      outbuf[outcnt++] = static_cast<uint8_t>(w);
-      outbuf[outcnt++] = static_cast<uint8_t>(w >> 8);
-    } else {
-      PutByte(static_cast<uint8_t>(w));
-      PutByte(static_cast<uint8_t>(w >> 8));
+
+    /* Output a 16 bit value, lsb first */
+    void PutShort(const uint16_t w) noexcept {
+      if (outcnt < OUTBUFSIZ - 2) {
+        outbuf[outcnt++] = static_cast<uint8_t>(w);
+        outbuf[outcnt++] = static_cast<uint8_t>(w >> 8);
+      } else {
+        PutByte(static_cast<uint8_t>(w));
+        PutByte(static_cast<uint8_t>(w >> 8));
+      }
     }
-  }
 
-  /* Output a 32 bit value to the bit stream, lsb first */
-  inline static void PutLong(const uint32_t n) noexcept {
-    PutShort(static_cast<uint16_t>(n));
-    PutShort(static_cast<uint16_t>(n >> 16));
-  }
+    /* Output a 32 bit value to the bit stream, lsb first */
+    void PutLong(const uint32_t n) noexcept {
+      PutShort(static_cast<uint16_t>(n));
+      PutShort(static_cast<uint16_t>(n >> 16));
+    }
+  };
 
+  // One-off runs on a context of their own
   auto Zip(FILE* const in, const uint32_t size, FILE* const out, const uint32_t level) noexcept -> uint32_t;
+  auto Zip(const uint8_t* const in, const uint32_t size, write_buffer_t out, void* const ptr, const uint32_t level) noexcept -> uint32_t;
 
   auto Unzip(FILE* const in, FILE* const out, uint32_t& ilength) noexcept -> uint32_t;
   auto Unzip(const uint8_t* const in, const uint32_t ilength, write_buffer_t out, void* const ptr) noexcept -> uint32_t;
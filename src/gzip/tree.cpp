@@ -21,50 +21,15 @@
 #include "gzip.h"
 
 namespace gzip {
-  namespace {
-#define MAX_BITS 15
-    /* All codes must not exceed MAX_BITS bits */
-
-#define MAX_BL_BITS 7
-    /* Bit length codes must not exceed MAX_BL_BITS bits */
-
-#define LENGTH_CODES 29
-    /* number of length codes, not counting the special END_BLOCK code */
-
-#define LITERALS 256
-    /* number of literal bytes 0..255 */
-
 #define END_BLOCK 256
-    /* end of block literal code */
-
-#define L_CODES (LITERALS + 1 + LENGTH_CODES)
-    /* number of Literal or Length codes, including the END_BLOCK code */
-
-#define D_CODES 30
-    /* number of distance codes */
-
-#define BL_CODES 19
-    /* number of codes used to transfer the bit lengths */
-
-    /* extra bits for each length code */
-    constexpr std::array<uint32_t, LENGTH_CODES> extra_lbits{{0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0}};
-
-    /* extra bits for each distance code */
-    constexpr std::array<uint32_t, D_CODES> extra_dbits{{0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13}};
-
-    /* extra bits for each bit length code */
-    constexpr std::array<uint32_t, BL_CODES> extra_blbits{{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 3, 7}};
+  /* end of block literal code */
 
 #define STORED_BLOCK 0
 #define STATIC_TREES 1
 #define DYN_TREES 2
-    /* The three kinds of block type */
+  /* The three kinds of block type */
 
-#define LIT_BUFSIZE 0x8000
-#ifndef DIST_BUFSIZE
-#  define DIST_BUFSIZE LIT_BUFSIZE
-#endif
-/* Sizes of match buffers for literals/lengths and distances.  There are
+/* Sizes of match buffers for literals/lengths and distances (see gzip.h).  There are
  * 4 reasons for limiting LIT_BUFSIZE to 64K:
  *   - frequencies can be kept in 16 bit counters
  *   - if compression is not successful for the first block, all input data is
@@ -89,225 +54,101 @@ namespace gzip {
 #endif
 
 #define REP_3_6 16
-    /* repeat previous bit length 3-6 times (2 bits of repeat count) */
+  /* repeat previous bit length 3-6 times (2 bits of repeat count) */
 
 #define REPZ_3_10 17
-    /* repeat a zero length 3-10 times  (3 bits of repeat count) */
+  /* repeat a zero length 3-10 times  (3 bits of repeat count) */
 
 #define REPZ_11_138 18
-    /* repeat a zero length 11-138 times  (7 bits of repeat count) */
-
-    /* ===========================================================================
-     * Local data
-     */
-
-    /* Data structure describing a single value and its code string. */
-    struct ct_data {
-      union {
-        uint16_t freq; /* frequency count */
-        uint16_t code; /* bit string */
-      } fc;
-      union {
-        uint16_t dad; /* father node in Huffman tree */
-        uint16_t len; /* length of bit string */
-      } dl;
-    };
-
-#define HEAP_SIZE (2 * L_CODES + 1)
-    /* maximum heap size */
-
-    std::array<ct_data, HEAP_SIZE> dyn_ltree;       /* literal and length tree */
-    std::array<ct_data, 2 * D_CODES + 1> dyn_dtree; /* distance tree */
-
-    std::array<ct_data, L_CODES + 2> static_ltree;
-    /* The static literal tree. Since the bit lengths are imposed, there is no
-     * need for the L_CODES extra codes used during heap construction. However
-     * The codes 286 and 287 are needed to build a canonical tree (see ct_init
-     * below).
-     */
-
-    std::array<ct_data, D_CODES> static_dtree;
-    /* The static distance tree. (Actually a trivial tree since all codes use
-     * 5 bits.)
-     */
-
-    std::array<ct_data, 2 * BL_CODES + 1> bl_tree;
-    /* Huffman tree for the bit lengths */
-
-    struct tree_desc {
-      ct_data* dyn_tree;           // the dynamic tree
-      ct_data* static_tree;        // corresponding static tree or nullptr
-      const uint32_t* extra_bits;  // extra bits for each code or nullptr
-      uint32_t extra_base;         // base index for extra_bits
-      uint32_t elems;              // max number of elements in the tree
-      uint32_t max_length;         // max bit length for the codes
-      uint32_t max_code;           // largest code with non zero frequency
-    };
-
-    tree_desc l_desc = {.dyn_tree = dyn_ltree.data(),  //
-                        .static_tree = static_ltree.data(),
-                        .extra_bits = extra_lbits.data(),
-                        .extra_base = LITERALS + 1,
-                        .elems = L_CODES,
-                        .max_length = MAX_BITS,
-                        .max_code = 0};
-
-    tree_desc d_desc = {.dyn_tree = dyn_dtree.data(),  //
-                        .static_tree = static_dtree.data(),
-                        .extra_bits = extra_dbits.data(),
-                        .extra_base = 0,
-                        .elems = D_CODES,
-                        .max_length = MAX_BITS,
-                        .max_code = 0};
-
-    tree_desc bl_desc = {.dyn_tree = bl_tree.data(),  //
-                         .static_tree = nullptr,
-                         .extra_bits = extra_blbits.data(),
-                         .extra_base = 0,
-                         .elems = BL_CODES,
-                         .max_length = MAX_BL_BITS,
-                         .max_code = 0};
-
-    std::array<uint16_t, MAX_BITS + 1> bl_count;
-    /* number of codes at each bit length for an optimal tree */
-
-    constexpr std::array<uint8_t, BL_CODES> bl_order{{16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15}};
-    /* The lengths of the bit length codes are sent in order of decreasing
-     * probability, to avoid transmitting the lengths for unused bit length codes.
-     */
-
-    std::array<uint32_t, 2 * L_CODES + 1> heap; /* heap used to build the Huffman trees */
-    uint32_t heap_len;                          /* number of elements in the heap */
-    uint32_t heap_max;                          /* element of largest frequency */
-    /* The sons of heap[n] are heap[2*n] and heap[2*n+1]. heap[0] is not used.
-     * The same heap array is used to build all trees.
-     */
-
-    std::array<uint8_t, 2 * L_CODES + 1> depth;
-    /* Depth of each subtree used as tie breaker for trees of equal frequency */
-
-    std::array<uint8_t, MAX_MATCH - MIN_MATCH + 1> length_code;
-    /* length code for each normalised match length (0 == MIN_MATCH) */
-
-    std::array<uint8_t, 512> dist_code;
-    /* distance codes. The first 256 values correspond to the distances
-     * 3 .. 258, the last 256 values correspond to the top 8 bits of
-     * the 15 bit distances.
-     */
+  /* repeat a zero length 11-138 times  (7 bits of repeat count) */
 
-    std::array<uint32_t, LENGTH_CODES> base_length;
-    /* First normalised length for each code (0 = MIN_MATCH) */
-
-    std::array<uint32_t, D_CODES> base_dist;
-    /* First normalised distance for each code (0 = distance of 1) */
+  constexpr std::array<uint8_t, BL_CODES> bl_order{{16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15}};
+  /* The lengths of the bit length codes are sent in order of decreasing
+   * probability, to avoid transmitting the lengths for unused bit length codes.
+   */
 
 #define l_buf inbuf
-    /* DECLARE(uint8_t, l_buf, LIT_BUFSIZE);  buffer for literals or lengths */
-
-    std::array<uint16_t, DIST_BUFSIZE> d_buf; /* buffer for distances */
-
-    std::array<uint8_t, LIT_BUFSIZE / 8> flag_buf;
-    /* flag_buf is a bit array distinguishing literals from lengths in
-     * l_buf, thus indicating the presence or absence of a distance.
-     */
-
-    uint32_t last_lit;   /* running index in l_buf */
-    uint32_t last_dist;  /* running index in d_buf */
-    uint32_t last_flags; /* running index in flag_buf */
-    uint8_t flags;       /* current flags not yet saved in flag_buf */
-    uint8_t flag_bit;    /* current bit used in flags */
-    /* bits are filled in flags starting at bit 0 (least significant).
-     * Note: these flags are overkill in the current code since we don't
-     * take advantage of DIST_BUFSIZE == LIT_BUFSIZE.
-     */
+  /* DECLARE(uint8_t, l_buf, LIT_BUFSIZE);  buffer for literals or lengths */
 
-    uint32_t opt_len;    /* bit length of current block with optimal trees */
-    uint32_t static_len; /* bit length of current block with static trees */
+#define send_code(c, tree) SendBits(tree[c].fc.code, tree[c].dl.len)
+  /* Send a code of the given tree. c and tree must not have side effects */
 
-    uint32_t compressed_len; /* total bit length of compressed file */
+#define d_code(dist) ((dist) < 256 ? dist_code[dist] : dist_code[256 + ((dist) >> 7)])
+  /* Mapping from a distance to a distance code. dist is the distance - 1 and
+   * must not have side effects. dist_code[256] and dist_code[257] are never
+   * used.
+   */
 
-    uint16_t* file_type; /* pointer to UNKNOWN, BINARY or ASCII */
+  /* ===========================================================================
+   * Initialise a new block.
+   */
+  void Context_t::InitBlock() noexcept {
+    /* Initialise the trees. */
+    for (uint32_t n{0}; n < L_CODES; n++) {
+      dyn_ltree[n].fc.freq = 0;
+    }
+    for (uint32_t n{0}; n < D_CODES; n++) {
+      dyn_dtree[n].fc.freq = 0;
+    }
+    for (uint32_t n{0}; n < BL_CODES; n++) {
+      bl_tree[n].fc.freq = 0;
+    }
 
-#define send_code(c, tree) SendBits(tree[c].fc.code, tree[c].dl.len)
-    /* Send a code of the given tree. c and tree must not have side effects */
+    dyn_ltree[END_BLOCK].fc.freq = 1;
+    opt_len = static_len = 0L;
+    last_lit = last_dist = last_flags = 0;
+    flags = 0;
+    flag_bit = 1;
+  }
 
-#define d_code(dist) ((dist) < 256 ? dist_code[dist] : dist_code[256 + ((dist) >> 7)])
-    /* Mapping from a distance to a distance code. dist is the distance - 1 and
-     * must not have side effects. dist_code[256] and dist_code[257] are never
-     * used.
-     */
+  /* ===========================================================================
+   * Generate the codes for a given tree and bit counts (which need not be
+   * optimal).
+   * IN assertion: the array bl_count contains the bit length statistics for
+   * the given tree and the field len is set for all tree elements.
+   * OUT assertion: the field code is set for all tree elements of non
+   *     zero code length.
+   */
+  void Context_t::GenerateCodes(ct_data* tree, const uint32_t max_code) noexcept {
+    std::array<uint16_t, MAX_BITS + 1> next_code; /* next code value for each bit length */
+    uint16_t code{0};                             /* running code value */
 
-    /* ===========================================================================
-     * Initialise a new block.
+    /* The distribution counts are first used to generate the code values
+     * without bit reversal.
      */
-    void InitBlock() noexcept {
-      /* Initialise the trees. */
-      for (uint32_t n{0}; n < L_CODES; n++) {
-        dyn_ltree[n].fc.freq = 0;
-      }
-      for (uint32_t n{0}; n < D_CODES; n++) {
-        dyn_dtree[n].fc.freq = 0;
-      }
-      for (uint32_t n{0}; n < BL_CODES; n++) {
-        bl_tree[n].fc.freq = 0;
-      }
-
-      dyn_ltree[END_BLOCK].fc.freq = 1;
-      opt_len = static_len = 0L;
-      last_lit = last_dist = last_flags = 0;
-      flags = 0;
-      flag_bit = 1;
+    for (uint32_t bits{1}; bits <= MAX_BITS; bits++) {
+      next_code[bits] = code = uint16_t((code + bl_count[bits - 1]) << 1);
     }
-
-    /* ===========================================================================
-     * Generate the codes for a given tree and bit counts (which need not be
-     * optimal).
-     * IN assertion: the array bl_count contains the bit length statistics for
-     * the given tree and the field len is set for all tree elements.
-     * OUT assertion: the field code is set for all tree elements of non
-     *     zero code length.
+    /* Check that the bit counts in bl_count are consistent. The last code
+     * must be all ones.
      */
-    void GenerateCodes(ct_data* tree, const uint32_t max_code) noexcept {
-      std::array<uint16_t, MAX_BITS + 1> next_code; /* next code value for each bit length */
-      uint16_t code{0};                             /* running code value */
-
-      /* The distribution counts are first used to generate the code values
-       * without bit reversal.
-       */
-      for (uint32_t bits{1}; bits <= MAX_BITS; bits++) {
-        next_code[bits] = code = uint16_t((code + bl_count[bits - 1]) << 1);
-      }
-      /* Check that the bit counts in bl_count are consistent. The last code
-       * must be all ones.
-       */
-      Assert(code + bl_count[MAX_BITS] - 1 == (1 << MAX_BITS) - 1, "inconsistent bit counts");
+    Assert(code + bl_count[MAX_BITS] - 1 == (1 << MAX_BITS) - 1, "inconsistent bit counts");
 #if 0
-      Tracev((stderr, "\ngen_codes: max_code %d ", max_code));
+    Tracev((stderr, "\ngen_codes: max_code %d ", max_code));
 #endif
 
-      if (int32_t(max_code) >= 0) {
-        for (uint32_t n{0}; n <= max_code; ++n) {
-          const auto len{tree[n].dl.len};
-          if (len == 0) {
-            continue;
-          }
+    if (int32_t(max_code) >= 0) {
+      for (uint32_t n{0}; n <= max_code; ++n) {
+        const auto len{tree[n].dl.len};
+        if (len == 0) {
+          continue;
+        }
 
-          /* Now reverse the bits */
-          tree[n].fc.code = BitsReverse(next_code[len]++, len);
+        /* Now reverse the bits */
+        tree[n].fc.code = BitsReverse(next_code[len]++, len);
 #if 0
-        Tracec(tree != static_ltree, (stderr, "\nn %3d %c l %2d c %4x (%x) ", n, (isgraph(n) ? n : ' '), len, tree[n].fc.code, next_code[len] - 1));
+      Tracec(tree != static_ltree, (stderr, "\nn %3d %c l %2d c %4x (%x) ", n, (isgraph(n) ? n : ' '), len, tree[n].fc.code, next_code[len] - 1));
 #endif
-        }
       }
     }
-  };  // namespace
+  }
 
   /* ===========================================================================
    * Allocate the match buffer, initialise the various tables and save the
    * location of the internal file attribute (ASCII/binary) and method
    * (DEFLATE/STORE).
    */
-  void CtInit(uint16_t* attr) noexcept {
+  void Context_t::CtInit(uint16_t* attr) noexcept {
     file_type = attr;
     compressed_len = 0L;
 
@@ -388,7 +229,6 @@ namespace gzip {
     InitBlock();
   }
 
-  namespace {
 #define SMALLEST 1
 /* Index within the heap array of least frequent node in the Huffman tree */
 
@@ -407,480 +247,479 @@ namespace gzip {
  */
 #define smaller(tree, n, m) (tree[n].fc.freq < tree[m].fc.freq || (tree[n].fc.freq == tree[m].fc.freq && depth[n] <= depth[m]))
 
-    /* ===========================================================================
-     * Restore the heap property by moving down the tree starting at node k,
-     * exchanging a node with the smallest of its two sons if necessary, stopping
-     * when the heap property is re-established (each father smaller than its
-     * two sons).
-     */
-    void PqDownHeap(ct_data* tree, uint32_t k) noexcept {
-      const uint32_t v = heap[k];
-      uint32_t j = k << 1; /* left son of k */
-      while (j <= heap_len) {
-        /* Set j to the smallest of the two sons: */
-        if (j < heap_len && smaller(tree, heap[j + 1], heap[j])) {
-          j++;
-        }
+  /* ===========================================================================
+   * Restore the heap property by moving down the tree starting at node k,
+   * exchanging a node with the smallest of its two sons if necessary, stopping
+   * when the heap property is re-established (each father smaller than its
+   * two sons).
+   */
+  void Context_t::PqDownHeap(ct_data* tree, uint32_t k) noexcept {
+    const uint32_t v = heap[k];
+    uint32_t j = k << 1; /* left son of k */
+    while (j <= heap_len) {
+      /* Set j to the smallest of the two sons: */
+      if (j < heap_len && smaller(tree, heap[j + 1], heap[j])) {
+        j++;
+      }
 
-        /* Exit if v is smaller than both sons */
-        if (smaller(tree, v, heap[j])) {
-          break;
-        }
+      /* Exit if v is smaller than both sons */
+      if (smaller(tree, v, heap[j])) {
+        break;
+      }
 
-        /* Exchange v with the smallest son */
-        heap[k] = heap[j];
-        k = j;
+      /* Exchange v with the smallest son */
+      heap[k] = heap[j];
+      k = j;
 
-        /* And continue down the tree, setting j to the left son of k */
-        j <<= 1;
-      }
-      heap[k] = v;
-    }
-
-    /* ===========================================================================
-     * Compute the optimal bit lengths for a tree and update the total bit length
-     * for the current block.
-     * IN assertion: the fields freq and dad are set, heap[heap_max] and
-     *    above are the tree nodes sorted by increasing frequency.
-     * OUT assertions: the field len is set to the optimal bit length, the
-     *     array bl_count contains the frequencies for each bit length.
-     *     The length opt_len is updated; static_len is also updated if stree is
-     *     not null.
+      /* And continue down the tree, setting j to the left son of k */
+      j <<= 1;
+    }
+    heap[k] = v;
+  }
+
+  /* ===========================================================================
+   * Compute the optimal bit lengths for a tree and update the total bit length
+   * for the current block.
+   * IN assertion: the fields freq and dad are set, heap[heap_max] and
+   *    above are the tree nodes sorted by increasing frequency.
+   * OUT assertions: the field len is set to the optimal bit length, the
+   *     array bl_count contains the frequencies for each bit length.
+   *     The length opt_len is updated; static_len is also updated if stree is
+   *     not null.
+   */
+  void Context_t::GenerateBitLengths(tree_desc* desc) noexcept {
+    ct_data* tree = desc->dyn_tree;
+    const uint32_t* extra = desc->extra_bits;
+    const uint32_t base = desc->extra_base;
+    const uint32_t max_code = desc->max_code;
+    const uint32_t max_length = desc->max_length;
+    ct_data* stree = desc->static_tree;
+    uint32_t h;           // heap index
+    uint32_t n, m;        // iterate over the tree elements
+    uint32_t xbits;       // extra bits
+    uint16_t f;           // frequency
+    int32_t overflow{0};  // number of elements with bit length too large
+
+    for (uint32_t bits{0}; bits <= MAX_BITS; bits++) {
+      bl_count[bits] = 0;
+    }
+
+    /* In a first pass, compute the optimal bit lengths (which may
+     * overflow in the case of the bit length tree).
      */
-    void GenerateBitLengths(tree_desc* desc) noexcept {
-      ct_data* tree = desc->dyn_tree;
-      const uint32_t* extra = desc->extra_bits;
-      const uint32_t base = desc->extra_base;
-      const uint32_t max_code = desc->max_code;
-      const uint32_t max_length = desc->max_length;
-      ct_data* stree = desc->static_tree;
-      uint32_t h;           // heap index
-      uint32_t n, m;        // iterate over the tree elements
-      uint32_t xbits;       // extra bits
-      uint16_t f;           // frequency
-      int32_t overflow{0};  // number of elements with bit length too large
-
-      for (uint32_t bits{0}; bits <= MAX_BITS; bits++) {
-        bl_count[bits] = 0;
-      }
+    tree[heap[heap_max]].dl.len = 0; /* root of the heap */
 
-      /* In a first pass, compute the optimal bit lengths (which may
-       * overflow in the case of the bit length tree).
-       */
-      tree[heap[heap_max]].dl.len = 0; /* root of the heap */
-
-      for (h = heap_max + 1; h < HEAP_SIZE; h++) {
-        n = heap[h];
-        uint32_t bits = tree[tree[n].dl.dad].dl.len + 1;
-        if (bits > max_length) {
-          bits = max_length;
-          overflow++;
-        }
-        tree[n].dl.len = uint16_t(bits);
-        /* We overwrite tree[n].Dad which is no longer needed */
+    for (h = heap_max + 1; h < HEAP_SIZE; h++) {
+      n = heap[h];
+      uint32_t bits = tree[tree[n].dl.dad].dl.len + 1;
+      if (bits > max_length) {
+        bits = max_length;
+        overflow++;
+      }
+      tree[n].dl.len = uint16_t(bits);
+      /* We overwrite tree[n].Dad which is no longer needed */
 
-        if (n > max_code) {
-          continue; /* not a leaf node */
-        }
-        bl_count[bits]++;
-        xbits = 0;
-        if (n >= base) {
-          xbits = extra[n - base];
-        }
-        f = tree[n].fc.freq;
-        opt_len += uint32_t(f) * (bits + xbits);
-        if (stree) {
-          static_len += uint32_t(f) * (stree[n].dl.len + xbits);
-        }
+      if (n > max_code) {
+        continue; /* not a leaf node */
+      }
+      bl_count[bits]++;
+      xbits = 0;
+      if (n >= base) {
+        xbits = extra[n - base];
       }
-      if (overflow == 0) {
-        return;
+      f = tree[n].fc.freq;
+      opt_len += uint32_t(f) * (bits + xbits);
+      if (stree) {
+        static_len += uint32_t(f) * (stree[n].dl.len + xbits);
       }
+    }
+    if (overflow == 0) {
+      return;
+    }
 
 #if 0
-      Trace((stderr, "\nbit length overflow\n"));
+    Trace((stderr, "\nbit length overflow\n"));
 #endif
-      /* This happens for example on obj2 and pic of the Calgary corpus */
+    /* This happens for example on obj2 and pic of the Calgary corpus */
+
+    /* Find the first bit length which could increase: */
+    do {
+      uint32_t bits = max_length - 1;
+      while (bl_count[bits] == 0) {
+        bits--;
+      }
+      bl_count[bits]--;        /* move one leaf down the tree */
+      bl_count[bits + 1] += 2; /* move one overflow item as its brother */
+      bl_count[max_length]--;
+      /* The brother of the overflow item also moves one step up,
+       * but this does not affect bl_count[max_length]
+       */
+      overflow -= 2;
+    } while (overflow > 0);
 
-      /* Find the first bit length which could increase: */
-      do {
-        uint32_t bits = max_length - 1;
-        while (bl_count[bits] == 0) {
-          bits--;
+    /* Now recompute all bit lengths, scanning in increasing frequency.
+     * h is still equal to HEAP_SIZE. (It is simpler to reconstruct all
+     * lengths instead of fixing only the wrong ones. This idea is taken
+     * from 'ar' written by Haruhiko Okumura.)
+     */
+    for (uint32_t bits = max_length; bits != 0; bits--) {
+      n = bl_count[bits];
+      while (n != 0) {
+        m = heap[--h];
+        if (m > max_code) {
+          continue;
         }
-        bl_count[bits]--;        /* move one leaf down the tree */
-        bl_count[bits + 1] += 2; /* move one overflow item as its brother */
-        bl_count[max_length]--;
-        /* The brother of the overflow item also moves one step up,
-         * but this does not affect bl_count[max_length]
-         */
-        overflow -= 2;
-      } while (overflow > 0);
-
-      /* Now recompute all bit lengths, scanning in increasing frequency.
-       * h is still equal to HEAP_SIZE. (It is simpler to reconstruct all
-       * lengths instead of fixing only the wrong ones. This idea is taken
-       * from 'ar' written by Haruhiko Okumura.)
-       */
-      for (uint32_t bits = max_length; bits != 0; bits--) {
-        n = bl_count[bits];
-        while (n != 0) {
-          m = heap[--h];
-          if (m > max_code) {
-            continue;
-          }
-          if (tree[m].dl.len != bits) {
+        if (tree[m].dl.len != bits) {
 #if 0
-            Trace((stderr, "code %d bits %d->%d\n", m, tree[m].dl.len, bits));
+          Trace((stderr, "code %d bits %d->%d\n", m, tree[m].dl.len, bits));
 #endif
-            opt_len += (bits - int32_t(tree[m].dl.len)) * int32_t(tree[m].fc.freq);
-            tree[m].dl.len = uint16_t(bits);
-          }
-          n--;
+          opt_len += (bits - int32_t(tree[m].dl.len)) * int32_t(tree[m].fc.freq);
+          tree[m].dl.len = uint16_t(bits);
         }
+        n--;
       }
     }
+  }
 
-    /* ===========================================================================
-     * Construct one Huffman tree and assigns the code bit strings and lengths.
-     * Update the total bit length for the current block.
-     * IN assertion: the field freq is set for all tree elements.
-     * OUT assertions: the fields len and code are set to the optimal bit length
-     *     and corresponding code. The length opt_len is updated; static_len is
-     *     also updated if stree is not null. The field max_code is set.
+  /* ===========================================================================
+   * Construct one Huffman tree and assigns the code bit strings and lengths.
+   * Update the total bit length for the current block.
+   * IN assertion: the field freq is set for all tree elements.
+   * OUT assertions: the fields len and code are set to the optimal bit length
+   *     and corresponding code. The length opt_len is updated; static_len is
+   *     also updated if stree is not null. The field max_code is set.
+   */
+  void Context_t::BuildTree(tree_desc* desc) noexcept {
+    ct_data* tree = desc->dyn_tree;
+    ct_data* stree = desc->static_tree;
+    const uint32_t elems = desc->elems;
+    uint32_t n, m;                    /* iterate over heap elements */
+    uint32_t max_code = UINT32_C(~0); /* largest code with non zero frequency */
+    uint32_t node = elems;            /* next internal node of the tree */
+
+    /* Construct the initial heap, with least frequent element in
+     * heap[SMALLEST]. The sons of heap[n] are heap[2*n] and heap[2*n+1].
+     * heap[0] is not used.
      */
-    void BuildTree(tree_desc* desc) noexcept {
-      ct_data* tree = desc->dyn_tree;
-      ct_data* stree = desc->static_tree;
-      const uint32_t elems = desc->elems;
-      uint32_t n, m;                    /* iterate over heap elements */
-      uint32_t max_code = UINT32_C(~0); /* largest code with non zero frequency */
-      uint32_t node = elems;            /* next internal node of the tree */
-
-      /* Construct the initial heap, with least frequent element in
-       * heap[SMALLEST]. The sons of heap[n] are heap[2*n] and heap[2*n+1].
-       * heap[0] is not used.
-       */
-      heap_len = 0;
-      heap_max = HEAP_SIZE;
+    heap_len = 0;
+    heap_max = HEAP_SIZE;
 
-      for (n = 0; n < elems; n++) {
-        if (tree[n].fc.freq != 0) {
-          heap[++heap_len] = max_code = n;
-          depth[n] = 0;
-        } else {
-          tree[n].dl.len = 0;
-        }
+    for (n = 0; n < elems; n++) {
+      if (tree[n].fc.freq != 0) {
+        heap[++heap_len] = max_code = n;
+        depth[n] = 0;
+      } else {
+        tree[n].dl.len = 0;
       }
+    }
 
-      /* The pkzip format requires that at least one distance code exists,
-       * and that at least one bit should be sent even if there is only one
-       * possible code. So to avoid special checks later on we force at least
-       * two codes of non zero frequency.
-       */
-      while (heap_len < 2) {
-        const uint32_t new_ = heap[++heap_len] = (int32_t(max_code) < 2 ? ++max_code : 0);
-        tree[new_].fc.freq = 1;
-        depth[new_] = 0;
-        opt_len--;
-        if (stree) {
-          static_len -= stree[new_].dl.len;
-        }
-        /* new is 0 or 1 so it does not have extra bits */
-      }
-      desc->max_code = max_code;
+    /* The pkzip format requires that at least one distance code exists,
+     * and that at least one bit should be sent even if there is only one
+     * possible code. So to avoid special checks later on we force at least
+     * two codes of non zero frequency.
+     */
+    while (heap_len < 2) {
+      const uint32_t new_ = heap[++heap_len] = (int32_t(max_code) < 2 ? ++max_code : 0);
+      tree[new_].fc.freq = 1;
+      depth[new_] = 0;
+      opt_len--;
+      if (stree) {
+        static_len -= stree[new_].dl.len;
+      }
+      /* new is 0 or 1 so it does not have extra bits */
+    }
+    desc->max_code = max_code;
 
-      /* The elements heap[heap_len/2+1 .. heap_len] are leaves of the tree,
-       * establish sub-heaps of increasing lengths:
-       */
-      for (n = heap_len / 2; n >= 1; n--) {
-        PqDownHeap(tree, n);
-      }
+    /* The elements heap[heap_len/2+1 .. heap_len] are leaves of the tree,
+     * establish sub-heaps of increasing lengths:
+     */
+    for (n = heap_len / 2; n >= 1; n--) {
+      PqDownHeap(tree, n);
+    }
 
-      /* Construct the Huffman tree by repeatedly combining the least two
-       * frequent nodes.
-       */
-      do {
-        pqremove(tree, n);  /* n = node of least frequency */
-        m = heap[SMALLEST]; /* m = node of next least frequency */
+    /* Construct the Huffman tree by repeatedly combining the least two
+     * frequent nodes.
+     */
+    do {
+      pqremove(tree, n);  /* n = node of least frequency */
+      m = heap[SMALLEST]; /* m = node of next least frequency */
 
-        heap[--heap_max] = n; /* keep the nodes sorted by frequency */
-        heap[--heap_max] = m;
+      heap[--heap_max] = n; /* keep the nodes sorted by frequency */
+      heap[--heap_max] = m;
 
-        /* Create a new node father of n and m */
-        tree[node].fc.freq = tree[n].fc.freq + tree[m].fc.freq;
-        depth[node] = uint8_t(std::max(depth[n], depth[m]) + 1);
-        tree[n].dl.dad = tree[m].dl.dad = uint16_t(node);
+      /* Create a new node father of n and m */
+      tree[node].fc.freq = tree[n].fc.freq + tree[m].fc.freq;
+      depth[node] = uint8_t(std::max(depth[n], depth[m]) + 1);
+      tree[n].dl.dad = tree[m].dl.dad = uint16_t(node);
 #ifdef DUMP_BL_TREE
-        if (tree == bl_tree) {
-          fprintf(stderr, "\nnode %d(%d), sons %d(%d) %d(%d)", node, tree[node].fc.freq, n, tree[n].fc.freq, m, tree[m].fc.freq);
-        }
+      if (tree == bl_tree) {
+        fprintf(stderr, "\nnode %d(%d), sons %d(%d) %d(%d)", node, tree[node].fc.freq, n, tree[n].fc.freq, m, tree[m].fc.freq);
+      }
 #endif
-        /* and insert the new node in the heap */
-        heap[SMALLEST] = node++;
-        PqDownHeap(tree, SMALLEST);
-      } while (heap_len >= 2);
-
-      heap[--heap_max] = heap[SMALLEST];
+      /* and insert the new node in the heap */
+      heap[SMALLEST] = node++;
+      PqDownHeap(tree, SMALLEST);
+    } while (heap_len >= 2);
 
-      /* At this point, the fields freq and dad are set. We can now
-       * generate the bit lengths.
-       */
-      GenerateBitLengths(desc);
-
-      /* The field len is now set, we can generate the bit codes */
-      GenerateCodes(tree, max_code);
-    }
+    heap[--heap_max] = heap[SMALLEST];
 
-    /* ===========================================================================
-     * Scan a literal or distance tree to determine the frequencies of the codes
-     * in the bit length tree. Updates opt_len to take into account the repeat
-     * counts. (The contribution of the bit length codes will be added later
-     * during the construction of bl_tree.)
+    /* At this point, the fields freq and dad are set. We can now
+     * generate the bit lengths.
      */
-    void ScanTree(ct_data* tree, const uint32_t max_code) noexcept {
-      uint32_t prevlen = UINT32_C(~0);   /* last emitted length */
-      uint32_t nextlen = tree[0].dl.len; /* length of next code */
-      uint32_t max_count = 7;            /* max repeat count */
-      uint32_t min_count = 4;            /* min repeat count */
+    GenerateBitLengths(desc);
 
+    /* The field len is now set, we can generate the bit codes */
+    GenerateCodes(tree, max_code);
+  }
+
+  /* ===========================================================================
+   * Scan a literal or distance tree to determine the frequencies of the codes
+   * in the bit length tree. Updates opt_len to take into account the repeat
+   * counts. (The contribution of the bit length codes will be added later
+   * during the construction of bl_tree.)
+   */
+  void Context_t::ScanTree(ct_data* tree, const uint32_t max_code) noexcept {
+    uint32_t prevlen = UINT32_C(~0);   /* last emitted length */
+    uint32_t nextlen = tree[0].dl.len; /* length of next code */
+    uint32_t max_count = 7;            /* max repeat count */
+    uint32_t min_count = 4;            /* min repeat count */
+
+    if (0 == nextlen) {
+      max_count = 138;
+      min_count = 3;
+    }
+    tree[max_code + 1].dl.len = 0xFFFF; /* guard */
+
+    uint16_t count = 0; /* repeat count of the current code */
+    for (uint32_t n = 0; n <= max_code; n++) {
+      const uint32_t curlen = nextlen; /* length of current code */
+      nextlen = tree[n + 1].dl.len;
+      if (++count < max_count && curlen == nextlen) {
+        continue;
+      }
+      if (count < min_count) {
+        bl_tree[curlen].fc.freq += count;
+      } else if (curlen != 0) {
+        if (curlen != prevlen) {
+          bl_tree[curlen].fc.freq++;
+        }
+        bl_tree[REP_3_6].fc.freq++;
+      } else if (count <= 10) {
+        bl_tree[REPZ_3_10].fc.freq++;
+      } else {
+        bl_tree[REPZ_11_138].fc.freq++;
+      }
+      count = 0;
+      prevlen = curlen;
       if (0 == nextlen) {
         max_count = 138;
         min_count = 3;
-      }
-      tree[max_code + 1].dl.len = 0xFFFF; /* guard */
-
-      uint16_t count = 0; /* repeat count of the current code */
-      for (uint32_t n = 0; n <= max_code; n++) {
-        const uint32_t curlen = nextlen; /* length of current code */
-        nextlen = tree[n + 1].dl.len;
-        if (++count < max_count && curlen == nextlen) {
-          continue;
-        }
-        if (count < min_count) {
-          bl_tree[curlen].fc.freq += count;
-        } else if (curlen != 0) {
-          if (curlen != prevlen) {
-            bl_tree[curlen].fc.freq++;
-          }
-          bl_tree[REP_3_6].fc.freq++;
-        } else if (count <= 10) {
-          bl_tree[REPZ_3_10].fc.freq++;
-        } else {
-          bl_tree[REPZ_11_138].fc.freq++;
-        }
-        count = 0;
-        prevlen = curlen;
-        if (0 == nextlen) {
-          max_count = 138;
-          min_count = 3;
-        } else if (curlen == nextlen) {
-          max_count = 6;
-          min_count = 3;
-        } else {
-          max_count = 7;
-          min_count = 4;
-        }
+      } else if (curlen == nextlen) {
+        max_count = 6;
+        min_count = 3;
+      } else {
+        max_count = 7;
+        min_count = 4;
       }
     }
+  }
 
-    /* ===========================================================================
-     * Send a literal or distance tree in compressed form, using the codes in
-     * bl_tree.
-     */
-    void SendTree(ct_data* tree, const uint32_t max_code) noexcept {
-      uint32_t prevlen = UINT32_C(~0);   /* last emitted length */
-      uint32_t nextlen = tree[0].dl.len; /* length of next code */
-      uint32_t max_count = 7;            /* max repeat count */
-      uint32_t min_count = 4;            /* min repeat count */
+  /* ===========================================================================
+   * Send a literal or distance tree in compressed form, using the codes in
+   * bl_tree.
+   */
+  void Context_t::SendTree(ct_data* tree, const uint32_t max_code) noexcept {
+    uint32_t prevlen = UINT32_C(~0);   /* last emitted length */
+    uint32_t nextlen = tree[0].dl.len; /* length of next code */
+    uint32_t max_count = 7;            /* max repeat count */
+    uint32_t min_count = 4;            /* min repeat count */
+
+    /* tree[max_code+1].dl.len = -1; */ /* guard already set */
+    if (0 == nextlen) {
+      max_count = 138;
+      min_count = 3;
+    }
 
-      /* tree[max_code+1].dl.len = -1; */ /* guard already set */
+    uint32_t count = 0; /* repeat count of the current code */
+    for (uint32_t n = 0; n <= max_code; n++) {
+      const uint32_t curlen = nextlen; /* length of current code */
+      nextlen = tree[n + 1].dl.len;
+      if (++count < max_count && curlen == nextlen) {
+        continue;
+      }
+      if (count < min_count) {
+        do {
+          send_code(curlen, bl_tree);
+        } while (--count != 0);
+      } else if (curlen != 0) {
+        if (curlen != prevlen) {
+          send_code(curlen, bl_tree);
+          count--;
+        }
+        Assert(count >= 3 && count <= 6, " 3_6?");
+        send_code(REP_3_6, bl_tree);
+        SendBits(count - 3, 2);
+      } else if (count <= 10) {
+        send_code(REPZ_3_10, bl_tree);
+        SendBits(count - 3, 3);
+      } else {
+        send_code(REPZ_11_138, bl_tree);
+        SendBits(count - 11, 7);
+      }
+      count = 0;
+      prevlen = curlen;
       if (0 == nextlen) {
         max_count = 138;
         min_count = 3;
-      }
-
-      uint32_t count = 0; /* repeat count of the current code */
-      for (uint32_t n = 0; n <= max_code; n++) {
-        const uint32_t curlen = nextlen; /* length of current code */
-        nextlen = tree[n + 1].dl.len;
-        if (++count < max_count && curlen == nextlen) {
-          continue;
-        }
-        if (count < min_count) {
-          do {
-            send_code(curlen, bl_tree);
-          } while (--count != 0);
-        } else if (curlen != 0) {
-          if (curlen != prevlen) {
-            send_code(curlen, bl_tree);
-            count--;
-          }
-          Assert(count >= 3 && count <= 6, " 3_6?");
-          send_code(REP_3_6, bl_tree);
-          SendBits(count - 3, 2);
-        } else if (count <= 10) {
-          send_code(REPZ_3_10, bl_tree);
-          SendBits(count - 3, 3);
-        } else {
-          send_code(REPZ_11_138, bl_tree);
-          SendBits(count - 11, 7);
-        }
-        count = 0;
-        prevlen = curlen;
-        if (0 == nextlen) {
-          max_count = 138;
-          min_count = 3;
-        } else if (curlen == nextlen) {
-          max_count = 6;
-          min_count = 3;
-        } else {
-          max_count = 7;
-          min_count = 4;
-        }
+      } else if (curlen == nextlen) {
+        max_count = 6;
+        min_count = 3;
+      } else {
+        max_count = 7;
+        min_count = 4;
       }
     }
+  }
 
-    /* ===========================================================================
-     * Construct the Huffman tree for the bit lengths and return the index in
-     * bl_order of the last bit length code to send.
-     */
-    auto BuildBitLengthTree() noexcept -> uint32_t {
-      uint32_t max_blindex; /* index of last bit length code of non zero freq */
+  /* ===========================================================================
+   * Construct the Huffman tree for the bit lengths and return the index in
+   * bl_order of the last bit length code to send.
+   */
+  auto Context_t::BuildBitLengthTree() noexcept -> uint32_t {
+    uint32_t max_blindex; /* index of last bit length code of non zero freq */
 
-      /* Determine the bit length frequencies for literal and distance trees */
-      ScanTree(dyn_ltree.data(), l_desc.max_code);
-      ScanTree(dyn_dtree.data(), d_desc.max_code);
+    /* Determine the bit length frequencies for literal and distance trees */
+    ScanTree(dyn_ltree.data(), l_desc.max_code);
+    ScanTree(dyn_dtree.data(), d_desc.max_code);
 
-      /* Build the bit length tree: */
-      BuildTree(&bl_desc);
-      /* opt_len now includes the length of the tree representations, except
-       * the lengths of the bit lengths codes and the 5+5+4 bits for the counts.
-       */
+    /* Build the bit length tree: */
+    BuildTree(&bl_desc);
+    /* opt_len now includes the length of the tree representations, except
+     * the lengths of the bit lengths codes and the 5+5+4 bits for the counts.
+     */
 
-      /* Determine the number of bit length codes to send. The pkzip format
-       * requires that at least 4 bit length codes be sent. (appnote.txt says
-       * 3 but the actual value used is 4.)
-       */
-      for (max_blindex = BL_CODES - 1; max_blindex >= 3; max_blindex--) {
-        if (bl_tree[bl_order[max_blindex]].dl.len != 0) {
-          break;
-        }
+    /* Determine the number of bit length codes to send. The pkzip format
+     * requires that at least 4 bit length codes be sent. (appnote.txt says
+     * 3 but the actual value used is 4.)
+     */
+    for (max_blindex = BL_CODES - 1; max_blindex >= 3; max_blindex--) {
+      if (bl_tree[bl_order[max_blindex]].dl.len != 0) {
+        break;
       }
-      /* Update opt_len to include the bit length tree and counts */
-      opt_len += 3 * (max_blindex + 1) + 5 + 5 + 4;
+    }
+    /* Update opt_len to include the bit length tree and counts */
+    opt_len += 3 * (max_blindex + 1) + 5 + 5 + 4;
 #if 0
-    Tracev((stderr, "\ndyn trees: dyn %lu, stat %lu", opt_len, static_len));
+  Tracev((stderr, "\ndyn trees: dyn %lu, stat %lu", opt_len, static_len));
 #endif
 
-      return max_blindex;
-    }
+    return max_blindex;
+  }
 
-    /* ===========================================================================
-     * Send the header for a block using dynamic Huffman trees: the counts, the
-     * lengths of the bit length codes, the literal tree and the distance tree.
-     * IN assertion: lcodes >= 257, dcodes >= 1, blcodes >= 4.
-     */
-    void SendAllTrees(uint32_t lcodes, uint32_t dcodes, uint32_t blcodes) noexcept {
-      Assert(lcodes >= 257 && dcodes >= 1 && blcodes >= 4, "not enough codes");
-      Assert(lcodes <= L_CODES && dcodes <= D_CODES && blcodes <= BL_CODES, "too many codes");
+  /* ===========================================================================
+   * Send the header for a block using dynamic Huffman trees: the counts, the
+   * lengths of the bit length codes, the literal tree and the distance tree.
+   * IN assertion: lcodes >= 257, dcodes >= 1, blcodes >= 4.
+   */
+  void Context_t::SendAllTrees(uint32_t lcodes, uint32_t dcodes, uint32_t blcodes) noexcept {
+    Assert(lcodes >= 257 && dcodes >= 1 && blcodes >= 4, "not enough codes");
+    Assert(lcodes <= L_CODES && dcodes <= D_CODES && blcodes <= BL_CODES, "too many codes");
 #if 0
-    Tracev((stderr, "\nbl counts: "));
+  Tracev((stderr, "\nbl counts: "));
 #endif
-      SendBits(lcodes - 257, 5); /* not +255 as stated in appnote.txt */
-      SendBits(dcodes - 1, 5);
-      SendBits(blcodes - 4, 4); /* not -3 as stated in appnote.txt */
-      for (uint32_t rank = 0; rank < blcodes; rank++) {
+    SendBits(lcodes - 257, 5); /* not +255 as stated in appnote.txt */
+    SendBits(dcodes - 1, 5);
+    SendBits(blcodes - 4, 4); /* not -3 as stated in appnote.txt */
+    for (uint32_t rank = 0; rank < blcodes; rank++) {
 #if 0
-      Tracev((stderr, "\nbl code %2d ", bl_order[rank]));
+    Tracev((stderr, "\nbl code %2d ", bl_order[rank]));
 #endif
-        SendBits(bl_tree[bl_order[rank]].dl.len, 3);
-      }
-      SendTree(dyn_ltree.data(), lcodes - 1); /* send the literal tree */
-      SendTree(dyn_dtree.data(), dcodes - 1); /* send the distance tree */
+      SendBits(bl_tree[bl_order[rank]].dl.len, 3);
     }
+    SendTree(dyn_ltree.data(), lcodes - 1); /* send the literal tree */
+    SendTree(dyn_dtree.data(), dcodes - 1); /* send the distance tree */
+  }
 
-    /* ===========================================================================
-     * Set the file type to ASCII or BINARY, using a crude approximation:
-     * binary if more than 20% of the bytes are <= 6 or >= 128, ascii otherwise.
-     * IN assertion: the fields freq of dyn_ltree are set and the total of all
-     * frequencies does not exceed 64K (to fit in an int on 16 bit machines).
-     */
-    void SetFileType() noexcept {
-      uint32_t n{0};
-      uint32_t ascii_freq{0};
-      uint32_t bin_freq{0};
-      while (n < 7) {
-        bin_freq += dyn_ltree[n++].fc.freq;
-      }
-      while (n < 128) {
-        ascii_freq += dyn_ltree[n++].fc.freq;
-      }
-      while (n < LITERALS) {
-        bin_freq += dyn_ltree[n++].fc.freq;
-      }
-      *file_type = bin_freq > (ascii_freq >> 2) ? BINARY : ASCII;
+  /* ===========================================================================
+   * Set the file type to ASCII or BINARY, using a crude approximation:
+   * binary if more than 20% of the bytes are <= 6 or >= 128, ascii otherwise.
+   * IN assertion: the fields freq of dyn_ltree are set and the total of all
+   * frequencies does not exceed 64K (to fit in an int on 16 bit machines).
+   */
+  void Context_t::SetFileType() noexcept {
+    uint32_t n{0};
+    uint32_t ascii_freq{0};
+    uint32_t bin_freq{0};
+    while (n < 7) {
+      bin_freq += dyn_ltree[n++].fc.freq;
     }
+    while (n < 128) {
+      ascii_freq += dyn_ltree[n++].fc.freq;
+    }
+    while (n < LITERALS) {
+      bin_freq += dyn_ltree[n++].fc.freq;
+    }
+    *file_type = bin_freq > (ascii_freq >> 2) ? BINARY : ASCII;
+  }
 
-    /* ===========================================================================
-     * Send the block data compressed using the given Huffman trees
-     */
-    void CompressBlock(ct_data* ltree, ct_data* dtree) noexcept {
-      uint32_t dist;    /* distance of matched string */
-      uint32_t lc;      /* match length or unmatched char (if dist == 0) */
-      uint32_t lx{0};   /* running index in l_buf */
-      uint32_t dx = 0;  /* running index in d_buf */
-      uint32_t fx = 0;  /* running index in flag_buf */
-      uint8_t flag = 0; /* current flags */
-      uint32_t code;    /* the code to send */
-      uint32_t extra;   /* number of extra bits to send */
-
-      if (last_lit != 0) {
-        do {
-          if ((lx & 7) == 0) {
-            flag = flag_buf[fx++];
-          }
-          lc = l_buf[lx++];
-          if ((flag & 1) == 0) {
-            send_code(lc, ltree); /* send a literal byte */
+  /* ===========================================================================
+   * Send the block data compressed using the given Huffman trees
+   */
+  void Context_t::CompressBlock(ct_data* ltree, ct_data* dtree) noexcept {
+    uint32_t dist;    /* distance of matched string */
+    uint32_t lc;      /* match length or unmatched char (if dist == 0) */
+    uint32_t lx{0};   /* running index in l_buf */
+    uint32_t dx = 0;  /* running index in d_buf */
+    uint32_t fx = 0;  /* running index in flag_buf */
+    uint8_t flag = 0; /* current flags */
+    uint32_t code;    /* the code to send */
+    uint32_t extra;   /* number of extra bits to send */
+
+    if (last_lit != 0) {
+      do {
+        if ((lx & 7) == 0) {
+          flag = flag_buf[fx++];
+        }
+        lc = l_buf[lx++];
+        if ((flag & 1) == 0) {
+          send_code(lc, ltree); /* send a literal byte */
 #if 0
-            Tracecv(isgraph(lc), (stderr, " '%c' ", lc));
+          Tracecv(isgraph(lc), (stderr, " '%c' ", lc));
 #endif
-          } else {
-            /* Here, lc is the match length - MIN_MATCH */
-            code = length_code[lc];
-            send_code(code + LITERALS + 1, ltree); /* send the length code */
-            extra = extra_lbits[code];
-            if (extra != 0) {
-              lc -= base_length[code];
-              SendBits(lc, extra); /* send the extra length bits */
-            }
-            dist = d_buf[dx++];
-            /* Here, dist is the match distance - 1 */
-            code = d_code(dist);
-            Assert(code < D_CODES, "bad d_code");
-
-            send_code(code, dtree); /* send the distance code */
-            extra = extra_dbits[code];
-            if (extra != 0) {
-              dist -= base_dist[code];
-              SendBits(dist, extra); /* send the extra distance bits */
-            }
-          } /* literal or match pair ? */
-          flag >>= 1;
-        } while (lx < last_lit);
-      }
-
-      send_code(END_BLOCK, ltree);
+        } else {
+          /* Here, lc is the match length - MIN_MATCH */
+          code = length_code[lc];
+          send_code(code + LITERALS + 1, ltree); /* send the length code */
+          extra = extra_lbits[code];
+          if (extra != 0) {
+            lc -= base_length[code];
+            SendBits(lc, extra); /* send the extra length bits */
+          }
+          dist = d_buf[dx++];
+          /* Here, dist is the match distance - 1 */
+          code = d_code(dist);
+          Assert(code < D_CODES, "bad d_code");
+
+          send_code(code, dtree); /* send the distance code */
+          extra = extra_dbits[code];
+          if (extra != 0) {
+            dist -= base_dist[code];
+            SendBits(dist, extra); /* send the extra distance bits */
+          }
+        } /* literal or match pair ? */
+        flag >>= 1;
+      } while (lx < last_lit);
     }
-  };  // namespace
+
+    send_code(END_BLOCK, ltree);
+  }
 
   /* ===========================================================================
    * Determine the best encoding for the current block: dynamic trees, static
    * trees or store, and output the encoded block to the zip file. This function
    * returns the total compressed length for the file so far.
    */
-  auto FlushBlock(char* buf, uint32_t stored_len, int32_t pad, const uint32_t eof) noexcept -> uint32_t {
+  auto Context_t::FlushBlock(char* buf, uint32_t stored_len, int32_t pad, const uint32_t eof) noexcept -> uint32_t {
     uint32_t opt_lenb, static_lenb; /* opt_len and static_len in bytes */
 
     flag_buf[last_flags] = flags; /* Save the flags for the last 8 items */
@@ -948,6 +787,9 @@ namespace gzip {
       compressed_len += 3 + opt_len;
     }
     InitBlock();
+    if (nullptr != omem) {
+      flush_outbuf(); /* output in memory is checked while it is produced, hand over each block */
+    }
 
     if (eof) {
       BitsWindup();
@@ -965,7 +807,7 @@ namespace gzip {
    * Save the match info and tally the frequency counts. Return true if
    * the current block must be flushed.
    */
-  auto CtTally(uint32_t dist, const uint32_t lc) noexcept -> int32_t {
+  auto Context_t::CtTally(uint32_t dist, const uint32_t lc) noexcept -> int32_t {
     l_buf[last_lit++] = uint8_t(lc);
     if (dist == 0) {
       /* lc is the unmatched char */
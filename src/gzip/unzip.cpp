@@ -16,6 +16,7 @@
  */
 #include <cstdint>
 #include <cstdio>
+#include <memory>
 #include "gzip.h"
 
 namespace {
@@ -29,7 +30,7 @@ namespace {
 };  // namespace
 
 namespace gzip {
-  auto Unzip(FILE* const in, FILE* const out, uint32_t& ilength) noexcept -> uint32_t {
+  auto Context_t::Unzip(FILE* const in, FILE* const out, uint32_t& ilength) noexcept -> uint32_t {
     if (in && out && (ilength > 0)) {
       Flush();
       ifd = in;
@@ -45,7 +46,7 @@ namespace gzip {
     return GZip_ERROR;
   }
 
-  auto Unzip(const uint8_t* const in, const uint32_t ilength, write_buffer_t out, void* const ptr) noexcept -> uint32_t {
+  auto Context_t::Unzip(const uint8_t* const in, const uint32_t ilength, write_buffer_t out, void* const ptr) noexcept -> uint32_t {
     if (in && (ilength > 0) && out) {
       Flush();
       ifd = nullptr;
@@ -60,4 +61,14 @@ namespace gzip {
     }
     return GZip_ERROR;
   }
+
+  auto Unzip(FILE* const in, FILE* const out, uint32_t& ilength) noexcept -> uint32_t {
+    const auto context{std::make_unique<Context_t>()};
+    return context->Unzip(in, out, ilength);
+  }
+
+  auto Unzip(const uint8_t* const in, const uint32_t ilength, write_buffer_t out, void* const ptr) noexcept -> uint32_t {
+    const auto context{std::make_unique<Context_t>()};
+    return context->Unzip(in, ilength, out, ptr);
+  }
 };  // namespace gzip
@@ -26,7 +26,7 @@ namespace gzip {
   /* ===========================================================================
    * Fill the input buffer. This is called only when the buffer is empty.
    */
-  auto fill_inbuf(int32_t eof_ok) noexcept -> int32_t {
+  auto Context_t::fill_inbuf(int32_t eof_ok) noexcept -> int32_t {
     /* Read as much as possible */
     insize = 0;
     do {
@@ -46,6 +46,7 @@ namespace gzip {
       }
       flush_window();
       errno = 0;
+      ++past_end;
       return 0;  // read_error();
     }
     bytes_in += insize;
@@ -55,7 +56,7 @@ namespace gzip {
 
   /* Like the standard read function, except do not attempt to read more
      than INT_MAX bytes at a time.  */
-  auto read_buffer(FILE* fd, void* buf, uint32_t cnt) noexcept -> uint32_t {
+  auto Context_t::read_buffer(FILE* fd, void* buf, uint32_t cnt) noexcept -> uint32_t {
     if (INT_MAX < cnt) {
       cnt = INT_MAX;
     }
@@ -82,40 +83,39 @@ namespace gzip {
     return 0;  // EOF
   }
 
-  namespace {
-    auto write_buffer(FILE* fd, void* buf, uint32_t cnt) noexcept -> uint32_t {
-      if (INT_MAX < cnt) {
-        cnt = INT_MAX;
-      }
-      if (fd) {
-        return uint32_t(fwrite(buf, sizeof(char), cnt, fd));
-      }
-      if (omem) {
-        bytes_out += cnt;
-        return omem(buf, cnt, this_pointer);
-      }
-      return 0;  // Failure
+  auto Context_t::write_buffer(FILE* fd, void* buf, uint32_t cnt) noexcept -> uint32_t {
+    if (INT_MAX < cnt) {
+      cnt = INT_MAX;
     }
-
-    void write_buf(FILE* fd, void* buf, uint32_t cnt) noexcept {
+    if (fd) {
+      return uint32_t(fwrite(buf, sizeof(char), cnt, fd));
+    }
+    if (omem) {
       bytes_out += cnt;
+      return omem(buf, cnt, this_pointer);
+    }
+    return 0;  // Failure
+  }
+
+  void Context_t::write_buf(FILE* fd, void* buf, uint32_t cnt) noexcept {
+    bytes_out += cnt;
 
-      uint32_t n{0};
-      while ((n = write_buffer(fd, buf, cnt)) != cnt) {
-        if (n == uint32_t(EOF)) {
-          return;  // write_error();
-        }
-        cnt -= n;
-        buf = static_cast<void*>(static_cast<char*>(buf) + n);
+    uint32_t n{0};
+    while ((n = write_buffer(fd, buf, cnt)) != cnt) {
+      if (n == uint32_t(EOF)) {
+        write_failed = true;
+        return;  // write_error();
       }
+      cnt -= n;
+      buf = static_cast<void*>(static_cast<char*>(buf) + n);
     }
-  };  // namespace
+  }
 
   /* ===========================================================================
    * Write the output buffer outbuf[0..outcnt-1] and update bytes_out.
    * (used for the compressed data only)
    */
-  void flush_outbuf() noexcept {
+  void Context_t::flush_outbuf() noexcept {
     if (outcnt == 0) {
       return;
     }
@@ -127,7 +127,7 @@ namespace gzip {
    * Write the output window window[0..outcnt-1] and update crc and bytes_out.
    * (Used for the decompressed data only.)
    */
-  void flush_window() noexcept {
+  void Context_t::flush_window() noexcept {
     if (outcnt == 0) {
       return;
     }
@@ -16,10 +16,14 @@
  */
 #include <cstdint>
 #include <cstdio>
+#include <memory>
 #include "gzip.h"
 
 namespace gzip {
-  auto FileRead(void* buf, uint32_t size) noexcept -> int32_t {
+  auto Context_t::FileRead(void* buf, uint32_t size) noexcept -> int32_t {
+    if (write_failed) {
+      return 0;  // The output is refused, end the input early
+    }
     if (size < insize) {
       insize -= size;
     } else {
@@ -37,20 +41,47 @@ namespace gzip {
     return int32_t(len);
   }
 
-  auto Zip(FILE* const in, const uint32_t size, FILE* const out, const uint32_t clevel) noexcept -> uint32_t {
+  auto Context_t::Zip_(const uint32_t size, const uint32_t clevel) noexcept -> uint32_t {
     uint16_t attr = 0; /* ASCII/binary flag */
 
-    ifd = in;
-    ofd = out;
     outcnt = 0;
     insize = size;
     level = clevel;
     bytes_in = 0;
+    write_failed = false;
 
     BitsInit();
     CtInit(&attr);
     Deflate(level);
     flush_outbuf();
-    return GZip_OK;
+    return write_failed ? GZip_ERROR : GZip_OK;
+  }
+
+  auto Context_t::Zip(FILE* const in, const uint32_t size, FILE* const out, const uint32_t clevel) noexcept -> uint32_t {
+    ifd = in;
+    ofd = out;
+    return Zip_(size, clevel);
+  }
+
+  auto Context_t::Zip(const uint8_t* const in, const uint32_t size, write_buffer_t out, void* const ptr, const uint32_t clevel) noexcept -> uint32_t {
+    ifd = nullptr;
+    ofd = nullptr;
+    imem = in;
+    ifile_size = size;
+    omem = out;
+    this_pointer = ptr;
+    const auto res{Zip_(size, clevel)};
+    omem = nullptr;
+    return res;
+  }
+
+  auto Zip(FILE* const in, const uint32_t size, FILE* const out, const uint32_t clevel) noexcept -> uint32_t {
+    const auto context{std::make_unique<Context_t>()};
+    return context->Zip(in, size, out, clevel);
+  }
+
+  auto Zip(const uint8_t* const in, const uint32_t size, write_buffer_t out, void* const ptr, const uint32_t clevel) noexcept -> uint32_t {
+    const auto context{std::make_unique<Context_t>()};
+    return context->Zip(in, size, out, ptr, clevel);
   }
 };  // namespace gzip
@@ -54,7 +54,9 @@
 #if defined(USE_BYTELL_HASH_MAP)
 using map_string2uint_t = ska::bytell_hash_map<std::string, uint32_t>;
 using map_uint2string_t = ska::bytell_hash_map<uint32_t, std::string>;
+using map_digest2offset_t = ska::bytell_hash_map<uint64_t, int64_t>;
 #else
 using map_string2uint_t = std::unordered_map<std::string, uint32_t>;
 using map_uint2string_t = std::unordered_map<uint32_t, std::string>;
+using map_digest2offset_t = std::unordered_map<uint64_t, int64_t>;
 #endif